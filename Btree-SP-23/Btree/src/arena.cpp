@@ -0,0 +1,58 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "arena.h"
+
+#include <stdint.h>
+
+namespace badgerdb {
+
+Arena::Arena(const std::size_t blockSize)
+    : current_(0), offset_(0), blockSize_(blockSize) {}
+
+Arena::~Arena() {
+  for (std::size_t b = 0; b < blocks_.size(); b++) {
+    delete[] blocks_[b];
+  }
+}
+
+void *Arena::allocate(const std::size_t size, const std::size_t alignment) {
+  // Look for room in the current block, then in the blocks after it which
+  // are left from before the last rewind
+  for (; current_ < blocks_.size(); current_++, offset_ = 0) {
+    const uintptr_t start = (uintptr_t)blocks_[current_];
+    const uintptr_t aligned =
+        (start + offset_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (aligned + size <= start + blockSizes_[current_]) {
+      offset_ = aligned + size - start;
+      return (void *)aligned;
+    }
+  }
+
+  // Add a block, large enough for the allocation
+  const std::size_t blockSize =
+      size + alignment > blockSize_ ? size + alignment : blockSize_;
+  blocks_.push_back(new char[blockSize]);
+  blockSizes_.push_back(blockSize);
+  current_ = blocks_.size() - 1;
+  const uintptr_t start = (uintptr_t)blocks_[current_];
+  const uintptr_t aligned =
+      (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+  offset_ = aligned + size - start;
+  return (void *)aligned;
+}
+
+std::size_t Arena::bytesReserved() const {
+  std::size_t bytes = 0;
+  for (std::size_t b = 0; b < blockSizes_.size(); b++) {
+    bytes += blockSizes_[b];
+  }
+  return bytes;
+}
+
+}  // namespace badgerdb
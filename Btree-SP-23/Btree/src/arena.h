@@ -0,0 +1,137 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Default size of the blocks an Arena allocates from.
+ */
+const std::size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+/**
+ * @brief Bump allocator for short-lived temporaries. Memory is handed out from
+ * large blocks and is only given back all at once, by rewinding the arena to
+ * a mark taken earlier. Blocks are kept when the arena is rewound, so an
+ * arena reused for the same kind of operation stops calling malloc once it
+ * has grown to the size that operation needs.
+ *
+ * Only meant for types that need no destructor.
+ */
+class Arena {
+ public:
+  /**
+   * @brief Position of the arena, to rewind it to.
+   */
+  struct Mark {
+    std::size_t block;
+    std::size_t offset;
+  };
+
+  /**
+   * @param blockSize   Size of the blocks allocated. Larger allocations get a
+   *                    block of their own.
+   */
+  explicit Arena(const std::size_t blockSize = ARENA_BLOCK_SIZE);
+
+  /**
+   * Frees every block.
+   */
+  ~Arena();
+
+  /**
+   * Allocates uninitialized memory.
+   *
+   * @param size        Number of bytes.
+   * @param alignment   Alignment of the memory, a power of two.
+   * @return  Memory valid until the arena is rewound before this allocation.
+   */
+  void *allocate(const std::size_t size,
+                 const std::size_t alignment = sizeof(double));
+
+  /**
+   * Allocates an uninitialized array.
+   *
+   * @param count   Number of elements.
+   */
+  template <class T>
+  T *allocateArray(const std::size_t count) {
+    return (T *)allocate(count * sizeof(T), alignof(T));
+  }
+
+  /**
+   * Returns the current position of the arena.
+   */
+  Mark mark() const {
+    Mark m = {current_, offset_};
+    return m;
+  }
+
+  /**
+   * Frees everything allocated since the mark was taken.
+   */
+  void rewind(const Mark &m) {
+    current_ = m.block;
+    offset_ = m.offset;
+  }
+
+  /**
+   * Frees everything allocated, keeping the blocks.
+   */
+  void reset() {
+    current_ = 0;
+    offset_ = 0;
+  }
+
+  /**
+   * Returns the number of bytes of the blocks held by the arena.
+   */
+  std::size_t bytesReserved() const;
+
+ private:
+  Arena(const Arena &);
+  Arena &operator=(const Arena &);
+
+  /**
+   * Start and size of every block.
+   */
+  std::vector<char *> blocks_;
+  std::vector<std::size_t> blockSizes_;
+
+  /**
+   * Block allocations are made from, and offset of its first free byte.
+   */
+  std::size_t current_;
+  std::size_t offset_;
+
+  std::size_t blockSize_;
+};
+
+/**
+ * @brief Rewinds an arena when it goes out of scope, freeing the temporaries
+ * of one operation.
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena &arena) : arena_(arena), mark_(arena.mark()) {}
+
+  ~ArenaScope() { arena_.rewind(mark_); }
+
+ private:
+  ArenaScope(const ArenaScope &);
+  ArenaScope &operator=(const ArenaScope &);
+
+  Arena &arena_;
+  Arena::Mark mark_;
+};
+
+}  // namespace badgerdb
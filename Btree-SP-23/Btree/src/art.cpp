@@ -0,0 +1,611 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "art.h"
+
+#include <string.h>
+
+#include <sstream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "blob_stream.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "filescan.h"
+
+namespace badgerdb {
+
+/**
+ * Visitor called for every leaf during iteration.
+ */
+typedef std::function<void(const ARTLeaf *leaf)> ARTLeafVisitor;
+
+/**
+ * Visits all the leaves of a subtree in key order. A key ending at an inner
+ * node sorts before all the keys below that node, so the node's own value is
+ * visited before its children.
+ */
+static void visitLeaves(const ARTNode *node, const ARTLeafVisitor &visitor) {
+  if (node == NULL) {
+    return;
+  }
+  if (node->type == ART_LEAF) {
+    visitor((const ARTLeaf *)node);
+    return;
+  }
+  if (node->value != NULL) {
+    visitor(node->value);
+  }
+  switch (node->type) {
+    case ART_NODE4: {
+      const ARTNode4 *n = (const ARTNode4 *)node;
+      for (int i = 0; i < n->numChildren; i++) {
+        visitLeaves(n->children[i], visitor);
+      }
+      break;
+    }
+    case ART_NODE16: {
+      const ARTNode16 *n = (const ARTNode16 *)node;
+      for (int i = 0; i < n->numChildren; i++) {
+        visitLeaves(n->children[i], visitor);
+      }
+      break;
+    }
+    case ART_NODE48: {
+      const ARTNode48 *n = (const ARTNode48 *)node;
+      for (int b = 0; b < 256; b++) {
+        if (n->childIndex[b]) {
+          visitLeaves(n->children[n->childIndex[b] - 1], visitor);
+        }
+      }
+      break;
+    }
+    case ART_NODE256: {
+      const ARTNode256 *n = (const ARTNode256 *)node;
+      for (int b = 0; b < 256; b++) {
+        if (n->children[b] != NULL) {
+          visitLeaves(n->children[b], visitor);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+ * Moves the fields common to all inner nodes to a node of a bigger type.
+ */
+static void moveHeader(ARTNode *to, ARTNode *from) {
+  to->prefix.swap(from->prefix);
+  to->value = from->value;
+  to->numChildren = from->numChildren;
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::ARTIndex -- Constructor
+// -----------------------------------------------------------------------------
+
+ARTIndex::ARTIndex(const std::string &relationName, std::string &outIndexName,
+                   BufMgr *bufMgrIn, const int attrByteOffset,
+                   const int attrLength) {
+  // Create index file name
+  std::ostringstream idxStr;
+  idxStr << relationName << "." << attrByteOffset << ".art";
+  outIndexName = idxStr.str();
+
+  // Initialize member variables
+  this->bufMgr = bufMgrIn;
+  this->headerPageNum = 1;
+  this->root = NULL;
+  this->attrByteOffset = attrByteOffset;
+  this->attrLength = attrLength;
+  this->keyCount = 0;
+  this->dirty = false;
+
+  try {
+    this->file = new BlobFile(outIndexName, false);
+    Page *metaPage;
+    this->bufMgr->readPage(this->file, this->headerPageNum, metaPage);
+    ARTMetaInfo *metaInfo = (ARTMetaInfo *)metaPage;
+    // Values in metapage must match the ones the index is opened with
+    bool relationNameMatch =
+        (strlen(metaInfo->relationName) == relationName.size()) &&
+        !strcmp(metaInfo->relationName, relationName.c_str());
+    bool attributeMatch = metaInfo->attrByteOffset == attrByteOffset &&
+                          metaInfo->attrLength == attrLength;
+    const PageId dataPageNo = metaInfo->dataPageNo;
+    this->bufMgr->unPinPage(this->file, this->headerPageNum, false);
+    if (!(relationNameMatch && attributeMatch)) {
+      throw BadIndexInfoException(
+          "Parameters passed while creating the index don't match");
+    }
+    load(dataPageNo);
+  } catch (const FileNotFoundException &e) {
+    // Create the blob file for the index and its meta page
+    this->file = new BlobFile(outIndexName, true);
+    Page *metaPage;
+    this->bufMgr->allocPage(this->file, this->headerPageNum, metaPage);
+    ARTMetaInfo *metaInfo = (ARTMetaInfo *)metaPage;
+    strncpy(metaInfo->relationName, relationName.c_str(),
+            sizeof(metaInfo->relationName) - 1);
+    metaInfo->relationName[sizeof(metaInfo->relationName) - 1] = '\0';
+    metaInfo->attrByteOffset = attrByteOffset;
+    metaInfo->attrLength = attrLength;
+    metaInfo->numKeys = 0;
+    metaInfo->dataPageNo = Page::INVALID_NUMBER;
+    this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
+
+    // Scan the file and insert the records into the index
+    {
+      FileScan fscan(relationName, bufMgr);
+      RecordId scanRid;
+      while (fscan.tryScanNext(scanRid)) {
+        RecordView recordView = fscan.getRecordView();
+        const char *key = recordView.data + attrByteOffset;
+        this->insertEntry(std::string(key, strnlen(key, attrLength)),
+                          scanRid);
+      }
+    }
+    save();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::~ARTIndex -- destructor
+// -----------------------------------------------------------------------------
+
+ARTIndex::~ARTIndex() {
+  try {
+    if (this->dirty) {
+      save();
+    }
+    this->bufMgr->flushFile(this->file);
+  } catch (...) {
+  }
+  delete this->file;
+  this->file = NULL;
+  freeSubtree(this->root);
+  this->root = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::save / load
+// -----------------------------------------------------------------------------
+
+void ARTIndex::save() {
+  Page *metaPage;
+  this->bufMgr->readPage(this->file, this->headerPageNum, metaPage);
+  ARTMetaInfo *metaInfo = (ARTMetaInfo *)metaPage;
+  {
+    // Entries are written in key order as
+    // <key length, key bytes, number of rids, rids>
+    BlobWriter writer(this->file, this->bufMgr, metaInfo->dataPageNo);
+    visitLeaves(this->root, [&writer](const ARTLeaf *leaf) {
+      writer.writeValue(std::uint32_t(leaf->key.size()));
+      writer.write(leaf->key.data(), leaf->key.size());
+      writer.writeValue(std::uint32_t(leaf->rids.size()));
+      writer.write(&leaf->rids[0], leaf->rids.size() * sizeof(RecordId));
+    });
+    writer.close();
+    metaInfo->dataPageNo = writer.firstPageNo();
+  }
+  metaInfo->numKeys = this->keyCount;
+  this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
+  this->dirty = false;
+}
+
+void ARTIndex::load(const PageId dataPageNo) {
+  BlobReader reader(this->file, this->bufMgr, dataPageNo);
+  std::uint32_t keyLength;
+  std::string key;
+  while (reader.readValue(keyLength)) {
+    key.resize(keyLength);
+    std::uint32_t numRids = 0;
+    if (!reader.read(&key[0], keyLength) || !reader.readValue(numRids)) {
+      break;
+    }
+    for (std::uint32_t i = 0; i < numRids; i++) {
+      RecordId rid;
+      if (!reader.readValue(rid)) {
+        break;
+      }
+      insertRecursive(this->root, key, 0, rid);
+    }
+  }
+  this->dirty = false;
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::insertEntry
+// -----------------------------------------------------------------------------
+
+void ARTIndex::insertEntry(const std::string &key, const RecordId rid) {
+  insertRecursive(this->root, key, 0, rid);
+  this->dirty = true;
+}
+
+ARTLeaf *ARTIndex::newLeaf(const std::string &key, const RecordId &rid) {
+  ARTLeaf *leaf = new ARTLeaf();
+  leaf->key = key;
+  leaf->rids.push_back(rid);
+  this->keyCount++;
+  return leaf;
+}
+
+void ARTIndex::insertRecursive(ARTNode *&nodeRef, const std::string &key,
+                               std::size_t depth, const RecordId &rid) {
+  ARTNode *node = nodeRef;
+  if (node == NULL) {
+    nodeRef = newLeaf(key, rid);
+    return;
+  }
+
+  if (node->type == ART_LEAF) {
+    ARTLeaf *leaf = (ARTLeaf *)node;
+    if (leaf->key == key) {
+      leaf->rids.push_back(rid);
+      return;
+    }
+    // Two different keys meet here, replace the leaf by an inner node holding
+    // their common bytes as prefix and both keys below it
+    std::size_t commonLength = 0;
+    while (depth + commonLength < leaf->key.size() &&
+           depth + commonLength < key.size() &&
+           leaf->key[depth + commonLength] == key[depth + commonLength]) {
+      commonLength++;
+    }
+    ARTNode *newNode = new ARTNode4();
+    newNode->prefix.assign(key, depth, commonLength);
+    const std::size_t splitDepth = depth + commonLength;
+    if (leaf->key.size() == splitDepth) {
+      newNode->value = leaf;
+    } else {
+      addChild(newNode, leaf->key[splitDepth], leaf);
+    }
+    if (key.size() == splitDepth) {
+      newNode->value = newLeaf(key, rid);
+    } else {
+      addChild(newNode, key[splitDepth], newLeaf(key, rid));
+    }
+    nodeRef = newNode;
+    return;
+  }
+
+  // Compare the compressed path of the node with the key
+  std::size_t matched = 0;
+  while (matched < node->prefix.size() && depth + matched < key.size() &&
+         node->prefix[matched] == (char)key[depth + matched]) {
+    matched++;
+  }
+  if (matched < node->prefix.size()) {
+    // Key diverges inside the compressed path, split the path
+    ARTNode *newNode = new ARTNode4();
+    newNode->prefix.assign(node->prefix, 0, matched);
+    const unsigned char splitByte = node->prefix[matched];
+    node->prefix.erase(0, matched + 1);
+    addChild(newNode, splitByte, node);
+    const std::size_t splitDepth = depth + matched;
+    if (key.size() == splitDepth) {
+      newNode->value = newLeaf(key, rid);
+    } else {
+      addChild(newNode, key[splitDepth], newLeaf(key, rid));
+    }
+    nodeRef = newNode;
+    return;
+  }
+
+  depth += node->prefix.size();
+  if (depth == key.size()) {
+    // Key ends at this node
+    if (node->value != NULL) {
+      node->value->rids.push_back(rid);
+    } else {
+      node->value = newLeaf(key, rid);
+    }
+    return;
+  }
+  ARTNode **child = findChild(node, key[depth]);
+  if (child != NULL) {
+    insertRecursive(*child, key, depth + 1, rid);
+  } else {
+    addChild(nodeRef, key[depth], newLeaf(key, rid));
+  }
+}
+
+void ARTIndex::addChild(ARTNode *&nodeRef, unsigned char keyByte,
+                        ARTNode *child) {
+  ARTNode *node = nodeRef;
+  switch (node->type) {
+    case ART_NODE4: {
+      ARTNode4 *n = (ARTNode4 *)node;
+      if (n->numChildren < 4) {
+        // Keep the key bytes sorted
+        int pos = 0;
+        while (pos < n->numChildren && n->keys[pos] < keyByte) {
+          pos++;
+        }
+        memmove(n->keys + pos + 1, n->keys + pos, n->numChildren - pos);
+        memmove(n->children + pos + 1, n->children + pos,
+                (n->numChildren - pos) * sizeof(ARTNode *));
+        n->keys[pos] = keyByte;
+        n->children[pos] = child;
+        n->numChildren++;
+        return;
+      }
+      // Node is full, grow it into a Node16
+      ARTNode16 *grown = new ARTNode16();
+      moveHeader(grown, n);
+      memcpy(grown->keys, n->keys, 4);
+      memcpy(grown->children, n->children, 4 * sizeof(ARTNode *));
+      delete n;
+      nodeRef = grown;
+      addChild(nodeRef, keyByte, child);
+      return;
+    }
+    case ART_NODE16: {
+      ARTNode16 *n = (ARTNode16 *)node;
+      if (n->numChildren < 16) {
+        int pos = 0;
+        while (pos < n->numChildren && n->keys[pos] < keyByte) {
+          pos++;
+        }
+        memmove(n->keys + pos + 1, n->keys + pos, n->numChildren - pos);
+        memmove(n->children + pos + 1, n->children + pos,
+                (n->numChildren - pos) * sizeof(ARTNode *));
+        n->keys[pos] = keyByte;
+        n->children[pos] = child;
+        n->numChildren++;
+        return;
+      }
+      // Node is full, grow it into a Node48
+      ARTNode48 *grown = new ARTNode48();
+      moveHeader(grown, n);
+      memset(grown->childIndex, 0, sizeof(grown->childIndex));
+      for (int i = 0; i < 16; i++) {
+        grown->childIndex[n->keys[i]] = i + 1;
+        grown->children[i] = n->children[i];
+      }
+      delete n;
+      nodeRef = grown;
+      addChild(nodeRef, keyByte, child);
+      return;
+    }
+    case ART_NODE48: {
+      ARTNode48 *n = (ARTNode48 *)node;
+      if (n->numChildren < 48) {
+        // Entries are never removed, so the used slots are always dense
+        n->children[n->numChildren] = child;
+        n->childIndex[keyByte] = n->numChildren + 1;
+        n->numChildren++;
+        return;
+      }
+      // Node is full, grow it into a Node256
+      ARTNode256 *grown = new ARTNode256();
+      moveHeader(grown, n);
+      memset(grown->children, 0, sizeof(grown->children));
+      for (int b = 0; b < 256; b++) {
+        if (n->childIndex[b]) {
+          grown->children[b] = n->children[n->childIndex[b] - 1];
+        }
+      }
+      delete n;
+      nodeRef = grown;
+      addChild(nodeRef, keyByte, child);
+      return;
+    }
+    case ART_NODE256: {
+      ARTNode256 *n = (ARTNode256 *)node;
+      n->children[keyByte] = child;
+      n->numChildren++;
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+ARTNode **ARTIndex::findChild(ARTNode *node, unsigned char keyByte) {
+  switch (node->type) {
+    case ART_NODE4: {
+      ARTNode4 *n = (ARTNode4 *)node;
+      for (int i = 0; i < n->numChildren; i++) {
+        if (n->keys[i] == keyByte) {
+          return &n->children[i];
+        }
+      }
+      return NULL;
+    }
+    case ART_NODE16: {
+      ARTNode16 *n = (ARTNode16 *)node;
+#ifdef __SSE2__
+      // Compare the key byte against all 16 key bytes at once
+      __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)keyByte),
+                                   _mm_loadu_si128((const __m128i *)n->keys));
+      int mask = _mm_movemask_epi8(cmp) & ((1 << n->numChildren) - 1);
+      if (mask) {
+        return &n->children[__builtin_ctz(mask)];
+      }
+#else
+      for (int i = 0; i < n->numChildren; i++) {
+        if (n->keys[i] == keyByte) {
+          return &n->children[i];
+        }
+      }
+#endif
+      return NULL;
+    }
+    case ART_NODE48: {
+      ARTNode48 *n = (ARTNode48 *)node;
+      if (n->childIndex[keyByte]) {
+        return &n->children[n->childIndex[keyByte] - 1];
+      }
+      return NULL;
+    }
+    case ART_NODE256: {
+      ARTNode256 *n = (ARTNode256 *)node;
+      if (n->children[keyByte] != NULL) {
+        return &n->children[keyByte];
+      }
+      return NULL;
+    }
+    default:
+      return NULL;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::lookup
+// -----------------------------------------------------------------------------
+
+bool ARTIndex::lookup(const std::string &key,
+                      std::vector<RecordId> &outRids) const {
+  ARTNode *node = this->root;
+  std::size_t depth = 0;
+  while (node != NULL) {
+    if (node->type == ART_LEAF) {
+      const ARTLeaf *leaf = (const ARTLeaf *)node;
+      if (leaf->key != key) {
+        return false;
+      }
+      outRids.insert(outRids.end(), leaf->rids.begin(), leaf->rids.end());
+      return true;
+    }
+    const std::string &prefix = node->prefix;
+    if (key.size() - depth < prefix.size() ||
+        key.compare(depth, prefix.size(), prefix) != 0) {
+      return false;
+    }
+    depth += prefix.size();
+    if (depth == key.size()) {
+      if (node->value == NULL) {
+        return false;
+      }
+      outRids.insert(outRids.end(), node->value->rids.begin(),
+                     node->value->rids.end());
+      return true;
+    }
+    ARTNode **child = findChild(node, key[depth]);
+    if (child == NULL) {
+      return false;
+    }
+    node = *child;
+    depth++;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::prefixScan
+// -----------------------------------------------------------------------------
+
+void ARTIndex::prefixScan(const std::string &prefix,
+                          const Visitor &visitor) const {
+  ARTLeafVisitor leafVisitor = [&visitor](const ARTLeaf *leaf) {
+    for (std::size_t i = 0; i < leaf->rids.size(); i++) {
+      visitor(leaf->key, leaf->rids[i]);
+    }
+  };
+  ARTNode *node = this->root;
+  std::size_t depth = 0;
+  while (node != NULL) {
+    if (node->type == ART_LEAF) {
+      const ARTLeaf *leaf = (const ARTLeaf *)node;
+      if (leaf->key.compare(0, prefix.size(), prefix) == 0) {
+        leafVisitor(leaf);
+      }
+      return;
+    }
+    // Compare the part of the compressed path the prefix still covers
+    const std::string &nodePrefix = node->prefix;
+    const std::size_t remaining = prefix.size() - depth;
+    const std::size_t length =
+        remaining < nodePrefix.size() ? remaining : nodePrefix.size();
+    if (prefix.compare(depth, length, nodePrefix, 0, length) != 0) {
+      return;
+    }
+    if (remaining <= nodePrefix.size()) {
+      // Prefix is consumed, every key below this node matches
+      visitLeaves(node, leafVisitor);
+      return;
+    }
+    depth += nodePrefix.size();
+    ARTNode **child = findChild(node, prefix[depth]);
+    if (child == NULL) {
+      return;
+    }
+    node = *child;
+    depth++;
+  }
+}
+
+void ARTIndex::prefixScan(const std::string &prefix,
+                          std::vector<RecordId> &outRids) const {
+  prefixScan(prefix, [&outRids](const std::string &key, const RecordId &rid) {
+    outRids.push_back(rid);
+  });
+}
+
+// -----------------------------------------------------------------------------
+// ARTIndex::freeSubtree
+// -----------------------------------------------------------------------------
+
+void ARTIndex::freeSubtree(ARTNode *node) {
+  if (node == NULL) {
+    return;
+  }
+  if (node->type == ART_LEAF) {
+    delete (ARTLeaf *)node;
+    return;
+  }
+  if (node->value != NULL) {
+    delete node->value;
+  }
+  switch (node->type) {
+    case ART_NODE4: {
+      ARTNode4 *n = (ARTNode4 *)node;
+      for (int i = 0; i < n->numChildren; i++) {
+        freeSubtree(n->children[i]);
+      }
+      delete n;
+      break;
+    }
+    case ART_NODE16: {
+      ARTNode16 *n = (ARTNode16 *)node;
+      for (int i = 0; i < n->numChildren; i++) {
+        freeSubtree(n->children[i]);
+      }
+      delete n;
+      break;
+    }
+    case ART_NODE48: {
+      ARTNode48 *n = (ARTNode48 *)node;
+      for (int i = 0; i < n->numChildren; i++) {
+        freeSubtree(n->children[i]);
+      }
+      delete n;
+      break;
+    }
+    case ART_NODE256: {
+      ARTNode256 *n = (ARTNode256 *)node;
+      for (int b = 0; b < 256; b++) {
+        freeSubtree(n->children[b]);
+      }
+      delete n;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,337 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Kinds of nodes of the adaptive radix tree. Inner nodes grow from 4 to
+ * 256 children as keys are added below them.
+ */
+enum ARTNodeType { ART_LEAF = 0, ART_NODE4 = 1, ART_NODE16 = 2,
+                   ART_NODE48 = 3, ART_NODE256 = 4 };
+
+/**
+ * @brief Fields common to all nodes of the tree. Inner nodes keep the bytes
+ * shared by every key below them in <prefix> (path compression), so a chain
+ * of single-child nodes never gets materialized.
+ */
+struct ARTNode {
+  /**
+   * Kind of the node, tells what structure the node can be cast to.
+   */
+  ARTNodeType type;
+
+  /**
+   * Number of children of an inner node.
+   */
+  std::uint16_t numChildren;
+
+  /**
+   * Compressed path of an inner node.
+   */
+  std::string prefix;
+
+  /**
+   * Leaf of the key which ends exactly at this inner node, if any. Needed
+   * since keys are variable-length and one key may be a prefix of another.
+   */
+  struct ARTLeaf *value;
+
+  explicit ARTNode(ARTNodeType t) : type(t), numChildren(0), value(NULL) {}
+};
+
+/**
+ * @brief Leaf holding a complete key and all the record ids stored under it.
+ * Leaves are placed as high in the tree as possible (lazy expansion), so the
+ * full key is kept to verify a match.
+ */
+struct ARTLeaf : public ARTNode {
+  /**
+   * Complete key.
+   */
+  std::string key;
+
+  /**
+   * RecordIds of all the records having this key.
+   */
+  std::vector<RecordId> rids;
+
+  ARTLeaf() : ARTNode(ART_LEAF) {}
+};
+
+/**
+ * @brief Inner node with up to 4 children, key bytes kept sorted.
+ */
+struct ARTNode4 : public ARTNode {
+  unsigned char keys[4];
+  ARTNode *children[4];
+
+  ARTNode4() : ARTNode(ART_NODE4) {}
+};
+
+/**
+ * @brief Inner node with up to 16 children, key bytes kept sorted so they can
+ * be searched with a single SIMD comparison.
+ */
+struct ARTNode16 : public ARTNode {
+  unsigned char keys[16];
+  ARTNode *children[16];
+
+  ARTNode16() : ARTNode(ART_NODE16) {}
+};
+
+/**
+ * @brief Inner node with up to 48 children. <childIndex> maps a key byte to
+ * the slot of its child plus one, 0 meaning no child.
+ */
+struct ARTNode48 : public ARTNode {
+  unsigned char childIndex[256];
+  ARTNode *children[48];
+
+  ARTNode48() : ARTNode(ART_NODE48) {}
+};
+
+/**
+ * @brief Inner node directly indexed by the key byte.
+ */
+struct ARTNode256 : public ARTNode {
+  ARTNode *children[256];
+
+  ARTNode256() : ARTNode(ART_NODE256) {}
+};
+
+/**
+ * @brief The meta page of an ART index file. It is always the first page of
+ * the file; the entries of the index follow as a blob stream.
+ */
+struct ARTMetaInfo {
+  /**
+   * Name of base relation.
+   */
+  char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored
+   * in pages.
+   */
+  int attrByteOffset;
+
+  /**
+   * Maximum length of the attribute over which index is built.
+   */
+  int attrLength;
+
+  /**
+   * Number of distinct keys stored in the index.
+   */
+  std::uint32_t numKeys;
+
+  /**
+   * First page of the blob stream holding the entries.
+   */
+  PageId dataPageNo;
+};
+
+/**
+ * @brief ARTIndex class. It implements an in-memory adaptive radix tree over a
+ * variable-length string attribute of a relation, used as a secondary index
+ * for string-keyed lookups. It supports point lookups, prefix scans and
+ * ordered iteration over all the keys.
+ *
+ * The tree lives in memory. It is built from the relation using FileScan the
+ * first time, and saved to its index file so later instances are rebuilt from
+ * the sorted entries instead of scanning the relation again.
+ */
+class ARTIndex {
+ public:
+  /**
+   * Visitor called for every (key, rid) entry during iteration.
+   */
+  typedef std::function<void(const std::string &key, const RecordId &rid)>
+      Visitor;
+
+  /**
+   * ARTIndex Constructor.
+   * Check to see if the corresponding index file exists. If so, open the file
+   * and rebuild the tree from it. If not, create it and insert entries for
+   * every tuple in the base relation using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn            Buffer Manager Instance
+   * @param attrByteOffset      Offset of attribute, over which index is to be
+   * built, in the record
+   * @param attrLength          Maximum length of the attribute. The key is the
+   * attribute up to its first null character or <attrLength> bytes.
+   * @throws  BadIndexInfoException     If the index file already exists for
+   * the corresponding attribute, but values in metapage do not match with
+   * values received through constructor parameters.
+   */
+  ARTIndex(const std::string &relationName, std::string &outIndexName,
+           BufMgr *bufMgrIn, const int attrByteOffset, const int attrLength);
+
+  /**
+   * ARTIndex Destructor.
+   * Saves the entries back to the index file if any were inserted since the
+   * index was opened, flushes and closes the index file and frees the tree.
+   */
+  ~ARTIndex();
+
+  /**
+   * Insert a new entry using the pair <key,rid>.
+   *
+   * @param key     Key to insert.
+   * @param rid     Record ID of a record whose entry is getting inserted into
+   * the index.
+   */
+  void insertEntry(const std::string &key, const RecordId rid);
+
+  /**
+   * Point lookup of a key.
+   *
+   * @param key       Key to look up.
+   * @param outRids   RecordIds of the records having the key are appended to
+   * this vector.
+   * @return  True if the key is present.
+   */
+  bool lookup(const std::string &key, std::vector<RecordId> &outRids) const;
+
+  /**
+   * Visits, in key order, all the entries whose key starts with <prefix>.
+   *
+   * @param prefix    Prefix of the keys to visit. Empty visits every entry.
+   * @param visitor   Called for every matching entry.
+   */
+  void prefixScan(const std::string &prefix, const Visitor &visitor) const;
+
+  /**
+   * Returns the RecordIds of all the entries whose key starts with <prefix>,
+   * in key order.
+   *
+   * @param prefix    Prefix of the keys to find.
+   * @param outRids   Matching RecordIds are appended to this vector.
+   */
+  void prefixScan(const std::string &prefix,
+                  std::vector<RecordId> &outRids) const;
+
+  /**
+   * Visits all the entries of the index in key order.
+   *
+   * @param visitor   Called for every entry.
+   */
+  void scanAll(const Visitor &visitor) const { prefixScan("", visitor); }
+
+  /**
+   * Returns the number of distinct keys in the index.
+   */
+  std::uint32_t numKeys() const { return keyCount; }
+
+  /**
+   * Writes all the entries to the index file.
+   */
+  void save();
+
+ private:
+  /**
+   * File object for the index file.
+   */
+  File *file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+  BufMgr *bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+  PageId headerPageNum;
+
+  /**
+   * Root of the tree, NULL if the index is empty.
+   */
+  ARTNode *root;
+
+  /**
+   * Offset of attribute, over which index is built, inside records.
+   */
+  int attrByteOffset;
+
+  /**
+   * Maximum length of attribute over which index is built.
+   */
+  int attrLength;
+
+  /**
+   * Number of distinct keys in the tree.
+   */
+  std::uint32_t keyCount;
+
+  /**
+   * True if entries were inserted since the index file was last written.
+   */
+  bool dirty;
+
+  /**
+   * Rebuilds the tree from the entries saved in the index file.
+   * @param dataPageNo    First page of the saved entries.
+   */
+  void load(const PageId dataPageNo);
+
+  /**
+   * Inserts the key below the node at <nodeRef>, replacing the node when it
+   * has to grow or be split.
+   * @param nodeRef   Reference to the child pointer holding the node.
+   * @param key       Key to insert.
+   * @param depth     Number of bytes of the key consumed above this node.
+   * @param rid       RecordId to insert.
+   */
+  void insertRecursive(ARTNode *&nodeRef, const std::string &key,
+                       std::size_t depth, const RecordId &rid);
+
+  /**
+   * Adds a child to an inner node, growing it into a bigger node type if it
+   * is full.
+   * @param nodeRef   Reference to the child pointer holding the node.
+   * @param keyByte   Key byte of the child.
+   * @param child     Child to add.
+   */
+  static void addChild(ARTNode *&nodeRef, unsigned char keyByte,
+                       ARTNode *child);
+
+  /**
+   * Returns a reference to the child pointer of an inner node for a key byte,
+   * or NULL if the node has no such child.
+   */
+  static ARTNode **findChild(ARTNode *node, unsigned char keyByte);
+
+  /**
+   * Frees a subtree.
+   */
+  static void freeSubtree(ARTNode *node);
+
+  /**
+   * Returns a new leaf holding one entry.
+   */
+  ARTLeaf *newLeaf(const std::string &key, const RecordId &rid);
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,227 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "async_index.h"
+
+namespace badgerdb {
+
+/**
+ * Lookup of a key: a scan of [key, key] collecting every entry.
+ */
+struct AsyncIndex::LookupOperation : public AsyncIndex::Operation {
+  AsyncScanState state;
+  std::vector<RIDKeyPair<IndexKey> > entries;
+  LookupCallback done;
+
+  bool resume(AsyncIndex &owner, PageId &pageNo) {
+    while (true) {
+      const AsyncStatus status = owner.resumeScan(this->state, this->entries);
+      if (status == ASYNC_WAITING) {
+        pageNo = this->state.pageNo;
+        return false;
+      }
+      if (status == ASYNC_DONE) {
+        std::vector<RecordId> rids;
+        rids.reserve(this->entries.size());
+        for (std::size_t i = 0; i < this->entries.size(); i++) {
+          rids.push_back(this->entries[i].rid);
+        }
+        this->done(rids);
+        return true;
+      }
+    }
+  }
+};
+
+/**
+ * Call to AsyncCursor::next: reads leaves into the cursor until it has an
+ * entry to return or the scan is done.
+ */
+struct AsyncIndex::NextOperation : public AsyncIndex::Operation {
+  AsyncCursor *cursor;
+  AsyncCursor::NextCallback done;
+
+  bool resume(AsyncIndex &owner, PageId &pageNo) {
+    AsyncCursor &cur = *this->cursor;
+    while (cur.nextEntry_ == cur.entries_.size()) {
+      if (cur.state_.phase == AsyncScanState::DONE) {
+        this->done(false, RecordId(), IndexKey());
+        return true;
+      }
+      cur.entries_.clear();
+      cur.nextEntry_ = 0;
+      if (owner.resumeScan(cur.state_, cur.entries_) == ASYNC_WAITING) {
+        pageNo = cur.state_.pageNo;
+        return false;
+      }
+    }
+    const RIDKeyPair<IndexKey> entry = cur.entries_[cur.nextEntry_++];
+    this->done(true, entry.rid, entry.key);
+    return true;
+  }
+};
+
+AsyncIndex::AsyncIndex(BTreeIndex *index, WorkStealingPool &pool)
+    : index_(index),
+      latchedBufMgr_(index->bufMgr),
+      inFlight_(0),
+      misses_(0),
+      reads_(pool) {}
+
+AsyncIndex::~AsyncIndex() {
+  try {
+    this->reads_.wait();
+  } catch (...) {
+  }
+  // Every read requeued its operation, whether it failed or not
+  for (std::size_t i = 0; i < this->ready_.size(); i++) {
+    AsyncScanState &scan = *this->ready_[i]->scan;
+    if (scan.pinnedPage != NULL) {
+      try {
+        this->latchedBufMgr_.unPinPage(this->index_->file, scan.pageNo,
+                                       false);
+      } catch (...) {
+      }
+    }
+    delete this->ready_[i];
+  }
+}
+
+void AsyncIndex::lookup(const void *key, const LookupCallback &done) {
+  LookupOperation *operation = new LookupOperation();
+  operation->scan = &operation->state;
+  try {
+    this->startScan(operation->state, key, GTE, key, LTE);
+  } catch (...) {
+    delete operation;
+    throw;
+  }
+  operation->done = done;
+  this->submit(operation);
+}
+
+void AsyncIndex::run() {
+  std::unique_lock<std::mutex> lock(this->latch_);
+  while (this->inFlight_ > 0) {
+    if (this->ready_.empty()) {
+      this->operationReady_.wait(lock);
+      continue;
+    }
+    Operation *operation = this->ready_.front();
+    this->ready_.pop_front();
+    lock.unlock();
+    this->process(operation);
+    lock.lock();
+  }
+}
+
+std::size_t AsyncIndex::poll() {
+  std::unique_lock<std::mutex> lock(this->latch_);
+  while (!this->ready_.empty()) {
+    Operation *operation = this->ready_.front();
+    this->ready_.pop_front();
+    lock.unlock();
+    this->process(operation);
+    lock.lock();
+  }
+  return this->inFlight_;
+}
+
+std::size_t AsyncIndex::misses() {
+  std::lock_guard<std::mutex> lock(this->latch_);
+  return this->misses_;
+}
+
+void AsyncIndex::submit(Operation *operation) {
+  {
+    std::lock_guard<std::mutex> lock(this->latch_);
+    this->ready_.push_back(operation);
+    this->inFlight_++;
+  }
+  this->operationReady_.notify_one();
+}
+
+void AsyncIndex::process(Operation *operation) {
+  PageId pageNo = Page::INVALID_NUMBER;
+  bool completed;
+  try {
+    if (operation->error) {
+      std::rethrow_exception(operation->error);
+    }
+    completed = operation->resume(*this, pageNo);
+  } catch (...) {
+    this->retire(operation);
+    throw;
+  }
+  if (completed) {
+    this->retire(operation);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->latch_);
+    this->misses_++;
+  }
+  // A page missing from the pool is read from the file: pages are written
+  // back when evicted, so the file holds the current version of those
+  this->latchedBufMgr_.readInBackground(
+      this->index_->file, pageNo, this->reads_,
+      [this, operation](Page *page, std::exception_ptr error) {
+        this->requeue(operation, page, error);
+      },
+      FOREGROUND_TASK);
+}
+
+void AsyncIndex::requeue(Operation *operation, Page *page,
+                         std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock(this->latch_);
+    operation->scan->pinnedPage = page;
+    operation->error = error;
+    this->ready_.push_back(operation);
+  }
+  this->operationReady_.notify_one();
+}
+
+void AsyncIndex::retire(Operation *operation) {
+  delete operation;
+  std::lock_guard<std::mutex> lock(this->latch_);
+  this->inFlight_--;
+}
+
+void AsyncIndex::startScan(AsyncScanState &state, const void *lowVal,
+                           const Operator lowOp, const void *highVal,
+                           const Operator highOp) {
+  this->index_->startAsyncScan(&this->latchedBufMgr_, state, lowVal, lowOp,
+                               highVal, highOp);
+}
+
+AsyncStatus AsyncIndex::resumeScan(
+    AsyncScanState &state, std::vector<RIDKeyPair<IndexKey> > &entries) {
+  return this->index_->resumeScan(state, entries);
+}
+
+// -----------------------------------------------------------------------------
+// AsyncCursor
+// -----------------------------------------------------------------------------
+
+AsyncCursor::AsyncCursor(AsyncIndex &index, const void *lowVal,
+                         const Operator lowOp, const void *highVal,
+                         const Operator highOp)
+    : index_(index), nextEntry_(0) {
+  index.startScan(this->state_, lowVal, lowOp, highVal, highOp);
+}
+
+void AsyncCursor::next(const NextCallback &done) {
+  AsyncIndex::NextOperation *operation = new AsyncIndex::NextOperation();
+  operation->cursor = this;
+  operation->scan = &this->state_;
+  operation->done = done;
+  this->index_.submit(operation);
+}
+
+}  // namespace badgerdb
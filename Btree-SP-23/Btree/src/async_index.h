@@ -0,0 +1,263 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "btree.h"
+#include "latched_buffer.h"
+#include "types.h"
+#include "work_pool.h"
+
+namespace badgerdb {
+
+class AsyncCursor;
+
+/**
+ * @brief Lookups and scans of a BTreeIndex which do not block on the pages
+ * missing from the buffer pool.
+ *
+ * An operation runs on the thread calling run() or poll() until it reads a
+ * page not in the pool. It is then suspended, the page is read by a
+ * FOREGROUND_TASK of a WorkStealingPool, and the operation is queued again
+ * once the page is in the pool, where it resumes from the node it stopped
+ * on. Meanwhile the thread runs the other operations, so many lookups can
+ * wait for the disk at once on a few threads.
+ *
+ * Results are handed to callbacks, called from run() or poll(), never from
+ * the call starting the operation. A callback may start other operations.
+ *
+ * The page an operation waited for stays pinned until the operation resumes,
+ * so the buffer pool needs a frame for each page waited for at once.
+ *
+ * The index is read through a LatchedBufMgr over its buffer manager, which
+ * the index itself keeps using directly, so the index must not be modified
+ * or used otherwise while the AsyncIndex is open.
+ */
+class AsyncIndex {
+ public:
+  /**
+   * Receives the RecordIds of the entries of a key.
+   */
+  typedef std::function<void(const std::vector<RecordId> &rids)>
+      LookupCallback;
+
+  /**
+   * Opens an index for asynchronous operations.
+   *
+   * @param index   Index to read. Outlives the AsyncIndex.
+   * @param pool    Threads reading the missing pages.
+   */
+  AsyncIndex(BTreeIndex *index, WorkStealingPool &pool);
+
+  /**
+   * Waits for the pages being read. Operations not completed are dropped,
+   * their callbacks not called.
+   */
+  ~AsyncIndex();
+
+  /**
+   * Starts a lookup of the entries with a given key.
+   *
+   * @param key   Pointer to integer / double / char string, as for
+   *              BTreeIndex::startScan.
+   * @param done  Called with the RecordIds of the entries, in no particular
+   *              order, none if the key is not in the index.
+   */
+  void lookup(const void *key, const LookupCallback &done);
+
+  /**
+   * Runs the operations until all of them are completed, waiting for their
+   * pages when none is ready.
+   *
+   * @throws  The exception an operation or a callback threw, the operation
+   *          being dropped. The others can be run again.
+   */
+  void run();
+
+  /**
+   * Runs the operations ready to, without waiting for any page.
+   *
+   * @return  Number of operations not completed yet.
+   * @throws  As run().
+   */
+  std::size_t poll();
+
+  /**
+   * Returns the number of times an operation was suspended on a page
+   * missing from the buffer pool.
+   */
+  std::size_t misses();
+
+ private:
+  // Not copyable, the tasks refer to the object
+  AsyncIndex(const AsyncIndex &);
+  AsyncIndex &operator=(const AsyncIndex &);
+
+  /**
+   * Operation in flight: the state it resumes from and its callback.
+   */
+  struct Operation {
+    Operation() : scan(NULL), error() {}
+    virtual ~Operation() {}
+
+    /**
+     * Runs the operation on the index until it completes, calling its
+     * callback, or reads a page not in the pool.
+     *
+     * @param pageNo  Set to the page to read when suspended.
+     * @return  true once completed.
+     */
+    virtual bool resume(AsyncIndex &owner, PageId &pageNo) = 0;
+
+    /**
+     * Scan the operation runs, which the page it waited for is handed to.
+     */
+    AsyncScanState *scan;
+
+    /**
+     * Exception reading the page the operation waited for threw.
+     */
+    std::exception_ptr error;
+  };
+
+  struct LookupOperation;
+  struct NextOperation;
+
+  /**
+   * Queues a new operation as ready to run.
+   */
+  void submit(Operation *operation);
+
+  /**
+   * Runs an operation taken from the ready queue, then drops it if
+   * completed or has its page read.
+   */
+  void process(Operation *operation);
+
+  /**
+   * Queues an operation again once its page was read, handing it the page
+   * pinned. Called from the task reading it.
+   */
+  void requeue(Operation *operation, Page *page, std::exception_ptr error);
+
+  /**
+   * Drops an operation, completed or failed.
+   */
+  void retire(Operation *operation);
+
+  /**
+   * BTreeIndex::startAsyncScan and resumeScan, for the operations.
+   */
+  void startScan(AsyncScanState &state, const void *lowVal,
+                 const Operator lowOp, const void *highVal,
+                 const Operator highOp);
+  AsyncStatus resumeScan(AsyncScanState &state,
+                         std::vector<RIDKeyPair<IndexKey> > &entries);
+
+  BTreeIndex *index_;
+
+  /**
+   * Buffer manager of the index, shared with the tasks reading the pages.
+   */
+  LatchedBufMgr latchedBufMgr_;
+
+  /**
+   * Protects the members below.
+   */
+  std::mutex latch_;
+
+  /**
+   * Signals run() that an operation was queued again.
+   */
+  std::condition_variable operationReady_;
+
+  /**
+   * Operations ready to run, oldest first.
+   */
+  std::deque<Operation *> ready_;
+
+  /**
+   * Number of operations not completed, ready or waiting for a page.
+   */
+  std::size_t inFlight_;
+
+  std::size_t misses_;
+
+  /**
+   * Tasks reading the pages the operations wait for. Last member, so it is
+   * done before the others go.
+   */
+  TaskGroup reads_;
+
+  friend class AsyncCursor;
+};
+
+/**
+ * @brief Range scan of an AsyncIndex, returning one entry per call to
+ * next().
+ *
+ * The cursor reads a leaf at a time into a buffer of its own, so it holds no
+ * page pinned between two calls and only the calls moving to another leaf
+ * may wait for a page.
+ */
+class AsyncCursor {
+ public:
+  /**
+   * Receives the next entry of the scan, <found> being false once the scan
+   * is done.
+   */
+  typedef std::function<void(const bool found, const RecordId &rid,
+                             const IndexKey &key)>
+      NextCallback;
+
+  /**
+   * Sets up a scan of a range, as BTreeIndex::startScan, reading nothing
+   * yet.
+   *
+   * @param index   Index to scan. Outlives the cursor.
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   */
+  AsyncCursor(AsyncIndex &index, const void *lowVal, const Operator lowOp,
+              const void *highVal, const Operator highOp);
+
+  /**
+   * Starts fetching the next entry, in key order. Not to be called again
+   * before <done> is.
+   *
+   * @param done  Called with the entry, or with <found> false once the scan
+   *              is done.
+   */
+  void next(const NextCallback &done);
+
+ private:
+  // Not copyable, the operations refer to the object
+  AsyncCursor(const AsyncCursor &);
+  AsyncCursor &operator=(const AsyncCursor &);
+
+  AsyncIndex &index_;
+  AsyncScanState state_;
+
+  /**
+   * Entries of the last leaf read, and the next one to return.
+   */
+  std::vector<RIDKeyPair<IndexKey> > entries_;
+  std::size_t nextEntry_;
+
+  friend class AsyncIndex;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,33 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+namespace badgerdb {
+
+/**
+ * @brief Datatype enumeration type.
+ */
+enum Datatype { INTEGER = 0, DOUBLE = 1, STRING = 2 };
+
+/**
+ * @brief Scan operations enumeration. Passed to BTreeIndex::startScan() method.
+ */
+enum Operator {
+  LT,  /* Less Than */
+  LTE, /* Less Than or Equal to */
+  GTE, /* Greater Than or Equal to */
+  GT   /* Greater Than */
+};
+
+/**
+ * @brief Size of String key.
+ */
+const int STRINGSIZE = 10;
+
+}  // namespace badgerdb
@@ -0,0 +1,217 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "bitmap_index.h"
+
+#include <string.h>
+
+#include <sstream>
+
+#include "blob_stream.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "filescan.h"
+
+namespace badgerdb {
+
+// -----------------------------------------------------------------------------
+// BitmapIndex::BitmapIndex -- Constructor
+// -----------------------------------------------------------------------------
+
+BitmapIndex::BitmapIndex(const std::string &relationName,
+                         std::string &outIndexName, BufMgr *bufMgrIn,
+                         const int attrByteOffset, const Datatype attrType) {
+  // Create index file name
+  std::ostringstream idxStr;
+  idxStr << relationName << "." << attrByteOffset << ".bitmap";
+  outIndexName = idxStr.str();
+
+  // Initialize member variables
+  this->bufMgr = bufMgrIn;
+  this->headerPageNum = 1;
+  this->attrByteOffset = attrByteOffset;
+  this->attributeType = attrType;
+
+  try {
+    this->file = new BlobFile(outIndexName, false);
+    Page *metaPage;
+    this->bufMgr->readPage(this->file, this->headerPageNum, metaPage);
+    BitmapMetaInfo *metaInfo = (BitmapMetaInfo *)metaPage;
+    // Values in metapage must match the ones the index is opened with
+    bool relationNameMatch =
+        (strlen(metaInfo->relationName) == relationName.size()) &&
+        !strcmp(metaInfo->relationName, relationName.c_str());
+    bool attributeMatch = metaInfo->attrByteOffset == attrByteOffset &&
+                          metaInfo->attrType == attrType;
+    const PageId dataPageNo = metaInfo->dataPageNo;
+    const std::uint32_t numRows = metaInfo->numRows;
+    const std::uint32_t numKeys = metaInfo->numKeys;
+    const std::uint32_t relationVersion = metaInfo->relationVersion;
+    this->bufMgr->unPinPage(this->file, this->headerPageNum, false);
+    if (!(relationNameMatch && attributeMatch)) {
+      throw BadIndexInfoException(
+          "Parameters passed while creating the index don't match");
+    }
+    // The index is not maintained, it would miss the records written since
+    if (PageFile(relationName, false).version() != relationVersion) {
+      this->bufMgr->flushFile(this->file);
+      delete this->file;
+      throw BadIndexInfoException(
+          "Relation was written since the index was built");
+    }
+    load(dataPageNo, numRows, numKeys);
+  } catch (const FileNotFoundException &e) {
+    // Create the blob file for the index and its meta page
+    this->file = new BlobFile(outIndexName, true);
+    Page *metaPage;
+    this->bufMgr->allocPage(this->file, this->headerPageNum, metaPage);
+    BitmapMetaInfo *metaInfo = (BitmapMetaInfo *)metaPage;
+    strncpy(metaInfo->relationName, relationName.c_str(),
+            sizeof(metaInfo->relationName) - 1);
+    metaInfo->relationName[sizeof(metaInfo->relationName) - 1] = '\0';
+    metaInfo->attrByteOffset = attrByteOffset;
+    metaInfo->attrType = attrType;
+    metaInfo->numRows = 0;
+    metaInfo->numKeys = 0;
+    metaInfo->dataPageNo = Page::INVALID_NUMBER;
+    metaInfo->relationVersion = PageFile(relationName, false).version();
+    this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
+
+    // Scan the file, numbering the records in the order they are found
+    {
+      FileScan fscan(relationName, bufMgr);
+      RecordId scanRid;
+      while (fscan.tryScanNext(scanRid)) {
+        RecordView recordView = fscan.getRecordView();
+        const char *key = recordView.data + attrByteOffset;
+        this->bitmaps[keyBytes(key)].add(this->rowRids.size());
+        this->rowRids.push_back(scanRid);
+      }
+    }
+    save();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// BitmapIndex::~BitmapIndex -- destructor
+// -----------------------------------------------------------------------------
+
+BitmapIndex::~BitmapIndex() {
+  this->bufMgr->flushFile(this->file);
+  delete this->file;
+  this->file = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// BitmapIndex::keyBytes
+// -----------------------------------------------------------------------------
+
+std::string BitmapIndex::keyBytes(const void *key) const {
+  const char *bytes = (const char *)key;
+  switch (this->attributeType) {
+    case INTEGER:
+      return std::string(bytes, sizeof(int));
+    case DOUBLE:
+      return std::string(bytes, sizeof(double));
+    default:
+      return std::string(bytes, strnlen(bytes, STRINGSIZE));
+  }
+}
+
+// -----------------------------------------------------------------------------
+// BitmapIndex::save / load
+// -----------------------------------------------------------------------------
+
+void BitmapIndex::save() {
+  Page *metaPage;
+  this->bufMgr->readPage(this->file, this->headerPageNum, metaPage);
+  BitmapMetaInfo *metaInfo = (BitmapMetaInfo *)metaPage;
+  {
+    // Row mapping first, then <key length, key bytes, bitmap> for every key
+    BlobWriter writer(this->file, this->bufMgr, metaInfo->dataPageNo);
+    if (!this->rowRids.empty()) {
+      writer.write(&this->rowRids[0], this->rowRids.size() * sizeof(RecordId));
+    }
+    for (std::map<std::string, RowBitmap>::const_iterator it =
+             this->bitmaps.begin();
+         it != this->bitmaps.end(); ++it) {
+      writer.writeValue(std::uint32_t(it->first.size()));
+      writer.write(it->first.data(), it->first.size());
+      it->second.write(writer);
+    }
+    writer.close();
+    metaInfo->dataPageNo = writer.firstPageNo();
+  }
+  metaInfo->numRows = this->rowRids.size();
+  metaInfo->numKeys = this->bitmaps.size();
+  this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
+}
+
+void BitmapIndex::load(const PageId dataPageNo, const std::uint32_t numRows,
+                       const std::uint32_t numKeys) {
+  BlobReader reader(this->file, this->bufMgr, dataPageNo);
+  this->rowRids.resize(numRows);
+  if (numRows > 0 &&
+      !reader.read(&this->rowRids[0], numRows * sizeof(RecordId))) {
+    this->rowRids.clear();
+    return;
+  }
+  std::string key;
+  for (std::uint32_t i = 0; i < numKeys; i++) {
+    std::uint32_t keyLength;
+    if (!reader.readValue(keyLength)) {
+      break;
+    }
+    key.resize(keyLength);
+    if (keyLength > 0 && !reader.read(&key[0], keyLength)) {
+      break;
+    }
+    if (!this->bitmaps[key].read(reader)) {
+      break;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// BitmapIndex::lookup
+// -----------------------------------------------------------------------------
+
+RowBitmap BitmapIndex::lookup(const void *key) const {
+  std::map<std::string, RowBitmap>::const_iterator it =
+      this->bitmaps.find(keyBytes(key));
+  if (it == this->bitmaps.end()) {
+    return RowBitmap();
+  }
+  return it->second;
+}
+
+RowBitmap BitmapIndex::lookupAny(const std::vector<const void *> &keys) const {
+  RowBitmap result;
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    result = result | lookup(keys[i]);
+  }
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// BitmapIndex::toRecordIds
+// -----------------------------------------------------------------------------
+
+void BitmapIndex::toRecordIds(const RowBitmap &rows,
+                              std::vector<RecordId> &outRids) const {
+  std::vector<std::uint32_t> rowNumbers;
+  rows.toRows(rowNumbers);
+  outRids.reserve(outRids.size() + rowNumbers.size());
+  for (std::size_t i = 0; i < rowNumbers.size(); i++) {
+    if (rowNumbers[i] < this->rowRids.size()) {
+      outRids.push_back(this->rowRids[rowNumbers[i]]);
+    }
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,210 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "row_bitmap.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief The meta page of a bitmap index file. It is always the first page of
+ * the file; the row mapping and the bitmaps follow as a blob stream.
+ */
+struct BitmapMetaInfo {
+  /**
+   * Name of base relation.
+   */
+  char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored
+   * in pages.
+   */
+  int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+  Datatype attrType;
+
+  /**
+   * Number of rows (records) of the relation when the index was written.
+   */
+  std::uint32_t numRows;
+
+  /**
+   * Number of distinct keys stored in the index.
+   */
+  std::uint32_t numKeys;
+
+  /**
+   * First page of the blob stream holding the row mapping and the bitmaps.
+   */
+  PageId dataPageNo;
+
+  /**
+   * Version of the relation file the index was built from.
+   */
+  std::uint32_t relationVersion;
+};
+
+/**
+ * @brief BitmapIndex class. It implements a bitmap index over an attribute of a
+ * relation, meant for attributes with few distinct values where a BTreeIndex
+ * would hold a long list of record ids per key.
+ *
+ * Records are numbered densely in the order of the relation, and every
+ * distinct key maps to a compressed bitmap (RowBitmap) of the rows having it.
+ * Predicates on one or several bitmap indexes over the same relation are
+ * combined with the boolean operations of RowBitmap, and only the final
+ * bitmap is translated back to record ids.
+ *
+ * Like BTreeIndex, string keys are the first STRINGSIZE characters of the
+ * attribute.
+ *
+ * The index is not maintained: it describes the relation as it was when the
+ * index was built, and refuses to open once the relation changed.
+ */
+class BitmapIndex {
+ public:
+  /**
+   * BitmapIndex Constructor.
+   * Check to see if the corresponding index file exists. If so, open the file
+   * and load the bitmaps from it. If not, create it and insert entries for
+   * every tuple in the base relation using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn            Buffer Manager Instance
+   * @param attrByteOffset      Offset of attribute, over which index is to be
+   * built, in the record
+   * @param attrType            Datatype of attribute over which index is built
+   * @throws  BadIndexInfoException     If the index file already exists for
+   * the corresponding attribute, but values in metapage do not match with
+   * values received through constructor parameters, or the relation was
+   * written since the index was built.
+   */
+  BitmapIndex(const std::string &relationName, std::string &outIndexName,
+              BufMgr *bufMgrIn, const int attrByteOffset,
+              const Datatype attrType);
+
+  /**
+   * BitmapIndex Destructor.
+   * Flushes and closes the index file.
+   */
+  ~BitmapIndex();
+
+  /**
+   * Returns the bitmap of the rows whose attribute equals <key>.
+   *
+   * @param key   Pointer to the key: int, double or char string.
+   * @return  Bitmap of the matching rows, empty if the key is not present.
+   */
+  RowBitmap lookup(const void *key) const;
+
+  /**
+   * Returns the bitmap of the rows whose attribute equals any of <keys>.
+   *
+   * @param keys  Pointers to the keys.
+   */
+  RowBitmap lookupAny(const std::vector<const void *> &keys) const;
+
+  /**
+   * Returns the bitmap of all the rows of the relation, used to negate a
+   * predicate.
+   */
+  RowBitmap allRows() const { return RowBitmap::range(numRows()); }
+
+  /**
+   * Translates a bitmap of rows into the record ids of the rows, in the order
+   * of the relation.
+   *
+   * @param rows      Bitmap of rows.
+   * @param outRids   RecordIds are appended to this vector.
+   */
+  void toRecordIds(const RowBitmap &rows, std::vector<RecordId> &outRids) const;
+
+  /**
+   * Returns the number of rows indexed.
+   */
+  std::uint32_t numRows() const { return rowRids.size(); }
+
+  /**
+   * Returns the number of distinct keys in the index.
+   */
+  std::uint32_t numKeys() const { return bitmaps.size(); }
+
+ private:
+  /**
+   * File object for the index file.
+   */
+  File *file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+  BufMgr *bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+  PageId headerPageNum;
+
+  /**
+   * Offset of attribute, over which index is built, inside records.
+   */
+  int attrByteOffset;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+  Datatype attributeType;
+
+  /**
+   * RecordId of every row, indexed by row number.
+   */
+  std::vector<RecordId> rowRids;
+
+  /**
+   * Bitmap of every distinct key, keyed by the raw bytes of the key.
+   */
+  std::map<std::string, RowBitmap> bitmaps;
+
+  /**
+   * Returns the raw bytes of a key used to find its bitmap.
+   */
+  std::string keyBytes(const void *key) const;
+
+  /**
+   * Writes the row mapping and the bitmaps to the index file.
+   */
+  void save();
+
+  /**
+   * Loads the row mapping and the bitmaps from the index file.
+   * @param dataPageNo    First page of the saved data.
+   * @param numRows       Number of rows saved.
+   * @param numKeys       Number of bitmaps saved.
+   */
+  void load(const PageId dataPageNo, const std::uint32_t numRows,
+            const std::uint32_t numKeys);
+};
+
+}  // namespace badgerdb
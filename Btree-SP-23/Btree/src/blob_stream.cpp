@@ -0,0 +1,166 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "blob_stream.h"
+
+#include <string.h>
+
+namespace badgerdb {
+
+// -----------------------------------------------------------------------------
+// BlobWriter
+// -----------------------------------------------------------------------------
+
+BlobWriter::BlobWriter(File *file, BufMgr *bufMgr, const PageId firstPageNo)
+    : file_(file),
+      bufMgr_(bufMgr),
+      firstPageNo_(firstPageNo),
+      currentPageNo_(firstPageNo),
+      currentPage_(NULL) {
+  if (firstPageNo_ == Page::INVALID_NUMBER) {
+    bufMgr_->allocPage(file_, currentPageNo_, currentPage_);
+    firstPageNo_ = currentPageNo_;
+    BlobPageHeader *header = (BlobPageHeader *)currentPage_;
+    header->nextPageNo = Page::INVALID_NUMBER;
+  } else {
+    bufMgr_->readPage(file_, currentPageNo_, currentPage_);
+  }
+  ((BlobPageHeader *)currentPage_)->length = 0;
+}
+
+BlobWriter::~BlobWriter() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void BlobWriter::nextPage() {
+  BlobPageHeader *header = (BlobPageHeader *)currentPage_;
+  PageId nextPageNo = header->nextPageNo;
+  Page *nextPage;
+  if (nextPageNo == Page::INVALID_NUMBER) {
+    bufMgr_->allocPage(file_, nextPageNo, nextPage);
+    ((BlobPageHeader *)nextPage)->nextPageNo = Page::INVALID_NUMBER;
+    header->nextPageNo = nextPageNo;
+  } else {
+    bufMgr_->readPage(file_, nextPageNo, nextPage);
+  }
+  ((BlobPageHeader *)nextPage)->length = 0;
+  bufMgr_->unPinPage(file_, currentPageNo_, true);
+  currentPageNo_ = nextPageNo;
+  currentPage_ = nextPage;
+}
+
+void BlobWriter::write(const void *data, const std::size_t length) {
+  const char *src = (const char *)data;
+  std::size_t remaining = length;
+  while (remaining > 0) {
+    BlobPageHeader *header = (BlobPageHeader *)currentPage_;
+    if (header->length == BLOBPAGEDATASIZE) {
+      nextPage();
+      header = (BlobPageHeader *)currentPage_;
+    }
+    std::size_t chunk = BLOBPAGEDATASIZE - header->length;
+    if (chunk > remaining) {
+      chunk = remaining;
+    }
+    char *dest = (char *)currentPage_ + sizeof(BlobPageHeader) + header->length;
+    memcpy(dest, src, chunk);
+    header->length += chunk;
+    src += chunk;
+    remaining -= chunk;
+  }
+}
+
+void BlobWriter::close() {
+  if (currentPage_ == NULL) {
+    return;
+  }
+  const BlobPageHeader *header = (const BlobPageHeader *)currentPage_;
+  const PageId sparePageNo = header->nextPageNo;
+  const bool full = header->length == BLOBPAGEDATASIZE;
+  bufMgr_->unPinPage(file_, currentPageNo_, true);
+  currentPage_ = NULL;
+  if (full && sparePageNo != Page::INVALID_NUMBER) {
+    // A full last page is followed by an empty one for readers to stop at
+    Page *sparePage;
+    bufMgr_->readPage(file_, sparePageNo, sparePage);
+    ((BlobPageHeader *)sparePage)->length = 0;
+    bufMgr_->unPinPage(file_, sparePageNo, true);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// BlobReader
+// -----------------------------------------------------------------------------
+
+BlobReader::BlobReader(File *file, BufMgr *bufMgr, const PageId firstPageNo)
+    : file_(file),
+      bufMgr_(bufMgr),
+      currentPageNo_(firstPageNo),
+      currentPage_(NULL),
+      offset_(0) {
+  if (currentPageNo_ != Page::INVALID_NUMBER) {
+    bufMgr_->readPage(file_, currentPageNo_, currentPage_);
+  }
+}
+
+BlobReader::~BlobReader() {
+  if (currentPage_ != NULL) {
+    try {
+      bufMgr_->unPinPage(file_, currentPageNo_, false);
+    } catch (...) {
+    }
+  }
+}
+
+bool BlobReader::read(void *out, const std::size_t length) {
+  return consume((char *)out, length);
+}
+
+bool BlobReader::consume(char *dest, const std::size_t length) {
+  std::size_t remaining = length;
+  while (remaining > 0) {
+    if (currentPage_ == NULL) {
+      return false;
+    }
+    const BlobPageHeader *header = (const BlobPageHeader *)currentPage_;
+    if (offset_ == header->length) {
+      // Current page is exhausted, move on to the next one unless it ended
+      // the stream
+      const PageId nextPageNo = header->length < BLOBPAGEDATASIZE
+                                    ? Page::INVALID_NUMBER
+                                    : header->nextPageNo;
+      bufMgr_->unPinPage(file_, currentPageNo_, false);
+      currentPage_ = NULL;
+      currentPageNo_ = nextPageNo;
+      offset_ = 0;
+      if (currentPageNo_ == Page::INVALID_NUMBER) {
+        return false;
+      }
+      bufMgr_->readPage(file_, currentPageNo_, currentPage_);
+      continue;
+    }
+    std::size_t chunk = header->length - offset_;
+    if (chunk > remaining) {
+      chunk = remaining;
+    }
+    if (dest != NULL) {
+      memcpy(dest,
+             (const char *)currentPage_ + sizeof(BlobPageHeader) + offset_,
+             chunk);
+      dest += chunk;
+    }
+    offset_ += chunk;
+    remaining -= chunk;
+  }
+  return true;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,176 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Header stored at the start of every page of a blob stream. Streams
+ * are kept as a singly linked chain of pages of a BlobFile; the rest of the
+ * page holds <length> bytes of payload. Every page but the last one of a
+ * stream is full, so the first page which isn't ends it; a rewritten chain
+ * can go on past it with spare pages.
+ */
+struct BlobPageHeader {
+  /**
+   * Page number of the next page of the stream, Page::INVALID_NUMBER if this
+   * is the last one.
+   */
+  PageId nextPageNo;
+
+  /**
+   * Number of payload bytes used in this page.
+   */
+  std::uint32_t length;
+};
+
+/**
+ * @brief Number of payload bytes held by one page of a blob stream.
+ */
+const std::size_t BLOBPAGEDATASIZE = Page::SIZE - sizeof(BlobPageHeader);
+
+/**
+ * @brief Writes an arbitrary byte stream into a chain of pages of a file
+ * through the buffer manager. Used by the in-memory access methods to persist
+ * themselves into their index file.
+ *
+ * If the writer is given the first page of an existing chain, the pages of
+ * that chain are overwritten and reused before any new page is allocated, so
+ * rewriting a stream no longer than any before it does not grow the file.
+ */
+class BlobWriter {
+ public:
+  /**
+   * Constructs a writer.
+   *
+   * @param file          File the stream is written to.
+   * @param bufMgr        Buffer manager instance.
+   * @param firstPageNo   First page of an existing chain to overwrite, or
+   *                      Page::INVALID_NUMBER to start a new chain.
+   */
+  BlobWriter(File *file, BufMgr *bufMgr,
+             const PageId firstPageNo = Page::INVALID_NUMBER);
+
+  /**
+   * Closes the writer if it hasn't been closed already.
+   */
+  ~BlobWriter();
+
+  /**
+   * Appends bytes to the stream.
+   *
+   * @param data    Bytes to append.
+   * @param length  Number of bytes to append.
+   */
+  void write(const void *data, const std::size_t length);
+
+  /**
+   * Appends the raw bytes of a fixed-size value to the stream.
+   *
+   * @param value   Value to append.
+   */
+  template <class T>
+  void writeValue(const T &value) {
+    write(&value, sizeof(T));
+  }
+
+  /**
+   * Ends the stream at the current page and unpins it. Pages of a reused
+   * chain which are past the end of the new stream stay linked behind it as
+   * spare pages, BlobFile pages not being deletable, for the next rewrite.
+   */
+  void close();
+
+  /**
+   * Returns the page number of the first page of the stream.
+   */
+  PageId firstPageNo() const { return firstPageNo_; }
+
+ private:
+  /**
+   * Moves on to the next page of the chain, reusing it if one exists.
+   */
+  void nextPage();
+
+  File *file_;
+  BufMgr *bufMgr_;
+  PageId firstPageNo_;
+  PageId currentPageNo_;
+  Page *currentPage_;
+};
+
+/**
+ * @brief Reads back a byte stream written by BlobWriter.
+ */
+class BlobReader {
+ public:
+  /**
+   * Constructs a reader positioned at the start of the stream.
+   *
+   * @param file          File the stream is stored in.
+   * @param bufMgr        Buffer manager instance.
+   * @param firstPageNo   First page of the stream.
+   */
+  BlobReader(File *file, BufMgr *bufMgr, const PageId firstPageNo);
+
+  /**
+   * Unpins the current page of the stream, if any.
+   */
+  ~BlobReader();
+
+  /**
+   * Reads bytes from the stream.
+   *
+   * @param out     Buffer receiving the bytes.
+   * @param length  Number of bytes to read.
+   * @return  False if the stream ended before <length> bytes could be read.
+   */
+  bool read(void *out, const std::size_t length);
+
+  /**
+   * Reads the raw bytes of a fixed-size value from the stream.
+   *
+   * @param value   Value receiving the bytes.
+   * @return  False if the stream ended before the value could be read.
+   */
+  template <class T>
+  bool readValue(T &value) {
+    return read(&value, sizeof(T));
+  }
+
+  /**
+   * Moves forward in the stream without copying the bytes passed over.
+   *
+   * @param length  Number of bytes to skip.
+   * @return  False if the stream ended before <length> bytes were skipped.
+   */
+  bool skip(const std::size_t length) { return consume(NULL, length); }
+
+ private:
+  /**
+   * Reads bytes from the stream into <dest>, or drops them if <dest> is NULL.
+   */
+  bool consume(char *dest, const std::size_t length);
+
+  File *file_;
+  BufMgr *bufMgr_;
+  PageId currentPageNo_;
+  Page *currentPage_;
+  std::size_t offset_;
+};
+
+}  // namespace badgerdb
@@ -9,11 +9,19 @@
 #include "btree.h"
 
 #include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include <algorithm>
 #include <deque>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "exceptions/bad_index_info_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
@@ -22,7 +30,12 @@
 #include "exceptions/index_scan_completed_exception.h"
 #include "exceptions/no_such_key_found_exception.h"
 #include "exceptions/scan_not_initialized_exception.h"
+#include "blob_stream.h"
+#include "columnar.h"
 #include "filescan.h"
+#include "fixed_page.h"
+#include "latched_buffer.h"
+#include "pax_page.h"
 
 // #define DEBUG
 
@@ -36,11 +49,14 @@ const bool fileExists(const std::string &fileName) {
 }
 
 /**
- * Sets up the leaf node occupancy data member of the class based on the data type
+ * Sets up the leaf node occupancy data member of the class based on the data
+ * type and the key encoding
  * @param attrType        Data Type of the attribute
  * */
 void BTreeIndex::setLeafOccupancy(const Datatype attrType) {
-  if (attrType == Datatype::INTEGER) {
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    this->leafOccupancy = NORMALIZEDARRAYLEAFSIZE;
+  } else if (attrType == Datatype::INTEGER) {
     this->leafOccupancy = INTARRAYLEAFSIZE;
   } else if (attrType == Datatype::DOUBLE) {
     this->leafOccupancy = DOUBLEARRAYLEAFSIZE;
@@ -50,11 +66,14 @@ void BTreeIndex::setLeafOccupancy(const Datatype attrType) {
 }
 
 /**
- * Sets up the non leaf node occupancy data member of the class based on the data type
+ * Sets up the non leaf node occupancy data member of the class based on the
+ * data type and the key encoding
  * @param attrType        Data Type of the attribute
  * */
 void BTreeIndex::setNodeOccupancy(const Datatype attrType) {
-  if (attrType == Datatype::INTEGER) {
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    this->nodeOccupancy = NORMALIZEDARRAYNONLEAFSIZE;
+  } else if (attrType == Datatype::INTEGER) {
     this->nodeOccupancy = INTARRAYNONLEAFSIZE;
   } else if (attrType == Datatype::DOUBLE) {
     this->nodeOccupancy = DOUBLEARRAYNONLEAFSIZE;
@@ -63,127 +82,556 @@ void BTreeIndex::setNodeOccupancy(const Datatype attrType) {
   }
 }
 
+// -----------------------------------------------------------------------------
+// IndexKey
+// -----------------------------------------------------------------------------
+
+static const std::uint32_t INT_SIGN_BIT = 0x80000000u;
+static const std::uint64_t DOUBLE_SIGN_BIT = 0x8000000000000000ull;
+
+static void storeBigEndian(unsigned char *bytes, std::uint64_t value,
+                           const int length) {
+  for (int i = length - 1; i >= 0; i--) {
+    bytes[i] = (unsigned char)value;
+    value >>= 8;
+  }
+}
+
+static std::uint64_t loadBigEndian(const unsigned char *bytes,
+                                   const int length) {
+  std::uint64_t value = 0;
+  for (int i = 0; i < length; i++) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+IndexKey IndexKey::fromInt(const int key) {
+  IndexKey indexKey;
+  indexKey.length_ = sizeof(std::uint32_t);
+  storeBigEndian(indexKey.bytes_, (std::uint32_t)key ^ INT_SIGN_BIT,
+                 indexKey.length_);
+  return indexKey;
+}
+
+IndexKey IndexKey::fromDouble(const double key) {
+  // -0.0 and 0.0 are equal keys
+  const double value = key == 0 ? 0.0 : key;
+  std::uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bits = (bits & DOUBLE_SIGN_BIT) ? ~bits : bits | DOUBLE_SIGN_BIT;
+  IndexKey indexKey;
+  indexKey.length_ = sizeof(std::uint64_t);
+  storeBigEndian(indexKey.bytes_, bits, indexKey.length_);
+  return indexKey;
+}
+
+IndexKey IndexKey::fromString(const char *key) {
+  IndexKey indexKey;
+  indexKey.length_ = strnlen(key, STRINGSIZE);
+  memcpy(indexKey.bytes_, key, indexKey.length_);
+  return indexKey;
+}
+
+IndexKey IndexKey::fromValue(const Datatype type, const void *key) {
+  if (type == Datatype::INTEGER) {
+    int value;
+    memcpy(&value, key, sizeof(int));
+    return fromInt(value);
+  } else if (type == Datatype::DOUBLE) {
+    double value;
+    memcpy(&value, key, sizeof(double));
+    return fromDouble(value);
+  }
+  return fromString((const char *)key);
+}
+
+IndexKey IndexKey::fromBytes(const unsigned char (&bytes)[MAX_LENGTH]) {
+  IndexKey indexKey;
+  indexKey.length_ = MAX_LENGTH;
+  memcpy(indexKey.bytes_, bytes, MAX_LENGTH);
+  return indexKey;
+}
+
+int IndexKey::toInt() const {
+  return (int)((std::uint32_t)loadBigEndian(bytes_, sizeof(std::uint32_t)) ^
+               INT_SIGN_BIT);
+}
+
+double IndexKey::toDouble() const {
+  std::uint64_t bits = loadBigEndian(bytes_, sizeof(std::uint64_t));
+  bits = (bits & DOUBLE_SIGN_BIT) ? bits & ~DOUBLE_SIGN_BIT : ~bits;
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void IndexKey::toString(char (&out)[STRINGSIZE]) const {
+  // Bytes past the end of the string are the padding
+  memcpy(out, bytes_, STRINGSIZE);
+}
+
+/**
+ * Returns the key held in a key slot of a node.
+ */
+static inline IndexKey nodeKey(const int &slot) {
+  return IndexKey::fromInt(slot);
+}
+
+static inline IndexKey nodeKey(const double &slot) {
+  return IndexKey::fromDouble(slot);
+}
+
+static inline IndexKey nodeKey(const char (&slot)[STRINGSIZE]) {
+  return IndexKey::fromString(slot);
+}
+
+static inline IndexKey nodeKey(const NormalizedKey &slot) {
+  return IndexKey::fromBytes(slot.bytes);
+}
+
+/**
+ * Copies a key into a key slot of a node.
+ */
+static inline void setNodeKey(int &slot, const IndexKey &key) {
+  slot = key.toInt();
+}
+
+static inline void setNodeKey(double &slot, const IndexKey &key) {
+  slot = key.toDouble();
+}
+
+static inline void setNodeKey(char (&slot)[STRINGSIZE], const IndexKey &key) {
+  key.toString(slot);
+}
+
+static inline void setNodeKey(NormalizedKey &slot, const IndexKey &key) {
+  memcpy(slot.bytes, key.data(), IndexKey::MAX_LENGTH);
+}
+
+/**
+ * Recomputes the heads of the keys of a node from index <first> on, after its
+ * keys changed. Leaves of NATIVE_KEYS and INTEGER non leaf nodes have no
+ * heads.
+ */
+template <class Node>
+static inline void refreshHeads(Node *node, const int first) {}
+
+template <class Node>
+static void refreshHeadArray(Node *node, const int first) {
+  for (int i = first; i < node->len; i++) {
+    node->headArray[i] = nodeKey(node->keyArray[i]).head();
+  }
+}
+
+static inline void refreshHeads(LeafNodeNormalized *node, const int first) {
+  refreshHeadArray(node, first);
+}
+
+static inline void refreshHeads(NonLeafNodeNormalized *node, const int first) {
+  refreshHeadArray(node, first);
+}
+
+static inline void refreshHeads(NonLeafNodeDouble *node, const int first) {
+  refreshHeadArray(node, first);
+}
+
+static inline void refreshHeads(NonLeafNodeString *node, const int first) {
+  refreshHeadArray(node, first);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::bulkLoad
+// -----------------------------------------------------------------------------
+
+/**
+ * Number of entries below which sortEntries sorts on the calling thread.
+ */
+static const std::size_t PARALLEL_SORT_MIN_ENTRIES = 1 << 16;
+
+void BTreeIndex::sortEntries(std::vector<RIDKeyPair<IndexKey> > &entries,
+                             WorkStealingPool &pool,
+                             const TaskPriority priority) {
+  const std::size_t chunks = pool.numThreads();
+  if (entries.size() < PARALLEL_SORT_MIN_ENTRIES || chunks < 2) {
+    std::sort(entries.begin(), entries.end());
+    return;
+  }
+  const std::vector<RIDKeyPair<IndexKey> >::iterator begin = entries.begin();
+  std::vector<std::size_t> bounds;
+  for (std::size_t i = 0; i <= chunks; i++) {
+    bounds.push_back(entries.size() * i / chunks);
+  }
+  TaskGroup group(pool);
+  for (std::size_t i = 0; i < chunks; i++) {
+    group.submit([&, i]() {
+      std::sort(begin + bounds[i], begin + bounds[i + 1]);
+    }, priority);
+  }
+  group.wait();
+  // Merge neighbouring runs, the merges of a round in parallel
+  for (std::size_t width = 1; width < chunks; width *= 2) {
+    for (std::size_t i = 0; i + width < chunks; i += 2 * width) {
+      const std::size_t last = std::min(i + 2 * width, chunks);
+      group.submit([&, i, width, last]() {
+        std::inplace_merge(begin + bounds[i], begin + bounds[i + width],
+                           begin + bounds[last]);
+      }, priority);
+    }
+    group.wait();
+  }
+}
+
+template <class LeafNode, class NonLeafNode>
+void BTreeIndex::bulkLoad(std::vector<RIDKeyPair<IndexKey> > &entries,
+                          const double fillFactor) {
+  if (entries.empty()) {
+    return;
+  }
+  // Relations are often loaded in key order
+  if (!std::is_sorted(entries.begin(), entries.end())) {
+    BTreeIndex::sortEntries(entries, WorkStealingPool::shared());
+  }
+
+  // Fill the leaves, the first one being the existing (empty) root page
+  const double fill = std::min(std::max(fillFactor, 0.0), 1.0);
+  const std::size_t leafFill =
+      std::max<std::size_t>(1, fill * this->leafOccupancy);
+  const std::size_t numLeaves = (entries.size() + leafFill - 1) / leafFill;
+  std::vector<PageKeyPair<IndexKey> > level(numLeaves);
+  std::size_t next = 0;
+  PageId pageNo = this->rootPageNum;
+  Page *page;
+  this->bufMgr->readPage(this->file, pageNo, page);
+  for (std::size_t l = 0; l < numLeaves; l++) {
+    // Spread the remaining entries evenly over the remaining leaves
+    const std::size_t remainingLeaves = numLeaves - l;
+    const std::size_t count =
+        (entries.size() - next + remainingLeaves - 1) / remainingLeaves;
+    LeafNode *leafNode = (LeafNode *)page;
+    leafNode->len = count;
+    for (std::size_t k = 0; k < count; k++) {
+      setNodeKey(leafNode->keyArray[k], entries[next + k].key);
+      leafNode->ridArray[k] = entries[next + k].rid;
+    }
+    refreshHeads(leafNode, 0);
+    level[l].pageNo = pageNo;
+    level[l].key = entries[next].key;
+    next += count;
+    if (l + 1 < numLeaves) {
+      PageId nextPageNo;
+      Page *nextPage;
+      this->bufMgr->allocPage(this->file, nextPageNo, nextPage);
+      leafNode->rightSibPageNo = nextPageNo;
+      this->bufMgr->unPinPage(this->file, pageNo, true);
+      pageNo = nextPageNo;
+      page = nextPage;
+    } else {
+      leafNode->rightSibPageNo = INVALID_PAGE;
+      this->bufMgr->unPinPage(this->file, pageNo, true);
+    }
+  }
+  if (numLeaves == 1) {
+    this->isRootLeaf = true;
+    return;
+  }
+
+  // Build the non leaf levels. Separator keys are the first key of the right
+  // child, as in the split convention used by insertEntry
+  int nodeLevel = 1;  // Nodes just above the leaves
+  const std::size_t fanout =
+      std::max<std::size_t>(2, fill * (this->nodeOccupancy + 1));
+  while (level.size() > 1) {
+    const std::size_t numNodes = (level.size() + fanout - 1) / fanout;
+    std::vector<PageKeyPair<IndexKey> > parents(numNodes);
+    std::size_t child = 0;
+    for (std::size_t n = 0; n < numNodes; n++) {
+      const std::size_t remainingNodes = numNodes - n;
+      const std::size_t count =
+          (level.size() - child + remainingNodes - 1) / remainingNodes;
+      PageId nodePageNo;
+      Page *nodePage;
+      this->bufMgr->allocPage(this->file, nodePageNo, nodePage);
+      NonLeafNode *nonLeafNode = (NonLeafNode *)nodePage;
+      nonLeafNode->level = nodeLevel;
+      nonLeafNode->len = count - 1;
+      nonLeafNode->pageNoArray[0] = level[child].pageNo;
+      for (std::size_t k = 1; k < count; k++) {
+        setNodeKey(nonLeafNode->keyArray[k - 1], level[child + k].key);
+        nonLeafNode->pageNoArray[k] = level[child + k].pageNo;
+      }
+      refreshHeads(nonLeafNode, 0);
+      parents[n].pageNo = nodePageNo;
+      parents[n].key = level[child].key;
+      child += count;
+      this->bufMgr->unPinPage(this->file, nodePageNo, true);
+    }
+    level.swap(parents);
+    nodeLevel = 0;
+  }
+  this->rootPageNum = level[0].pageNo;
+  this->isRootLeaf = false;
+}
+
 BTreeIndex::BTreeIndex(const std::string &relationName,
                        std::string &outIndexName, BufMgr *bufMgrIn,
-                       const int attrByteOffset, const Datatype attrType) {
+                       const int attrByteOffset, const Datatype attrType,
+                       const RelationFormat format,
+                       const KeyEncoding keyEncoding,
+                       const IndexStorage storage, const double fillFactor) {
   // Create index file name
   std::ostringstream idxStr;
   idxStr << relationName << "." << attrByteOffset;
   outIndexName = idxStr.str();
 
+  this->setUp(bufMgrIn, attrByteOffset, attrType, keyEncoding, storage);
+  if (this->openIndex(outIndexName, relationName)) {
+    return;
+  }
+  std::vector<RIDKeyPair<IndexKey> > entries;
+  scanRelation(relationName, bufMgrIn, attrByteOffset, attrType, format,
+               entries);
+  this->createIndex(outIndexName, relationName, entries, fillFactor);
+}
+
+BTreeIndex::BTreeIndex(const std::string &relationName,
+                       const std::string &indexName, BufMgr *bufMgrIn,
+                       const int attrByteOffset, const Datatype attrType,
+                       std::vector<RIDKeyPair<IndexKey> > &entries,
+                       const KeyEncoding keyEncoding,
+                       const IndexStorage storage, const double fillFactor) {
+  this->setUp(bufMgrIn, attrByteOffset, attrType, keyEncoding, storage);
+  if (!this->openIndex(indexName, relationName)) {
+    this->createIndex(indexName, relationName, entries, fillFactor);
+  }
+}
+
+void BTreeIndex::setUp(BufMgr *bufMgrIn, const int attrByteOffset,
+                       const Datatype attrType, const KeyEncoding keyEncoding,
+                       const IndexStorage storage) {
   // Initialize member variables
   this->attributeType = attrType;
   this->attrByteOffset = attrByteOffset;
+  this->keyEncoding = keyEncoding;
+  this->storage = storage;
   this->setLeafOccupancy(attrType);
   this->setNodeOccupancy(attrType);
   // Meta page is always the first page of the index file
   this->headerPageNum = 1;
   this->isRootLeaf = true;
   this->bufMgr = bufMgrIn;
-  this->scanExecuting = false;
-  this->nextEntry = INVALID_KEY_INDEX;
+  this->lastSnapshotId = 0;
+  this->committedTxn = 0;
+}
 
+bool BTreeIndex::openIndex(const std::string &indexName,
+                           const std::string &relationName) {
   try {
-    this->file = new BlobFile(outIndexName, false);
-    std::cout<<"Index already exists"<<std::endl;
+    this->file = new BlobFile(indexName, false);
+  } catch (FileNotFoundException e) {
+    return false;
+  }
+  std::cout<<"Index already exists"<<std::endl;
+  IndexMetaInfo metaInfo;
+  if (this->openCommitted(metaInfo)) {
+    this->storage = APPEND_ONLY_STORAGE;
+  } else {
     PageId metaPageId = this->headerPageNum;
     Page *metaPage;
     // Read the meta page
     this->bufMgr->readPage(this->file, metaPageId, metaPage);
+    metaInfo = *(IndexMetaInfo *)metaPage;
     // Unpin the page since the page won't be used for writing here after
     this->bufMgr->unPinPage(this->file, metaPageId, false);
-    // Cast meta page to IndexMetaInfo
-    IndexMetaInfo *indexMetaInfo = (IndexMetaInfo *)(metaPage);
-    // Since, this is the case where index file already exists
-    // read the isRootLeaf attribute value from the meta page and set it
-    this->isRootLeaf = indexMetaInfo->isRootLeaf;
-    // Set the root page id
-    this->rootPageNum = indexMetaInfo->rootPageNo;
-    // Values in metapage (relationName, attribute byte offset, attribute type
-    // etc.) must match
-    // Compare both the length and the characters comparison
-    bool relationNameMatch =
-        (strlen(indexMetaInfo->relationName) == relationName.size()) &&
-        !strcmp(indexMetaInfo->relationName, relationName.c_str());
-    bool attributeByteOffsetMatch =
-        indexMetaInfo->attrByteOffset == attrByteOffset;
-    bool attrTypeMatch = indexMetaInfo->attrType == attrType;
-    if (!(relationNameMatch && attributeByteOffsetMatch && attrTypeMatch)) {
-      throw BadIndexInfoException(
-          "Parameters passed while creating the index don't match");
+    if (metaInfo.storage == APPEND_ONLY_STORAGE) {
+      throw BadIndexInfoException("Neither meta page of the index is valid");
     }
-  } catch (FileNotFoundException e) {
-    // Create the blob file for the index
-    this->file = new BlobFile(outIndexName, true);
-    // Create pages for metadata and root (page 1 and 2 repectively)
-    PageId metaPageNo;
-    Page *metaPage;
-    PageId rootPageNo;
-    Page *rootPage;
-    // Allocate the page for metapage
-    this->bufMgr->allocPage(this->file, metaPageNo, metaPage);
-    this->headerPageNum = metaPageNo;
-    // Cast the metaPage into the IndexMetaInfo
-    IndexMetaInfo *indexMetaInfo = (IndexMetaInfo *)metaPage;
-    // Allocate the page for root node
-    this->bufMgr->allocPage(this->file, rootPageNo, rootPage);
-    this->rootPageNum = rootPageNo;
-    // Write meta data to the meta page
-    indexMetaInfo->isRootLeaf = this->isRootLeaf;
-    indexMetaInfo->attrType = attributeType;
-    indexMetaInfo->attrByteOffset = attrByteOffset;
-    strcpy((char *)(&indexMetaInfo->relationName), relationName.c_str());
-    indexMetaInfo->relationName[relationName.size()] = '\0';
-    indexMetaInfo->rootPageNo = rootPageNo;
-    // Meta page is modified now, we can unpin this page which will result in
-    // disk flushing
-    this->bufMgr->unPinPage(this->file, metaPageNo, true);
-    // Dont unpin root page since its useful for insert, scans operations.
-    // Unpin it in the destructor or when the root node changes
-    this->bufMgr->unPinPage(this->file, rootPageNo, true);
-
-    // Set root node members
-    // Root page is initially leaf node
-    // Cast root page to leaf node
-    if (this->attributeType == Datatype::INTEGER) {
-      LeafNodeInt *rootLeafNode = (LeafNodeInt *)rootPage;
-      rootLeafNode->len = 0;
-      rootLeafNode->rightSibPageNo = INVALID_PAGE;
-    } else if (this->attributeType == Datatype::DOUBLE) {
-      LeafNodeDouble *rootLeafNode = (LeafNodeDouble *)rootPage;
-      rootLeafNode->len = 0;
-      rootLeafNode->rightSibPageNo = INVALID_PAGE;
-    } else if (this->attributeType == Datatype::STRING) {
-      LeafNodeString *rootLeafNode = (LeafNodeString *)rootPage;
-      rootLeafNode->len = 0;
-      rootLeafNode->rightSibPageNo = INVALID_PAGE;
+    this->storage = IN_PLACE_STORAGE;
+    if (metaInfo.freeListPageNo != Page::INVALID_NUMBER) {
+      std::vector<FreedPage> freePages;
+      this->readFreeList(metaInfo.freeListPageNo, freePages);
+      for (std::size_t i = 0; i < freePages.size(); i++) {
+        this->freePages.push_back(freePages[i].pageNo);
+      }
     }
+  }
+  IndexMetaInfo *indexMetaInfo = &metaInfo;
+  // Since, this is the case where index file already exists
+  // read the isRootLeaf attribute value from the meta page and set it
+  this->isRootLeaf = indexMetaInfo->isRootLeaf;
+  // The index keeps the key encoding it was created with
+  this->keyEncoding = indexMetaInfo->keyEncoding;
+  this->setLeafOccupancy(this->attributeType);
+  this->setNodeOccupancy(this->attributeType);
+  // Set the root page id
+  this->rootPageNum = indexMetaInfo->rootPageNo;
+  // Values in metapage (relationName, attribute byte offset, attribute type
+  // etc.) must match
+  // Compare both the length and the characters comparison
+  bool relationNameMatch =
+      (strlen(indexMetaInfo->relationName) == relationName.size()) &&
+      !strcmp(indexMetaInfo->relationName, relationName.c_str());
+  bool attributeByteOffsetMatch =
+      indexMetaInfo->attrByteOffset == this->attrByteOffset;
+  bool attrTypeMatch = indexMetaInfo->attrType == this->attributeType;
+  if (!(relationNameMatch && attributeByteOffsetMatch && attrTypeMatch)) {
+    throw BadIndexInfoException(
+        "Parameters passed while creating the index don't match");
+  }
+  return true;
+}
 
-    // Scan the file and insert the records into the index
-    FileScan fscan(relationName, bufMgr);
+void BTreeIndex::createIndex(const std::string &indexName,
+                             const std::string &relationName,
+                             std::vector<RIDKeyPair<IndexKey> > &entries,
+                             const double fillFactor) {
+  // Create the blob file for the index
+  this->file = new BlobFile(indexName, true);
+  // Create pages for metadata and root (page 1 and 2 repectively)
+  PageId metaPageNo;
+  Page *metaPage;
+  PageId rootPageNo;
+  Page *rootPage;
+  // Allocate the page for metapage
+  this->bufMgr->allocPage(this->file, metaPageNo, metaPage);
+  this->headerPageNum = metaPageNo;
+  if (this->storage == APPEND_ONLY_STORAGE) {
+    // The commits write the two meta pages in turn, starting with the
+    // second one
+    PageId otherMetaPageNo;
+    Page *otherMetaPage;
+    this->bufMgr->allocPage(this->file, otherMetaPageNo, otherMetaPage);
+    this->bufMgr->unPinPage(this->file, otherMetaPageNo, true);
+  }
+  // Cast the metaPage into the IndexMetaInfo
+  IndexMetaInfo *indexMetaInfo = (IndexMetaInfo *)metaPage;
+  // Allocate the page for root node
+  this->bufMgr->allocPage(this->file, rootPageNo, rootPage);
+  this->rootPageNum = rootPageNo;
+  // Write meta data to the meta page
+  indexMetaInfo->isRootLeaf = this->isRootLeaf;
+  indexMetaInfo->keyEncoding = this->keyEncoding;
+  indexMetaInfo->attrType = this->attributeType;
+  indexMetaInfo->attrByteOffset = this->attrByteOffset;
+  strcpy((char *)(&indexMetaInfo->relationName), relationName.c_str());
+  indexMetaInfo->relationName[relationName.size()] = '\0';
+  indexMetaInfo->rootPageNo = rootPageNo;
+  indexMetaInfo->storage = this->storage;
+  indexMetaInfo->txnId = 0;
+  indexMetaInfo->freeListPageNo = Page::INVALID_NUMBER;
+  indexMetaInfo->checksum = 0;
+  // Meta page is modified now, we can unpin this page which will result in
+  // disk flushing
+  this->bufMgr->unPinPage(this->file, metaPageNo, true);
+  // Dont unpin root page since its useful for insert, scans operations.
+  // Unpin it in the destructor or when the root node changes
+  this->bufMgr->unPinPage(this->file, rootPageNo, true);
+
+  // Set root node members
+  // Root page is initially leaf node
+  // Cast root page to leaf node
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    LeafNodeNormalized *rootLeafNode = (LeafNodeNormalized *)rootPage;
+    rootLeafNode->len = 0;
+    rootLeafNode->rightSibPageNo = INVALID_PAGE;
+  } else if (this->attributeType == Datatype::INTEGER) {
+    LeafNodeInt *rootLeafNode = (LeafNodeInt *)rootPage;
+    rootLeafNode->len = 0;
+    rootLeafNode->rightSibPageNo = INVALID_PAGE;
+  } else if (this->attributeType == Datatype::DOUBLE) {
+    LeafNodeDouble *rootLeafNode = (LeafNodeDouble *)rootPage;
+    rootLeafNode->len = 0;
+    rootLeafNode->rightSibPageNo = INVALID_PAGE;
+  } else if (this->attributeType == Datatype::STRING) {
+    LeafNodeString *rootLeafNode = (LeafNodeString *)rootPage;
+    rootLeafNode->len = 0;
+    rootLeafNode->rightSibPageNo = INVALID_PAGE;
+  }
+
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    this->bulkLoad<LeafNodeNormalized, NonLeafNodeNormalized>(entries,
+                                                               fillFactor);
+  } else if (this->attributeType == Datatype::INTEGER) {
+    this->bulkLoad<LeafNodeInt, NonLeafNodeInt>(entries, fillFactor);
+  } else if (this->attributeType == Datatype::DOUBLE) {
+    this->bulkLoad<LeafNodeDouble, NonLeafNodeDouble>(entries, fillFactor);
+  } else if (this->attributeType == Datatype::STRING) {
+    this->bulkLoad<LeafNodeString, NonLeafNodeString>(entries, fillFactor);
+  }
+  if (this->storage == APPEND_ONLY_STORAGE) {
+    this->commit();
+  }
+}
+
+void BTreeIndex::scanRelation(const std::string &relationName,
+                              BufMgr *bufMgr, const int attrByteOffset,
+                              const Datatype attrType,
+                              const RelationFormat format,
+                              std::vector<RIDKeyPair<IndexKey> > &entries) {
+  // Scan the file and collect the entries of all the records
+  auto addEntry = [&](const RecordId &rid, const char *key) {
+    // STRING keys are only the first 10 characters of the record's value
+    RIDKeyPair<IndexKey> entry;
+    entry.set(rid, IndexKey::fromValue(attrType, key));
+    entries.push_back(entry);
+  };
+  if (format == PAX_RELATION) {
+    // Read the key column of every page, the other attributes are not
+    // touched
+    PaxFileScan pscan(relationName, bufMgr);
+    while (pscan.nextPage()) {
+      const PaxPage page = pscan.currentPage();
+      const int attribute = page.findAttribute(attrByteOffset);
+      if (attribute < 0) {
+        throw BadIndexInfoException(
+            "Attribute is not stored in the PAX relation");
+      }
+      const char *key = page.column(attribute);
+      const std::size_t keySize = page.attributeSize(attribute);
+      for (SlotId slot = 1; slot <= page.numRecords(); slot++) {
+        RecordId rid = {pscan.currentPageNo(), slot};
+        addEntry(rid, key);
+        key += keySize;
+      }
+    }
+  } else if (format == COLUMNAR_RELATION) {
+    // Only the key column chunks are read and decoded
+    int column;
+    {
+      const ColumnarRelation relation(relationName, bufMgr);
+      column = relation.findColumn(attrByteOffset);
+    }
+    if (column < 0) {
+      throw BadIndexInfoException(
+          "Attribute is not stored in the columnar relation");
+    }
+    ColumnarScan cscan(relationName, bufMgr, std::vector<int>(1, column));
+    try {
+      RecordId scanRid;
+      while (true) {
+        cscan.scanNext(scanRid);
+        addEntry(scanRid, cscan.getValue(column));
+      }
+    } catch (const EndOfFileException &e) {
+    }
+  } else if (format == FIXED_RELATION) {
+    FixedFileScan fscan(relationName, bufMgr);
     try {
       RecordId scanRid;
       while (true) {
         fscan.scanNext(scanRid);
-        std::string recordStr = fscan.getRecord();
-        const char *record = recordStr.c_str();
-        if (this->attributeType == Datatype::INTEGER) {
-          int *key = ((int *)(record + attrByteOffset));
-          this->insertEntry((void *)key, scanRid);
-        } else if (this->attributeType == Datatype::DOUBLE) {
-          double *key = ((double *)(record + attrByteOffset));
-          this->insertEntry((void *)key, scanRid);
-        } else if (this->attributeType == Datatype::STRING) {
-          const char *key = ((char *)(record + attrByteOffset));
-          std::string key_str(key);
-          // Key is only first 10 characters of the record's string value
-          std::string actualIndexKeyValue = key_str.substr(0, STRINGSIZE);
-          this->insertEntry((void *)&actualIndexKeyValue, scanRid);
-        }
+        addEntry(scanRid, fscan.getRecordView().data + attrByteOffset);
       }
-    } catch (EndOfFileException e) {
-      std::cout << "Read all records" << std::endl;
+    } catch (const EndOfFileException &e) {
+    }
+  } else {
+    FileScan fscan(relationName, bufMgr);
+    RecordId scanRid;
+    while (fscan.tryScanNext(scanRid)) {
+      RecordView recordView = fscan.getRecordView();
+      addEntry(scanRid, recordView.data + attrByteOffset);
     }
+    std::cout << "Read all records" << std::endl;
   }
 }
 
@@ -192,1257 +640,1488 @@ BTreeIndex::BTreeIndex(const std::string &relationName,
 // -----------------------------------------------------------------------------
 
 BTreeIndex::~BTreeIndex() {
-  // Clear up state variables
-  Page* metaPage;
-  // Read meta page
-  this->bufMgr->readPage(this->file, this->headerPageNum, metaPage);
-  // Set the metadata in the metapage
-  IndexMetaInfo *indexMetaInfo = (IndexMetaInfo *)metaPage;
-  indexMetaInfo->rootPageNo = this->rootPageNum;
-  indexMetaInfo->isRootLeaf = this->isRootLeaf;
-  this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
-  this->scanExecuting = false;
-  try {
-    // Unpin the root page if not already unpinned
-    this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-  } catch (...) {
-  }
-  try {
-    // Unpin the current page if not already unpinned
-    this->bufMgr->unPinPage(this->file, this->currentPageNum, true);
-  } catch (...) {
-  }
   // Call endScan to stop the scan function
   try {
     this->endScan();
   } catch (...) {
   }
-  this->bufMgr->flushFile(this->file);
+  this->commit();
   // Delete blobfile used for the index
   delete this->file;
   this->file = nullptr;
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::insertEntry
+// BTreeIndex::commit
 // -----------------------------------------------------------------------------
 
-const void BTreeIndex::insertEntry(const void *key, const RecordId rid) {
-  PageId rootPageId = this->rootPageNum;
-  Page *rootPage;
-  // Read the root page
-  this->bufMgr->readPage(this->file, rootPageId, rootPage);
-  // First identify the leaf node
-  if (this->isRootLeaf) {
-    // std::cout << "Inserting when root is leaf" << std::endl;
-    if (this->attributeType == Datatype::INTEGER) {
-      // Cast the rootPage to the leaf node
-      LeafNodeInt *rootLeafNode = (LeafNodeInt *)rootPage;
-        // Case 1: Root is leaf and ideal occupancy is not attained (Non-split)
-      if (hasSpaceInLeafNode<LeafNodeInt>(rootLeafNode)) {
-        // Non-split, insert the (key, record)
-        int keyCopy = *(int *)key;
-        insertKeyRidToKeyRidArray<int>(rootLeafNode->keyArray,
-                                       rootLeafNode->ridArray,
-                                       rootLeafNode->len, keyCopy, rid);
-        rootLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, rootPageId, true);
-      } else {
-        std::cout << "Leaf Root split case" << std::endl;
-        // Split the root node
-        this->isRootLeaf = false;
-        std::vector<RIDKeyPair<int>> ridKeyPairVec;
-        // Insert all the key, rid pairs including current key, rid to be
-        // inserted
-        for (int i = 0; i < rootLeafNode->len; i++) {
-          RIDKeyPair<int> ridKeyPair;
-          const RecordId rid_ = rootLeafNode->ridArray[i];
-          const int key_ = rootLeafNode->keyArray[i];
-          ridKeyPair.set(rid_, key_);
-          ridKeyPairVec.push_back(ridKeyPair);
-        }
-        // Insert current key, rid
-        RIDKeyPair<int> ridKeyPair;
-        ridKeyPair.set(rid, *(int *)key);
-        ridKeyPairVec.push_back(ridKeyPair);
-
-        // Sort the vector
-        sort(ridKeyPairVec.begin(), ridKeyPairVec.end());
-        int middleKeyIndex = ridKeyPairVec.size() / 2;
-        int middleKey = ridKeyPairVec[middleKeyIndex].key;
-        // Create new page
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Move half the (key, recordID) to the new node
-        // Cast the page to leaf node
-        LeafNodeInt *newPageLeafNode = (LeafNodeInt *)newPage;
-        newPageLeafNode->rightSibPageNo = INVALID_PAGE;
-        newPageLeafNode->len = 0;
-        for (int i = middleKeyIndex; i < (int)ridKeyPairVec.size(); i++) {
-          int key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<int>(newPageLeafNode->keyArray,
-                                         newPageLeafNode->ridArray,
-                                         newPageLeafNode->len, key_, rid_);
-          newPageLeafNode->len += 1;
-        }
-        std::cout << "new leaf node with page id " << newPageNum
-                  << " has length " << newPageLeafNode->len << std::endl;
-
-        // Move the first half to the root leaf node
-        rootLeafNode->len = 0;
-        for (int i = 0; i < middleKeyIndex; i++) {
-          int key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<int>(rootLeafNode->keyArray,
-                                         rootLeafNode->ridArray,
-                                         rootLeafNode->len, key_, rid_);
-          rootLeafNode->len += 1;
-        }
-        std::cout << "old root leaf node with page id " << rootPageId
-                  << " has length " << middleKeyIndex << std::endl;
-
-        // Set next page id of left leaf node
-        rootLeafNode->rightSibPageNo = newPageNum;
-
-        // Create root node non leaf page
-        Page *newRootPage;
-        PageId newRootPageNum;
-        bufMgr->allocPage(this->file, newRootPageNum, newRootPage);
-        std::cout << "new root non leaf node with page id " << newRootPageNum << std::endl;
-        this->rootPageNum = newRootPageNum;
-        NonLeafNodeInt *rootNonLeafNode = (NonLeafNodeInt *)newRootPage;
-        rootNonLeafNode->level = 1;  // Since this is the node above the leaf
-        // Copy up the middle key to root;
-        rootNonLeafNode->keyArray[0] = middleKey;
-        rootNonLeafNode->len = 1;
-        rootNonLeafNode->pageNoArray[0] = rootPageId;
-        rootNonLeafNode->pageNoArray[1] = newPageNum;
-
-        // Unpin old root page, new leaf page, new root page
-        this->bufMgr->unPinPage(this->file, rootPageId, true);
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-        this->bufMgr->unPinPage(this->file, newRootPageNum, true);
-      }
-    } else if (this->attributeType == Datatype::DOUBLE) {
-      // std::cout << "Inserting when root is leaf" << std::endl;
-      // Cast the rootPage to the leaf node
-      LeafNodeDouble *rootLeafNode = (LeafNodeDouble *)rootPage;
-      if (hasSpaceInLeafNode<LeafNodeDouble>(rootLeafNode)) {
-        // Non-split, insert the (key, record)
-        double keyCopy = *(double *)key;
-        insertKeyRidToKeyRidArray<double>(rootLeafNode->keyArray,
-                                          rootLeafNode->ridArray,
-                                          rootLeafNode->len, keyCopy, rid);
-        rootLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, rootPageId, true);
-      } else {
-        std::cout << "Leaf Root split case" << std::endl;
-        // Split the root node
-        this->isRootLeaf = false;
-        std::vector<RIDKeyPair<double>> ridKeyPairVec;
-        // Insert all the key, rid pairs including current key, rid to be
-        // inserted
-        for (int i = 0; i < rootLeafNode->len; i++) {
-          RIDKeyPair<double> ridKeyPair;
-          const RecordId rid_ = rootLeafNode->ridArray[i];
-          const double key_ = rootLeafNode->keyArray[i];
-          ridKeyPair.set(rid_, key_);
-          ridKeyPairVec.push_back(ridKeyPair);
-        }
-        // Insert current key, rid
-        RIDKeyPair<double> ridKeyPair;
-        ridKeyPair.set(rid, *(double *)key);
-        ridKeyPairVec.push_back(ridKeyPair);
-
-        // Sort the vector
-        sort(ridKeyPairVec.begin(), ridKeyPairVec.end());
-        int middleKeyIndex = ridKeyPairVec.size() / 2;
-        double middleKey = ridKeyPairVec[middleKeyIndex].key;
-        // Create new page
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Move half the (key, recordID) to the new node
-        // Cast the page to leaf node
-        LeafNodeDouble *newPageLeafNode = (LeafNodeDouble *)newPage;
-        newPageLeafNode->rightSibPageNo = INVALID_PAGE;
-        newPageLeafNode->len = 0;
-        for (int i = middleKeyIndex; i < (int)ridKeyPairVec.size(); i++) {
-          double key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<double>(newPageLeafNode->keyArray,
-                                            newPageLeafNode->ridArray,
-                                            newPageLeafNode->len, key_, rid_);
-          newPageLeafNode->len += 1;
-        }
-        std::cout << "new leaf node with page id " << newPageNum
-                  << " has length " << newPageLeafNode->len << std::endl;
-
-        // Move the first half to the root leaf node
-        rootLeafNode->len = 0;
-        for (int i = 0; i < middleKeyIndex; i++) {
-          double key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<double>(rootLeafNode->keyArray,
-                                         rootLeafNode->ridArray,
-                                         rootLeafNode->len, key_, rid_);
-          rootLeafNode->len += 1;
-        }
-        std::cout << "old root leaf node with page id " << rootPageId
-                  << " has length " << middleKeyIndex << std::endl;
-
-        // Set next page id of left leaf node
-        rootLeafNode->rightSibPageNo = newPageNum;
-
-        // Create root node non leaf page
-        Page *newRootPage;
-        PageId newRootPageNum;
-        bufMgr->allocPage(this->file, newRootPageNum, newRootPage);
-        this->rootPageNum = newRootPageNum;
-        NonLeafNodeDouble *rootNonLeafNode = (NonLeafNodeDouble *)newRootPage;
-        rootNonLeafNode->level = 1;  // Since this is the node above the leaf
-        // Copy up the middle key to root;
-        rootNonLeafNode->keyArray[0] = middleKey;
-        rootNonLeafNode->len = 1;
-        rootNonLeafNode->pageNoArray[0] = rootPageId;
-        rootNonLeafNode->pageNoArray[1] = newPageNum;
-
-        // Unpin old root page and new leaf page
-        this->bufMgr->unPinPage(this->file, rootPageId, true);
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-        this->bufMgr->unPinPage(this->file, newRootPageNum, true);
-      }
-    } else if (this->attributeType == Datatype::STRING) {
-      // std::cout << "Inserting when root is leaf" << std::endl;
-      // Cast the rootPage to the leaf node
-      LeafNodeString *rootLeafNode = (LeafNodeString *)rootPage;
-      if (hasSpaceInLeafNode<LeafNodeString>(rootLeafNode)) {
-        // Non-split, insert the (key, record)
-        std::string* keyCopy = (std::string *)key;
-        insertKeyRidToKeyRidArrayForString(rootLeafNode->keyArray,
-                                          rootLeafNode->ridArray,
-                                          rootLeafNode->len, *keyCopy, rid);
-        rootLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, rootPageId, true);
-      } else {
-        std::cout << "Leaf Root split case" << std::endl;
-        // Split the root node
-        this->isRootLeaf = false;
-        std::vector<RIDKeyPair<std::string>> ridKeyPairVec;
-        // Insert all the key, rid pairs including current key, rid to be
-        // inserted
-        for (int i = 0; i < rootLeafNode->len; i++) {
-          RIDKeyPair<std::string> ridKeyPair;
-          const RecordId rid_ = rootLeafNode->ridArray[i];
-          std::string key_(rootLeafNode->keyArray[i], STRINGSIZE);
-          ridKeyPair.set(rid_, key_);
-          ridKeyPairVec.push_back(ridKeyPair);
-        }
-        // Insert current key, rid
-        RIDKeyPair<std::string> ridKeyPair;
-        ridKeyPair.set(rid, *(std::string*)key);
-        ridKeyPairVec.push_back(ridKeyPair);
-
-        // Sort the vector
-        sort(ridKeyPairVec.begin(), ridKeyPairVec.end());
-        int middleKeyIndex = ridKeyPairVec.size() / 2;
-        std::string middleKey = ridKeyPairVec[middleKeyIndex].key;
-        // Create new page
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Move half the (key, recordID) to the new node
-        // Cast the page to leaf node
-        LeafNodeString *newPageLeafNode = (LeafNodeString *)newPage;
-        newPageLeafNode->rightSibPageNo = INVALID_PAGE;
-        newPageLeafNode->len = 0;
-        for (int i = middleKeyIndex; i < (int)ridKeyPairVec.size(); i++) {
-          std::string key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArrayForString(newPageLeafNode->keyArray,
-                                            newPageLeafNode->ridArray,
-                                            newPageLeafNode->len, key_, rid_);
-          newPageLeafNode->len += 1;
-        }
-        std::cout << "new leaf node with page id " << newPageNum
-                  << " has length " << newPageLeafNode->len << std::endl;
-
-        // Move the first half to the root leaf node
-        rootLeafNode->len = 0;
-        for (int i = 0; i < middleKeyIndex; i++) {
-          std::string key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArrayForString(rootLeafNode->keyArray,
-                                         rootLeafNode->ridArray,
-                                         rootLeafNode->len, key_, rid_);
-          rootLeafNode->len += 1;
-        }
-        std::cout << "old root leaf node with page id " << rootPageId
-                  << " has length " << middleKeyIndex << std::endl;
-
-        // Set next page id of left leaf node
-        rootLeafNode->rightSibPageNo = newPageNum;
-
-        // Create root node non leaf page
-        Page *newRootPage;
-        PageId newRootPageNum;
-        bufMgr->allocPage(this->file, newRootPageNum, newRootPage);
-        this->rootPageNum = newRootPageNum;
-        NonLeafNodeString *rootNonLeafNode = (NonLeafNodeString *)newRootPage;
-        rootNonLeafNode->level = 1;  // Since this is the node above the leaf
-        // Copy up the middle key to root;
-        strncpy(rootNonLeafNode->keyArray[0], middleKey.c_str(), STRINGSIZE);
-        rootNonLeafNode->len = 1;
-        rootNonLeafNode->pageNoArray[0] = rootPageId;
-        rootNonLeafNode->pageNoArray[1] = newPageNum;
-
-        // Unpin old root page and new leaf page
-        this->bufMgr->unPinPage(this->file, rootPageId, true);
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-        this->bufMgr->unPinPage(this->file, newRootPageNum, true);
-      }
-    }
-  } else {
-    // std::cout << "Inserting when root is non-leaf" << std::endl;
-    // Case 2: Root is non-leaf
-    // isSplit will be passed by reference and will by set 
-    // by children if split happens at children 
-    bool isSplit = false;
-    // splitKey is the key which needs to be moved up in the current node
-    // when the children node split
-    void *splitKey = nullptr;
-    PageId splitRightNodePageId;
-    insertRecursive(rootPageId, key, rid, isSplit, splitKey,
-                    splitRightNodePageId);
-    // Unpin the root page if pinned
-    try {
-      this->bufMgr->unPinPage(this->file, rootPageId, true);
-    } catch(...) {
+/**
+ * FNV-1a hash of the IndexMetaInfo at the start of a page, its checksum
+ * field counted as 0.
+ */
+static std::uint32_t metaChecksum(const Page &page) {
+  unsigned char bytes[sizeof(IndexMetaInfo)];
+  memcpy(bytes, &page, sizeof(bytes));
+  memset(bytes + offsetof(IndexMetaInfo, checksum), 0, sizeof(std::uint32_t));
+  std::uint32_t hash = 2166136261u;
+  for (std::size_t i = 0; i < sizeof(bytes); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
 
-    }
+/**
+ * Appends the pages of a blob chain to <pages>.
+ */
+static void chainPages(File *file, BufMgr *bufMgr, PageId pageNo,
+                       std::vector<PageId> &pages) {
+  while (pageNo != Page::INVALID_NUMBER) {
+    pages.push_back(pageNo);
+    Page *page;
+    bufMgr->readPage(file, pageNo, page);
+    const PageId nextPageNo = ((const BlobPageHeader *)page)->nextPageNo;
+    bufMgr->unPinPage(file, pageNo, false);
+    pageNo = nextPageNo;
   }
 }
 
-void BTreeIndex::insertRecursive(PageId nodePageNumber, const void *key,
-                                 const RecordId rid, bool &isSplit,
-                                 void *splitKey, PageId &splitRightNodePageId) {
-  // Read current page
-  Page *curPage;
-  bufMgr->readPage(this->file, nodePageNumber, curPage);
-  if (this->attributeType == Datatype::INTEGER) {
-    // Cast it to non leaf
-    NonLeafNodeInt *curNode = (NonLeafNodeInt *)curPage;
-    int keyCopy = *(int *)key;
-    PageId nextPage = -1;
-    int nextPageIndex = -1;
-    bool foundKey = false;
-    // Find the index of the next page to traverse
-    for (int i = 0; i < curNode->len; i++) {
-      int curKey = curNode->keyArray[i];
-      int nextKey = -1;
-      if (i == curNode->len - 1) {
-        nextKey = INT_MAX;
-      } else {
-        nextKey = curNode->keyArray[i + 1];
-      }
-      if (i == 0 && keyCopy < curKey) {
-        // Insert in the left of the first key
-        nextPageIndex = 0;
-        nextPage = curNode->pageNoArray[0];
-        foundKey = true;
-        break;
-      } else {
-        if (keyCopy >= curKey && keyCopy < nextKey) {
-          nextPageIndex = i + 1;
-          nextPage = curNode->pageNoArray[i + 1];
-          foundKey = true;
-          break;
-        }
-      }
-    }
-    // Split key passed by reference to children nodes which is set when children nodes
-    // split and the split key is the key which needs to be inserted in the current node
-    int splitKey;
-    if (foundKey) {
-      // If the current non-leaf node is just above the leaf nodes, then call
-      // insertAtLeaf else call insertRecursive
-      if (curNode->level) {
-        // The split key to be copied up the non-leaf nodes will be in the
-        // splitKey variable
-        insertLeaf(nextPage, &keyCopy, rid, isSplit, &splitKey,
-                        splitRightNodePageId);
-      } else {
-        // std::cout << "Insert recursive" << std::endl;
-        // The split key will contain the value which has to be moved up to
-        // above non-leaf nodes
-        insertRecursive(nextPage, key, rid, isSplit, (void *)&splitKey,
-                        splitRightNodePageId);
-      }
-      if (isSplit) {
-        // Check the current node is the root node
-        // If current node is root node, then new root will be created
-        int middleKey = splitKey;
-        insertNonLeaf(nodePageNumber, nextPageIndex, &middleKey, isSplit,
-                           &splitKey, splitRightNodePageId);
-        if (isSplit && nodePageNumber == this->rootPageNum) {
-          std::cout << "Non leaf Root split case" << std::endl;
-          // Create new page for the root
-          Page *newRootPage;
-          PageId newRootPageNum;
-          // Unpin current root page
-          this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-          this->bufMgr->allocPage(this->file, newRootPageNum, newRootPage);
-          // Cast to non leaf node int
-          NonLeafNodeInt *nonLeafRootNodeInt = (NonLeafNodeInt *)newRootPage;
-          nonLeafRootNodeInt->keyArray[0] = splitKey;
-          nonLeafRootNodeInt->pageNoArray[0] = nodePageNumber;
-          nonLeafRootNodeInt->pageNoArray[1] = splitRightNodePageId;
-          nonLeafRootNodeInt->len = 1;
-          nonLeafRootNodeInt->level = 0;
-          this->rootPageNum = newRootPageNum;
-          this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-        }
-      }
-    }
-    this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-  } else if (this->attributeType == Datatype::DOUBLE) {
-    // Cast it to non leaf
-    NonLeafNodeDouble *curNode = (NonLeafNodeDouble *)curPage;
-    double keyCopy = *(double *)key;
-    PageId nextPage = -1;
-    int nextPageIndex = -1;
-    bool foundKey = false;
-    // Find the index of the next page to traverse
-    for (int i = 0; i < curNode->len; i++) {
-      double curKey = curNode->keyArray[i];
-      double nextKey = -1;
-      if (i == curNode->len - 1) {
-        nextKey = INT_MAX;
-      } else {
-        nextKey = curNode->keyArray[i + 1];
-      }
-      if (i == 0 && keyCopy < curKey) {
-        // Insert in the left of the first key
-        nextPageIndex = 0;
-        nextPage = curNode->pageNoArray[0];
-        foundKey = true;
-        break;
-      } else {
-        if (keyCopy >= curKey && keyCopy < nextKey) {
-          nextPageIndex = i + 1;
-          nextPage = curNode->pageNoArray[i + 1];
-          foundKey = true;
-          break;
-        }
-      }
-    }
-    // Split key passed by reference to children nodes which is set when children nodes
-    // split and the split key is the key which needs to be inserted in the current node
-    double splitKey;
-    if (foundKey) {
-      // If the current non-leaf node is just above the leaf nodes, then call
-      // insertAtLeaf else call insertRecursive
-      if (curNode->level) {
-        // The split key to be copied up the non-leaf nodes will be in the
-        // splitKey variable
-        insertLeaf(nextPage, &keyCopy, rid, isSplit, &splitKey,
-                           splitRightNodePageId);
-      } else {
-        // std::cout << "Insert recursive" << std::endl;
-        // The split key will contain the value which has to be moved up to
-        // above non-leaf nodes
-        insertRecursive(nextPage, key, rid, isSplit, (void *)&splitKey,
-                        splitRightNodePageId);
-      }
-      if (isSplit) {
-        // Check the current node is the root node
-        // If current node is root node, then new root will be created
-        double middleKey = splitKey;
-        insertNonLeaf(nodePageNumber, nextPageIndex, &middleKey, isSplit,
-                              &splitKey, splitRightNodePageId);
-        if (isSplit && nodePageNumber == this->rootPageNum) {
-          std::cout << "Non leaf Root split case" << std::endl;
-          // Create new page for the root
-          Page *newRootPage;
-          PageId newRootPageNum;
-          // Unpin current root page
-          this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-          this->bufMgr->allocPage(this->file, newRootPageNum, newRootPage);
-          // Cast to non leaf node double
-          NonLeafNodeDouble *nonLeafRootNodeDouble = (NonLeafNodeDouble *)newRootPage;
-          nonLeafRootNodeDouble->keyArray[0] = splitKey;
-          nonLeafRootNodeDouble->pageNoArray[0] = nodePageNumber;
-          nonLeafRootNodeDouble->pageNoArray[1] = splitRightNodePageId;
-          nonLeafRootNodeDouble->len = 1;
-          nonLeafRootNodeDouble->level = 0;
-          this->rootPageNum = newRootPageNum;
-          this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-        }
-      }
+void BTreeIndex::commit() {
+  // The leaf the scan is on is unpinned for the flush, then pinned again:
+  // a commit leaves the pages of the tree where they are
+  const bool scanOnLeaf = this->scan.leafPinned;
+  this->leaveLeaf(this->scan);
+  try {
+    this->writeCommit();
+  } catch (...) {
+    if (scanOnLeaf) {
+      this->enterLeaf(this->scan, this->scan.currentPageNum, 0);
     }
-    this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-  } else if (this->attributeType == Datatype::STRING) {
-    // Cast it to non leaf
-    NonLeafNodeString *curNode = (NonLeafNodeString *)curPage;
-    std::string keyCopy = *(std::string *)key;
-    PageId nextPage = -1;
-    int nextPageIndex = -1;
-    bool foundKey = false;
-    // Find the index of the next page to traverse
-    for (int i = 0; i < curNode->len; i++) {
-      std::string curKey = curNode->keyArray[i];
-      std::string nextKey = "";
-      if (i == curNode->len - 1) {
-        nextKey = ""; // last key plus extra character to make it larger than last key
-      } else {
-        nextKey = curNode->keyArray[i + 1];
-      }
-      if (i == 0 && keyCopy < curKey) {
-        // Insert in the left of the first key
-        nextPageIndex = 0;
-        nextPage = curNode->pageNoArray[0];
-        foundKey = true;
-        break;
-      } else {
-        if ((i == curNode->len - 1 && keyCopy >= curKey) || (keyCopy >= curKey && keyCopy < nextKey)) {
-          nextPageIndex = i + 1;
-          nextPage = curNode->pageNoArray[i + 1];
-          foundKey = true;
-          break;
-        }
-      }
+    throw;
+  }
+  if (scanOnLeaf) {
+    this->enterLeaf(this->scan, this->scan.currentPageNum, 0);
+  }
+}
+
+void BTreeIndex::writeCommit() {
+  if (this->storage == IN_PLACE_STORAGE) {
+    Page* metaPage;
+    // Read meta page
+    this->bufMgr->readPage(this->file, this->headerPageNum, metaPage);
+    // Set the metadata in the metapage
+    IndexMetaInfo *indexMetaInfo = (IndexMetaInfo *)metaPage;
+    indexMetaInfo->rootPageNo = this->rootPageNum;
+    indexMetaInfo->isRootLeaf = this->isRootLeaf;
+    // Copies no snapshot needs anymore are reused after the index is opened
+    // again. The list is rewritten over its own chain.
+    indexMetaInfo->freeListPageNo =
+        this->writeFreeList(indexMetaInfo->freeListPageNo);
+    this->bufMgr->unPinPage(this->file, this->headerPageNum, true);
+    this->bufMgr->flushFile(this->file);
+    return;
+  }
+  const std::uint32_t txnId = this->committedTxn + 1;
+  // The free list of the last commit is replaced by a new one
+  for (std::size_t i = 0; i < this->freeListChain.size(); i++) {
+    this->freePage(this->freeListChain[i]);
+  }
+  this->freeListChain.clear();
+  const PageId freeListPageNo = this->writeFreeList();
+  // Write the tree, then the meta page the last commit is not on. Until its
+  // write is over, the last commit is the one opened
+  this->bufMgr->flushFile(this->file);
+  // The tree has to be on disk before a meta page points to it
+  this->file->sync();
+  Page page = this->file->readPage(this->headerPageNum);
+  IndexMetaInfo *indexMetaInfo = (IndexMetaInfo *)&page;
+  indexMetaInfo->rootPageNo = this->rootPageNum;
+  indexMetaInfo->isRootLeaf = this->isRootLeaf;
+  indexMetaInfo->txnId = txnId;
+  indexMetaInfo->freeListPageNo = freeListPageNo;
+  indexMetaInfo->checksum = metaChecksum(page);
+  this->headerPageNum = this->headerPageNum == 1 ? 2 : 1;
+  this->file->writePage(this->headerPageNum, page);
+  this->file->sync();
+  this->committedTxn = txnId;
+  // Pages of the commit are copied before being modified from now on
+  this->txnPages.clear();
+  this->reclaimPages();
+}
+
+bool BTreeIndex::openCommitted(IndexMetaInfo &meta) {
+  bool found = false;
+  for (PageId pageNo = 1; pageNo <= 2; pageNo++) {
+    const Page page = this->file->readPage(pageNo);
+    const IndexMetaInfo *candidate = (const IndexMetaInfo *)&page;
+    if (candidate->storage != APPEND_ONLY_STORAGE ||
+        candidate->checksum != metaChecksum(page)) {
+      continue;
     }
-    // Split key passed by reference to children nodes which is set when children nodes
-    // split and the split key is the key which needs to be inserted in the current node
-    std::string splitKey;
-    if (foundKey) {
-      // If the current non-leaf node is just above the leaf nodes, then call
-      // insertAtLeaf else call insertRecursive
-      if (curNode->level) {
-        // The split key to be copied up the non-leaf nodes will be in the
-        // splitKey variable
-        insertLeaf(nextPage, &keyCopy, rid, isSplit, &splitKey,
-                           splitRightNodePageId);
-      } else {
-        // std::cout << "Insert recursive" << std::endl;
-        // The split key will contain the value which has to be moved up to
-        // above non-leaf nodes
-        insertRecursive(nextPage, key, rid, isSplit, (void *)&splitKey,
-                        splitRightNodePageId);
-      }
-      if (isSplit) {
-        // Check the current node is the root node
-        // If current node is root node, then new root will be created
-        std::string middleKey = splitKey;
-        insertNonLeaf(nodePageNumber, nextPageIndex, &middleKey, isSplit,
-                              &splitKey, splitRightNodePageId);
-        if (isSplit && nodePageNumber == this->rootPageNum) {
-          std::cout << "Non leaf Root split case" << std::endl;
-          // Create new page for the root
-          Page *newRootPage;
-          PageId newRootPageNum;
-          // Unpin current root page
-          this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-          this->bufMgr->allocPage(this->file, newRootPageNum, newRootPage);
-          // Cast to non leaf node double
-          NonLeafNodeString *nonLeafRootNodeString = (NonLeafNodeString *)newRootPage;
-          strncpy(nonLeafRootNodeString->keyArray[0], splitKey.c_str(), STRINGSIZE);
-          nonLeafRootNodeString->pageNoArray[0] = nodePageNumber;
-          nonLeafRootNodeString->pageNoArray[1] = splitRightNodePageId;
-          nonLeafRootNodeString->len = 1;
-          nonLeafRootNodeString->level = 0;
-          this->rootPageNum = newRootPageNum;
-          this->bufMgr->unPinPage(this->file, this->rootPageNum, true);
-        }
-      }
+    if (!found || candidate->txnId > meta.txnId) {
+      meta = *candidate;
+      this->headerPageNum = pageNo;
+      found = true;
     }
-    this->bufMgr->unPinPage(this->file, nodePageNumber, true);
   }
-
-  // insertRecursive(childPageNum, key, rid, isSplit, splitKey);
-  // Else recurse
+  if (!found) {
+    return false;
+  }
+  this->committedTxn = meta.txnId;
+  if (meta.freeListPageNo != Page::INVALID_NUMBER) {
+    this->readFreeList(meta.freeListPageNo, this->freedPages);
+    chainPages(this->file, this->bufMgr, meta.freeListPageNo,
+               this->freeListChain);
+  }
+  this->reclaimPages();
+  return true;
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::startScan
-// -----------------------------------------------------------------------------
+void BTreeIndex::readFreeList(const PageId freeListPageNo,
+                              std::vector<FreedPage> &outPages) {
+  BlobReader reader(this->file, this->bufMgr, freeListPageNo);
+  std::uint32_t count = 0;
+  reader.readValue(count);
+  for (std::uint32_t i = 0; i < count; i++) {
+    // No snapshot is open yet
+    FreedPage freed = {Page::INVALID_NUMBER, 0, 0};
+    reader.readValue(freed.pageNo);
+    reader.readValue(freed.freedTxn);
+    outPages.push_back(freed);
+  }
+}
 
-const void BTreeIndex::startScan(const void *lowValParm,
-                                 const Operator lowOpParm,
-                                 const void *highValParm,
-                                 const Operator highOpParm) {
-  // Check if another scan is executing
-  // If another scan is executing, end that scan
-  if (this->scanExecuting) {
-    this->endScan();
+PageId BTreeIndex::writeFreeList(const PageId chainPageNo) {
+  const std::uint32_t count = this->freePages.size() + this->freedPages.size();
+  if (count == 0 && chainPageNo == Page::INVALID_NUMBER) {
+    return Page::INVALID_NUMBER;
   }
-  if (lowOpParm == Operator::LT || lowOpParm == Operator::LTE) {
-    throw BadOpcodesException();
+  BlobWriter writer(this->file, this->bufMgr, chainPageNo);
+  writer.writeValue(count);
+  for (std::size_t i = 0; i < this->freePages.size(); i++) {
+    writer.writeValue(this->freePages[i]);
+    writer.writeValue(std::uint32_t(0));
   }
-  if (highOpParm == Operator::GT || highOpParm == Operator::GTE) {
-    throw BadOpcodesException();
+  for (std::size_t i = 0; i < this->freedPages.size(); i++) {
+    writer.writeValue(this->freedPages[i].pageNo);
+    writer.writeValue(this->freedPages[i].freedTxn);
   }
-  // Set up scan variables
-  this->scanExecuting = true;
-  this->lowOp = lowOpParm;
-  this->highOp = highOpParm;
-  if (this->attributeType == Datatype::INTEGER) {
-    this->lowValInt = *(int *)lowValParm;
-    this->highValInt = *(int *)highValParm;
-  } else if (this->attributeType == Datatype::DOUBLE) {
-    this->lowValDouble = *(double *)lowValParm;
-    this->highValDouble = *(double *)highValParm;
-  } else if (this->attributeType == Datatype::STRING) {
-    const char* lowStrKey = static_cast<const char*>(lowValParm);
-    const char* highStrKey = static_cast<const char*>(highValParm);
-    std::string lowStrKey_(lowStrKey);
-    std::string highStrKey_(highStrKey);
-    lowStrKey_ = lowStrKey_.substr(0, STRINGSIZE);
-    highStrKey_ = highStrKey_.substr(0, STRINGSIZE);
-    this->lowValString = lowStrKey_;
-    this->highValString = highStrKey_;
-  }
-
-  if (this->attributeType == Datatype::INTEGER) {
-    int lowIntValue = *(int *)lowValParm;
-    int highIntValue = *(int *)highValParm;
-    if (lowIntValue > highIntValue) {
-      throw BadScanrangeException();
-    }
-    PageId rootPageId = this->rootPageNum;
-    this->currentPageNum = rootPageId;
-    Page *rootPage;
-    if (isRootLeaf) {
-      this->bufMgr->readPage(this->file, rootPageId, rootPage);
-      // Cast root page to leaf node
-      LeafNodeInt *rootLeafNode = (LeafNodeInt *)rootPage;
-      this->currentPageData = rootPage;
-      for (int i = 0; i < rootLeafNode->len; i++) {
-        if (lowOpParm == Operator::GT &&
-            rootLeafNode->keyArray[i] > lowIntValue) {
-          this->nextEntry = i;
-          break;
-        }
-        if (lowOpParm == Operator::GTE &&
-            rootLeafNode->keyArray[i] >= lowIntValue) {
-          this->nextEntry = i;
-          break;
-        }
-      }
-      // If the nextEntry is still not set, it means no keys match the scan
-      // criteria
-      if (this->nextEntry == INVALID_KEY_INDEX) {
-        this->bufMgr->unPinPage(this->file, rootPageId, false);
-        throw NoSuchKeyFoundException();
-      }
-      this->bufMgr->unPinPage(this->file, rootPageId, false);
+  writer.close();
+  chainPages(this->file, this->bufMgr, writer.firstPageNo(),
+             this->freeListChain);
+  return writer.firstPageNo();
+}
+
+void BTreeIndex::freePage(const PageId pageNo) {
+  FreedPage freed = {pageNo, this->committedTxn + 1, this->lastSnapshotId};
+  this->freedPages.push_back(freed);
+}
+
+void BTreeIndex::reclaimPages() {
+  std::vector<FreedPage> kept;
+  for (std::size_t i = 0; i < this->freedPages.size(); i++) {
+    const FreedPage &freed = this->freedPages[i];
+    const bool committedPast = freed.freedTxn < this->committedTxn;
+    const bool unread = this->liveSnapshots.empty() ||
+                        *this->liveSnapshots.begin() > freed.snapshotId;
+    if (committedPast && unread) {
+      this->freePages.push_back(freed.pageNo);
     } else {
-      PageId curPageNum = this->rootPageNum;
-      Page *curPage;
-      // Navigate till the node which is just above the leaf node
-      while (true) {
-        bufMgr->readPage(this->file, curPageNum, curPage);
-        this->currentPageNum = curPageNum;
-        this->currentPageData = curPage;
-        // Cast to non leaf node
-        NonLeafNodeInt *curNonLeafNode = (NonLeafNodeInt *)curPage;
-        // Unpin each page except the leaf page
-        bufMgr->unPinPage(this->file, curPageNum, false);
-        bool nextKeyFound = false;
-        for (int i = 0; i < curNonLeafNode->len; i++) {
-          // For both GT and GTE operator, need to find first key index
-          // which is greater than lowIntValue (convention: left child node
-          // contains keys strictly less than key of parent node and right
-          // child node contains keys greater than or equal to parent node
-          // key)
-          if (curNonLeafNode->keyArray[i] > lowIntValue) {
-            curPageNum = curNonLeafNode->pageNoArray[i];
-            nextKeyFound = true;
-            break;
-          }
-        }
-        if (!nextKeyFound) {
-          // It means the next page should be the last index of pageNoArray
-          curPageNum = curNonLeafNode->pageNoArray[curNonLeafNode->len];
-        }
-        // Break the loop, when we are at one level above the leaf node level
-        // curPageNum now points to a leaf node
-        if (curNonLeafNode->level == 1) {
-          break;
-        }
-      }
-      bufMgr->readPage(this->file, curPageNum, curPage);
-      this->currentPageData = curPage;
-      // Reached the leaf node
-      LeafNodeInt *curLeafNode = (LeafNodeInt *)curPage;
-      // Unpin each page except the leaf page
-      bufMgr->unPinPage(this->file, curPageNum, false);
-      // Iterate over the leaf nodes and its siblings until a key is found
-      // satisfying the criteria or the end of index is reached
-      while (true) {
-        // Scan current page
-        // Its possible that current page doesn't contain any satisfying
-        // key, in which case move to next sibling (eg 10, 11, 12 are the
-        // keys in current page and lowIntValue - 14)
-        bool satisfyingKeyFound = false;
-        for (int i = 0; i < curLeafNode->len; i++) {
-          if (this->lowOp == GTE && curLeafNode->keyArray[i] >= lowIntValue) {
-            this->nextEntry = i;
-            this->currentPageData = curPage;
-            satisfyingKeyFound = true;
-            break;
-          }
-          if (this->lowOp == GT && curLeafNode->keyArray[i] > lowIntValue) {
-            this->nextEntry = i;
-            this->currentPageData = curPage;
-            satisfyingKeyFound = true;
-            break;
-          }
-        }
-        if (!satisfyingKeyFound) {
-          PageId nextPageNo = curLeafNode->rightSibPageNo;
-          if (nextPageNo == INVALID_PAGE) {
-            this->nextEntry = INVALID_KEY_INDEX;
-            return;
-          }
-          curPageNum = nextPageNo;
-          this->nextEntry = 0;
-          bufMgr->readPage(this->file, curPageNum, curPage);
-          this->currentPageData = curPage;
-          this->currentPageNum = curPageNum;
-          bufMgr->unPinPage(this->file, curPageNum, false);
-        } else {
-          break;
-        }
-      }
+      kept.push_back(freed);
     }
+  }
+  this->freedPages.swap(kept);
+}
+// -----------------------------------------------------------------------------
+// Node searches and splits
+// -----------------------------------------------------------------------------
+
+/**
+ * Decodes the key a node is searched for to the type of its key slots, so
+ * it is decoded once per search rather than once per key compared.
+ */
+static inline void decodeProbe(const IndexKey &key, int &probe) {
+  probe = key.toInt();
+}
+
+static inline void decodeProbe(const IndexKey &key, double &probe) {
+  probe = key.toDouble();
+}
+
+static inline void decodeProbe(const IndexKey &key,
+                               char (&probe)[STRINGSIZE]) {
+  key.toString(probe);
+}
+
+static inline void decodeProbe(const IndexKey &key, NormalizedKey &probe) {
+  setNodeKey(probe, key);
+}
+
+/**
+ * Compares a key slot of a node with a decoded probe, in the order of their
+ * IndexKey encodings.
+ */
+static inline int compareSlot(const int slot, const int probe) {
+  return slot < probe ? -1 : slot > probe;
+}
+
+static inline int compareSlot(const double slot, const double probe) {
+  // -0.0 and 0.0 are equal keys, as they are encoded
+  return slot < probe ? -1 : slot > probe;
+}
+
+static inline int compareSlot(const char (&slot)[STRINGSIZE],
+                              const char (&probe)[STRINGSIZE]) {
+  // Compares unsigned characters up to the end of the strings, as the zero
+  // padded encodings do
+  return strncmp(slot, probe, STRINGSIZE);
+}
+
+static inline int compareSlot(const NormalizedKey &slot,
+                              const NormalizedKey &probe) {
+  return memcmp(slot.bytes, probe.bytes, IndexKey::MAX_LENGTH);
+}
+
+/**
+ * Binary search of the keys from index <low> to <high> of a node. Returns the
+ * index of the first key greater than <key> if <upper>, of the first key not
+ * smaller than it otherwise.
+ */
+template <class Slot>
+static int searchSlots(const Slot *keys, int low, int high,
+                       const IndexKey &key, const bool upper) {
+  Slot probe;
+  decodeProbe(key, probe);
+  while (low < high) {
+    const int middle = (low + high) / 2;
+    const int result = compareSlot(keys[middle], probe);
+    if (upper ? result <= 0 : result < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/**
+ * Returns the index of the first key of a node not smaller than <key>.
+ */
+template <class Node>
+static int lowerBound(const Node *node, const IndexKey &key) {
+  return searchSlots(node->keyArray, 0, node->len, key, false);
+}
+
+/**
+ * Returns the index of the first key of a node greater than <key>. In a non
+ * leaf node, it is the index of the child holding <key>.
+ */
+template <class Node>
+static int upperBound(const Node *node, const IndexKey &key) {
+  return searchSlots(node->keyArray, 0, node->len, key, true);
+}
+
+/**
+ * Number of heads below which firstHeadNotBelow stops its binary search and
+ * scans them.
+ */
+static const int HEAD_SCAN_WIDTH = 16;
+
+/**
+ * Returns the index of the first of <len> sorted heads not smaller than
+ * <head>, <len> if there is none. The heads are narrowed down by a binary
+ * search then scanned, 4 at a time where SSE2 is available.
+ */
+static int firstHeadNotBelow(const std::uint32_t *heads, const int len,
+                             const std::uint32_t head) {
+  int low = 0;
+  int high = len;
+  while (high - low > HEAD_SCAN_WIDTH) {
+    const int middle = (low + high) / 2;
+    if (heads[middle] < head) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  int i = low;
+#ifdef __SSE2__
+  // SSE2 compares signed numbers, flipping the sign bit of both sides keeps
+  // the unsigned order
+  const __m128i signBits = _mm_set1_epi32(INT_MIN);
+  const __m128i probe = _mm_xor_si128(_mm_set1_epi32((int)head), signBits);
+  for (; i < high && i + 4 <= len; i += 4) {
+    const __m128i block = _mm_xor_si128(
+        _mm_loadu_si128((const __m128i *)(heads + i)), signBits);
+    // Heads are sorted, so the lanes below <head> come first
+    const int below =
+        _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(block, probe)));
+    if (below != 0xf) {
+      return i + __builtin_ctz(~below);
+    }
+  }
+#endif
+  while (i < high && heads[i] < head) {
+    i++;
+  }
+  return i;
+}
+
+/**
+ * Search kernel of the nodes with a head array, for keys of every type.
+ * Returns the index of the first key greater than <key> if <upper>, of the
+ * first key not smaller than it otherwise. Keys are located by their head,
+ * then those sharing the head of <key> are searched on their whole key.
+ */
+template <class Node>
+static int searchHeads(const Node *node, const IndexKey &key,
+                       const bool upper) {
+  const std::uint32_t head = key.head();
+  const int low = firstHeadNotBelow(node->headArray, node->len, head);
+  int high = low;
+  while (high < node->len && node->headArray[high] == head) {
+    high++;
+  }
+  return searchSlots(node->keyArray, low, high, key, upper);
+}
+
+static inline int lowerBound(const LeafNodeNormalized *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, false);
+}
+
+static inline int lowerBound(const NonLeafNodeNormalized *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, false);
+}
+
+static inline int upperBound(const LeafNodeNormalized *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, true);
+}
+
+static inline int upperBound(const NonLeafNodeNormalized *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, true);
+}
+
+static inline int lowerBound(const NonLeafNodeDouble *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, false);
+}
+
+static inline int upperBound(const NonLeafNodeDouble *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, true);
+}
+
+static inline int lowerBound(const NonLeafNodeString *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, false);
+}
+
+static inline int upperBound(const NonLeafNodeString *node,
+                             const IndexKey &key) {
+  return searchHeads(node, key, true);
+}
+
+/**
+ * Inserts an entry into a leaf node which has space for it.
+ */
+template <class LeafNode>
+static void insertIntoLeaf(LeafNode *leaf, const IndexKey &key,
+                           const RecordId rid) {
+  const std::size_t keySize = sizeof(leaf->keyArray[0]);
+  const int pos = lowerBound(leaf, key);
+  memmove(&leaf->keyArray[pos + 1], &leaf->keyArray[pos],
+          (leaf->len - pos) * keySize);
+  memmove(&leaf->ridArray[pos + 1], &leaf->ridArray[pos],
+          (leaf->len - pos) * sizeof(RecordId));
+  setNodeKey(leaf->keyArray[pos], key);
+  leaf->ridArray[pos] = rid;
+  leaf->len += 1;
+  refreshHeads(leaf, pos);
+}
+
+/**
+ * Inserts a key and the page right of it into a non leaf node which has space
+ * for them, the key going at <nextPageIndex>.
+ */
+template <class NonLeafNode>
+static void insertIntoNonLeaf(NonLeafNode *node, const int nextPageIndex,
+                              const IndexKey &key, const PageId rightPageNo) {
+  const std::size_t keySize = sizeof(node->keyArray[0]);
+  memmove(&node->keyArray[nextPageIndex + 1], &node->keyArray[nextPageIndex],
+          (node->len - nextPageIndex) * keySize);
+  memmove(&node->pageNoArray[nextPageIndex + 2],
+          &node->pageNoArray[nextPageIndex + 1],
+          (node->len - nextPageIndex) * sizeof(PageId));
+  setNodeKey(node->keyArray[nextPageIndex], key);
+  node->pageNoArray[nextPageIndex + 1] = rightPageNo;
+  node->len += 1;
+  refreshHeads(node, nextPageIndex);
+}
+
+/**
+ * Splits a full leaf. Keys are moved as spans of bytes of the size of a key
+ * slot.
+ */
+template <class LeafNode>
+static void splitLeaf(Arena &arena, LeafNode *leaf, LeafNode *newLeaf,
+                      const IndexKey &key, const RecordId rid) {
+  typedef typename std::remove_reference<decltype(leaf->keyArray[0])>::type
+      KeySlot;
+  const std::size_t keySize = sizeof(KeySlot);
+  const int len = leaf->len;
+  // The new entry goes before the first key not smaller than it, as in
+  // insertIntoLeaf
+  const int pos = lowerBound(leaf, key);
+  KeySlot keySlot;
+  setNodeKey(keySlot, key);
+
+  ArenaScope scope(arena);
+  char *keys = (char *)arena.allocate((len + 1) * keySize);
+  RecordId *rids = arena.allocateArray<RecordId>(len + 1);
+  memcpy(keys, leaf->keyArray, pos * keySize);
+  memcpy(keys + pos * keySize, &keySlot, keySize);
+  memcpy(keys + (pos + 1) * keySize, &leaf->keyArray[pos],
+         (len - pos) * keySize);
+  memcpy(rids, leaf->ridArray, pos * sizeof(RecordId));
+  rids[pos] = rid;
+  memcpy(rids + pos + 1, &leaf->ridArray[pos], (len - pos) * sizeof(RecordId));
+
+  const int middle = (len + 1) / 2;
+  memcpy(newLeaf->keyArray, keys + middle * keySize,
+         (len + 1 - middle) * keySize);
+  memcpy(newLeaf->ridArray, rids + middle,
+         (len + 1 - middle) * sizeof(RecordId));
+  newLeaf->len = len + 1 - middle;
+  memcpy(leaf->keyArray, keys, middle * keySize);
+  memcpy(leaf->ridArray, rids, middle * sizeof(RecordId));
+  leaf->len = middle;
+  refreshHeads(leaf, pos);
+  refreshHeads(newLeaf, 0);
+}
+
+/**
+ * Splits a full non leaf node. Keys are moved as spans of bytes of the size
+ * of a key slot.
+ */
+template <class NonLeafNode>
+static void splitNonLeaf(Arena &arena, NonLeafNode *node,
+                         NonLeafNode *newNode, const int nextPageIndex,
+                         const IndexKey &middleKey, const PageId rightPageNo,
+                         IndexKey &splitKey) {
+  typedef typename std::remove_reference<decltype(node->keyArray[0])>::type
+      KeySlot;
+  const std::size_t keySize = sizeof(KeySlot);
+  const int len = node->len;
+  KeySlot keySlot;
+  setNodeKey(keySlot, middleKey);
+
+  // Keys and pages with the new key at nextPageIndex and the new page right
+  // of it
+  ArenaScope scope(arena);
+  char *keys = (char *)arena.allocate((len + 1) * keySize);
+  PageId *pages = arena.allocateArray<PageId>(len + 2);
+  memcpy(keys, node->keyArray, nextPageIndex * keySize);
+  memcpy(keys + nextPageIndex * keySize, &keySlot, keySize);
+  memcpy(keys + (nextPageIndex + 1) * keySize,
+         &node->keyArray[nextPageIndex], (len - nextPageIndex) * keySize);
+  memcpy(pages, node->pageNoArray, (nextPageIndex + 1) * sizeof(PageId));
+  pages[nextPageIndex + 1] = rightPageNo;
+  memcpy(pages + nextPageIndex + 2, &node->pageNoArray[nextPageIndex + 1],
+         (len - nextPageIndex) * sizeof(PageId));
+
+  // The key at splitKeyIndex moves up, the keys after it and their pages go
+  // to the new node
+  const int splitKeyIndex = len / 2;
+  splitKey = nodeKey(*(const KeySlot *)(keys + splitKeyIndex * keySize));
+  memcpy(node->keyArray, keys, splitKeyIndex * keySize);
+  memcpy(node->pageNoArray, pages, (splitKeyIndex + 1) * sizeof(PageId));
+  node->len = splitKeyIndex;
+  newNode->level = node->level;
+  newNode->len = len - splitKeyIndex;
+  memcpy(newNode->keyArray, keys + (splitKeyIndex + 1) * keySize,
+         newNode->len * keySize);
+  memcpy(newNode->pageNoArray, pages + splitKeyIndex + 1,
+         (newNode->len + 1) * sizeof(PageId));
+  refreshHeads(node, nextPageIndex);
+  refreshHeads(newNode, 0);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertEntry
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::insertEntry(const void *key, const RecordId rid) {
+  this->insertEntry(IndexKey::fromValue(this->attributeType, key), rid);
+}
+
+const void BTreeIndex::insertEntry(const IndexKey &key, const RecordId rid) {
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    this->insertInto<LeafNodeNormalized, NonLeafNodeNormalized>(key, rid);
+  } else if (this->attributeType == Datatype::INTEGER) {
+    this->insertInto<LeafNodeInt, NonLeafNodeInt>(key, rid);
   } else if (this->attributeType == Datatype::DOUBLE) {
-    // Check if another scan is executing
-    // If another scan is executing, end that scan
-      double lowDoubleValue = *(double *)lowValParm;
-      double highDoubleValue = *(double *)highValParm;
-      if (lowDoubleValue > highDoubleValue) {
-        throw BadScanrangeException();
-      }
-      PageId rootPageId = this->rootPageNum;
-      this->currentPageNum = rootPageId;
-      Page *rootPage;
-      if (isRootLeaf) {
-        this->bufMgr->readPage(this->file, rootPageId, rootPage);
-        // Cast root page to leaf node
-        LeafNodeDouble *rootLeafNode = (LeafNodeDouble *)rootPage;
-        this->currentPageData = rootPage;
-        for (int i = 0; i < rootLeafNode->len; i++) {
-          if (lowOpParm == Operator::GT &&
-              rootLeafNode->keyArray[i] > lowDoubleValue) {
-            this->nextEntry = i;
-            break;
-          }
-          if (lowOpParm == Operator::GTE &&
-              rootLeafNode->keyArray[i] >= lowDoubleValue) {
-            this->nextEntry = i;
-            break;
-          }
-        }
-        // If the nextEntry is still not set, it means no keys match the scan
-        // criteria
-        if (this->nextEntry == INVALID_KEY_INDEX) {
-          this->bufMgr->unPinPage(this->file, rootPageId, false);
-          throw NoSuchKeyFoundException();
-        }
-        this->bufMgr->unPinPage(this->file, rootPageId, false);
-      } else {
-        PageId curPageNum = this->rootPageNum;
-        Page *curPage;
-        // Navigate till the node which is just above the leaf node
-        while (true) {
-          bufMgr->readPage(this->file, curPageNum, curPage);
-          this->currentPageNum = curPageNum;
-          this->currentPageData = curPage;
-          // Cast to non leaf node
-          NonLeafNodeDouble *curNonLeafNode = (NonLeafNodeDouble *)curPage;
-          // Unpin each page except the leaf page
-          bufMgr->unPinPage(this->file, curPageNum, false);
-          bool nextKeyFound = false;
-          for (int i = 0; i < curNonLeafNode->len; i++) {
-            // For both GT and GTE operator, need to find first key index
-            // which is greater than lowIntValue (convention: left child node
-            // contains keys strictly less than key of parent node and right
-            // child node contains keys greater than or equal to parent node
-            // key)
-            if (curNonLeafNode->keyArray[i] > lowDoubleValue) {
-              curPageNum = curNonLeafNode->pageNoArray[i];
-              nextKeyFound = true;
-              break;
-            }
-          }
-          if (!nextKeyFound) {
-            // It means the next page should be the last index of pageNoArray
-            curPageNum = curNonLeafNode->pageNoArray[curNonLeafNode->len];
-          }
-          // Break the loop, when we are at one level above the leaf node level
-          // curPageNum now points to a leaf node
-          if (curNonLeafNode->level == 1) {
-            break;
-          }
-        }
-        bufMgr->readPage(this->file, curPageNum, curPage);
-        this->currentPageData = curPage;
-        // Reached the leaf node
-        LeafNodeDouble *curLeafNode = (LeafNodeDouble *)curPage;
-        // Unpin each page except the leaf page
-        bufMgr->unPinPage(this->file, curPageNum, false);
-        // Iterate over the leaf nodes and its siblings until a key is found
-        // satisfying the criteria or the end of index is reached
-        while (true) {
-          // Scan current page
-          // Its possible that current page doesn't contain any satisfying
-          // key, in which case move to next sibling (eg 10, 11, 12 are the
-          // keys in current page and lowIntValue - 14)
-          bool satisfyingKeyFound = false;
-          for (int i = 0; i < curLeafNode->len; i++) {
-            if (this->lowOp == GTE && curLeafNode->keyArray[i] >= lowDoubleValue) {
-              this->nextEntry = i;
-              this->currentPageData = curPage;
-              satisfyingKeyFound = true;
-              break;
-            }
-            if (this->lowOp == GT && curLeafNode->keyArray[i] > lowDoubleValue) {
-              this->nextEntry = i;
-              this->currentPageData = curPage;
-              satisfyingKeyFound = true;
-              break;
-            }
-          }
-          if (!satisfyingKeyFound) {
-            PageId nextPageNo = curLeafNode->rightSibPageNo;
-            if (nextPageNo == INVALID_PAGE) {
-              this->nextEntry = INVALID_KEY_INDEX;
-              return;
-            }
-            curPageNum = nextPageNo;
-            this->nextEntry = 0;
-            bufMgr->readPage(this->file, curPageNum, curPage);
-            this->currentPageData = curPage;
-            this->currentPageNum = curPageNum;
-            bufMgr->unPinPage(this->file, curPageNum, false);
-          } else {
-            break;
-          }
-        }
-      }
-    } else if (this->attributeType == Datatype::STRING) {
-      // Check if another scan is executing
-      // If another scan is executing, end that scan
-      std::string lowStringValue = this->lowValString;
-      std::string highStringValue = this->highValString;
-      std::cout<<lowStringValue<<" "<<highStringValue<<std::endl;
-
-      if (lowStringValue > highStringValue) {
-        throw BadScanrangeException();
-      }
-      PageId rootPageId = this->rootPageNum;
-      this->currentPageNum = rootPageId;
-      Page *rootPage;
-      if (isRootLeaf) {
-        this->bufMgr->readPage(this->file, rootPageId, rootPage);
-        // Cast root page to leaf node
-        LeafNodeString *rootLeafNode = (LeafNodeString *)rootPage;
-        this->currentPageData = rootPage;
-        for (int i = 0; i < rootLeafNode->len; i++) {
-          if (lowOpParm == Operator::GT &&
-              (strncmp(rootLeafNode->keyArray[i], lowStringValue.c_str(), STRINGSIZE) > 0)) {
-            this->nextEntry = i;
-            break;
-          }
-          if (lowOpParm == Operator::GTE &&
-          (strncmp(rootLeafNode->keyArray[i], lowStringValue.c_str(), STRINGSIZE) >= 0)) {
-            this->nextEntry = i;
-            break;
-          }
-        }
-        // If the nextEntry is still not set, it means no keys match the scan
-        // criteria
-        if (this->nextEntry == INVALID_KEY_INDEX) {
-          this->bufMgr->unPinPage(this->file, rootPageId, false);
-          throw NoSuchKeyFoundException();
-        }
-        this->bufMgr->unPinPage(this->file, rootPageId, false);
-      } else {
-        PageId curPageNum = this->rootPageNum;
-        Page *curPage;
-        // Navigate till the node which is just above the leaf node
-        while (true) {
-          bufMgr->readPage(this->file, curPageNum, curPage);
-          this->currentPageNum = curPageNum;
-          this->currentPageData = curPage;
-          // Cast to non leaf node
-          NonLeafNodeString *curNonLeafNode = (NonLeafNodeString *)curPage;
-          // Unpin each page except the leaf page
-          bufMgr->unPinPage(this->file, curPageNum, false);
-          bool nextKeyFound = false;
-          for (int i = 0; i < curNonLeafNode->len; i++) {
-            // For both GT and GTE operator, need to find first key index
-            // which is greater than lowIntValue (convention: left child node
-            // contains keys strictly less than key of parent node and right
-            // child node contains keys greater than or equal to parent node
-            // key)
-            if (strncmp(curNonLeafNode->keyArray[i], lowStringValue.c_str(), STRINGSIZE) > 0) {
-              curPageNum = curNonLeafNode->pageNoArray[i];
-              nextKeyFound = true;
-              break;
-            }
-          }
-          if (!nextKeyFound) {
-            // It means the next page should be the last index of pageNoArray
-            curPageNum = curNonLeafNode->pageNoArray[curNonLeafNode->len];
-          }
-          // Break the loop, when we are at one level above the leaf node level
-          // curPageNum now points to a leaf node
-          if (curNonLeafNode->level == 1) {
-            break;
-          }
-        }
-        bufMgr->readPage(this->file, curPageNum, curPage);
-        this->currentPageData = curPage;
-        // Reached the leaf node
-        LeafNodeString *curLeafNode = (LeafNodeString *)curPage;
-        // Unpin each page except the leaf page
-        bufMgr->unPinPage(this->file, curPageNum, false);
-        // Iterate over the leaf nodes and its siblings until a key is found
-        // satisfying the criteria or the end of index is reached
-        while (true) {
-          // Scan current page
-          // Its possible that current page doesn't contain any satisfying
-          // key, in which case move to next sibling (eg 10, 11, 12 are the
-          // keys in current page and lowIntValue - 14)
-          bool satisfyingKeyFound = false;
-          for (int i = 0; i < curLeafNode->len; i++) {
-            
-            if (this->lowOp == GTE && (strncmp(curLeafNode->keyArray[i], lowStringValue.c_str(), STRINGSIZE) >= 0)) {
-              this->nextEntry = i;
-              this->currentPageData = curPage;
-              satisfyingKeyFound = true;
-              break;
-            }
-            if (this->lowOp == GT && (strncmp(curLeafNode->keyArray[i], lowStringValue.c_str(), STRINGSIZE) > 0)) {
-              this->nextEntry = i;
-              this->currentPageData = curPage;
-              satisfyingKeyFound = true;
-              break;
-            }
-          }
-          if (!satisfyingKeyFound) {
-            PageId nextPageNo = curLeafNode->rightSibPageNo;
-            if (nextPageNo == INVALID_PAGE) {
-              this->nextEntry = INVALID_KEY_INDEX;
-              return;
-            }
-            curPageNum = nextPageNo;
-            this->nextEntry = 0;
-            bufMgr->readPage(this->file, curPageNum, curPage);
-            this->currentPageData = curPage;
-            this->currentPageNum = curPageNum;
-            bufMgr->unPinPage(this->file, curPageNum, false);
-          } else {
-            break;
-          }
-        }
-      }
+    this->insertInto<LeafNodeDouble, NonLeafNodeDouble>(key, rid);
+  } else if (this->attributeType == Datatype::STRING) {
+    this->insertInto<LeafNodeString, NonLeafNodeString>(key, rid);
+  }
+}
+
+template <class LeafNode, class NonLeafNode>
+void BTreeIndex::insertInto(const IndexKey &key, const RecordId rid) {
+  bool isSplit = false;
+  IndexKey splitKey;
+  PageId splitRightNodePageId;
+  // The root moves if it is copied
+  if (this->isRootLeaf) {
+    this->insertLeaf<LeafNode>(this->rootPageNum, key, rid, isSplit, splitKey,
+                               splitRightNodePageId, this->rootPageNum);
+    if (isSplit) {
+      std::cout << "Leaf Root split case" << std::endl;
+      // Level 1 since the new root is just above the leaves
+      this->growRoot<NonLeafNode>(splitKey, splitRightNodePageId, 1);
+      this->isRootLeaf = false;
     }
-    // Unpin the current page if not already unpinned
-    try {
-      bufMgr->unPinPage(this->file, this->currentPageNum, false);
-    } catch (...) {
+  } else {
+    this->insertRecursive<LeafNode, NonLeafNode>(this->rootPageNum, key, rid,
+                                                 isSplit, splitKey,
+                                                 splitRightNodePageId,
+                                                 this->rootPageNum);
+    if (isSplit) {
+      std::cout << "Non leaf Root split case" << std::endl;
+      this->growRoot<NonLeafNode>(splitKey, splitRightNodePageId, 0);
     }
   }
+}
 
-  // -----------------------------------------------------------------------------
-  // BTreeIndex::scanNext
-  // -----------------------------------------------------------------------------
+template <class NonLeafNode>
+void BTreeIndex::growRoot(const IndexKey &splitKey, const PageId rightPageNo,
+                          const int level) {
+  Page *newRootPage;
+  PageId newRootPageNum;
+  this->allocIndexPage(newRootPageNum, newRootPage);
+  std::cout << "new root non leaf node with page id " << newRootPageNum
+            << std::endl;
+  NonLeafNode *rootNode = (NonLeafNode *)newRootPage;
+  rootNode->level = level;
+  setNodeKey(rootNode->keyArray[0], splitKey);
+  rootNode->len = 1;
+  rootNode->pageNoArray[0] = this->rootPageNum;
+  rootNode->pageNoArray[1] = rightPageNo;
+  refreshHeads(rootNode, 0);
+  this->rootPageNum = newRootPageNum;
+  this->bufMgr->unPinPage(this->file, newRootPageNum, true);
+}
 
-  const void BTreeIndex::scanNext(RecordId & outRid) {
-    if (!scanExecuting) {
-      try{
-      this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-      }catch(...){
-      }
-      throw ScanNotInitializedException();
+template <class LeafNode, class NonLeafNode>
+void BTreeIndex::insertRecursive(PageId nodePageNumber, const IndexKey &key,
+                                 const RecordId rid, bool &isSplit,
+                                 IndexKey &splitKey,
+                                 PageId &splitRightNodePageId,
+                                 PageId &movedTo) {
+  // Find the child holding the key, the node is read again if the child
+  // splits or moves
+  Page *curPage;
+  this->bufMgr->readPage(this->file, nodePageNumber, curPage);
+  const NonLeafNode *curNode = (const NonLeafNode *)curPage;
+  const int nextPageIndex = upperBound(curNode, key);
+  const PageId nextPage = curNode->pageNoArray[nextPageIndex];
+  const bool childIsLeaf = curNode->level == 1;
+  this->bufMgr->unPinPage(this->file, nodePageNumber, false);
+
+  // Key and page to insert into the current node if the child splits
+  IndexKey childSplitKey;
+  PageId childRightPageNo;
+  PageId childMovedTo;
+  if (childIsLeaf) {
+    this->insertLeaf<LeafNode>(nextPage, key, rid, isSplit, childSplitKey,
+                               childRightPageNo, childMovedTo);
+  } else {
+    this->insertRecursive<LeafNode, NonLeafNode>(nextPage, key, rid, isSplit,
+                                                 childSplitKey,
+                                                 childRightPageNo,
+                                                 childMovedTo);
+  }
+  if (isSplit || childMovedTo != nextPage) {
+    this->insertNonLeaf<NonLeafNode>(nodePageNumber, nextPageIndex,
+                                     childMovedTo, isSplit, childSplitKey,
+                                     childRightPageNo, isSplit, splitKey,
+                                     splitRightNodePageId, movedTo);
+  } else {
+    movedTo = nodePageNumber;
+  }
+}
+
+template <class NonLeafNode>
+void BTreeIndex::insertNonLeaf(PageId nodePageNumber, int nextPageIndex,
+                               const PageId childPageNo, const bool childSplit,
+                               const IndexKey &middleKey, PageId rightPageNo,
+                               bool &isSplit, IndexKey &splitKey,
+                               PageId &splitRightNodePageId, PageId &movedTo) {
+  Page *curPage;
+  movedTo = this->modifyPage(nodePageNumber, curPage);
+  NonLeafNode *curNode = (NonLeafNode *)curPage;
+  curNode->pageNoArray[nextPageIndex] = childPageNo;
+  if (!childSplit || hasSpaceInNonLeafNode(curNode)) {
+    if (childSplit) {
+      insertIntoNonLeaf(curNode, nextPageIndex, middleKey, rightPageNo);
     }
-    // Check if nextEntry is valid or not (points to valid entry in the page or
-    // not)
-    if (this->nextEntry == INVALID_KEY_INDEX) {
-      try {
-        this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-      } catch(...) {
+    isSplit = false;
+    this->bufMgr->unPinPage(this->file, movedTo, true);
+    return;
+  }
+  std::cout << "Non leaf split case" << std::endl;
+  // Split and move up the key in the middle
+  Page *newPage;
+  PageId newPageNum;
+  this->allocIndexPage(newPageNum, newPage);
+  NonLeafNode *newNode = (NonLeafNode *)newPage;
+  splitNonLeaf(this->splitArena, curNode, newNode, nextPageIndex, middleKey,
+               rightPageNo, splitKey);
+  std::cout << "cur non leaf node with page id " << movedTo
+            << " has length " << curNode->len << std::endl;
+  std::cout << "new non leaf node with page id " << newPageNum
+            << " has length " << newNode->len << std::endl;
+  isSplit = true;
+  splitRightNodePageId = newPageNum;
+  this->bufMgr->unPinPage(this->file, movedTo, true);
+  this->bufMgr->unPinPage(this->file, newPageNum, true);
+}
+
+template <class LeafNode>
+void BTreeIndex::insertLeaf(PageId pageNum, const IndexKey &key,
+                            const RecordId rid, bool &isSplit,
+                            IndexKey &splitKey, PageId &splitRightNodePageId,
+                            PageId &movedTo) {
+  Page *curPage;
+  movedTo = this->modifyPage(pageNum, curPage);
+  LeafNode *curLeafNode = (LeafNode *)curPage;
+  if (hasSpaceInLeafNode(curLeafNode)) {
+    insertIntoLeaf(curLeafNode, key, rid);
+    isSplit = false;
+    this->bufMgr->unPinPage(this->file, movedTo, true);
+    return;
+  }
+  std::cout << "Leaf split case" << std::endl;
+  // Create another page and move the upper half of the entries, the new one
+  // included, to it
+  Page *newPage;
+  PageId newPageNum;
+  this->allocIndexPage(newPageNum, newPage);
+  LeafNode *newLeafNode = (LeafNode *)newPage;
+  splitLeaf(this->splitArena, curLeafNode, newLeafNode, key, rid);
+  std::cout << "new leaf node with page id " << newPageNum << " has length "
+            << newLeafNode->len << std::endl;
+  std::cout << "cur leaf node with page id " << movedTo << " has length "
+            << curLeafNode->len << std::endl;
+  newLeafNode->rightSibPageNo = curLeafNode->rightSibPageNo;
+  curLeafNode->rightSibPageNo = newPageNum;
+  // The first key of the new leaf is copied up
+  isSplit = true;
+  splitKey = nodeKey(newLeafNode->keyArray[0]);
+  splitRightNodePageId = newPageNum;
+  this->bufMgr->unPinPage(this->file, movedTo, true);
+  this->bufMgr->unPinPage(this->file, newPageNum, true);
+}
+
+PageId BTreeIndex::modifyPage(const PageId pageNo, Page *&page) {
+  this->bufMgr->readPage(this->file, pageNo, page);
+  if (this->storage == IN_PLACE_STORAGE) {
+    this->preservePage(pageNo, page);
+    return pageNo;
+  }
+  if (this->txnPages.count(pageNo) != 0) {
+    return pageNo;
+  }
+  // A commit or a snapshot may read the page, modify a copy of it
+  PageId copyPageNo;
+  Page *copy;
+  this->allocIndexPage(copyPageNo, copy);
+  *copy = *page;
+  this->bufMgr->unPinPage(this->file, pageNo, false);
+  this->freePage(pageNo);
+  page = copy;
+  return copyPageNo;
+}
+
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::startScan
+// -----------------------------------------------------------------------------
+
+/**
+ * Returns the index of the first key of a leaf satisfying the low bound of a
+ * scan, len if there is none.
+ */
+template <class LeafNode>
+static int firstInRange(const LeafNode *leaf, const IndexKey &lowValKey,
+                        const Operator lowOp) {
+  return lowOp == GT ? upperBound(leaf, lowValKey)
+                     : lowerBound(leaf, lowValKey);
+}
+
+/**
+ * Returns true if a key is past the high bound of a scan.
+ */
+static inline bool pastHigh(const IndexKey &key, const IndexKey &highValKey,
+                            const Operator highOp) {
+  const int result = key.compare(highValKey);
+  return highOp == LT ? result >= 0 : result > 0;
+}
+
+const void BTreeIndex::startScan(const void *lowValParm,
+                                 const Operator lowOpParm,
+                                 const void *highValParm,
+                                 const Operator highOpParm) {
+  if (!this->tryStartScan(lowValParm, lowOpParm, highValParm, highOpParm)) {
+    throw NoSuchKeyFoundException();
+  }
+}
+
+const bool BTreeIndex::tryStartScan(const void *lowValParm,
+                                    const Operator lowOpParm,
+                                    const void *highValParm,
+                                    const Operator highOpParm) {
+  return this->tryStartScanOn(this->scan, this->rootPageNum, this->isRootLeaf,
+                              0, lowValParm, lowOpParm, highValParm,
+                              highOpParm);
+}
+
+bool BTreeIndex::tryStartScanOn(ScanCursor &cursor, const PageId rootPageNo,
+                                const bool rootIsLeaf,
+                                const std::uint32_t snapshotId,
+                                const void *lowValParm,
+                                const Operator lowOpParm,
+                                const void *highValParm,
+                                const Operator highOpParm) {
+  // Check if another scan is executing
+  // If another scan is executing, end that scan
+  if (cursor.scanExecuting) {
+    this->endScanOn(cursor);
+  }
+  if (lowOpParm == Operator::LT || lowOpParm == Operator::LTE) {
+    throw BadOpcodesException();
+  }
+  if (highOpParm == Operator::GT || highOpParm == Operator::GTE) {
+    throw BadOpcodesException();
+  }
+  // Set up scan variables
+  cursor.scanExecuting = true;
+  cursor.lowOp = lowOpParm;
+  cursor.highOp = highOpParm;
+  cursor.lowValKey = IndexKey::fromValue(this->attributeType, lowValParm);
+  cursor.highValKey = IndexKey::fromValue(this->attributeType, highValParm);
+  if (cursor.highValKey < cursor.lowValKey) {
+    throw BadScanrangeException();
+  }
+  cursor.bufMgr = this->bufMgr;
+  return this->seekScan(cursor, rootPageNo, rootIsLeaf, snapshotId);
+}
+
+bool BTreeIndex::seekScan(ScanCursor &cursor, const PageId rootPageNo,
+                          const bool rootIsLeaf,
+                          const std::uint32_t snapshotId) {
+  cursor.nextEntry = INVALID_KEY_INDEX;
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    this->startScanIn<LeafNodeNormalized, NonLeafNodeNormalized>(
+        cursor, rootPageNo, rootIsLeaf, snapshotId);
+  } else if (this->attributeType == Datatype::INTEGER) {
+    this->startScanIn<LeafNodeInt, NonLeafNodeInt>(cursor, rootPageNo,
+                                                   rootIsLeaf, snapshotId);
+  } else if (this->attributeType == Datatype::DOUBLE) {
+    this->startScanIn<LeafNodeDouble, NonLeafNodeDouble>(
+        cursor, rootPageNo, rootIsLeaf, snapshotId);
+  } else if (this->attributeType == Datatype::STRING) {
+    this->startScanIn<LeafNodeString, NonLeafNodeString>(
+        cursor, rootPageNo, rootIsLeaf, snapshotId);
+  }
+  if (cursor.nextEntry == INVALID_KEY_INDEX) {
+    // Nothing to scan, no page is kept pinned until the scan is ended
+    this->leaveLeaf(cursor);
+    cursor.pathPages.clear();
+    cursor.pathSlots.clear();
+    return false;
+  }
+  return true;
+}
 
+template <class LeafNode, class NonLeafNode>
+void BTreeIndex::startScanIn(ScanCursor &cursor, const PageId rootPageNo,
+                             const bool rootIsLeaf,
+                             const std::uint32_t snapshotId) {
+  PageId curPageNum = rootPageNo;
+  Page *curPage;
+  cursor.pathPages.clear();
+  cursor.pathSlots.clear();
+  if (!rootIsLeaf) {
+    // Navigate till the node which is just above the leaf node, unpinning
+    // each page. Separator keys are the first key of their right child, so
+    // keys equal to the low value may also end the child left of them
+    while (true) {
+      const PageId readPageNo = this->pageInSnapshot(curPageNum, snapshotId);
+      cursor.bufMgr->readPage(this->file, readPageNo, curPage);
+      const NonLeafNode *curNode = (const NonLeafNode *)curPage;
+      const bool aboveLeaves = curNode->level == 1;
+      const int slot = lowerBound(curNode, cursor.lowValKey);
+      cursor.pathPages.push_back(curPageNum);
+      cursor.pathSlots.push_back(slot);
+      curPageNum = curNode->pageNoArray[slot];
+      cursor.bufMgr->unPinPage(this->file, readPageNo, false);
+      if (aboveLeaves) {
+        break;
       }
-      throw IndexScanCompletedException();
     }
-    if (this->attributeType == Datatype::INTEGER) {
-      // Cast the curPage to leaf page node
-      LeafNodeInt *curLeafNode = (LeafNodeInt *)this->currentPageData;
-      // Before setting the record id, check if it matches the criteria
-      if (this->highOp == LT &&
-          curLeafNode->keyArray[this->nextEntry] >= this->highValInt) {
-          try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-        throw IndexScanCompletedException();
-      }
-      if (this->highOp == LTE &&
-          curLeafNode->keyArray[this->nextEntry] > this->highValInt) {
-          try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-        throw IndexScanCompletedException();
+  }
+  // Iterate over the leaf nodes and its siblings until a key is found
+  // satisfying the criteria or the end of index is reached
+  while (true) {
+    this->enterLeaf(cursor, curPageNum, snapshotId);
+    const LeafNode *curLeafNode = (const LeafNode *)cursor.currentPageData;
+    const int first =
+        firstInRange(curLeafNode, cursor.lowValKey, cursor.lowOp);
+    const bool found = first < curLeafNode->len;
+    if (found && !pastHigh(nodeKey(curLeafNode->keyArray[first]),
+                           cursor.highValKey, cursor.highOp)) {
+      cursor.nextEntry = first;
+    }
+    PageId nextPageNo;
+    if (found || !this->nextLeaf<NonLeafNode>(cursor, snapshotId,
+                                              curLeafNode->rightSibPageNo,
+                                              nextPageNo)) {
+      return;
+    }
+    curPageNum = nextPageNo;
+  }
+}
+
+template <class NonLeafNode>
+bool BTreeIndex::nextLeaf(ScanCursor &cursor, const std::uint32_t snapshotId,
+                          const PageId rightSibPageNo, PageId &nextPageNo) {
+  if (this->storage == IN_PLACE_STORAGE) {
+    nextPageNo = rightSibPageNo;
+    return nextPageNo != INVALID_PAGE;
+  }
+  // Go up to the first node of the path with a child right of the one
+  // followed, then down the leftmost children of that child
+  while (!cursor.pathPages.empty()) {
+    const PageId readPageNo =
+        this->pageInSnapshot(cursor.pathPages.back(), snapshotId);
+    Page *page;
+    cursor.bufMgr->readPage(this->file, readPageNo, page);
+    const NonLeafNode *node = (const NonLeafNode *)page;
+    const int slot = cursor.pathSlots.back() + 1;
+    if (slot > node->len) {
+      cursor.bufMgr->unPinPage(this->file, readPageNo, false);
+      cursor.pathPages.pop_back();
+      cursor.pathSlots.pop_back();
+      continue;
+    }
+    cursor.pathSlots.back() = slot;
+    nextPageNo = node->pageNoArray[slot];
+    bool aboveLeaves = node->level == 1;
+    cursor.bufMgr->unPinPage(this->file, readPageNo, false);
+    while (!aboveLeaves) {
+      cursor.pathPages.push_back(nextPageNo);
+      cursor.pathSlots.push_back(0);
+      const PageId childPageNo = this->pageInSnapshot(nextPageNo, snapshotId);
+      cursor.bufMgr->readPage(this->file, childPageNo, page);
+      node = (const NonLeafNode *)page;
+      aboveLeaves = node->level == 1;
+      nextPageNo = node->pageNoArray[0];
+      cursor.bufMgr->unPinPage(this->file, childPageNo, false);
+    }
+    return true;
+  }
+  return false;
+}
+
+void BTreeIndex::enterLeaf(ScanCursor &cursor, const PageId pageNo,
+                           const std::uint32_t snapshotId) {
+  this->leaveLeaf(cursor);
+  cursor.currentPageNum = pageNo;
+  if (snapshotId == 0) {
+    cursor.bufMgr->readPage(this->file, pageNo, cursor.currentPageData);
+    cursor.leafPinned = true;
+    return;
+  }
+  // The page may be modified in place before the scan leaves it, keep the
+  // version of the snapshot
+  const PageId readPageNo = this->pageInSnapshot(pageNo, snapshotId);
+  Page *page;
+  cursor.bufMgr->readPage(this->file, readPageNo, page);
+  *cursor.currentPageData = *page;
+  cursor.bufMgr->unPinPage(this->file, readPageNo, false);
+}
+
+void BTreeIndex::leaveLeaf(ScanCursor &cursor) {
+  if (cursor.leafPinned) {
+    cursor.leafPinned = false;
+    cursor.bufMgr->unPinPage(this->file, cursor.currentPageNum, false);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::scanNext
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::scanNext(RecordId &outRid) {
+  if (!this->tryScanNext(outRid)) {
+    throw IndexScanCompletedException();
+  }
+}
+
+const bool BTreeIndex::tryScanNext(RecordId &outRid) {
+  return this->tryScanNextOn(this->scan, 0, outRid, NULL);
+}
+
+const bool BTreeIndex::tryScanNext(RecordId &outRid, IndexKey &outKey) {
+  return this->tryScanNextOn(this->scan, 0, outRid, &outKey);
+}
+
+bool BTreeIndex::tryScanNextOn(ScanCursor &cursor,
+                               const std::uint32_t snapshotId,
+                               RecordId &outRid, IndexKey *outKey) {
+  if (!cursor.scanExecuting) {
+    throw ScanNotInitializedException();
+  }
+  // Check if nextEntry is valid or not (points to valid entry in the page or
+  // not)
+  if (cursor.nextEntry == INVALID_KEY_INDEX) {
+    return false;
+  }
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    return this->scanNextIn<LeafNodeNormalized, NonLeafNodeNormalized>(
+        cursor, snapshotId, outRid, outKey);
+  } else if (this->attributeType == Datatype::INTEGER) {
+    return this->scanNextIn<LeafNodeInt, NonLeafNodeInt>(cursor, snapshotId,
+                                                         outRid, outKey);
+  } else if (this->attributeType == Datatype::DOUBLE) {
+    return this->scanNextIn<LeafNodeDouble, NonLeafNodeDouble>(
+        cursor, snapshotId, outRid, outKey);
+  }
+  return this->scanNextIn<LeafNodeString, NonLeafNodeString>(
+      cursor, snapshotId, outRid, outKey);
+}
+
+template <class LeafNode, class NonLeafNode>
+bool BTreeIndex::scanNextIn(ScanCursor &cursor, const std::uint32_t snapshotId,
+                            RecordId &outRid, IndexKey *outKey) {
+  const LeafNode *curLeafNode = (const LeafNode *)cursor.currentPageData;
+  // Before setting the record id, check if it matches the criteria
+  if (pastHigh(nodeKey(curLeafNode->keyArray[cursor.nextEntry]),
+               cursor.highValKey, cursor.highOp)) {
+    cursor.nextEntry = INVALID_KEY_INDEX;
+    return false;
+  }
+  outRid = curLeafNode->ridArray[cursor.nextEntry];
+  if (outKey != NULL) {
+    *outKey = nodeKey(curLeafNode->keyArray[cursor.nextEntry]);
+  }
+  cursor.nextEntry += 1;
+  if (cursor.nextEntry < curLeafNode->len) {
+    if (pastHigh(nodeKey(curLeafNode->keyArray[cursor.nextEntry]),
+                 cursor.highValKey, cursor.highOp)) {
+      // Reached the end of the scan
+      cursor.nextEntry = INVALID_KEY_INDEX;
+    }
+    return true;
+  }
+  // Reached the end of the current page, need to read the sibling page
+  PageId siblingPageNo;
+  if (!this->nextLeaf<NonLeafNode>(cursor, snapshotId,
+                                   curLeafNode->rightSibPageNo,
+                                   siblingPageNo)) {
+    cursor.nextEntry = INVALID_KEY_INDEX;
+    return true;
+  }
+  this->enterLeaf(cursor, siblingPageNo, snapshotId);
+  curLeafNode = (const LeafNode *)cursor.currentPageData;
+  // Check if the first entry of the new sibling page is valid or not as per
+  // scan critiera
+  if (pastHigh(nodeKey(curLeafNode->keyArray[0]), cursor.highValKey,
+               cursor.highOp)) {
+    cursor.nextEntry = INVALID_KEY_INDEX;
+  } else {
+    cursor.nextEntry = 0;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::endScan
+// -----------------------------------------------------------------------------
+//
+const void BTreeIndex::endScan() { this->endScanOn(this->scan); }
+
+void BTreeIndex::endScanOn(ScanCursor &cursor) {
+  if (!cursor.scanExecuting) {
+    throw ScanNotInitializedException();
+  }
+  cursor.scanExecuting = false;
+  cursor.nextEntry = INVALID_KEY_INDEX;
+  this->leaveLeaf(cursor);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::parallelScan
+// -----------------------------------------------------------------------------
+
+/**
+ * Number of nodes per sub-range splitRange looks for before sharing the
+ * nodes out, so sub-ranges differ by a fraction of a node.
+ */
+static const std::size_t SPLIT_NODES_PER_SUBRANGE = 4;
+
+void BTreeIndex::splitRange(const void *lowVal, const void *highVal,
+                            const std::size_t subranges,
+                            std::vector<IndexKey> &cuts) {
+  const IndexKey lowValKey = IndexKey::fromValue(this->attributeType, lowVal);
+  const IndexKey highValKey =
+      IndexKey::fromValue(this->attributeType, highVal);
+  if (highValKey < lowValKey) {
+    throw BadScanrangeException();
+  }
+  cuts.clear();
+  if (this->isRootLeaf || subranges < 2) {
+    return;
+  }
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    this->splitRangeIn<NonLeafNodeNormalized>(lowValKey, highValKey,
+                                              subranges, cuts);
+  } else if (this->attributeType == Datatype::INTEGER) {
+    this->splitRangeIn<NonLeafNodeInt>(lowValKey, highValKey, subranges,
+                                       cuts);
+  } else if (this->attributeType == Datatype::DOUBLE) {
+    this->splitRangeIn<NonLeafNodeDouble>(lowValKey, highValKey, subranges,
+                                          cuts);
+  } else if (this->attributeType == Datatype::STRING) {
+    this->splitRangeIn<NonLeafNodeString>(lowValKey, highValKey, subranges,
+                                          cuts);
+  }
+}
+
+template <class NonLeafNode>
+void BTreeIndex::splitRangeIn(const IndexKey &lowValKey,
+                              const IndexKey &highValKey,
+                              const std::size_t subranges,
+                              std::vector<IndexKey> &cuts) {
+  // separators[i] is the lowest key of nodes[i + 1]
+  std::vector<PageId> nodes(1, this->rootPageNum);
+  std::vector<IndexKey> separators;
+  bool leaves = false;
+  while (!leaves && nodes.size() < subranges * SPLIT_NODES_PER_SUBRANGE) {
+    std::vector<PageId> children;
+    std::vector<IndexKey> childSeparators;
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+      if (i > 0) {
+        childSeparators.push_back(separators[i - 1]);
       }
-      // Read the nextEntry, its valid now since we are validating it in the
-      // function start
-      RecordId entryRid = curLeafNode->ridArray[this->nextEntry];
-      outRid = entryRid;
-      // Update the nextEntry member
-      this->nextEntry += 1;
-      if (this->nextEntry < curLeafNode->len) {
-        // Fetch the record from this page
-        // Check if the nextEntry matches the scan criteria
-        if (this->highOp == LT) {
-          if (curLeafNode->keyArray[this->nextEntry] >= this->highValInt) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          }
-        } else if (this->highOp == LTE) {
-          if (curLeafNode->keyArray[this->nextEntry] > this->highValInt) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          }
-        }
-      } else {
-        // Reached the end of the current page, need to read the sibling page
-        if (curLeafNode->rightSibPageNo == INVALID_PAGE) {
-          this->nextEntry = INVALID_KEY_INDEX;
-          // Reached the end
-          try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-          return;
+      Page *page;
+      this->bufMgr->readPage(this->file, nodes[i], page);
+      const NonLeafNode *node = (const NonLeafNode *)page;
+      // Children holding the low and the high value, as startScanIn finds
+      // them
+      const int first = lowerBound(node, lowValKey);
+      const int last = upperBound(node, highValKey);
+      for (int slot = first; slot <= last; slot++) {
+        if (slot > first) {
+          childSeparators.push_back(nodeKey(node->keyArray[slot - 1]));
         }
-        PageId siblingPageNo = curLeafNode->rightSibPageNo;
-        // Unpin the current page
-        try {
-          this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-        } catch(...) {
-        }
-        this->currentPageNum = siblingPageNo;
-        // Read the sibling page and keep it pinned
-        this->bufMgr->readPage(this->file, this->currentPageNum,
-                               this->currentPageData);
-        // Cast the page to leaf node
-        curLeafNode = (LeafNodeInt *)this->currentPageData;
-        // Check if the first entry of the new sibling page is valid or not as
-        // per scan critiera
-        if (this->highOp == LT) {
-          if (curLeafNode->keyArray[0] >= this->highValInt) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          } else {
-            this->nextEntry = 0;
-          }
-        } else if (this->highOp == LTE) {
-          if (curLeafNode->keyArray[0] > this->highValInt) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          } else {
-            this->nextEntry = 0;
-          }
-        }
-        this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+        children.push_back(node->pageNoArray[slot]);
       }
-    } else if (this->attributeType == Datatype::DOUBLE) {
-      // Cast the curPage to leaf page node
-      LeafNodeDouble *curLeafNode = (LeafNodeDouble *)this->currentPageData;
-      // Before setting the record id, check if it matches the criteria
-      if (this->highOp == LT &&
-          curLeafNode->keyArray[this->nextEntry] >= this->highValDouble) {
-          try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-        throw IndexScanCompletedException();
+      leaves = node->level == 1;
+      this->bufMgr->unPinPage(this->file, nodes[i], false);
+    }
+    nodes.swap(children);
+    separators.swap(childSeparators);
+  }
+
+  // Share the nodes out. A cut not above the low value would let the
+  // second sub-range start below it, duplicate keys give equal cuts
+  const std::size_t count = std::min(subranges, nodes.size());
+  for (std::size_t j = 1; j < count; j++) {
+    const IndexKey &cut = separators[j * nodes.size() / count - 1];
+    if (cut.compare(lowValKey) > 0 &&
+        (cuts.empty() || cut.compare(cuts.back()) > 0)) {
+      cuts.push_back(cut);
+    }
+  }
+}
+
+void BTreeIndex::scanRange(BufMgr *bufMgr, const IndexKey &lowValKey,
+                           const Operator lowOp, const IndexKey &highValKey,
+                           const Operator highOp,
+                           std::vector<RIDKeyPair<IndexKey> > &entries) {
+  ScanCursor cursor;
+  cursor.bufMgr = bufMgr;
+  cursor.scanExecuting = true;
+  cursor.lowValKey = lowValKey;
+  cursor.lowOp = lowOp;
+  cursor.highValKey = highValKey;
+  cursor.highOp = highOp;
+  try {
+    if (this->seekScan(cursor, this->rootPageNum, this->isRootLeaf, 0)) {
+      RIDKeyPair<IndexKey> entry;
+      while (this->tryScanNextOn(cursor, 0, entry.rid, &entry.key)) {
+        entries.push_back(entry);
       }
-      if (this->highOp == LTE &&
-          curLeafNode->keyArray[this->nextEntry] > this->highValDouble) {
-             try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-        throw IndexScanCompletedException();
+    }
+  } catch (...) {
+    this->endScanOn(cursor);
+    throw;
+  }
+  this->endScanOn(cursor);
+}
+
+void BTreeIndex::parallelScan(const void *lowVal, const Operator lowOp,
+                              const void *highVal, const Operator highOp,
+                              const std::size_t subranges,
+                              WorkStealingPool &pool,
+                              const ScanDelivery delivery,
+                              const SubrangeVisitor &visitor) {
+  if (lowOp == Operator::LT || lowOp == Operator::LTE) {
+    throw BadOpcodesException();
+  }
+  if (highOp == Operator::GT || highOp == Operator::GTE) {
+    throw BadOpcodesException();
+  }
+  const IndexKey lowValKey = IndexKey::fromValue(this->attributeType, lowVal);
+  const IndexKey highValKey =
+      IndexKey::fromValue(this->attributeType, highVal);
+  std::vector<IndexKey> cuts;
+  this->splitRange(lowVal, highVal, subranges, cuts);
+  const std::size_t count = cuts.size() + 1;
+
+  // Delivery state shared by the tasks, under latch
+  std::mutex latch;
+  std::size_t nextDelivered = 0;
+  std::vector<std::vector<RIDKeyPair<IndexKey> > > scanned(count);
+  std::vector<bool> ready(count, false);
+  bool failed = false;
+
+  // The tasks share the buffer manager through a latch, the index keeps its
+  // own for the other operations
+  LatchedBufMgr latchedBufMgr(this->bufMgr);
+  TaskGroup group(pool);
+  for (std::size_t i = 0; i < count; i++) {
+    group.submit([&, i]() {
+      std::vector<RIDKeyPair<IndexKey> > entries;
+      this->scanRange(&latchedBufMgr, i == 0 ? lowValKey : cuts[i - 1],
+                      i == 0 ? lowOp : GTE,
+                      i == count - 1 ? highValKey : cuts[i],
+                      i == count - 1 ? highOp : LT, entries);
+      if (delivery == UNORDERED_DELIVERY) {
+        visitor(i, entries);
+        return;
       }
-      // Read the nextEntry, its valid now since we are validating it in the
-      // function start
-      RecordId entryRid = curLeafNode->ridArray[this->nextEntry];
-      outRid = entryRid;
-      // Update the nextEntry member
-      this->nextEntry += 1;
-      if (this->nextEntry < curLeafNode->len) {
-        // Fetch the record from this page
-        // Check if the nextEntry matches the scan criteria
-        if (this->highOp == LT) {
-          if (curLeafNode->keyArray[this->nextEntry] >= this->highValDouble) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          }
-        } else if (this->highOp == LTE) {
-          if (curLeafNode->keyArray[this->nextEntry] > this->highValDouble) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          }
-        }
-      } else {
-        // Reached the end of the current page, need to read the sibling page
-        if (curLeafNode->rightSibPageNo == INVALID_PAGE) {
-          this->nextEntry = INVALID_KEY_INDEX;
-          // Reached the end
-          try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-          return;
-        }
-        PageId siblingPageNo = curLeafNode->rightSibPageNo;
-        // Unpin the current page
+      // The thread completing the scanned prefix delivers it. A failed scan
+      // leaves the prefix incomplete for good, a failed visitor stops it
+      std::lock_guard<std::mutex> lock(latch);
+      scanned[i].swap(entries);
+      ready[i] = true;
+      for (; !failed && nextDelivered < count && ready[nextDelivered];
+           nextDelivered++) {
         try {
-          this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-        } catch(...) {
-        }
-        this->currentPageNum = siblingPageNo;
-        // Read the sibling page and keep it pinned
-        this->bufMgr->readPage(this->file, this->currentPageNum,
-                               this->currentPageData);
-        // Cast the page to leaf node
-        curLeafNode = (LeafNodeDouble *)this->currentPageData;
-        // Check if the first entry of the new sibling page is valid or not as
-        // per scan critiera
-        if (this->highOp == LT) {
-          if (curLeafNode->keyArray[0] >= this->highValDouble) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          } else {
-            this->nextEntry = 0;
-          }
-        } else if (this->highOp == LTE) {
-          if (curLeafNode->keyArray[0] > this->highValDouble) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          } else {
-            this->nextEntry = 0;
-          }
+          visitor(nextDelivered, scanned[nextDelivered]);
+        } catch (...) {
+          failed = true;
+          throw;
         }
-        this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+        std::vector<RIDKeyPair<IndexKey> >().swap(scanned[nextDelivered]);
       }
-    } else if (this->attributeType == Datatype::STRING) {
-      // Cast the curPage to leaf page node
-      LeafNodeString *curLeafNode = (LeafNodeString *)this->currentPageData;
-      // Before setting the record id, check if it matches the criteria
-      if (this->highOp == LT &&
-          (strncmp(curLeafNode->keyArray[this->nextEntry], this->highValString.c_str(), STRINGSIZE) >= 0)) {
-             try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-        throw IndexScanCompletedException();
-      }
-      if (this->highOp == LTE &&
-          (strncmp(curLeafNode->keyArray[this->nextEntry], this->highValString.c_str(), STRINGSIZE) > 0)) {
-             try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-        throw IndexScanCompletedException();
+    });
+  }
+  group.wait();
+}
+
+// -----------------------------------------------------------------------------
+// Resumable scans
+// -----------------------------------------------------------------------------
+
+void BTreeIndex::startAsyncScan(BufMgr *bufMgr, AsyncScanState &state,
+                                const void *lowVal, const Operator lowOp,
+                                const void *highVal, const Operator highOp) {
+  if (lowOp == Operator::LT || lowOp == Operator::LTE) {
+    throw BadOpcodesException();
+  }
+  if (highOp == Operator::GT || highOp == Operator::GTE) {
+    throw BadOpcodesException();
+  }
+  state.lowValKey = IndexKey::fromValue(this->attributeType, lowVal);
+  state.highValKey = IndexKey::fromValue(this->attributeType, highVal);
+  if (state.highValKey < state.lowValKey) {
+    throw BadScanrangeException();
+  }
+  state.lowOp = lowOp;
+  state.highOp = highOp;
+  state.bufMgr = bufMgr;
+  state.pinnedPage = NULL;
+  state.phase =
+      this->isRootLeaf ? AsyncScanState::LEAF : AsyncScanState::DESCEND;
+  state.pageNo = this->rootPageNum;
+  state.seeking = true;
+  state.pathPages.clear();
+  state.pathSlots.clear();
+}
+
+AsyncStatus BTreeIndex::resumeScan(
+    AsyncScanState &state, std::vector<RIDKeyPair<IndexKey> > &entries) {
+  if (this->keyEncoding == NORMALIZED_KEYS) {
+    return this->resumeScanIn<LeafNodeNormalized, NonLeafNodeNormalized>(
+        state, entries);
+  } else if (this->attributeType == Datatype::INTEGER) {
+    return this->resumeScanIn<LeafNodeInt, NonLeafNodeInt>(state, entries);
+  } else if (this->attributeType == Datatype::DOUBLE) {
+    return this->resumeScanIn<LeafNodeDouble, NonLeafNodeDouble>(state,
+                                                                 entries);
+  }
+  return this->resumeScanIn<LeafNodeString, NonLeafNodeString>(state,
+                                                               entries);
+}
+
+template <class LeafNode, class NonLeafNode>
+AsyncStatus BTreeIndex::resumeScanIn(
+    AsyncScanState &state, std::vector<RIDKeyPair<IndexKey> > &entries) {
+  // Each step pins one page and unpins it before the next, the scan keeps
+  // page numbers only so it can be suspended between any two steps
+  while (state.phase != AsyncScanState::DONE) {
+    const PageId readPageNo = state.phase == AsyncScanState::ASCEND
+                                  ? state.pathPages.back()
+                                  : state.pageNo;
+    Page *page = state.pinnedPage;
+    state.pinnedPage = NULL;
+    if (page == NULL &&
+        !state.bufMgr->tryReadCachedPage(this->file, readPageNo, page)) {
+      state.pageNo = readPageNo;
+      return ASYNC_WAITING;
+    }
+    if (state.phase == AsyncScanState::DESCEND) {
+      // Same descent as startScanIn, or down the leftmost children once
+      // the range was entered
+      const NonLeafNode *node = (const NonLeafNode *)page;
+      const int slot = state.seeking ? lowerBound(node, state.lowValKey) : 0;
+      state.pathPages.push_back(state.pageNo);
+      state.pathSlots.push_back(slot);
+      state.pageNo = node->pageNoArray[slot];
+      if (node->level == 1) {
+        state.phase = AsyncScanState::LEAF;
       }
-      // Read the nextEntry, its valid now since we are validating it in the
-      // function start
-      RecordId entryRid = curLeafNode->ridArray[this->nextEntry];
-      // std::cout<<curLeafNode->keyArray[this->nextEntry]<<std::endl;
-      // std::cout<<"&&&&&&&&&&&&&&&&&"<<std::endl;
-      outRid = entryRid;
-      std::string s(curLeafNode->keyArray[this->nextEntry], 10);
-      // std::cout<<s<<std::endl;
-      // Update the nextEntry member
-      this->nextEntry += 1;
-      if (this->nextEntry < curLeafNode->len) {
-        // Fetch the record from this page
-        // Check if the nextEntry matches the scan criteria
-        if (this->highOp == LT) {
-          if (strncmp(curLeafNode->keyArray[this->nextEntry], this->highValString.c_str(), STRINGSIZE) >= 0) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          }
-        } else if (this->highOp == LTE) {
-          if (strncmp(curLeafNode->keyArray[this->nextEntry], this->highValString.c_str(), STRINGSIZE) > 0) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          }
+      state.bufMgr->unPinPage(this->file, readPageNo, false);
+      continue;
+    }
+    if (state.phase == AsyncScanState::ASCEND) {
+      const NonLeafNode *node = (const NonLeafNode *)page;
+      const int slot = state.pathSlots.back() + 1;
+      if (slot > node->len) {
+        state.pathPages.pop_back();
+        state.pathSlots.pop_back();
+        if (state.pathPages.empty()) {
+          state.phase = AsyncScanState::DONE;
         }
       } else {
-        // Reached the end of the current page, need to read the sibling page
-        if (curLeafNode->rightSibPageNo == INVALID_PAGE) {
-          this->nextEntry = INVALID_KEY_INDEX;
-          // Reached the end
-          try {
-            this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
-          } catch(...) {
-          }
-          return;
-        }
-        PageId siblingPageNo = curLeafNode->rightSibPageNo;
-        this->currentPageNum = siblingPageNo;
-        // Read the sibling page and keep it pinned
-        this->bufMgr->readPage(this->file, this->currentPageNum,
-                               this->currentPageData);
-        // Cast the page to leaf node
-        curLeafNode = (LeafNodeString *)this->currentPageData;
-        // Check if the first entry of the new sibling page is valid or not as
-        // per scan critiera
-        if (this->highOp == LT) {        
-          if (strncmp(curLeafNode->keyArray[0], this->highValString.c_str(), STRINGSIZE) >= 0) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          } else {
-            this->nextEntry = 0;
-          }
-        } else if (this->highOp == LTE) {
-          if (strncmp(curLeafNode->keyArray[0], this->highValString.c_str(), STRINGSIZE) > 0) {
-            // Reached the end of the scan
-            this->nextEntry = INVALID_KEY_INDEX;
-          } else {
-            this->nextEntry = 0;
-          }
-        }
-        this->bufMgr->unPinPage(this->file, this->currentPageNum, false);
+        state.pathSlots.back() = slot;
+        state.pageNo = node->pageNoArray[slot];
+        state.phase = node->level == 1 ? AsyncScanState::LEAF
+                                       : AsyncScanState::DESCEND;
+      }
+      state.bufMgr->unPinPage(this->file, readPageNo, false);
+      continue;
+    }
+    const LeafNode *leaf = (const LeafNode *)page;
+    int entry = state.seeking
+                    ? firstInRange(leaf, state.lowValKey, state.lowOp)
+                    : 0;
+    const std::size_t found = entries.size();
+    bool past = false;
+    for (; entry < leaf->len; entry++) {
+      const IndexKey key = nodeKey(leaf->keyArray[entry]);
+      if (pastHigh(key, state.highValKey, state.highOp)) {
+        past = true;
+        break;
       }
+      RIDKeyPair<IndexKey> pair;
+      pair.set(leaf->ridArray[entry], key);
+      entries.push_back(pair);
+    }
+    if (entry < leaf->len) {
+      state.seeking = false;
+    }
+    const PageId rightSibPageNo = leaf->rightSibPageNo;
+    state.bufMgr->unPinPage(this->file, readPageNo, false);
+    if (past) {
+      state.phase = AsyncScanState::DONE;
+    } else if (this->storage == IN_PLACE_STORAGE) {
+      state.pageNo = rightSibPageNo;
+      if (rightSibPageNo == INVALID_PAGE) {
+        state.phase = AsyncScanState::DONE;
+      }
+    } else {
+      state.phase = state.pathPages.empty() ? AsyncScanState::DONE
+                                            : AsyncScanState::ASCEND;
+    }
+    if (entries.size() > found) {
+      return state.phase == AsyncScanState::DONE ? ASYNC_DONE : ASYNC_READY;
     }
   }
+  return ASYNC_DONE;
+}
 
-  // -----------------------------------------------------------------------------
-  // BTreeIndex::endScan
-  // -----------------------------------------------------------------------------
-  //
-  const void BTreeIndex::endScan() {
-    if (!this->scanExecuting) {
-      throw ScanNotInitializedException();
+// -----------------------------------------------------------------------------
+// Snapshots
+// -----------------------------------------------------------------------------
+
+BTreeSnapshot *BTreeIndex::openSnapshot() {
+  // In APPEND_ONLY_STORAGE, the pages the snapshot reaches are copied before
+  // being modified from now on
+  this->txnPages.clear();
+  const std::uint32_t snapshotId = ++this->lastSnapshotId;
+  this->liveSnapshots.insert(snapshotId);
+  return new BTreeSnapshot(this, snapshotId, this->rootPageNum,
+                           this->isRootLeaf);
+}
+
+PageId BTreeIndex::pageInSnapshot(const PageId pageNo,
+                                  const std::uint32_t snapshotId) const {
+  if (snapshotId == 0) {
+    return pageNo;
+  }
+  std::map<PageId, std::vector<PageVersion> >::const_iterator versions =
+      this->pageVersions.find(pageNo);
+  if (versions == this->pageVersions.end()) {
+    return pageNo;
+  }
+  // The first copy saved for the snapshot or a later one holds the page as
+  // the snapshot saw it, the page was not modified in between
+  for (std::size_t i = 0; i < versions->second.size(); i++) {
+    if (versions->second[i].snapshotId >= snapshotId) {
+      return versions->second[i].pageNo;
     }
-    this->scanExecuting = false;
-    this->nextEntry = INVALID_KEY_INDEX;
-    try {
-      // Unpin all the pages that were pinned
-      this->bufMgr->unPinPage(this->file, this->currentPageNum, true);
-    } catch (...) {
+  }
+  return pageNo;
+}
+
+void BTreeIndex::preservePage(const PageId pageNo, const Page *page) {
+  if (this->liveSnapshots.empty()) {
+    return;
+  }
+  const std::uint32_t newest = *this->liveSnapshots.rbegin();
+  std::map<PageId, std::uint32_t>::const_iterator birth =
+      this->pageBirths.find(pageNo);
+  if (birth != this->pageBirths.end() && birth->second >= newest) {
+    // Allocated after the newest snapshot was taken
+    return;
+  }
+  std::vector<PageVersion> &versions = this->pageVersions[pageNo];
+  if (!versions.empty() && versions.back().snapshotId >= newest) {
+    // Already saved as the newest snapshot saw it
+    return;
+  }
+  PageVersion version = {newest, Page::INVALID_NUMBER};
+  Page *copy;
+  this->allocIndexPage(version.pageNo, copy);
+  *copy = *page;
+  this->bufMgr->unPinPage(this->file, version.pageNo, true);
+  versions.push_back(version);
+}
+
+void BTreeIndex::allocIndexPage(PageId &pageNo, Page *&page) {
+  if (this->freePages.empty()) {
+    this->bufMgr->allocPage(this->file, pageNo, page);
+  } else {
+    pageNo = this->freePages.back();
+    this->freePages.pop_back();
+    this->bufMgr->readPage(this->file, pageNo, page);
+    *page = Page();
+  }
+  if (this->storage == APPEND_ONLY_STORAGE) {
+    this->txnPages.insert(pageNo);
+  } else if (this->liveSnapshots.empty()) {
+    this->pageBirths.erase(pageNo);
+  } else {
+    this->pageBirths[pageNo] = *this->liveSnapshots.rbegin();
+  }
+}
+
+void BTreeIndex::closeSnapshot(const std::uint32_t snapshotId) {
+  this->liveSnapshots.erase(snapshotId);
+  // A copy is still needed by the open snapshots taken after the previous
+  // copy of its page and not after the copy itself
+  std::map<PageId, std::vector<PageVersion> >::iterator versions =
+      this->pageVersions.begin();
+  while (versions != this->pageVersions.end()) {
+    std::vector<PageVersion> &list = versions->second;
+    std::vector<PageVersion> kept;
+    std::uint32_t previous = 0;
+    for (std::size_t i = 0; i < list.size(); i++) {
+      std::set<std::uint32_t>::const_iterator reader =
+          this->liveSnapshots.upper_bound(previous);
+      if (reader != this->liveSnapshots.end() &&
+          *reader <= list[i].snapshotId) {
+        kept.push_back(list[i]);
+      } else {
+        this->freePages.push_back(list[i].pageNo);
+      }
+      previous = list[i].snapshotId;
     }
+    if (kept.empty()) {
+      this->pageVersions.erase(versions++);
+    } else {
+      list.swap(kept);
+      ++versions;
+    }
+  }
+  if (this->liveSnapshots.empty()) {
+    this->pageBirths.clear();
+  }
+  this->reclaimPages();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeSnapshot
+// -----------------------------------------------------------------------------
+
+BTreeSnapshot::BTreeSnapshot(BTreeIndex *index, const std::uint32_t snapshotId,
+                             const PageId rootPageNo, const bool rootIsLeaf)
+    : index_(index),
+      snapshotId_(snapshotId),
+      rootPageNo_(rootPageNo),
+      rootIsLeaf_(rootIsLeaf) {}
+
+BTreeSnapshot::~BTreeSnapshot() {
+  if (this->cursor_.scanExecuting) {
+    this->index_->endScanOn(this->cursor_);
   }
-}  // namespace badgerdb
\ No newline at end of file
+  this->index_->closeSnapshot(this->snapshotId_);
+}
+
+void BTreeSnapshot::startScan(const void *lowVal, const Operator lowOp,
+                              const void *highVal, const Operator highOp) {
+  if (!this->tryStartScan(lowVal, lowOp, highVal, highOp)) {
+    throw NoSuchKeyFoundException();
+  }
+}
+
+bool BTreeSnapshot::tryStartScan(const void *lowVal, const Operator lowOp,
+                                 const void *highVal, const Operator highOp) {
+  this->cursor_.currentPageData = &this->leaf_;
+  return this->index_->tryStartScanOn(this->cursor_, this->rootPageNo_,
+                                      this->rootIsLeaf_, this->snapshotId_,
+                                      lowVal, lowOp, highVal, highOp);
+}
+
+void BTreeSnapshot::scanNext(RecordId &outRid) {
+  if (!this->tryScanNext(outRid)) {
+    throw IndexScanCompletedException();
+  }
+}
+
+bool BTreeSnapshot::tryScanNext(RecordId &outRid) {
+  return this->index_->tryScanNextOn(this->cursor_, this->snapshotId_, outRid,
+                                     NULL);
+}
+
+void BTreeSnapshot::endScan() { this->index_->endScanOn(this->cursor_); }
+
+}  // namespace badgerdb
@@ -9,18 +9,25 @@
 #pragma once
 
 #include <limits.h>
+#include <stdint.h>
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "arena.h"
+#include "attribute.h"
 #include "buffer.h"
 #include "file.h"
 #include "page.h"
 #include "string.h"
 #include "types.h"
+#include "work_pool.h"
 
 namespace badgerdb {
 
@@ -30,24 +37,50 @@ const PageId INVALID_PAGE = PageId(INT_MIN);
 const int INVALID_KEY_INDEX = INT_MIN;
 
 /**
- * @brief Datatype enumeration type.
+ * @brief Default share of the key slots of a node filled by a bulk load. The
+ * room left lets keys be inserted next to the loaded ones for a while before
+ * the nodes split.
  */
-enum Datatype { INTEGER = 0, DOUBLE = 1, STRING = 2 };
+const double BULKLOAD_FILL_FACTOR = 0.9;
 
 /**
- * @brief Scan operations enumeration. Passed to BTreeIndex::startScan() method.
+ * @brief Page format of a relation. Passed to the BTreeIndex constructor so it
+ * reads the relation with the matching scan.
  */
-enum Operator {
-  LT,  /* Less Than */
-  LTE, /* Less Than or Equal to */
-  GTE, /* Greater Than or Equal to */
-  GT   /* Greater Than */
+enum RelationFormat {
+  SLOTTED_RELATION, /* Page records, read with FileScan */
+  FIXED_RELATION,   /* FixedRecordPage records, read with FixedFileScan */
+  PAX_RELATION,     /* PaxPage records, read with PaxFileScan */
+  COLUMNAR_RELATION /* ColumnarRelation row groups, read with ColumnarScan */
 };
 
 /**
- * @brief Size of String key.
+ * @brief Layout of the keys in the nodes of a BTreeIndex. Passed to the
+ * BTreeIndex constructor.
  */
-const int STRINGSIZE = 10;
+enum KeyEncoding {
+  NATIVE_KEYS,    /* int / double / char[STRINGSIZE] keys, one node type each */
+  NORMALIZED_KEYS /* IndexKey bytes and their heads, one node type for all */
+};
+
+/**
+ * @brief How a BTreeIndex writes its pages. Passed to the BTreeIndex
+ * constructor.
+ */
+enum IndexStorage {
+  IN_PLACE_STORAGE,   /* Nodes are modified in place, one meta page */
+  APPEND_ONLY_STORAGE /* Committed nodes are copied before being modified,
+                         the root is committed through two meta pages */
+};
+
+/**
+ * @brief Order in which BTreeIndex::parallelScan() hands the entries of its
+ * sub-ranges over.
+ */
+enum ScanDelivery {
+  ORDERED_DELIVERY,  /* One sub-range at a time, in key order */
+  UNORDERED_DELIVERY /* Each sub-range once scanned, from the scanning thread */
+};
 
 /**
  * @brief Number of key slots in B+Tree leaf for INTEGER key.
@@ -84,22 +117,42 @@ const int INTARRAYNONLEAFSIZE = (Page::SIZE - 2*sizeof(int) - sizeof(PageId)) /
  * @brief Number of key slots in B+Tree leaf for DOUBLE key.
  */
 //                                                        level        extra
-//                                                        pageNo key pageNo   -1
+//                                                        pageNo head key
+//                                                        pageNo   -1
 //                                                        due to structure
 //                                                        padding
 const int DOUBLEARRAYNONLEAFSIZE =
     ((Page::SIZE - 2*sizeof(int) - sizeof(PageId)) /
-     (sizeof(double) + sizeof(PageId))) -
+     (sizeof(std::uint32_t) + sizeof(double) + sizeof(PageId))) -
     1;
 
 /**
  * @brief Number of key slots in B+Tree leaf for STRING key.
  */
 //                                                        level        extra
-//                                                        pageNo             key
+//                                                        pageNo        head key
 //                                                        pageNo
 const int STRINGARRAYNONLEAFSIZE = (Page::SIZE - 2*sizeof(int) - sizeof(PageId)) /
-                                   (10 * sizeof(char) + sizeof(PageId));
+                                   (sizeof(std::uint32_t) + 10 * sizeof(char) +
+                                    sizeof(PageId));
+
+/**
+ * @brief Number of key slots in B+Tree leaf for NORMALIZED_KEYS.
+ */
+//                                                      sibling ptr len
+//                                                      head key rid
+const int NORMALIZEDARRAYLEAFSIZE =
+    (Page::SIZE - sizeof(PageId) - sizeof(int)) /
+    (sizeof(std::uint32_t) + STRINGSIZE + sizeof(RecordId));
+
+/**
+ * @brief Number of key slots in B+Tree non-leaf for NORMALIZED_KEYS.
+ */
+//                                                      level extra pageNo
+//                                                      head key pageNo
+const int NORMALIZEDARRAYNONLEAFSIZE =
+    (Page::SIZE - 2 * sizeof(int) - sizeof(PageId)) /
+    (sizeof(std::uint32_t) + STRINGSIZE + sizeof(PageId));
 
 /**
  * @brief Structure to store a key-rid pair. It is used to pass the pair to
@@ -117,6 +170,100 @@ class RIDKeyPair {
   }
 };
 
+/**
+ * @brief Key of the index, of any Datatype, held as bytes whose order under
+ * memcmp is the order of the keys, so keys of all types are compared the same
+ * way and passed around without allocating. INTEGER keys are stored big endian
+ * with their sign bit flipped. DOUBLE keys are stored big endian with their
+ * sign bit flipped if positive and all their bits flipped if negative. STRING
+ * keys are their first STRINGSIZE characters, up to the first NUL. Keys are
+ * zero padded to MAX_LENGTH bytes and compared on all of them, so a string
+ * which is a prefix of another is smaller.
+ */
+class IndexKey {
+ public:
+  /**
+   * Largest length of a key, the one of STRING keys.
+   */
+  static const int MAX_LENGTH = STRINGSIZE;
+
+  IndexKey() : length_(0) { memset(bytes_, 0, MAX_LENGTH); }
+
+  static IndexKey fromInt(const int key);
+
+  static IndexKey fromDouble(const double key);
+
+  /**
+   * Key of the first STRINGSIZE characters of a string.
+   */
+  static IndexKey fromString(const char *key);
+
+  /**
+   * @param type   Datatype of the key.
+   * @param key    Pointer to an integer / double / char string.
+   */
+  static IndexKey fromValue(const Datatype type, const void *key);
+
+  /**
+   * Key of MAX_LENGTH bytes of an encoded key, as stored by NORMALIZED_KEYS
+   * nodes.
+   */
+  static IndexKey fromBytes(const unsigned char (&bytes)[MAX_LENGTH]);
+
+  int toInt() const;
+
+  double toDouble() const;
+
+  /**
+   * Copies the characters of a STRING key, zero padded to STRINGSIZE.
+   */
+  void toString(char (&out)[STRINGSIZE]) const;
+
+  const unsigned char *data() const { return bytes_; }
+
+  /**
+   * Number of bytes of the encoding, before the padding. MAX_LENGTH for keys
+   * made by fromBytes.
+   */
+  int length() const { return length_; }
+
+  /**
+   * First 4 bytes of the key as a big endian number, which orders keys as
+   * their first 4 bytes do.
+   */
+  std::uint32_t head() const {
+    return (std::uint32_t)bytes_[0] << 24 | (std::uint32_t)bytes_[1] << 16 |
+           (std::uint32_t)bytes_[2] << 8 | bytes_[3];
+  }
+
+  /**
+   * @return  Negative, zero or positive as the key is smaller than, equal to
+   *          or greater than <other>.
+   */
+  int compare(const IndexKey &other) const {
+    return memcmp(bytes_, other.bytes_, MAX_LENGTH);
+  }
+
+ private:
+  unsigned char bytes_[MAX_LENGTH];
+  unsigned char length_;
+};
+
+inline bool operator<(const IndexKey &a, const IndexKey &b) {
+  return a.compare(b) < 0;
+}
+
+inline bool operator!=(const IndexKey &a, const IndexKey &b) {
+  return a.compare(b) != 0;
+}
+
+/**
+ * @brief Key slot of NORMALIZED_KEYS nodes: the bytes of an IndexKey.
+ */
+struct NormalizedKey {
+  unsigned char bytes[IndexKey::MAX_LENGTH];
+};
+
 /**
  * @brief Structure to store a key page pair which is used to pass the key and
  * page to functions that make any modifications to the non leaf pages of the
@@ -154,7 +301,8 @@ bool operator<(const RIDKeyPair<T> &r1, const RIDKeyPair<T> &r2) {
  * index is created, the byte offset of the key value on which the index is
  * made, the type of the key and the page no of the root page. Root page starts
  * as page 2 but since a split can occur at the root the root page may get moved
- * up and get a new page no.
+ * up and get a new page no. An APPEND_ONLY_STORAGE index has two meta pages,
+ * pages 1 and 2, written in turn by its commits, and its root starts as page 3.
  */
 struct IndexMetaInfo {
   /**
@@ -182,6 +330,56 @@ struct IndexMetaInfo {
    * Indicates whether the root node is a leaf or not
   */
  bool isRootLeaf;
+
+  /**
+   * Layout of the keys in the nodes.
+   */
+  KeyEncoding keyEncoding;
+
+  /**
+   * How the index writes its pages.
+   */
+  IndexStorage storage;
+
+  /**
+   * Number of the commit which wrote the meta page. APPEND_ONLY_STORAGE only,
+   * as is the checksum below.
+   */
+  std::uint32_t txnId;
+
+  /**
+   * First page of the blob chain holding the free pages of the commit,
+   * Page::INVALID_NUMBER if there are none. In IN_PLACE_STORAGE, the pages of
+   * snapshot copies no snapshot needs anymore.
+   */
+  PageId freeListPageNo;
+
+  /**
+   * Checksum of the meta page, computed with this field set to 0. A meta page
+   * whose write was torn by a crash does not match it.
+   */
+  std::uint32_t checksum;
+};
+
+/**
+ * @brief Page of an APPEND_ONLY_STORAGE index no longer part of the current
+ * tree, waiting to be reused.
+ */
+struct FreedPage {
+  PageId pageNo;
+
+  /**
+   * Commit which dropped the page. The meta page of the commit before it,
+   * kept in case the meta page of the next one is torn, still reaches the
+   * page until the commit after it.
+   */
+  std::uint32_t freedTxn;
+
+  /**
+   * Newest snapshot taken when the page was dropped. It and the snapshots
+   * before it may still read the page.
+   */
+  std::uint32_t snapshotId;
 };
 
 /*
@@ -203,7 +401,8 @@ struct NonLeafNodeInt {
   int level;
 
   /**
-   * Stores keys.
+   * Stores keys. At 4 bytes per key they are compact enough to be searched
+   * as they are, without a head array.
    */
   int keyArray[INTARRAYNONLEAFSIZE];
 
@@ -228,6 +427,13 @@ struct NonLeafNodeDouble {
    */
   int level;
 
+  /**
+   * First 4 bytes of the IndexKey of every key, see IndexKey::head(). They
+   * are kept together, ahead of the keys and pages, so the descent searches
+   * a few cache lines of them before reading one key.
+   */
+  std::uint32_t headArray[DOUBLEARRAYNONLEAFSIZE];
+
   /**
    * Stores keys.
    */
@@ -254,6 +460,11 @@ struct NonLeafNodeString {
    */
   int level;
 
+  /**
+   * First 4 bytes of the IndexKey of every key, see IndexKey::head().
+   */
+  std::uint32_t headArray[STRINGARRAYNONLEAFSIZE];
+
   /**
    * Stores keys.
    */
@@ -352,9 +563,236 @@ struct LeafNodeString {
   int len;
 };
 
+/**
+ * @brief Structure for all non-leaf nodes of a NORMALIZED_KEYS index,
+ * whatever the type of the key.
+ */
+struct NonLeafNodeNormalized {
+  /**
+   * Level of the node in the tree.
+   */
+  int level;
+
+  /**
+   * First 4 bytes of every key, see IndexKey::head(). Node searches scan them
+   * before looking at whole keys.
+   */
+  std::uint32_t headArray[NORMALIZEDARRAYNONLEAFSIZE];
+
+  /**
+   * Stores keys.
+   */
+  NormalizedKey keyArray[NORMALIZEDARRAYNONLEAFSIZE];
+
+  /**
+   * Stores page numbers of child pages which themselves are other non-leaf/leaf
+   * nodes in the tree.
+   */
+  PageId pageNoArray[NORMALIZEDARRAYNONLEAFSIZE + 1];
+
+  /**
+   * Length of the node (number of keys in the node)
+  */
+  int len;
+};
+
+/**
+ * @brief Structure for all leaf nodes of a NORMALIZED_KEYS index, whatever
+ * the type of the key.
+ */
+struct LeafNodeNormalized {
+  /**
+   * First 4 bytes of every key, see IndexKey::head().
+   */
+  std::uint32_t headArray[NORMALIZEDARRAYLEAFSIZE];
+
+  /**
+   * Stores keys.
+   */
+  NormalizedKey keyArray[NORMALIZEDARRAYLEAFSIZE];
+
+  /**
+   * Stores RecordIds.
+   */
+  RecordId ridArray[NORMALIZEDARRAYLEAFSIZE];
+
+  /**
+   * Page number of the leaf on the right side.
+   */
+  PageId rightSibPageNo;
+
+  /**
+   * Length of the node (number of keys in the node)
+  */
+  int len;
+};
+
+/**
+ * @brief State of a range scan over a B+ tree: its bounds and the leaf it is
+ * on.
+ */
+struct ScanCursor {
+  /**
+   * True if the scan has been started.
+   */
+  bool scanExecuting;
+
+  /**
+   * Index of next entry to be scanned in current leaf being scanned.
+   */
+  int nextEntry;
+
+  /**
+   * Page number of current leaf being scanned.
+   */
+  PageId currentPageNum;
+
+  /**
+   * Current leaf being scanned. Pinned while the scan is on it, unless the
+   * scan reads a snapshot, which copies its leaves.
+   */
+  Page *currentPageData;
+
+  /**
+   * True if currentPageNum is pinned by the scan.
+   */
+  bool leafPinned;
+
+  /**
+   * Buffer manager the scan reads its pages through and keeps its leaf
+   * pinned in.
+   */
+  BufMgr *bufMgr;
+
+  /**
+   * Low value for scan.
+   */
+  IndexKey lowValKey;
+
+  /**
+   * High value for scan.
+   */
+  IndexKey highValKey;
+
+  /**
+   * Low Operator. Can only be GT(>) or GTE(>=).
+   */
+  Operator lowOp;
+
+  /**
+   * High Operator. Can only be LT(<) or LTE(<=).
+   */
+  Operator highOp;
+
+  /**
+   * Non leaf nodes from the root down to the parent of the current leaf, and
+   * the child followed in each. Scans of an APPEND_ONLY_STORAGE index move to
+   * the next leaf through them, since copied leaves leave the sibling pointers
+   * of their left neighbours stale.
+   */
+  std::vector<PageId> pathPages;
+  std::vector<int> pathSlots;
+
+  ScanCursor()
+      : scanExecuting(false),
+        nextEntry(INVALID_KEY_INDEX),
+        currentPageNum(Page::INVALID_NUMBER),
+        currentPageData(NULL),
+        leafPinned(false),
+        bufMgr(NULL) {}
+};
+
+/**
+ * @brief Progress of a resumable scan, see BTreeIndex::resumeScan.
+ */
+enum AsyncStatus {
+  ASYNC_WAITING, /* Stopped on a page not in the buffer pool */
+  ASYNC_READY,   /* Stopped after appending the entries of a leaf */
+  ASYNC_DONE     /* Past the high value or the last leaf */
+};
+
+/**
+ * @brief State of a range scan which reads only pages already in the buffer
+ * pool and stops on the first one missing, to be resumed once the page is
+ * read. Nothing is kept pinned in between.
+ */
+struct AsyncScanState {
+  /**
+   * Bounds of the scan, as in ScanCursor.
+   */
+  IndexKey lowValKey;
+  IndexKey highValKey;
+  Operator lowOp;
+  Operator highOp;
+
+  /**
+   * Step the scan resumes at: going down a non leaf node, reading a leaf,
+   * going up the path to the next leaf (APPEND_ONLY_STORAGE), or done.
+   */
+  enum Phase { DESCEND, LEAF, ASCEND, DONE } phase;
+
+  /**
+   * Page the step reads, unused by ASCEND which reads the end of the path.
+   * Page::INVALID_NUMBER until the scan is started.
+   */
+  PageId pageNo;
+
+  /**
+   * True until the first entry of the range is found: nodes are searched for
+   * the low value instead of being entered at their first entry.
+   */
+  bool seeking;
+
+  /**
+   * Non leaf nodes from the root down to the parent of the leaf, and the
+   * child followed in each, as in ScanCursor.
+   */
+  std::vector<PageId> pathPages;
+  std::vector<int> pathSlots;
+
+  /**
+   * Buffer manager the scan reads its pages through.
+   */
+  BufMgr *bufMgr;
+
+  /**
+   * Page the scan waited for, pinned for it by whoever read it, NULL if none.
+   * The next step uses it instead of looking the page up, so it cannot be
+   * evicted before the scan resumes.
+   */
+  Page *pinnedPage;
+
+  AsyncScanState()
+      : phase(DONE),
+        pageNo(Page::INVALID_NUMBER),
+        seeking(false),
+        bufMgr(NULL),
+        pinnedPage(NULL) {}
+};
+
+/**
+ * @brief Copy of a page of a BTreeIndex as it was when a snapshot was taken,
+ * saved before the page was first modified afterwards.
+ */
+struct PageVersion {
+  /**
+   * Newest snapshot the copy was saved for. It serves that snapshot and the
+   * ones taken since the previous copy of the page.
+   */
+  std::uint32_t snapshotId;
+
+  /**
+   * Page of the index file holding the copy.
+   */
+  PageId pageNo;
+};
+
+class BTreeSnapshot;
+
 /**
  * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute
- * of a relation. This index supports only one scan at a time.
+ * of a relation. This index supports only one scan at a time, and any number
+ * of snapshots, each with a scan of its own.
  */
 class BTreeIndex {
  private:
@@ -388,6 +826,16 @@ class BTreeIndex {
    */
   int attrByteOffset;
 
+  /**
+   * Layout of the keys in the nodes.
+   */
+  KeyEncoding keyEncoding;
+
+  /**
+   * How the index writes its pages.
+   */
+  IndexStorage storage;
+
   /**
    * Number of keys in leaf node, depending upon the type of key.
    */
@@ -398,67 +846,74 @@ class BTreeIndex {
    */
   int nodeOccupancy;
 
-  // MEMBERS SPECIFIC TO SCANNING
-
   /**
-   * True if an index scan has been started.
+   * Scratch memory for the temporaries of node splits, rewound after every
+   * split.
    */
-  bool scanExecuting;
+  Arena splitArena;
 
-  /**
-   * Index of next entry to be scanned in current leaf being scanned.
-   */
-  int nextEntry;
+  // MEMBERS SPECIFIC TO SCANNING
 
   /**
-   * Page number of current page being scanned.
+   * The scan of the index itself, over the current tree.
    */
-  PageId currentPageNum;
+  ScanCursor scan;
+
+  // MEMBERS SPECIFIC TO SNAPSHOTS
 
   /**
-   * Current Page being scanned.
+   * Ids of the open snapshots, in the order they were taken. Ids start at 1,
+   * 0 stands for the current tree.
    */
-  Page *currentPageData;
+  std::set<std::uint32_t> liveSnapshots;
 
   /**
-   * Low INTEGER value for scan.
+   * Id of the last snapshot taken.
    */
-  int lowValInt;
+  std::uint32_t lastSnapshotId;
 
   /**
-   * Low DOUBLE value for scan.
+   * Saved copies of the pages modified since a snapshot still open was
+   * taken, oldest first.
    */
-  double lowValDouble;
+  std::map<PageId, std::vector<PageVersion> > pageVersions;
 
   /**
-   * Low STRING value for scan.
+   * Pages allocated while a snapshot was open, with the newest snapshot at
+   * that time. Those snapshots cannot reach them, so they are not copied.
    */
-  std::string lowValString;
+  std::map<PageId, std::uint32_t> pageBirths;
 
   /**
-   * High INTEGER value for scan.
+   * Pages of copies no open snapshot needs anymore, reused before the file
+   * is grown. In APPEND_ONLY_STORAGE, the freed pages no commit or snapshot
+   * can reach anymore.
    */
-  int highValInt;
+  std::vector<PageId> freePages;
+
+  // MEMBERS SPECIFIC TO APPEND_ONLY_STORAGE
 
   /**
-   * High DOUBLE value for scan.
+   * Number of the last commit.
    */
-  double highValDouble;
+  std::uint32_t committedTxn;
 
   /**
-   * High STRING value for scan.
+   * Pages allocated since the last commit or snapshot, which no meta page or
+   * snapshot reaches and which are modified in place.
    */
-  std::string highValString;
+  std::set<PageId> txnPages;
 
   /**
-   * Low Operator. Can only be GT(>) or GTE(>=).
+   * Pages dropped from the tree which may still be read through an older
+   * meta page or a snapshot.
    */
-  Operator lowOp;
+  std::vector<FreedPage> freedPages;
 
   /**
-   * High Operator. Can only be LT(<) or LTE(<=).
+   * Pages of the blob chain holding the free pages of the last commit.
    */
-  Operator highOp;
+  std::vector<PageId> freeListChain;
 
   /*
   * Indicates whether the root node is a leaf or not
@@ -477,12 +932,335 @@ class BTreeIndex {
    * */
   void setNodeOccupancy(const Datatype dataType);
 
+  /**
+   * Initializes the members of a new index object.
+   * */
+  void setUp(BufMgr *bufMgrIn, const int attrByteOffset,
+             const Datatype attrType, const KeyEncoding keyEncoding,
+             const IndexStorage storage);
+
+  /**
+   * Opens an existing index file.
+   * @return  false if the file does not exist.
+   * @throws  BadIndexInfoException If the meta page does not match the
+   * relation and attribute of the index, or no meta page is valid.
+   * */
+  bool openIndex(const std::string &indexName,
+                 const std::string &relationName);
+
+  /**
+   * Creates the index file and bulk loads entries into it.
+   * */
+  void createIndex(const std::string &indexName,
+                   const std::string &relationName,
+                   std::vector<RIDKeyPair<IndexKey> > &entries,
+                   const double fillFactor);
+
+  /**
+   * Builds the tree bottom-up from a list of entries instead of inserting
+   * them one by one. Entries are sorted, leaves are filled left to right and
+   * linked through their sibling pointers, then each level of non leaf nodes
+   * is built over the level below until a single root remains. Entries are
+   * spread evenly so no node at the end of a level is left nearly empty.
+   * Called on an index holding only its empty root leaf.
+   * @param entries         <key, rid> pairs to load. Sorted in place.
+   * @param fillFactor      Share of the key slots of a node to fill, at least
+   * one entry and two children being put in every node.
+   * */
+  template <class LeafNode, class NonLeafNode>
+  void bulkLoad(std::vector<RIDKeyPair<IndexKey> > &entries,
+                const double fillFactor);
+
+  /**
+   * Inserts an entry into the tree of the given node types, splitting the
+   * root if needed.
+   * @param key             Key to insert
+   * @param rid             Record ID to insert
+   * */
+  template <class LeafNode, class NonLeafNode>
+  void insertInto(const IndexKey &key, const RecordId rid);
+
+  /**
+   * Makes a new root over the current root and the node split from it.
+   * @param splitKey        Key moved up by the split
+   * @param rightPageNo     Page number of the node split from the root
+   * @param level           Level of the new root, 1 if the old root was a leaf
+   * */
+  template <class NonLeafNode>
+  void growRoot(const IndexKey &splitKey, const PageId rightPageNo,
+                const int level);
+
+  /**
+   * Insert a new entry using the pair <value,rid> recursively.
+   * Start from root to recursively find out the leaf to insert the entry in.
+   * @param nodePageNumber page number of the node which contains the key
+   * @param key key to be inserted
+   * @param rid rid to be inserted
+   * @param isSplit reference indicating whether split happened at the next level or not
+   * @param splitKey splitKey which needs to be inserted at current node due to split at next level
+   * @param splitRightNodePageId page number of new right children node created due to split
+   * @param movedTo page number of the node once modified, see modifyPage
+   **/
+  template <class LeafNode, class NonLeafNode>
+  void insertRecursive(PageId nodePageNumber, const IndexKey &key,
+                       const RecordId rid, bool &isSplit, IndexKey &splitKey,
+                       PageId &splitRightNodePageId, PageId &movedTo);
+
+  /**
+   * Insert a new entry using the pair <key, pageId> in the non leaf node.
+   * A full node is split: its entries and the new one are merged in key order
+   * into a temporary of splitArena, the key in the middle moves up and the
+   * upper half goes to a new node.
+   * @param nodePageNumber page number of the node where the middleKey needs to be inserted
+   * @param nextPageIndex index of the page in the pageNoArray where the page id of the next node was found while inserting recursively
+   * @param childPageNo page number of that child once modified
+   * @param childSplit true if the child split, false if it only moved
+   * @param middleKey key which needs to be inserted
+   * @param rightPageNo page which needs to be inserted right of middleKey
+   * @param isSplit reference indicating whether split happened at the current level or not
+   * @param splitKey splitKey which needs to be set by current node due to split at current level
+   * @param splitRightNodePageId page number of new right children node created due to split at current level
+   * @param movedTo page number of the node once modified, see modifyPage
+   **/
+  template <class NonLeafNode>
+  void insertNonLeaf(PageId nodePageNumber, int nextPageIndex,
+                     const PageId childPageNo, const bool childSplit,
+                     const IndexKey &middleKey, PageId rightPageNo,
+                     bool &isSplit, IndexKey &splitKey,
+                     PageId &splitRightNodePageId, PageId &movedTo);
+
+  /**
+   * Insert a new entry using the pair <key, rid> in the leaf node. A full leaf
+   * is split the same way as in insertNonLeaf, the first key of the new leaf
+   * being copied up.
+   * @param pageNum page number of the leaf node
+   * @param key key to be inserted
+   * @param rid rid to be inserted
+   * @param isSplit reference indicating whether split happened at the current level or not
+   * @param splitKey splitKey which needs to be inserted at the parent node due to split
+   * @param splitRightNodePageId page number of new right leaf node created due to split
+   * @param movedTo page number of the leaf once modified, see modifyPage
+   **/
+  template <class LeafNode>
+  void insertLeaf(PageId pageNum, const IndexKey &key, const RecordId rid,
+                  bool &isSplit, IndexKey &splitKey,
+                  PageId &splitRightNodePageId, PageId &movedTo);
+
+  /**
+   * Pins a node of the current tree to modify it. In IN_PLACE_STORAGE it is
+   * the node itself, saved first for the open snapshots. In
+   * APPEND_ONLY_STORAGE a node a commit or a snapshot may read is copied to
+   * a new page, and its page freed, so its parent has to be modified in turn.
+   * @param pageNo          Page of the node
+   * @param page            Set to the pinned page to modify
+   * @return  The page now holding the node.
+   * */
+  PageId modifyPage(const PageId pageNo, Page *&page);
+
+  /**
+   * Positions a scan on the first entry satisfying the low value, in the
+   * tree of the given node types. Leaves nextEntry invalid if that entry is
+   * past the high value or there is none.
+   * @param cursor          Scan to position
+   * @param rootPageNo      Root of the tree to scan
+   * @param rootIsLeaf      True if the root is a leaf
+   * @param snapshotId      Snapshot to read, 0 for the current tree
+   * */
+  template <class LeafNode, class NonLeafNode>
+  void startScanIn(ScanCursor &cursor, const PageId rootPageNo,
+                   const bool rootIsLeaf, const std::uint32_t snapshotId);
+
+  /**
+   * tryScanNext over leaves of the given node type.
+   * */
+  template <class LeafNode, class NonLeafNode>
+  bool scanNextIn(ScanCursor &cursor, const std::uint32_t snapshotId,
+                  RecordId &outRid, IndexKey *outKey);
+
+  /**
+   * Finds the leaf after the one a scan is on, from the sibling pointer of
+   * the leaf or, in APPEND_ONLY_STORAGE, from the path of the scan.
+   * @param cursor          Scan
+   * @param snapshotId      Snapshot it reads, 0 for the current tree
+   * @param rightSibPageNo  Sibling pointer of the leaf
+   * @param nextPageNo      Set to the next leaf
+   * @return  false if the leaf is the last one.
+   * */
+  template <class NonLeafNode>
+  bool nextLeaf(ScanCursor &cursor, const std::uint32_t snapshotId,
+                const PageId rightSibPageNo, PageId &nextPageNo);
+
+  /**
+   * tryStartScan on a given cursor, tree and snapshot.
+   * */
+  bool tryStartScanOn(ScanCursor &cursor, const PageId rootPageNo,
+                      const bool rootIsLeaf, const std::uint32_t snapshotId,
+                      const void *lowVal, const Operator lowOp,
+                      const void *highVal, const Operator highOp);
+
+  /**
+   * tryScanNext on a given cursor and snapshot, setting *outKey to the key
+   * of the entry unless outKey is NULL.
+   * */
+  bool tryScanNextOn(ScanCursor &cursor, const std::uint32_t snapshotId,
+                     RecordId &outRid, IndexKey *outKey);
+
+  /**
+   * Positions a scan whose bounds are set on the first entry satisfying
+   * them, dispatching on the node types of the index.
+   * @return  false if no entry satisfies them.
+   * */
+  bool seekScan(ScanCursor &cursor, const PageId rootPageNo,
+                const bool rootIsLeaf, const std::uint32_t snapshotId);
+
+  /**
+   * endScan on a given cursor.
+   * */
+  void endScanOn(ScanCursor &cursor);
+
+  /**
+   * splitRange over non leaf nodes of the given type. Goes down the tree
+   * level by level, keeping the nodes overlapping the range and the
+   * separators between them, until there are enough nodes to share out or
+   * they are leaves.
+   * */
+  template <class NonLeafNode>
+  void splitRangeIn(const IndexKey &lowValKey, const IndexKey &highValKey,
+                    const std::size_t subranges, std::vector<IndexKey> &cuts);
+
+  /**
+   * Scans a range of the current tree with a cursor of its own and appends
+   * the entries it returns to <entries>.
+   * @param bufMgr  Buffer manager to read the pages through, the index one
+   *                or a LatchedBufMgr over it.
+   * */
+  void scanRange(BufMgr *bufMgr, const IndexKey &lowValKey,
+                 const Operator lowOp, const IndexKey &highValKey,
+                 const Operator highOp,
+                 std::vector<RIDKeyPair<IndexKey> > &entries);
+
+  /**
+   * Moves a scan to a leaf. The leaf of the current tree is kept pinned, the
+   * leaf of a snapshot is copied into the cursor, whose currentPageData has
+   * to point to a page of its own.
+   * */
+  void enterLeaf(ScanCursor &cursor, const PageId pageNo,
+                 const std::uint32_t snapshotId);
+
+  /**
+   * Unpins the leaf a scan is on, if it is pinned.
+   * */
+  void leaveLeaf(ScanCursor &cursor);
+
+  /**
+   * Returns the page holding a page of the tree as a snapshot sees it.
+   * @param pageNo          Page of the current tree
+   * @param snapshotId      Snapshot, 0 for the current tree
+   * */
+  PageId pageInSnapshot(const PageId pageNo,
+                        const std::uint32_t snapshotId) const;
+
+  /**
+   * Saves a copy of a page about to be modified, if an open snapshot may
+   * read it and no copy was saved for the newest snapshot yet.
+   * @param pageNo          Page about to be modified
+   * @param page            Its contents, pinned
+   * */
+  void preservePage(const PageId pageNo, const Page *page);
+
+  /**
+   * Allocates a page for a node or a copy, reusing the free pages first.
+   * The page is pinned and blank, as from BufMgr::allocPage.
+   * */
+  void allocIndexPage(PageId &pageNo, Page *&page);
+
+  /**
+   * Closes a snapshot and frees the copies no other snapshot needs.
+   * @param snapshotId      Id of the snapshot
+   * */
+  void closeSnapshot(const std::uint32_t snapshotId);
+
+  /**
+   * Drops a page from the tree of an APPEND_ONLY_STORAGE index, to be reused
+   * once no meta page or snapshot reaches it.
+   * */
+  void freePage(const PageId pageNo);
+
+  /**
+   * Moves the freed pages no meta page or snapshot reaches anymore to the
+   * free pages.
+   * */
+  void reclaimPages();
+
+  /**
+   * Reads the meta page of the last commit of an APPEND_ONLY_STORAGE index
+   * and its free pages.
+   * @return  false if neither meta page is valid, the index being in
+   *          IN_PLACE_STORAGE.
+   * */
+  bool openCommitted(IndexMetaInfo &meta);
+
+  /**
+   * Reads the pages of a free list written by writeFreeList.
+   * @param freeListPageNo  First page of the chain of the list.
+   * @param outPages        Receives the pages, with the commit which freed
+   *                        them.
+   * */
+  void readFreeList(const PageId freeListPageNo,
+                    std::vector<FreedPage> &outPages);
+
+  /**
+   * Writes the free and freed pages into a blob chain.
+   * @param chainPageNo   First page of a chain to write the list over,
+   *                      Page::INVALID_NUMBER to write a new chain.
+   * @return  The first page of the chain, Page::INVALID_NUMBER if there are
+   *          no pages and no chain to write over.
+   * */
+  PageId writeFreeList(const PageId chainPageNo = Page::INVALID_NUMBER);
+
+  /**
+   * Writes the index to its file, as commit(), with no page of the scan
+   * pinned.
+   * */
+  void writeCommit();
+
+  /**
+   * Sets up a resumable scan of the current tree.
+   * @param bufMgr  Buffer manager to read the pages through, the index one
+   *                or a LatchedBufMgr over it.
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   * */
+  void startAsyncScan(BufMgr *bufMgr, AsyncScanState &state,
+                      const void *lowVal, const Operator lowOp,
+                      const void *highVal, const Operator highOp);
+
+  /**
+   * Runs a resumable scan until a page it reads is not in the buffer pool,
+   * a leaf added entries to <entries> or the scan is done. When waiting,
+   * state.pageNo is the page to read before resuming, which may be handed
+   * pinned through state.pinnedPage.
+   * */
+  AsyncStatus resumeScan(AsyncScanState &state,
+                         std::vector<RIDKeyPair<IndexKey> > &entries);
+
+  /**
+   * resumeScan over nodes of the given types.
+   * */
+  template <class LeafNode, class NonLeafNode>
+  AsyncStatus resumeScanIn(AsyncScanState &state,
+                           std::vector<RIDKeyPair<IndexKey> > &entries);
+
+  friend class BTreeSnapshot;
+  friend class AsyncIndex;
+
  public:
   /**
    * BTreeIndex Constructor.
    * Check to see if the corresponding index file exists. If so, open the file.
-   * If not, create it and insert entries for every tuple in the base relation
-   * using FileScan class.
+   * If not, create it and bulk load entries for every tuple in the base
+   * relation, read using FileScan class.
    *
    * @param relationName        Name of file.
    * @param outIndexName        Return the name of index file.
@@ -492,24 +1270,96 @@ class BTreeIndex {
    * index is to be built, in the record
    * @param attrType						Datatype of
    * attribute over which index is built
+   * @param format              Page format of the relation. For a PAX
+   * relation only the column of the attribute is read.
+   * @param keyEncoding         Layout of the keys in the nodes. Ignored if
+   * the index exists, which keeps its own.
+   * @param storage             How the index writes its pages. Ignored if the
+   * index exists, which keeps its own.
+   * @param fillFactor          Share of the key slots of a node filled by the
+   * bulk load of a new index.
    * @throws  BadIndexInfoException     If the index file already exists for the
    * corresponding attribute, but values in metapage(relationName, attribute
    * byte offset, attribute type etc.) do not match with values received through
-   * constructor parameters.
+   * constructor parameters, or if a PAX relation does not store the attribute.
    */
   BTreeIndex(const std::string &relationName, std::string &outIndexName,
              BufMgr *bufMgrIn, const int attrByteOffset,
-             const Datatype attrType);
+             const Datatype attrType,
+             const RelationFormat format = SLOTTED_RELATION,
+             const KeyEncoding keyEncoding = NATIVE_KEYS,
+             const IndexStorage storage = IN_PLACE_STORAGE,
+             const double fillFactor = BULKLOAD_FILL_FACTOR);
+
+  /**
+   * Opens the index file <indexName> over an attribute of a relation, or
+   * creates it and bulk loads the given entries instead of scanning the
+   * relation. Used to build several indexes from one scan.
+   *
+   * @param relationName        Name of the relation, checked against the
+   * meta page as by the other constructor
+   * @param indexName           Name of the index file
+   * @param entries             <key, rid> pairs to load. Sorted in place.
+   * Ignored if the index exists.
+   * @throws  BadIndexInfoException     If the index file exists but its meta
+   * page does not match the parameters.
+   */
+  BTreeIndex(const std::string &relationName, const std::string &indexName,
+             BufMgr *bufMgrIn, const int attrByteOffset,
+             const Datatype attrType,
+             std::vector<RIDKeyPair<IndexKey> > &entries,
+             const KeyEncoding keyEncoding = NATIVE_KEYS,
+             const IndexStorage storage = IN_PLACE_STORAGE,
+             const double fillFactor = BULKLOAD_FILL_FACTOR);
+
+  /**
+   * Reads the key of an attribute of every record of a relation, as the
+   * constructor does to build a new index.
+   *
+   * @param entries             Receives the <key, rid> pairs
+   * @throws  BadIndexInfoException If a PAX or columnar relation does not
+   * store the attribute.
+   */
+  static void scanRelation(const std::string &relationName, BufMgr *bufMgr,
+                           const int attrByteOffset, const Datatype attrType,
+                           const RelationFormat format,
+                           std::vector<RIDKeyPair<IndexKey> > &entries);
+
+  /**
+   * Sorts <key, rid> pairs into the order a bulk load takes them in. Large
+   * lists are sorted on a pool, in chunks merged two by two; lists of a few
+   * pages, or lists sorted from a task of the pool, on the calling thread.
+   *
+   * @param entries             <key, rid> pairs to sort, in place
+   * @param pool                Threads sorting the chunks
+   * @param priority            Class of the tasks sorting them
+   */
+  static void sortEntries(std::vector<RIDKeyPair<IndexKey> > &entries,
+                          WorkStealingPool &pool,
+                          const TaskPriority priority = FOREGROUND_TASK);
 
   /**
    * BTreeIndex Destructor.
-   * End any initialized scan, flush index file, after unpinning any pinned
-   * pages, from the buffer manager and delete file instance thereby closing the
+   * End any initialized scan, commit the index, after unpinning any pinned
+   * pages, and delete file instance thereby closing the
    * index file. Destructor should not throw any exceptions. All exceptions
    * should be caught in here itself.
    * */
   ~BTreeIndex();
 
+  /**
+   * Writes the index to its file. In APPEND_ONLY_STORAGE the pages of the
+   * tree are written and synced to disk first, then the meta page not
+   * holding the last commit, synced too, which commits the new root at once:
+   * if the write is torn, the index is opened at the last commit. Pages
+   * dropped by the commit are reused once the next one is done. Pages are
+   * never overwritten while a commit reaches them, so readers of the file
+   * need no locks. The leaf an executing scan is on is unpinned during the
+   * commit and pinned again after it, so the scan goes on from where it was.
+   * @throws  FileSyncException If the file cannot be synced.
+   **/
+  void commit();
+
   /**
    * Insert a new entry using the pair <value,rid>.
    * Start from root to recursively find out the leaf to insert the entry in.
@@ -519,613 +1369,20 @@ class BTreeIndex {
    *root to get split. If root gets split, metapage needs to be changed
    *accordingly. Make sure to unpin pages as soon as you can.
    * @param key			Key to insert, pointer to integer/double/char
-   *string
+   *string, as for startScan
    * @param rid			Record ID of a record whose entry is getting
    *inserted into the index.
    **/
   const void insertEntry(const void *key, const RecordId rid);
 
   /**
-   * Insert a new entry using the pair <value,rid> recursively.
-   * Start from root to recursively find out the leaf to insert the entry in.
-   * @param nodePageNumber page number of the node which contains the key
-   * @param key key to be inserted
-   * @param rid rid to be inserted
-   * @param isSplit reference indicating whether split happened at the next level or not
-   * @param splitKey splitKey which needs to be inserted at current node due to split at next level
-   * @param splitRightNodePageId page number of new right children node created due to split
-   **/
- void insertRecursive(PageId nodePageNumber, const void *key,
-                       const RecordId rid, bool &isSplit, void *splitKey,
-                       PageId &splitRightNodePageId);
-
-   /**
-   * Insert a new entry using the pair <key, pageId> in the non leaf node.
-   * @param nodePageNumber page number of the node where the middleKey needs to be inserted
-   * @param nextPageIndex index of the page in the pageNoArray where the page id of the next node was found while inserting recursively
-   * @param middleKey key which needs to be inserted
-   * @param isSplit reference indicating whether split happened at the next level or not (passed by reference from insertRecursive)
-   * @param splitKey splitKey which needs to be set by current node due to split at current level (passed by pointer from insertRecursive)
-   * @param splitRightNodePageId page number of new right children node created due to split at current level (passed by reference from insertRecursive)
-   **/
-  void insertNonLeaf(PageId nodePageNumber, int nextPageIndex, void* middleKey,
-                     bool &isSplit, void* splitKey, PageId &splitRightNodePageId) {
-    // std::cout << "Non leaf insert case" << std::endl;
-    // Read current page
-    Page *curPage;
-    this->bufMgr->readPage(this->file, nodePageNumber, curPage);
-    if (this->attributeType == Datatype::INTEGER) {
-      // Cast to non leaf node
-      NonLeafNodeInt *curNonLeafNode = (NonLeafNodeInt *)curPage;
-      // Check if space exists
-      if (hasSpaceInNonLeafNode(curNonLeafNode)) {
-        // Insert the key and rightPageId
-        int keyCopy = *(int*)middleKey;
-        insertKeyPageIdToKeyPageIdArray<int>(
-            curNonLeafNode->keyArray, curNonLeafNode->pageNoArray,
-            curNonLeafNode->len, keyCopy, splitRightNodePageId);
-        // Set isSplit to false
-        isSplit = false;
-        curNonLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-      } else {
-        std::cout<<"Non leaf split case"<<std::endl;
-        // Split and move up the middleKey
-        // nextPageIndex is the index in the pageNoArray whose page was selected
-        // while recursively inserting the key Insert the splitRightNodePageId
-        // after the nextPageIndex in the pageNoArray
-        PageId tempPageNoArray[curNonLeafNode->len + 2];
-        int tempKeyArray[curNonLeafNode->len + 1];
-        for (int i = curNonLeafNode->len; i >= nextPageIndex + 1; i--) {
-          tempPageNoArray[i + 1] = curNonLeafNode->pageNoArray[i];
-          tempKeyArray[i] = curNonLeafNode->keyArray[i - 1];
-        }
-        // Insert splitRightNodePageId at nextPageIndex + 1
-        tempPageNoArray[nextPageIndex + 1] = splitRightNodePageId;
-        // Insert middleKey at nextPageIndex
-        tempKeyArray[nextPageIndex] = *(int*)middleKey;
-        for (int i = 0; i < nextPageIndex; i++) {
-          tempKeyArray[i] = curNonLeafNode->keyArray[i];
-          tempPageNoArray[i] = curNonLeafNode->pageNoArray[i];
-        }
-        tempPageNoArray[nextPageIndex] = curNonLeafNode->pageNoArray[nextPageIndex];
-
-        // Create new page for the split
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Cast new page to non leaf node int
-        NonLeafNodeInt *newNonLeafNodeInt = (NonLeafNodeInt *)newPage;
-        newNonLeafNodeInt->len = 0;
-        newNonLeafNodeInt->level = curNonLeafNode->level;
-        // New key array length - curNonLeafNode->len + 1
-        int splitKeyIndex = (curNonLeafNode->len) / 2;
-        int newSplitKey = tempKeyArray[splitKeyIndex];
-        // Ignore key at splitKeyIndex and move all the keys after that to new
-        // node
-        for (int i = 0; i < splitKeyIndex; i++) {
-          curNonLeafNode->keyArray[i] = tempKeyArray[i];
-          curNonLeafNode->pageNoArray[i] = tempPageNoArray[i];
-        }
-        std::cout<<"cur non leaf node with page id "<<nodePageNumber<<" has length "<<curNonLeafNode->len<<std::endl;
-
-        curNonLeafNode->pageNoArray[splitKeyIndex] = splitRightNodePageId;
-        // Need to move every page number after index splitIndex+1 to new page
-        // node
-        for (int i = splitKeyIndex + 1; i < curNonLeafNode->len + 1; i++) {
-          newNonLeafNodeInt->keyArray[i - splitKeyIndex - 1] = tempKeyArray[i];
-          newNonLeafNodeInt->pageNoArray[i - splitKeyIndex - 1] =
-              tempPageNoArray[i];
-          newNonLeafNodeInt->len += 1;
-        }
-        std::cout<<"new non leaf node with page id "<<newPageNum<<" has length "<<newNonLeafNodeInt->len<<std::endl;
-
-        newNonLeafNodeInt->pageNoArray[curNonLeafNode->len - splitKeyIndex] =
-            tempPageNoArray[curNonLeafNode->len + 1];
-        curNonLeafNode->len = splitKeyIndex;
-        // Set the splitKey and splitRightNodePageId
-        *static_cast<int*>(splitKey) = newSplitKey;
-        splitRightNodePageId = newPageNum;
-
-        this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-      }
-    } else if (this->attributeType == Datatype::DOUBLE) {
-      NonLeafNodeDouble *curNonLeafNode = (NonLeafNodeDouble *)curPage;
-      // Check if space exists
-      if (hasSpaceInNonLeafNode(curNonLeafNode)) {
-        // Insert the key and rightPageId
-        double keyCopy = *(double*)middleKey;
-        insertKeyPageIdToKeyPageIdArray<double>(
-            curNonLeafNode->keyArray, curNonLeafNode->pageNoArray,
-            curNonLeafNode->len, keyCopy, splitRightNodePageId);
-        // Set isSplit to false
-        isSplit = false;
-        curNonLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-      } else {
-        std::cout<<"Non leaf split case"<<std::endl;
-        // Split and move up the middleKey
-        // nextPageIndex is the index in the pageNoArray whose page was selected
-        // while recursively inserting the key Insert the splitRightNodePageId
-        // after the nextPageIndex in the pageNoArray
-        PageId tempPageNoArray[curNonLeafNode->len + 2];
-        double tempKeyArray[curNonLeafNode->len + 1];
-        for (int i = curNonLeafNode->len; i >= nextPageIndex + 1; i--) {
-          tempPageNoArray[i + 1] = curNonLeafNode->pageNoArray[i];
-          tempKeyArray[i] = curNonLeafNode->keyArray[i - 1];
-        }
-        // Insert splitRightNodePageId at nextPageIndex + 1
-        tempPageNoArray[nextPageIndex + 1] = splitRightNodePageId;
-        // Insert middleKey at nextPageIndex
-        tempKeyArray[nextPageIndex] = *(double*)middleKey;
-        for (int i = 0; i < nextPageIndex; i++) {
-          tempKeyArray[i] = curNonLeafNode->keyArray[i];
-          tempPageNoArray[i] = curNonLeafNode->pageNoArray[i];
-        }
-        tempPageNoArray[nextPageIndex] = curNonLeafNode->pageNoArray[nextPageIndex];
-
-        // Create new page for the split
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Cast new page to non leaf node int
-        NonLeafNodeDouble *newNonLeafNodeInt = (NonLeafNodeDouble *)newPage;
-        newNonLeafNodeInt->len = 0;
-        newNonLeafNodeInt->level = curNonLeafNode->level;
-        // New key array length - curNonLeafNode->len + 1
-        int splitKeyIndex = (curNonLeafNode->len) / 2;
-        double newSplitKey = tempKeyArray[splitKeyIndex];
-        // Ignore key at splitKeyIndex and move all the keys after that to new
-        // node
-        for (int i = 0; i < splitKeyIndex; i++) {
-          curNonLeafNode->keyArray[i] = tempKeyArray[i];
-          curNonLeafNode->pageNoArray[i] = tempPageNoArray[i];
-        }
-        std::cout<<"cur non leaf node with page id "<<nodePageNumber<<" has length "<<curNonLeafNode->len<<std::endl;
-
-        curNonLeafNode->pageNoArray[splitKeyIndex] = splitRightNodePageId;
-        // Need to move every page number after index splitIndex+1 to new page
-        // node
-        for (int i = splitKeyIndex + 1; i < curNonLeafNode->len + 1; i++) {
-          newNonLeafNodeInt->keyArray[i - splitKeyIndex - 1] = tempKeyArray[i];
-          newNonLeafNodeInt->pageNoArray[i - splitKeyIndex - 1] =
-              tempPageNoArray[i];
-          newNonLeafNodeInt->len += 1;
-        }
-        std::cout<<"new non leaf node with page id "<<newPageNum<<" has length "<<newNonLeafNodeInt->len<<std::endl;
-
-        newNonLeafNodeInt->pageNoArray[curNonLeafNode->len - splitKeyIndex] =
-            tempPageNoArray[curNonLeafNode->len + 1];
-        curNonLeafNode->len = splitKeyIndex;
-        // Set the splitKey and splitRightNodePageId
-        *static_cast<double*>(splitKey) = newSplitKey;
-        splitRightNodePageId = newPageNum;
-
-        this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-      }
-    } else if (this->attributeType == Datatype::STRING) {
-      NonLeafNodeString *curNonLeafNode = (NonLeafNodeString *)curPage;
-      // Check if space exists
-      if (hasSpaceInNonLeafNode(curNonLeafNode)) {
-        // Insert the key and rightPageId
-        std::string keyCopy = *(std::string*)middleKey;
-        insertKeyPageIdToKeyPageIdArrayForString(
-            curNonLeafNode->keyArray, curNonLeafNode->pageNoArray,
-            curNonLeafNode->len, keyCopy, splitRightNodePageId);
-        // Set isSplit to false
-        isSplit = false;
-        curNonLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-      } else {
-        std::cout<<"Non leaf split case"<<std::endl;
-        // Split and move up the middleKey
-        // nextPageIndex is the index in the pageNoArray whose page was selected
-        // while recursively inserting the key Insert the splitRightNodePageId
-        // after the nextPageIndex in the pageNoArray
-        PageId tempPageNoArray[curNonLeafNode->len + 2];
-        std::string tempKeyArray[curNonLeafNode->len + 1];
-        for (int i = curNonLeafNode->len; i >= nextPageIndex + 1; i--) {
-          tempPageNoArray[i + 1] = curNonLeafNode->pageNoArray[i];
-          tempKeyArray[i] = curNonLeafNode->keyArray[i - 1];
-        }
-        // Insert splitRightNodePageId at nextPageIndex + 1
-        tempPageNoArray[nextPageIndex + 1] = splitRightNodePageId;
-        // Insert middleKey at nextPageIndex
-        tempKeyArray[nextPageIndex] = *(std::string*)middleKey;
-        for (int i = 0; i < nextPageIndex; i++) {
-          tempKeyArray[i] = curNonLeafNode->keyArray[i];
-          tempPageNoArray[i] = curNonLeafNode->pageNoArray[i];
-        }
-        tempPageNoArray[nextPageIndex] = curNonLeafNode->pageNoArray[nextPageIndex];
-
-        // Create new page for the split
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Cast new page to non leaf node int
-        NonLeafNodeString *newNonLeafNodeString = (NonLeafNodeString *)newPage;
-        newNonLeafNodeString->len = 0;
-        newNonLeafNodeString->level = curNonLeafNode->level;
-        // New key array length - curNonLeafNode->len + 1
-        int splitKeyIndex = (curNonLeafNode->len) / 2;
-        std::string newSplitKey(tempKeyArray[splitKeyIndex], STRINGSIZE);
-        // Ignore key at splitKeyIndex and move all the keys after that to new
-        // node
-        for (int i = 0; i < splitKeyIndex; i++) {
-          strncpy(curNonLeafNode->keyArray[i], tempKeyArray[i].c_str(), STRINGSIZE);
-          curNonLeafNode->pageNoArray[i] = tempPageNoArray[i];
-        }
-        std::cout<<"cur non leaf node with page id "<<nodePageNumber<<" has length "<<curNonLeafNode->len<<std::endl;
-
-        curNonLeafNode->pageNoArray[splitKeyIndex] = splitRightNodePageId;
-        // Need to move every page number after index splitIndex+1 to new page
-        // node
-        for (int i = splitKeyIndex + 1; i < curNonLeafNode->len + 1; i++) {
-          strncpy(newNonLeafNodeString->keyArray[i - splitKeyIndex - 1] , tempKeyArray[i].c_str(), STRINGSIZE);
-          newNonLeafNodeString->pageNoArray[i - splitKeyIndex - 1] =
-              tempPageNoArray[i];
-          newNonLeafNodeString->len += 1;
-        }
-        std::cout<<"new non leaf node with page id "<<newPageNum<<" has length "<<newNonLeafNodeString->len<<std::endl;
-
-        newNonLeafNodeString->pageNoArray[curNonLeafNode->len - splitKeyIndex] =
-            tempPageNoArray[curNonLeafNode->len + 1];
-
-        curNonLeafNode->len = splitKeyIndex;
-        // Set the splitKey and splitRightNodePageId
-        *static_cast<std::string*>(splitKey) = newSplitKey;
-        splitRightNodePageId = newPageNum;
-
-        this->bufMgr->unPinPage(this->file, nodePageNumber, true);
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-      }
-    }
-  }
-
-   /**
-   * Insert a new entry using the pair <value,rid> recursively in the leaf node.
-   * Start from root to recursively find out the leaf to insert the entry in.
-   * @param pageNum page number of the node which contains the key
-   * @param key key to be inserted
-   * @param rid rid to be inserted
-   * @param isSplit reference indicating whether split happened at the next level or not(passed by reference from insertRecursive)
-   * @param splitKey splitKey which needs to be inserted at current node due to split at next level (passed by pointer from insertRecursive)
-   * @param splitRightNodePageId page number of new right children node created due to split (passed by reference from insertRecursive)
-   **/
-  void insertLeaf(PageId pageNum, void* key, const RecordId rid,
-                  bool &isSplit, void* splitKey, PageId &splitRightNodePageId) {
-    // std::cout << "Inserting leaf case" << std::endl;
-    // Read current page
-    Page *curPage;
-    this->bufMgr->readPage(this->file, pageNum, curPage);
-    if (this->attributeType == Datatype::INTEGER) {
-      // Cast to LeafNode
-      LeafNodeInt *curLeafNode = (LeafNodeInt *)curPage;
-      // Check the occupancy of the leaf node
-      if (hasSpaceInLeafNode(curLeafNode)) {
-        // SubCase 1: Non-Split
-        // Insert the (key, record)
-        insertKeyRidToKeyRidArray<int>(curLeafNode->keyArray,
-                                       curLeafNode->ridArray, curLeafNode->len,
-                                       *(int*)key, rid);
-        curLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, pageNum, true);
-        isSplit = false;
-      } else {
-        std::cout << "Leaf split case" << std::endl;
-        // SubCase 2: Split the leaf-node
-        std::vector<RIDKeyPair<int>> ridKeyPairVec;
-        // Insert all the key, rid pairs including current key, rid to be
-        // inserted
-        for (int i = 0; i < curLeafNode->len; i++) {
-          RIDKeyPair<int> ridKeyPair;
-          const RecordId rid_ = curLeafNode->ridArray[i];
-          const int key_ = curLeafNode->keyArray[i];
-          ridKeyPair.set(rid_, key_);
-          ridKeyPairVec.push_back(ridKeyPair);
-        }
-        // Insert current key, rid
-        RIDKeyPair<int> ridKeyPair;
-        ridKeyPair.set(rid, *(int*)key);
-        ridKeyPairVec.push_back(ridKeyPair);
-        // Sort the vector
-        sort(ridKeyPairVec.begin(), ridKeyPairVec.end());
-        int middleKeyIndex = ridKeyPairVec.size() / 2;
-        int middleKey = ridKeyPairVec[middleKeyIndex].key;
-
-        // Create another page and move half the (key, recordID) to that node
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Move half the (key, recordID) to the new node
-        // Cast the page to leaf node
-        LeafNodeInt *newPageLeafNode = (LeafNodeInt *)newPage;
-        newPageLeafNode->len = 0;
-        for (int i = middleKeyIndex; i < (int)ridKeyPairVec.size(); i++) {
-          int key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<int>(newPageLeafNode->keyArray,
-                                         newPageLeafNode->ridArray,
-                                         newPageLeafNode->len, key_, rid_);
-          newPageLeafNode->len += 1;
-        }
-        std::cout<<"new leaf node with page id "<<newPageNum<<" has length "<<newPageLeafNode->len<<std::endl;
-
-        curLeafNode->len = 0;
-        for (int i = 0; i < middleKeyIndex; i++) {
-          int key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<int>(curLeafNode->keyArray,
-                                         curLeafNode->ridArray,
-                                         curLeafNode->len, key_, rid_);
-          curLeafNode->len += 1;
-        }
-        std::cout<<"cur leaf node with page id "<<pageNum<<" has length "<<curLeafNode->len<<std::endl;
-
-        // Set next page id of left leaf node
-        newPageLeafNode->rightSibPageNo = curLeafNode->rightSibPageNo;
-        curLeafNode->rightSibPageNo = newPageNum;
-
-        // For leaf node, middle key is inserted in the leaf as well as copied
-        // to non-leaf
-        *static_cast<int*>(splitKey) = middleKey;
-        isSplit = true;
-        splitRightNodePageId = newPageNum;
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-        this->bufMgr->unPinPage(this->file, pageNum, true);
-      }
-    } else if (this->attributeType == Datatype::DOUBLE) {
-      // Cast to LeafNode
-      LeafNodeDouble *curLeafNode = (LeafNodeDouble *)curPage;
-      // Check the occupancy of the leaf node
-      if (hasSpaceInLeafNode(curLeafNode)) {
-        // SubCase 1: Non-Split
-        // Insert the (key, record)
-        insertKeyRidToKeyRidArray<double>(curLeafNode->keyArray,
-                                       curLeafNode->ridArray, curLeafNode->len,
-                                       *(double*)key, rid);
-        curLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, pageNum, true);
-        isSplit = false;
-      } else {
-        std::cout << "Leaf split case" << std::endl;
-        // SubCase 2: Split the leaf-node
-        std::vector<RIDKeyPair<double>> ridKeyPairVec;
-        // Insert all the key, rid pairs including current key, rid to be
-        // inserted
-        for (int i = 0; i < curLeafNode->len; i++) {
-          RIDKeyPair<double> ridKeyPair;
-          const RecordId rid_ = curLeafNode->ridArray[i];
-          const double key_ = curLeafNode->keyArray[i];
-          ridKeyPair.set(rid_, key_);
-          ridKeyPairVec.push_back(ridKeyPair);
-        }
-        // Insert current key, rid
-        RIDKeyPair<double> ridKeyPair;
-        ridKeyPair.set(rid, *(double*)key);
-        ridKeyPairVec.push_back(ridKeyPair);
-        // Sort the vector
-        sort(ridKeyPairVec.begin(), ridKeyPairVec.end());
-        int middleKeyIndex = ridKeyPairVec.size() / 2;
-        double middleKey = ridKeyPairVec[middleKeyIndex].key;
-
-        // Create another page and move half the (key, recordID) to that node
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Move half the (key, recordID) to the new node
-        // Cast the page to leaf node
-        LeafNodeDouble *newPageLeafNode = (LeafNodeDouble *)newPage;
-        newPageLeafNode->len = 0;
-        for (int i = middleKeyIndex; i < (int)ridKeyPairVec.size(); i++) {
-          double key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<double>(newPageLeafNode->keyArray,
-                                         newPageLeafNode->ridArray,
-                                         newPageLeafNode->len, key_, rid_);
-          newPageLeafNode->len += 1;
-        }
-        std::cout<<"new leaf node with page id "<<newPageNum<<" has length "<<newPageLeafNode->len<<std::endl;
-
-        curLeafNode->len = 0;
-        for (int i = 0; i < middleKeyIndex; i++) {
-          double key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArray<double>(curLeafNode->keyArray,
-                                         curLeafNode->ridArray,
-                                         curLeafNode->len, key_, rid_);
-          curLeafNode->len += 1;
-        }
-        std::cout<<"cur leaf node with page id "<<pageNum<<" has length "<<curLeafNode->len<<std::endl;
-
-        // Set next page id of left leaf node
-        newPageLeafNode->rightSibPageNo = curLeafNode->rightSibPageNo;
-        curLeafNode->rightSibPageNo = newPageNum;
-
-        // For leaf node, middle key is inserted in the leaf as well as copied
-        // to non-leaf
-        *static_cast<double*>(splitKey) = middleKey;
-        isSplit = true;
-        splitRightNodePageId = newPageNum;
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-        this->bufMgr->unPinPage(this->file, pageNum, true);
-      }
-    } else if (this->attributeType == Datatype::STRING) {
-      // Cast to LeafNode
-      LeafNodeString *curLeafNode = (LeafNodeString *)curPage;
-      // Check the occupancy of the leaf node
-      if (hasSpaceInLeafNode(curLeafNode)) {
-        // SubCase 1: Non-Split
-        // Insert the (key, record)
-        insertKeyRidToKeyRidArrayForString(curLeafNode->keyArray,
-                                       curLeafNode->ridArray, curLeafNode->len,
-                                       *(std::string*)key, rid);
-        curLeafNode->len += 1;
-        this->bufMgr->unPinPage(this->file, pageNum, true);
-        isSplit = false;
-      } else {
-        std::cout << "Leaf split case" << std::endl;
-        // SubCase 2: Split the leaf-node
-        std::vector<RIDKeyPair<std::string>> ridKeyPairVec;
-        // Insert all the key, rid pairs including current key, rid to be
-        // inserted
-        for (int i = 0; i < curLeafNode->len; i++) {
-          RIDKeyPair<std::string> ridKeyPair;
-          const RecordId rid_ = curLeafNode->ridArray[i];
-          std::string key_(curLeafNode->keyArray[i], STRINGSIZE);
-          ridKeyPair.set(rid_, key_);
-          ridKeyPairVec.push_back(ridKeyPair);
-        }
-        // Insert current key, rid
-        RIDKeyPair<std::string> ridKeyPair;
-        ridKeyPair.set(rid, *(std::string*)key);
-        ridKeyPairVec.push_back(ridKeyPair);
-        // Sort the vector
-        sort(ridKeyPairVec.begin(), ridKeyPairVec.end());
-        int middleKeyIndex = ridKeyPairVec.size() / 2;
-        std::string middleKey = ridKeyPairVec[middleKeyIndex].key;
-
-        // Create another page and move half the (key, recordID) to that node
-        Page *newPage;
-        PageId newPageNum;
-        bufMgr->allocPage(this->file, newPageNum, newPage);
-        // Move half the (key, recordID) to the new node
-        // Cast the page to leaf node
-        LeafNodeString *newPageLeafNode = (LeafNodeString *)newPage;
-        newPageLeafNode->len = 0;
-        for (int i = middleKeyIndex; i < (int)ridKeyPairVec.size(); i++) {
-          std::string key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArrayForString(newPageLeafNode->keyArray,
-                                         newPageLeafNode->ridArray,
-                                         newPageLeafNode->len, key_, rid_);
-          newPageLeafNode->len += 1;
-        }
-        std::cout<<"new leaf node with page id "<<newPageNum<<" has length "<<newPageLeafNode->len<<std::endl;
-
-        curLeafNode->len = 0;
-        for (int i = 0; i < middleKeyIndex; i++) {
-          std::string key_ = ridKeyPairVec[i].key;
-          RecordId rid_ = ridKeyPairVec[i].rid;
-          insertKeyRidToKeyRidArrayForString(curLeafNode->keyArray,
-                                         curLeafNode->ridArray,
-                                         curLeafNode->len, key_, rid_);
-          curLeafNode->len += 1;
-        }
-        // curLeafNode->len = middleKeyIndex;
-        std::cout<<"cur leaf node with page id "<<pageNum<<" has length "<<curLeafNode->len<<std::endl;
-
-        // Set next page id of left leaf node
-        newPageLeafNode->rightSibPageNo = curLeafNode->rightSibPageNo;
-        curLeafNode->rightSibPageNo = newPageNum;
-
-        // For leaf node, middle key is inserted in the leaf as well as copied
-        // to non-leaf
-        *static_cast<std::string*>(splitKey) = middleKey;
-        isSplit = true;
-        splitRightNodePageId = newPageNum;
-        this->bufMgr->unPinPage(this->file, newPageNum, true);
-        this->bufMgr->unPinPage(this->file, pageNum, true);
-    }
-  }
-  }
-
-  /**
-   * Inserts the key (of int, double type) and the record id at the appropriate location to keep the keys sorted
-   * Called by leaf nodes to insert the key and the record id
-   * @param keyArray current keyArray of the node
-   * @param ridArray current ridArray of the node
-   * @param len current length of the node
-   * @param key key to be inserted
-   * @param rid recordId to be inserted
-   **/
-  template <class T>
-  void insertKeyRidToKeyRidArray(T keyArray[], RecordId ridArray[], int len,
-                                 T key, const RecordId rid) {
-    if (len == 0) {
-      keyArray[0] = key;
-      ridArray[0] = rid;
-      return;
-    }
-    bool foundKeyIndex = false;
-    int keyIndex =
-        -1;  // keyIndex is the index just before the given key needs to be inserted
-    for (int i = 0; i < len; i++) {
-      if (keyArray[i] >= key) {
-        keyIndex = i;
-        foundKeyIndex = true;
-        break;
-      }
-    }
-    if (foundKeyIndex) {
-      T tempKeyArray[len + 1];
-      RecordId tempRidArray[len + 1];
-      for (int i = 0; i < len; i++) {
-        tempKeyArray[i] = keyArray[i];
-        tempRidArray[i] = ridArray[i];
-      }
-      // Insert key before index keyIndex
-      keyArray[keyIndex] = key;
-      ridArray[keyIndex] = rid;
-      for (int i = keyIndex; i < len; i++) {
-        keyArray[i + 1] = tempKeyArray[i];
-        ridArray[i + 1] = tempRidArray[i];
-      }
-    } else {
-      // it means key needs to be inserted at the last
-      keyArray[len] = key;
-      ridArray[len] = rid;
-    }
-  }
-
-  /**
-   * Inserts the key (of string type) and the record id at the appropriate location to keep the keys sorted
-   * Called by leaf nodes to insert the key and the record id
-   * @param keyArray current keyArray of the node
-   * @param ridArray current ridArray of the node
-   * @param len current length of the node
-   * @param key key to be inserted
-   * @param rid recordId to be inserted
+   * Insert a new entry using the pair <key,rid>, the key being already in
+   * the form the index compares.
+   * @param key			Key to insert, of the datatype of the index
+   * @param rid			Record ID of a record whose entry is getting
+   *inserted into the index.
    **/
-  void insertKeyRidToKeyRidArrayForString(char keyArray[][10], RecordId ridArray[], int len,
-                                 std::string key, const RecordId rid) {
-    if (len == 0) {
-      strncpy(keyArray[0], key.c_str(), STRINGSIZE);
-      ridArray[0] = rid;
-      return;
-    }
-    bool foundKeyIndex = false;
-    int keyIndex =
-        -1;  // keyIndex is the index just before the given key needs to be inserted
-    for (int i = 0; i < len; i++) {
-      if (strncmp(keyArray[i], key.c_str(), STRINGSIZE) >= 0) {
-        keyIndex = i;
-        foundKeyIndex = true;
-        break;
-      }
-    }
-    if (foundKeyIndex) {
-      char tempKeyArray[len + 1][10];
-      RecordId tempRidArray[len + 1];
-      for (int i = 0; i < len; i++) {
-        strncpy(tempKeyArray[i], keyArray[i], STRINGSIZE);
-        tempRidArray[i] = ridArray[i];
-      }
-      // Insert key before index keyIndex
-      strncpy(keyArray[keyIndex], key.c_str(), STRINGSIZE);
-      ridArray[keyIndex] = rid;
-      for (int i = keyIndex; i < len; i++) {
-        strncpy(keyArray[i+1], tempKeyArray[i], STRINGSIZE);
-        ridArray[i + 1] = tempRidArray[i];
-      }
-    } else {
-      // It means key needs to be inserted at the last
-      strncpy(keyArray[len], key.c_str(), 10);
-      ridArray[len] = rid;
-    }
-  }
+  const void insertEntry(const IndexKey &key, const RecordId rid);
 
   /**
    * Checks whether the leaf node has space for a key to be inserted or not
@@ -1145,93 +1402,6 @@ class BTreeIndex {
     return nonLeafNode->len < IDEAL_OCCUPANCY * this->nodeOccupancy;
   }
 
-  /**
-   * Inserts the key (of int, double type) and the page at the appropriate location to keep the keys sorted
-   * Called by non leaf nodes to insert the key and the page number
-   * @param keyArray current keyArray of the node
-   * @param pageNoArray current pageNoArray of the node
-   * @param len current length of the node
-   * @param key key to be inserted
-   * @param pageNo page number to be inserted
-   **/
-  template <class T>
-  void insertKeyPageIdToKeyPageIdArray(T keyArray[], PageId pageNoArray[],
-                                       int len, T key, PageId pageNo) {
-    bool foundKeyIndex = false;
-    int keyIndex =
-        -1;  // keyIndex is the index just before which the given key needs to be inserted
-    for (int i = 0; i < len; i++) {
-      if (keyArray[i] >= key) {
-        keyIndex = i;
-        foundKeyIndex = true;
-        break;
-      }
-    }
-    if (foundKeyIndex) {
-      T tempKeyArray[len + 1];
-      PageId tempPageNoArray[len + 2];
-      for (int i = 0; i < len; i++) {
-        tempKeyArray[i] = keyArray[i];
-        tempPageNoArray[i] = pageNoArray[i];
-      }
-      tempPageNoArray[len] = pageNoArray[len];
-      // Insert key before index keyIndex
-      keyArray[keyIndex] = key;
-      pageNoArray[keyIndex + 1] = pageNo;
-      for (int i = keyIndex+1; i <= len; i++) {
-        keyArray[i] = tempKeyArray[i-1];
-        pageNoArray[i + 1] = tempPageNoArray[i];
-      }
-    } else {
-      // It means key needs to be inserted at the last
-      keyArray[len] = key;
-      pageNoArray[len + 1] = pageNo;
-    }
-  }
-
-  /**
-   * Inserts the key (of string type) and the page at the appropriate location to keep the keys sorted
-   * Called by non leaf nodes to insert the key and the page number
-   * @param keyArray current keyArray of the node
-   * @param pageNoArray current pageNoArray of the node
-   * @param len current length of the node
-   * @param key key to be inserted
-   * @param pageNo page number to be inserted
-   **/
-  void insertKeyPageIdToKeyPageIdArrayForString(char keyArray[][10], PageId pageNoArray[],
-                                       int len, std::string key, PageId pageNo) {
-    bool foundKeyIndex = false;
-    int keyIndex =
-        -1;  // keyIndex is the index just before which the given key needs to be inserted
-    for (int i = 0; i < len; i++) {
-      if (strncmp(keyArray[i], key.c_str(), STRINGSIZE) >= 0) {
-        keyIndex = i;
-        foundKeyIndex = true;
-        break;
-      }
-    }
-    if (foundKeyIndex) {
-      char tempKeyArray[len + 1][10];
-      PageId tempPageNoArray[len + 2];
-      for (int i = 0; i < len; i++) {
-        strncpy(tempKeyArray[i], keyArray[i], STRINGSIZE);
-        tempPageNoArray[i] = pageNoArray[i];
-      }
-      tempPageNoArray[len] = pageNoArray[len];
-      // Insert key before index keyIndex
-      strncpy(keyArray[keyIndex], key.c_str(), STRINGSIZE);
-      pageNoArray[keyIndex + 1] = pageNo;
-      for (int i = keyIndex+1; i <= len; i++) {
-        strncpy(keyArray[i], tempKeyArray[i-1], STRINGSIZE);
-        pageNoArray[i + 1] = tempPageNoArray[i];
-      }
-    } else {
-      // It means key needs to be inserted at the last
-      strncpy(keyArray[len], key.c_str(), STRINGSIZE);
-      pageNoArray[len + 1] = pageNo;
-    }
-  }
-
   /**
    * Begin a filtered scan of the index.  For instance, if the method is called
    * using ("a",GT,"d",LTE) then we should seek all entries with a value
@@ -1255,6 +1425,17 @@ class BTreeIndex {
   const void startScan(const void *lowVal, const Operator lowOp,
                        const void *highVal, const Operator highOp);
 
+  /**
+   * Same as startScan, but returns false instead of throwing
+   * NoSuchKeyFoundException when no key satisfies the scan criteria. The scan
+   * is started either way and has to be ended with endScan.
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   **/
+  const bool tryStartScan(const void *lowVal, const Operator lowOp,
+                          const void *highVal, const Operator highOp);
+
   /**
    * Fetch the record id of the next index entry that matches the scan.
    * Return the next record from current page being scanned. If current page has
@@ -1269,11 +1450,170 @@ class BTreeIndex {
    **/
   const void scanNext(RecordId &outRid);  // returned record id
 
+  /**
+   * Same as scanNext, but returns false instead of throwing
+   * IndexScanCompletedException once no record satisfying the scan criteria
+   * is left.
+   * @param outRid	RecordId of next record found that satisfies the scan
+   *criteria returned in this
+   * @throws ScanNotInitializedException If no scan has been initialized.
+   **/
+  const bool tryScanNext(RecordId &outRid);
+
+  /**
+   * Same as tryScanNext, also returning the key of the entry.
+   * @param outRid	RecordId of next record found that satisfies the scan
+   *criteria returned in this
+   * @param outKey	Key of that record
+   * @throws ScanNotInitializedException If no scan has been initialized.
+   **/
+  const bool tryScanNext(RecordId &outRid, IndexKey &outKey);
+
+  /**
+   * Datatype of the attribute the index is built over.
+   **/
+  Datatype getAttributeType() const { return this->attributeType; }
+
   /**
    * Terminate the current scan. Unpin any pinned pages. Reset scan specific
    *variables.
    * @throws ScanNotInitializedException If no scan has been initialized.
    **/
   const void endScan();
-};  // namespace badgerdb
-}
\ No newline at end of file
+
+  /**
+   * Receives the entries of a sub-range of a parallelScan, in key order.
+   **/
+  typedef std::function<void(const std::size_t subrange,
+                             const std::vector<RIDKeyPair<IndexKey> > &entries)>
+      SubrangeVisitor;
+
+  /**
+   * Returns the keys splitting a range into at most <subranges> sub-ranges
+   * of about the same number of leaves, taken from the separators of the non
+   * leaf nodes. Sub-range i holds the keys from cut i - 1 included to cut i
+   * excluded, the first and the last sub-ranges being bounded by the range.
+   * A range within a single leaf is not split.
+   * @param lowVal	Low value of range, as for startScan
+   * @param highVal	High value of range, as for startScan
+   * @param subranges	Largest number of sub-ranges
+   * @param cuts	Receives the keys, increasing and all above lowVal
+   * @throws  BadScanrangeException If lowVal > highval
+   **/
+  void splitRange(const void *lowVal, const void *highVal,
+                  const std::size_t subranges, std::vector<IndexKey> &cuts);
+
+  /**
+   * Scans a range on the threads of a pool. The range is split by
+   * splitRange and each sub-range is scanned by a FOREGROUND_TASK with a
+   * cursor of its own, the tasks sharing the buffer manager of the index
+   * through a LatchedBufMgr handed to their scans. The entries of each
+   * sub-range are handed to the visitor from the threads of the pool: with
+   * ORDERED_DELIVERY one sub-range at a time in key order, with
+   * UNORDERED_DELIVERY as soon as it is scanned, possibly by several threads
+   * at once. Returns once every sub-range was delivered.
+   *
+   * The index must not be used otherwise until the scan returns, and its
+   * buffer manager needs two free frames per thread of the pool. Not to be
+   * called from a task of the pool.
+   * @param subranges	Largest number of sub-ranges, see splitRange
+   * @param pool	Threads scanning the sub-ranges
+   * @param delivery	Order the sub-ranges are delivered in
+   * @param visitor	Receives the number of each sub-range and its entries
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   * @throws  Any exception a scan or the visitor threw, once the other
+   *tasks are done. With ORDERED_DELIVERY the sub-ranges after it are not
+   *delivered.
+   **/
+  void parallelScan(const void *lowVal, const Operator lowOp,
+                    const void *highVal, const Operator highOp,
+                    const std::size_t subranges, WorkStealingPool &pool,
+                    const ScanDelivery delivery,
+                    const SubrangeVisitor &visitor);
+
+  /**
+   * Opens a snapshot of the index as it is now. Entries inserted afterwards
+   * are not seen by the snapshot, which can be scanned in between inserts
+   * without skipping or repeating entries. Pages modified while a snapshot is
+   * open are copied first, so the snapshot keeps reading the old root and
+   * the pages as they were. The copies are freed when no snapshot needs them
+   * anymore. In APPEND_ONLY_STORAGE pages are copied anyway, the snapshot
+   * only keeps the pages it reaches from being reused.
+   * @return  The snapshot, to be deleted, before the index, to close it.
+   **/
+  BTreeSnapshot *openSnapshot();
+};
+
+/**
+ * @brief Read-only view of a BTreeIndex as it was when the snapshot was
+ * opened, with a scan of its own. Opened by BTreeIndex::openSnapshot().
+ */
+class BTreeSnapshot {
+ public:
+  /**
+   * Ends the scan of the snapshot and closes it.
+   */
+  ~BTreeSnapshot();
+
+  /**
+   * Same as BTreeIndex::startScan, over the snapshot.
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   * @throws  NoSuchKeyFoundException If there is no key in the snapshot that
+   *satisfies the scan criteria.
+   **/
+  void startScan(const void *lowVal, const Operator lowOp,
+                 const void *highVal, const Operator highOp);
+
+  /**
+   * Same as BTreeIndex::tryStartScan, over the snapshot.
+   **/
+  bool tryStartScan(const void *lowVal, const Operator lowOp,
+                    const void *highVal, const Operator highOp);
+
+  /**
+   * Same as BTreeIndex::scanNext, over the snapshot.
+   * @throws ScanNotInitializedException If no scan has been initialized.
+   * @throws IndexScanCompletedException If no more records, satisfying the scan
+   *criteria, are left to be scanned.
+   **/
+  void scanNext(RecordId &outRid);
+
+  /**
+   * Same as BTreeIndex::tryScanNext, over the snapshot.
+   * @throws ScanNotInitializedException If no scan has been initialized.
+   **/
+  bool tryScanNext(RecordId &outRid);
+
+  /**
+   * Terminates the scan of the snapshot.
+   * @throws ScanNotInitializedException If no scan has been initialized.
+   **/
+  void endScan();
+
+ private:
+  BTreeSnapshot(BTreeIndex *index, const std::uint32_t snapshotId,
+                const PageId rootPageNo, const bool rootIsLeaf);
+
+  // Not copyable, the snapshot is closed once
+  BTreeSnapshot(const BTreeSnapshot &);
+  BTreeSnapshot &operator=(const BTreeSnapshot &);
+
+  BTreeIndex *index_;
+  std::uint32_t snapshotId_;
+  PageId rootPageNo_;
+  bool rootIsLeaf_;
+  ScanCursor cursor_;
+
+  /**
+   * Copy of the leaf the scan is on.
+   */
+  Page leaf_;
+
+  friend class BTreeIndex;
+};
+
+}  // namespace badgerdb
\ No newline at end of file
@@ -38,6 +38,11 @@ BufMgr::BufMgr(std::uint32_t bufs)
   clockHand = bufs - 1;
 }
 
+BufMgr::BufMgr()
+	: clockHand(0), numBufs(0), hashTable(NULL), bufDescTable(NULL),
+	  bufPool(NULL) {
+}
+
 
 BufMgr::~BufMgr() {
   //Flush out all unwritten pages
@@ -55,6 +60,14 @@ BufMgr::~BufMgr() {
 }
 
 void BufMgr::allocBuf(FrameId & frame) 
+{
+  if (!tryAllocBuf(frame))
+  {
+    throw BufferExceededException();
+  }
+}
+
+bool BufMgr::tryAllocBuf(FrameId & frame) 
 {
   // perform first part of clock algorithm to search for 
   // open buffer frame
@@ -71,6 +84,7 @@ void BufMgr::allocBuf(FrameId & frame)
     // if invalid, use frame
     if (! bufDescTable[clockHand].valid)
     {
+      found = true;
       break;
     }
 
@@ -96,9 +110,9 @@ void BufMgr::allocBuf(FrameId & frame)
   }
   
   // check for full buffer pool
-  if (!found && numScanned >= 2*numBufs)
+  if (!found)
   {
-    throw BufferExceededException();
+    return false;
   }
   
   // flush any existing changes to disk if necessary
@@ -114,27 +128,38 @@ void BufMgr::allocBuf(FrameId & frame)
 
   // return new frame number
   frame = clockHand;
-} // end allocBuf
+  return true;
+} // end tryAllocBuf
 
 	
 void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
+{
+  if (!tryReadPage(file, pageNo, page))
+  {
+    throw BufferExceededException();
+  }
+}
+
+
+bool BufMgr::tryReadPage(File* file, const PageId pageNo, Page*& page)
 {
   // check to see if it is already in the buffer pool
   // std::cout << "readPage called on file.page " << file << "." << pageNo << endl;
   FrameId frameNo = 0;
-	try
+	if (hashTable->tryLookup(file, pageNo, frameNo))
 	{
-  	hashTable->lookup(file, pageNo, frameNo);
-
     // set the referenced bit
     bufDescTable[frameNo].refbit = true;
     bufDescTable[frameNo].pinCnt++;
     page = &bufPool[frameNo];
   }
-  catch(HashNotFoundException e) //not in the buffer pool, must allocate a new page
+  else //not in the buffer pool, must allocate a new page
   {
     // alloc a new frame
-    allocBuf(frameNo);
+    if (!tryAllocBuf(frameNo))
+    {
+      return false;
+    }
 
     // read the page into the new frame
     bufStats.diskreads++;
@@ -148,6 +173,56 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
     // insert in the hash table
     hashTable->insert(file, pageNo, frameNo);
   }
+  return true;
+}
+
+
+void BufMgr::prefetchPage(File* file, const PageId pageNo)
+{
+  FrameId frameNo = 0;
+  if (!hashTable->tryLookup(file, pageNo, frameNo))
+  {
+    file->adviseWillNeed(pageNo);
+  }
+}
+
+
+bool BufMgr::tryReadCachedPage(File* file, const PageId pageNo, Page*& page)
+{
+  FrameId frameNo = 0;
+  if (!hashTable->tryLookup(file, pageNo, frameNo))
+  {
+    return false;
+  }
+  bufDescTable[frameNo].refbit = true;
+  bufDescTable[frameNo].pinCnt++;
+  page = &bufPool[frameNo];
+  return true;
+}
+
+
+bool BufMgr::installPage(File* file, const PageId pageNo, const Page& page,
+                         Page*& cached)
+{
+  // the copy in the pool may be newer than the one read
+  if (tryReadCachedPage(file, pageNo, cached))
+  {
+    return true;
+  }
+
+  FrameId frameNo = 0;
+  if (!tryAllocBuf(frameNo)) //every frame is pinned, drop the page
+  {
+    return false;
+  }
+
+  bufStats.diskreads++;
+  bufPool[frameNo] = page;
+
+  bufDescTable[frameNo].Set(file, pageNo);
+  hashTable->insert(file, pageNo, frameNo);
+  cached = &bufPool[frameNo];
+  return true;
 }
 
 
@@ -194,6 +269,21 @@ void BufMgr::flushFile(const File* file)
   }
 }
 
+void BufMgr::writeBackFile(const File* file)
+{
+  for (std::uint32_t i = 0; i < numBufs; i++)
+	{
+  	BufDesc* tmpbuf = &(bufDescTable[i]);
+  	if (tmpbuf->valid == true && tmpbuf->file == file &&
+  	    tmpbuf->dirty == true && tmpbuf->pinCnt == 0)
+		{
+			tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[i]);
+			tmpbuf->dirty = false;
+			bufStats.diskwrites++;
+  	}
+  }
+}
+
 void BufMgr::disposePage(File* file, const PageId pageNo) 
 {
 	//Deallocate from file altogether
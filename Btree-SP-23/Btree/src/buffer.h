@@ -182,11 +182,6 @@ class BufMgr
   BufDesc *bufDescTable;
 
 	/**
-   * Maintains Buffer pool usage statistics 
-	 */
-  BufStats bufStats;
-
-	/**
 	 * Allocate a free frame.  
 	 *
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
@@ -195,6 +190,14 @@ class BufMgr
   void allocBuf(FrameId & frame);
 
 	/**
+	 * Allocate a free frame, without throwing if every frame is pinned.
+	 *
+	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @return  false if no such buffer is found which can be allocated
+	 */
+  bool tryAllocBuf(FrameId & frame);
+
+	/**
    * Advance clock to next frame in the buffer pool
 	 */
   void advanceClock()
@@ -202,6 +205,17 @@ class BufMgr
 		clockHand = (clockHand + 1) % numBufs;
   }
 
+ protected:
+	/**
+   * Maintains Buffer pool usage statistics 
+	 */
+  BufStats bufStats;
+
+	/**
+   * Constructor for subclasses which keep their frames elsewhere. Leaves the
+   * buffer pool of this class empty.
+	 */
+  BufMgr();
 
  public:
 	/**
@@ -217,7 +231,7 @@ class BufMgr
 	/**
    * Destructor of BufMgr class
 	 */
-  ~BufMgr();
+  virtual ~BufMgr();
 
 	/**
 	 * Reads the given page from the file into a frame and returns the pointer to page.
@@ -227,9 +241,60 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number in the file to be read
 	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+	 * @throws BufferExceededException If the page is not present and every frame is pinned
 	 */
   void readPage(File* file, const PageId PageNo, Page*& page);
 
+	/**
+	 * Same as readPage(), but reports a full buffer pool through its return
+	 * value instead of an exception. Callers which can give up on a page, such
+	 * as readers holding many pins, take this path; readPage() wraps it.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param page  	Reference to page pointer, set only if true is returned
+	 * @return  false if the page is not present and every frame is pinned
+	 */
+  virtual bool tryReadPage(File* file, const PageId PageNo, Page*& page);
+
+	/**
+	 * Starts reading the given page in the background if it is not in the
+	 * buffer pool, so that a following readPage() on it finds it in the
+	 * operating system's cache instead of waiting for the disk. Returns at
+	 * once, without taking a frame.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 */
+  virtual void prefetchPage(File* file, const PageId PageNo);
+
+	/**
+	 * Same as tryReadPage(), but never goes to disk: the page is pinned and
+	 * returned only if it is already in the buffer pool.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param page  	Reference to page pointer, set only if true is returned
+	 * @return  false if the page is not present
+	 */
+  virtual bool tryReadCachedPage(File* file, const PageId PageNo, Page*& page);
+
+	/**
+	 * Brings a page the caller read from the file itself into the buffer pool
+	 * and pins it. If the page is already present, the copy in the pool is
+	 * pinned instead, as tryReadCachedPage() does. The page must be the one in
+	 * the file, not older than a dirty copy that was in the pool.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @param page  	Contents of the page
+	 * @param cached	Reference to page pointer, set to the page in the pool
+	 *              	only if true is returned
+	 * @return  false if no frame can be freed for the page
+	 */
+  virtual bool installPage(File* file, const PageId PageNo, const Page& page,
+                           Page*& cached);
+
 	/**
 	 * Unpin a page from memory since it is no longer required for it to remain in memory.
 	 *
@@ -238,7 +303,7 @@ class BufMgr
 	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
    * @throws  PageNotPinnedException If the page is not already pinned
 	 */
-  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+  virtual void unPinPage(File* file, const PageId PageNo, const bool dirty);
 
 	/**
 	 * Allocates a new, empty page in the file and returns the Page object.
@@ -248,7 +313,7 @@ class BufMgr
 	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
 	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
 	 */
-  void allocPage(File* file, PageId &PageNo, Page*& page); 
+  virtual void allocPage(File* file, PageId &PageNo, Page*& page); 
 
 	/**
 	 * Writes out all dirty pages of the file to disk.
@@ -259,7 +324,17 @@ class BufMgr
    * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
    * @throws BadBufferException If any frame allocated to the file is found to be invalid
 	 */
-  void flushFile(const File* file);
+  virtual void flushFile(const File* file);
+
+	/**
+	 * Writes out the dirty pages of the file which are not pinned, keeping them
+	 * in the buffer pool. Unlike flushFile() it can be called while pages of
+	 * the file are in use, so a background task can clean the pool ahead of
+	 * evictions.
+	 *
+	 * @param file   	File object
+	 */
+  virtual void writeBackFile(const File* file);
 
 	/**
 	 * Delete page from file and also from buffer pool if present.
@@ -268,12 +343,12 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number
 	 */
-  void disposePage(File* file, const PageId PageNo);
+  virtual void disposePage(File* file, const PageId PageNo);
 
 	/**
    * Print member variable values. 
 	 */
-  void  printSelf();
+  virtual void  printSelf();
 
 	/**
    * Get buffer pool usage statistics
@@ -0,0 +1,217 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "cluster.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <queue>
+#include <sstream>
+
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+#include "filescan.h"
+#include "page_builder.h"
+
+namespace badgerdb {
+
+/**
+ * Orders records by the value of an attribute. String attributes are
+ * compared on their first STRINGSIZE characters, like BTreeIndex keys.
+ */
+struct RecordKeyLess {
+  int attrByteOffset;
+  Datatype attrType;
+
+  bool operator()(const std::string &a, const std::string &b) const {
+    const char *keyA = a.data() + attrByteOffset;
+    const char *keyB = b.data() + attrByteOffset;
+    switch (attrType) {
+      case INTEGER:
+        return *(const int *)keyA < *(const int *)keyB;
+      case DOUBLE:
+        return *(const double *)keyA < *(const double *)keyB;
+      default:
+        return strncmp(keyA, keyB, STRINGSIZE) < 0;
+    }
+  }
+};
+
+/**
+ * Entry of the merge heap: current record of a run.
+ */
+struct MergeEntry {
+  std::string record;
+  std::size_t run;
+};
+
+/**
+ * Orders the merge heap so its top is the smallest record. Ties go to the
+ * earlier run so the merge is stable.
+ */
+struct MergeEntryGreater {
+  RecordKeyLess less;
+
+  bool operator()(const MergeEntry &a, const MergeEntry &b) const {
+    if (less(b.record, a.record)) {
+      return true;
+    }
+    if (less(a.record, b.record)) {
+      return false;
+    }
+    return a.run > b.run;
+  }
+};
+
+static void removeIfExists(const std::string &name) {
+  try {
+    File::remove(name);
+  } catch (const FileNotFoundException &e) {
+  }
+}
+
+/**
+ * Sorts the records in memory and writes them out as a new run.
+ */
+static void writeRun(std::vector<std::string> &records,
+                     const RecordKeyLess &less, const std::string &name) {
+  std::stable_sort(records.begin(), records.end(), less);
+  removeIfExists(name);
+  PageFile file = PageFile::create(name);
+  BulkLoader loader(&file);
+  for (std::size_t i = 0; i < records.size(); i++) {
+    loader.append(records[i]);
+  }
+  loader.flush();
+  records.clear();
+}
+
+/**
+ * Merges sorted runs into a single sorted file and removes the runs.
+ */
+static void mergeRuns(const std::vector<std::string> &runs,
+                      const RecordKeyLess &less, BufMgr *bufMgr,
+                      const std::string &outName) {
+  removeIfExists(outName);
+  {
+    PageFile file = PageFile::create(outName);
+    BulkLoader loader(&file);
+    std::vector<FileScan *> scans;
+    MergeEntryGreater greater = {less};
+    std::priority_queue<MergeEntry, std::vector<MergeEntry>, MergeEntryGreater>
+        heap(greater);
+    RecordId rid;
+    for (std::size_t r = 0; r < runs.size(); r++) {
+      scans.push_back(new FileScan(runs[r], bufMgr));
+      if (scans[r]->tryScanNext(rid)) {
+        MergeEntry entry = {scans[r]->getRecord(), r};
+        heap.push(entry);
+      }
+    }
+    while (!heap.empty()) {
+      MergeEntry entry = heap.top();
+      heap.pop();
+      loader.append(entry.record);
+      if (scans[entry.run]->tryScanNext(rid)) {
+        entry.record = scans[entry.run]->getRecord();
+        heap.push(entry);
+      }
+    }
+    loader.flush();
+    for (std::size_t r = 0; r < scans.size(); r++) {
+      delete scans[r];
+    }
+  }
+  for (std::size_t r = 0; r < runs.size(); r++) {
+    removeIfExists(runs[r]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// clusterRelation
+// -----------------------------------------------------------------------------
+
+std::size_t clusterRelation(const std::string &relationName, BufMgr *bufMgr,
+                            const int attrByteOffset, const Datatype attrType,
+                            const std::vector<IndexAttribute> &indexes,
+                            const std::size_t sortMemory,
+                            const double fillFactor) {
+  const RecordKeyLess less = {attrByteOffset, attrType};
+  const std::string clusteredName = relationName + ".clustered";
+  std::size_t runCount = 0;
+  std::vector<std::string> runs;
+
+  // Split the relation into sorted runs
+  {
+    std::vector<std::string> records;
+    std::size_t bytes = 0;
+    FileScan fscan(relationName, bufMgr);
+    RecordId scanRid;
+    while (fscan.tryScanNext(scanRid)) {
+      records.push_back(fscan.getRecord());
+      bytes += records.back().size();
+      if (bytes >= sortMemory) {
+        std::ostringstream runName;
+        runName << relationName << ".run." << runCount++;
+        runs.push_back(runName.str());
+        writeRun(records, less, runs.back());
+        bytes = 0;
+      }
+    }
+    if (runs.empty()) {
+      // Relation fits in memory, write it out directly
+      runCount = 1;
+      writeRun(records, less, clusteredName);
+    } else if (!records.empty()) {
+      std::ostringstream runName;
+      runName << relationName << ".run." << runCount++;
+      runs.push_back(runName.str());
+      writeRun(records, less, runs.back());
+    }
+  }
+
+  // Merge the runs, several passes if there are more than the merge fan-in
+  std::size_t mergeCount = 0;
+  while (runs.size() > CLUSTER_MERGE_FANIN) {
+    std::vector<std::string> merged;
+    for (std::size_t first = 0; first < runs.size();
+         first += CLUSTER_MERGE_FANIN) {
+      std::size_t last = std::min(first + CLUSTER_MERGE_FANIN, runs.size());
+      std::vector<std::string> group(runs.begin() + first,
+                                     runs.begin() + last);
+      std::ostringstream mergedName;
+      mergedName << relationName << ".merge." << mergeCount++;
+      merged.push_back(mergedName.str());
+      mergeRuns(group, less, bufMgr, merged.back());
+    }
+    runs.swap(merged);
+  }
+  if (!runs.empty()) {
+    mergeRuns(runs, less, bufMgr, clusteredName);
+  }
+
+  // Replace the relation by its clustered copy
+  File::remove(relationName);
+  File::rename(clusteredName, relationName);
+
+  // Rebuild the indexes since every RecordId has changed
+  for (std::size_t i = 0; i < indexes.size(); i++) {
+    std::ostringstream idxStr;
+    idxStr << relationName << "." << indexes[i].attrByteOffset;
+    removeIfExists(idxStr.str());
+    std::string indexName;
+    BTreeIndex index(relationName, indexName, bufMgr,
+                     indexes[i].attrByteOffset, indexes[i].attrType,
+                     SLOTTED_RELATION, NATIVE_KEYS, IN_PLACE_STORAGE,
+                     fillFactor);
+  }
+  return runCount;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,77 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "buffer.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Attribute of a relation over which a BTreeIndex is built.
+ */
+struct IndexAttribute {
+  /**
+   * Offset of the attribute inside the record.
+   */
+  int attrByteOffset;
+
+  /**
+   * Datatype of the attribute.
+   */
+  Datatype attrType;
+};
+
+/**
+ * @brief Default number of record bytes sorted in memory per run when
+ * clustering a relation.
+ */
+const std::size_t CLUSTER_SORT_MEMORY = 1 << 20;
+
+/**
+ * @brief Maximum number of runs merged at once. Every run being merged keeps
+ * one page pinned in the buffer pool.
+ */
+const std::size_t CLUSTER_MERGE_FANIN = 16;
+
+/**
+ * Rewrites a relation in the order of one of its attributes (CLUSTER), so that
+ * range scans on an index over that attribute fetch heap pages sequentially.
+ *
+ * The relation is sorted externally: runs of at most <sortMemory> bytes of
+ * records are sorted in memory and written to temporary files, then merged
+ * CLUSTER_MERGE_FANIN at a time. The sorted records are written page after
+ * page into a new file which replaces the relation. Since every record moves,
+ * the given indexes are dropped and rebuilt (bulk loaded) with the new
+ * RecordIds.
+ *
+ * The relation and its indexes must not be open while it is clustered.
+ *
+ * @param relationName    Name of the relation file.
+ * @param bufMgr          Buffer manager instance.
+ * @param attrByteOffset  Offset of the attribute to cluster on.
+ * @param attrType        Datatype of the attribute to cluster on.
+ * @param indexes         Attributes whose BTreeIndex has to be rebuilt.
+ * @param sortMemory      Number of record bytes sorted in memory per run.
+ * @param fillFactor      Share of the key slots of the index nodes filled by
+ *                        the rebuilds.
+ * @return  Number of sorted runs the relation was split into.
+ * @throws  FileOpenException   If the relation is open.
+ */
+std::size_t clusterRelation(const std::string &relationName, BufMgr *bufMgr,
+                            const int attrByteOffset, const Datatype attrType,
+                            const std::vector<IndexAttribute> &indexes,
+                            const std::size_t sortMemory = CLUSTER_SORT_MEMORY,
+                            const double fillFactor = BULKLOAD_FILL_FACTOR);
+
+}  // namespace badgerdb
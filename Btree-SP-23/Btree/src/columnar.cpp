@@ -0,0 +1,523 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "columnar.h"
+
+#include <string.h>
+
+#include <map>
+
+#include "blob_stream.h"
+#include "exceptions/end_of_file_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/invalid_record_exception.h"
+
+namespace badgerdb {
+
+static void appendBytes(std::vector<char> &out, const void *data,
+                        const std::size_t length) {
+  const char *bytes = (const char *)data;
+  out.insert(out.end(), bytes, bytes + length);
+}
+
+static void computeZoneMap(const PaxAttribute &attr, const char *values,
+                           const std::uint32_t numValues, ZoneMap &zoneMap) {
+  memset(&zoneMap, 0, sizeof(ZoneMap));
+  if (numValues == 0) {
+    return;
+  }
+  zoneMap.reset(attr.type, values);
+  for (std::uint32_t i = 1; i < numValues; i++) {
+    zoneMap.widen(attr.type, values + i * attr.size);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Column chunk encodings
+// -----------------------------------------------------------------------------
+
+static void encodeRle(const std::size_t size, const char *values,
+                      const std::uint32_t numValues, std::vector<char> &out) {
+  std::uint32_t i = 0;
+  while (i < numValues) {
+    std::uint32_t run = 1;
+    while (i + run < numValues &&
+           !memcmp(values + i * size, values + (i + run) * size, size)) {
+      run++;
+    }
+    appendBytes(out, &run, sizeof(run));
+    appendBytes(out, values + i * size, size);
+    i += run;
+  }
+}
+
+static void encodeDictionary(const std::size_t size, const char *values,
+                             const std::uint32_t numValues,
+                             std::vector<char> &out) {
+  std::map<std::string, std::uint16_t> codes;
+  std::vector<const char *> dictionary;
+  std::vector<std::uint16_t> rowCodes(numValues);
+  for (std::uint32_t i = 0; i < numValues; i++) {
+    const std::string value(values + i * size, size);
+    std::map<std::string, std::uint16_t>::iterator it = codes.find(value);
+    if (it == codes.end()) {
+      it = codes.insert(std::make_pair(value, dictionary.size())).first;
+      dictionary.push_back(values + i * size);
+    }
+    rowCodes[i] = it->second;
+  }
+  const std::uint32_t numEntries = dictionary.size();
+  appendBytes(out, &numEntries, sizeof(numEntries));
+  for (std::uint32_t e = 0; e < numEntries; e++) {
+    appendBytes(out, dictionary[e], size);
+  }
+  for (std::uint32_t i = 0; i < numValues; i++) {
+    if (numEntries <= 256) {
+      const std::uint8_t code = rowCodes[i];
+      appendBytes(out, &code, sizeof(code));
+    } else {
+      appendBytes(out, &rowCodes[i], sizeof(std::uint16_t));
+    }
+  }
+}
+
+static void encodeFrameOfReference(const char *values,
+                                   const std::uint32_t numValues,
+                                   std::vector<char> &out) {
+  int base = 0;
+  int maxValue = 0;
+  for (std::uint32_t i = 0; i < numValues; i++) {
+    int value;
+    memcpy(&value, values + i * sizeof(int), sizeof(int));
+    if (i == 0 || value < base) {
+      base = value;
+    }
+    if (i == 0 || value > maxValue) {
+      maxValue = value;
+    }
+  }
+  const std::uint32_t range = (std::uint32_t)maxValue - (std::uint32_t)base;
+  const std::uint8_t width = range < 0x100 ? 1 : (range < 0x10000 ? 2 : 4);
+  appendBytes(out, &base, sizeof(base));
+  appendBytes(out, &width, sizeof(width));
+  for (std::uint32_t i = 0; i < numValues; i++) {
+    int value;
+    memcpy(&value, values + i * sizeof(int), sizeof(int));
+    const std::uint32_t delta = (std::uint32_t)value - (std::uint32_t)base;
+    // Little endian: the low <width> bytes of the delta
+    appendBytes(out, &delta, width);
+  }
+}
+
+/**
+ * Encodes a column chunk in the smallest encoding that applies to it.
+ */
+static void encodeChunk(const PaxAttribute &attr, const char *values,
+                        const std::uint32_t numValues, std::vector<char> &out,
+                        std::uint32_t &encoding) {
+  out.assign(values, values + numValues * attr.size);
+  encoding = PLAIN_ENCODING;
+
+  std::vector<char> candidate;
+  encodeRle(attr.size, values, numValues, candidate);
+  if (candidate.size() < out.size()) {
+    out.swap(candidate);
+    encoding = RLE_ENCODING;
+  }
+  candidate.clear();
+  encodeDictionary(attr.size, values, numValues, candidate);
+  if (candidate.size() < out.size()) {
+    out.swap(candidate);
+    encoding = DICTIONARY_ENCODING;
+  }
+  if (attr.type == INTEGER) {
+    candidate.clear();
+    encodeFrameOfReference(values, numValues, candidate);
+    if (candidate.size() < out.size()) {
+      out.swap(candidate);
+      encoding = FOR_ENCODING;
+    }
+  }
+}
+
+static void decodeChunk(const PaxAttribute &attr, const std::uint32_t encoding,
+                        const std::vector<char> &in,
+                        const std::uint32_t numValues, std::vector<char> &out) {
+  const std::size_t size = attr.size;
+  out.resize(numValues * size);
+  const char *pos = in.empty() ? NULL : &in[0];
+  switch (encoding) {
+    case RLE_ENCODING: {
+      std::uint32_t i = 0;
+      while (i < numValues) {
+        std::uint32_t run;
+        memcpy(&run, pos, sizeof(run));
+        pos += sizeof(run);
+        for (std::uint32_t r = 0; r < run; r++, i++) {
+          memcpy(&out[i * size], pos, size);
+        }
+        pos += size;
+      }
+      break;
+    }
+    case DICTIONARY_ENCODING: {
+      std::uint32_t numEntries;
+      memcpy(&numEntries, pos, sizeof(numEntries));
+      const char *dictionary = pos + sizeof(numEntries);
+      const char *codes = dictionary + numEntries * size;
+      for (std::uint32_t i = 0; i < numValues; i++) {
+        std::uint16_t code;
+        if (numEntries <= 256) {
+          code = ((const std::uint8_t *)codes)[i];
+        } else {
+          memcpy(&code, codes + i * sizeof(std::uint16_t), sizeof(code));
+        }
+        memcpy(&out[i * size], dictionary + code * size, size);
+      }
+      break;
+    }
+    case FOR_ENCODING: {
+      int base;
+      memcpy(&base, pos, sizeof(base));
+      const std::uint8_t width = *(const std::uint8_t *)(pos + sizeof(base));
+      const char *deltas = pos + sizeof(base) + sizeof(width);
+      for (std::uint32_t i = 0; i < numValues; i++) {
+        std::uint32_t delta = 0;
+        memcpy(&delta, deltas + i * width, width);
+        const int value = (int)((std::uint32_t)base + delta);
+        memcpy(&out[i * size], &value, sizeof(int));
+      }
+      break;
+    }
+    default:
+      memcpy(&out[0], pos, numValues * size);
+      break;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Directory
+// -----------------------------------------------------------------------------
+
+/**
+ * Reads the schema and the row groups of a columnar relation from its meta
+ * page and directory.
+ */
+static void readDirectory(BlobFile *file, BufMgr *bufMgr, PaxSchema &schema,
+                          std::vector<std::uint32_t> &rowGroupSizes,
+                          std::vector<ColumnChunkInfo> &chunks) {
+  Page *metaPage;
+  bufMgr->readPage(file, 1, metaPage);
+  const ColumnarMetaInfo metaInfo = *(ColumnarMetaInfo *)metaPage;
+  bufMgr->unPinPage(file, 1, false);
+
+  BlobReader reader(file, bufMgr, metaInfo.directoryPageNo);
+  schema.resize(metaInfo.numColumns);
+  for (std::size_t c = 0; c < schema.size(); c++) {
+    std::int32_t offset;
+    std::uint32_t type;
+    std::uint32_t size;
+    reader.readValue(offset);
+    reader.readValue(type);
+    reader.readValue(size);
+    schema[c].offset = offset;
+    schema[c].type = (Datatype)type;
+    schema[c].size = size;
+  }
+  rowGroupSizes.resize(metaInfo.numRowGroups);
+  chunks.resize(metaInfo.numRowGroups * schema.size());
+  for (std::uint32_t g = 0; g < metaInfo.numRowGroups; g++) {
+    reader.readValue(rowGroupSizes[g]);
+    reader.read(&chunks[g * schema.size()],
+                schema.size() * sizeof(ColumnChunkInfo));
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ColumnarRelation
+// -----------------------------------------------------------------------------
+
+ColumnarRelation::ColumnarRelation(const std::string &name, BufMgr *bufMgr)
+    : file_(new BlobFile(name, false)), bufMgr_(bufMgr), recordLength_(0) {
+  readDirectory(file_, bufMgr_, schema_, rowGroupSizes_, chunks_);
+  for (std::size_t c = 0; c < schema_.size(); c++) {
+    if (schema_[c].offset + schema_[c].size > recordLength_) {
+      recordLength_ = schema_[c].offset + schema_[c].size;
+    }
+  }
+  cachedGroups_.assign(schema_.size(), numRowGroups());
+  cachedValues_.resize(schema_.size());
+}
+
+ColumnarRelation::~ColumnarRelation() {
+  try {
+    bufMgr_->flushFile(file_);
+  } catch (...) {
+  }
+  delete file_;
+}
+
+int ColumnarRelation::findColumn(const int recordOffset) const {
+  for (std::size_t c = 0; c < schema_.size(); c++) {
+    if (schema_[c].offset == recordOffset) {
+      return c;
+    }
+  }
+  return -1;
+}
+
+void ColumnarRelation::readColumn(const std::uint32_t group,
+                                  const std::size_t column,
+                                  std::vector<char> &out) const {
+  const ColumnChunkInfo &info = chunk(group, column);
+  std::vector<char> encoded(info.encodedLength);
+  BlobReader reader(file_, bufMgr_, info.firstPageNo);
+  if (!encoded.empty()) {
+    reader.read(&encoded[0], encoded.size());
+  }
+  decodeChunk(schema_[column], info.encoding, encoded, rowGroupSizes_[group],
+              out);
+}
+
+std::string ColumnarRelation::getRecord(const RecordId &rid) const {
+  if (rid.page_number == Page::INVALID_NUMBER ||
+      rid.page_number > numRowGroups() || rid.slot_number == Page::INVALID_SLOT ||
+      rid.slot_number > rowGroupSizes_[rid.page_number - 1]) {
+    throw InvalidRecordException(rid, rid.page_number);
+  }
+  const std::uint32_t group = rid.page_number - 1;
+  const std::uint32_t row = rid.slot_number - 1;
+  std::string record(recordLength_, '\0');
+  for (std::size_t c = 0; c < schema_.size(); c++) {
+    readValue(group, c, row, &record[schema_[c].offset]);
+  }
+  return record;
+}
+
+void ColumnarRelation::readValue(const std::uint32_t group,
+                                 const std::size_t column,
+                                 const std::uint32_t row, char *out) const {
+  const ColumnChunkInfo &info = chunk(group, column);
+  const std::size_t size = schema_[column].size;
+  switch (info.encoding) {
+    case PLAIN_ENCODING: {
+      BlobReader reader(file_, bufMgr_, info.firstPageNo);
+      reader.skip(row * size);
+      reader.read(out, size);
+      break;
+    }
+    case FOR_ENCODING: {
+      BlobReader reader(file_, bufMgr_, info.firstPageNo);
+      int base;
+      std::uint8_t width;
+      reader.readValue(base);
+      reader.readValue(width);
+      reader.skip(row * width);
+      std::uint32_t delta = 0;
+      reader.read(&delta, width);
+      const int value = (int)((std::uint32_t)base + delta);
+      memcpy(out, &value, sizeof(int));
+      break;
+    }
+    default:
+      // The run of a row is only found by walking the runs before it, and
+      // the dictionary entry of a row comes before its code in the stream
+      if (cachedGroups_[column] != group) {
+        readColumn(group, column, cachedValues_[column]);
+        cachedGroups_[column] = group;
+      }
+      memcpy(out, &cachedValues_[column][row * size], size);
+      break;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ColumnarWriter
+// -----------------------------------------------------------------------------
+
+ColumnarWriter::ColumnarWriter(const std::string &name, BufMgr *bufMgr,
+                               const PaxSchema &schema,
+                               const std::uint32_t rowGroupSize)
+    : file_(NULL),
+      bufMgr_(bufMgr),
+      schema_(schema),
+      rowGroupSize_(rowGroupSize > 0xFFFF ? 0xFFFF : rowGroupSize),
+      numBuffered_(0) {
+  try {
+    file_ = new BlobFile(name, false);
+    readDirectory(file_, bufMgr_, schema_, rowGroupSizes_, chunks_);
+  } catch (const FileNotFoundException &e) {
+    file_ = new BlobFile(name, true);
+    PageId metaPageNo;
+    Page *metaPage;
+    bufMgr_->allocPage(file_, metaPageNo, metaPage);
+    ColumnarMetaInfo *metaInfo = (ColumnarMetaInfo *)metaPage;
+    metaInfo->numColumns = schema_.size();
+    metaInfo->numRowGroups = 0;
+    metaInfo->directoryPageNo = Page::INVALID_NUMBER;
+    bufMgr_->unPinPage(file_, metaPageNo, true);
+  }
+  if (rowGroupSize_ == 0) {
+    rowGroupSize_ = 1;
+  }
+  columns_.resize(schema_.size());
+  for (std::size_t c = 0; c < schema_.size(); c++) {
+    columns_[c].reserve(rowGroupSize_ * schema_[c].size);
+  }
+}
+
+ColumnarWriter::~ColumnarWriter() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void ColumnarWriter::append(const char *record) {
+  for (std::size_t c = 0; c < schema_.size(); c++) {
+    appendBytes(columns_[c], record + schema_[c].offset, schema_[c].size);
+  }
+  if (++numBuffered_ == rowGroupSize_) {
+    flushRowGroup();
+  }
+}
+
+void ColumnarWriter::flushRowGroup() {
+  if (numBuffered_ == 0) {
+    return;
+  }
+  std::vector<char> encoded;
+  for (std::size_t c = 0; c < schema_.size(); c++) {
+    ColumnChunkInfo info;
+    computeZoneMap(schema_[c], &columns_[c][0], numBuffered_, info.zoneMap);
+    encodeChunk(schema_[c], &columns_[c][0], numBuffered_, encoded,
+                info.encoding);
+    info.encodedLength = encoded.size();
+    BlobWriter writer(file_, bufMgr_);
+    writer.write(encoded.empty() ? NULL : &encoded[0], encoded.size());
+    writer.close();
+    info.firstPageNo = writer.firstPageNo();
+    chunks_.push_back(info);
+    columns_[c].clear();
+  }
+  rowGroupSizes_.push_back(numBuffered_);
+  numBuffered_ = 0;
+}
+
+void ColumnarWriter::close() {
+  if (file_ == NULL) {
+    return;
+  }
+  flushRowGroup();
+
+  Page *metaPage;
+  bufMgr_->readPage(file_, 1, metaPage);
+  ColumnarMetaInfo *metaInfo = (ColumnarMetaInfo *)metaPage;
+  {
+    BlobWriter writer(file_, bufMgr_, metaInfo->directoryPageNo);
+    for (std::size_t c = 0; c < schema_.size(); c++) {
+      writer.writeValue(std::int32_t(schema_[c].offset));
+      writer.writeValue(std::uint32_t(schema_[c].type));
+      writer.writeValue(std::uint32_t(schema_[c].size));
+    }
+    for (std::size_t g = 0; g < rowGroupSizes_.size(); g++) {
+      writer.writeValue(rowGroupSizes_[g]);
+      writer.write(&chunks_[g * schema_.size()],
+                   schema_.size() * sizeof(ColumnChunkInfo));
+    }
+    writer.close();
+    metaInfo->directoryPageNo = writer.firstPageNo();
+  }
+  metaInfo->numColumns = schema_.size();
+  metaInfo->numRowGroups = rowGroupSizes_.size();
+  bufMgr_->unPinPage(file_, 1, true);
+
+  bufMgr_->flushFile(file_);
+  delete file_;
+  file_ = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// ColumnarScan
+// -----------------------------------------------------------------------------
+
+ColumnarScan::ColumnarScan(const std::string &name, BufMgr *bufMgr,
+                           const std::vector<int> &columns)
+    : relation_(name, bufMgr),
+      wanted_(relation_.schema().size(), columns.empty()),
+      values_(relation_.schema().size()),
+      curGroup_(0),
+      curRow_(0),
+      nextRow_(0),
+      groupLoaded_(false),
+      rangeColumn_(-1),
+      rowGroupsSkipped_(0) {
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    wanted_[columns[i]] = true;
+  }
+}
+
+void ColumnarScan::setRange(const int column, const void *lowVal,
+                            const Operator lowOp, const void *highVal,
+                            const Operator highOp) {
+  range_ = AttributeRange(relation_.schema()[column].type, lowVal, lowOp,
+                          highVal, highOp);
+  rangeColumn_ = column;
+  wanted_[column] = true;
+  curGroup_ = 0;
+  groupLoaded_ = false;
+  rowGroupsSkipped_ = 0;
+}
+
+void ColumnarScan::scanNext(RecordId &outRid) {
+  while (true) {
+    if (groupLoaded_) {
+      const std::uint32_t numRows = relation_.rowGroupSize(curGroup_);
+      while (nextRow_ < numRows) {
+        const std::uint32_t row = nextRow_++;
+        if (rangeColumn_ < 0 || range_.contains(valueAt(rangeColumn_, row))) {
+          curRow_ = row;
+          outRid = {curGroup_ + 1, (SlotId)(row + 1)};
+          return;
+        }
+      }
+      groupLoaded_ = false;
+      curGroup_++;
+    }
+    if (curGroup_ >= relation_.numRowGroups()) {
+      throw EndOfFileException();
+    }
+    if (rangeColumn_ >= 0 &&
+        !range_.mayMatch(relation_.chunk(curGroup_, rangeColumn_).zoneMap)) {
+      rowGroupsSkipped_++;
+      curGroup_++;
+      continue;
+    }
+    for (std::size_t c = 0; c < wanted_.size(); c++) {
+      if (wanted_[c]) {
+        relation_.readColumn(curGroup_, c, values_[c]);
+      }
+    }
+    groupLoaded_ = true;
+    nextRow_ = 0;
+  }
+}
+
+std::string ColumnarScan::getRecord() const {
+  std::string record(relation_.recordLength(), '\0');
+  for (std::size_t c = 0; c < wanted_.size(); c++) {
+    if (wanted_[c]) {
+      const std::size_t size = relation_.schema()[c].size;
+      memcpy(&record[relation_.schema()[c].offset],
+             &values_[c][curRow_ * size], size);
+    }
+  }
+  return record;
+}
+
+}  // namespace badgerdb
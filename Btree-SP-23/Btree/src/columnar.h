@@ -0,0 +1,363 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "buffer.h"
+#include "file.h"
+#include "pax_page.h"
+#include "types.h"
+#include "zone_map.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Default number of records of a row group of a columnar relation.
+ * Slot numbers of RecordIds are 16 bits, so a row group holds at most 65535
+ * records.
+ */
+const std::uint32_t COLUMNAR_ROW_GROUP_SIZE = 4096;
+
+/**
+ * @brief Encoding of a column chunk. The writer picks the smallest one for
+ * every chunk.
+ */
+enum ColumnEncoding {
+  /**
+   * Values stored one after the other.
+   */
+  PLAIN_ENCODING = 0,
+  /**
+   * Runs of equal values, stored as <run length, value>.
+   */
+  RLE_ENCODING = 1,
+  /**
+   * Distinct values stored once, followed by a 1 or 2 byte code per record.
+   */
+  DICTIONARY_ENCODING = 2,
+  /**
+   * Frame of reference, INTEGER columns only: the minimum of the chunk
+   * followed by the 1, 2 or 4 byte difference of every value to it.
+   */
+  FOR_ENCODING = 3
+};
+
+/**
+ * @brief Location, encoding and zone map of one column of a row group.
+ */
+struct ColumnChunkInfo {
+  /**
+   * First page of the blob stream holding the encoded chunk.
+   */
+  PageId firstPageNo;
+
+  /**
+   * Number of bytes of the encoded chunk.
+   */
+  std::uint32_t encodedLength;
+
+  /**
+   * ColumnEncoding of the chunk.
+   */
+  std::uint32_t encoding;
+
+  /**
+   * Smallest and largest value of the chunk.
+   */
+  ZoneMap zoneMap;
+};
+
+/**
+ * @brief The meta page of a columnar relation. The schema and the chunks of
+ * every row group are kept in a blob stream, the directory, rewritten when
+ * row groups are appended.
+ */
+struct ColumnarMetaInfo {
+  /**
+   * Number of columns of the relation.
+   */
+  std::uint32_t numColumns;
+
+  /**
+   * Number of row groups of the relation.
+   */
+  std::uint32_t numRowGroups;
+
+  /**
+   * First page of the directory stream.
+   */
+  PageId directoryPageNo;
+};
+
+/**
+ * @brief Read access to a columnar relation.
+ *
+ * A columnar relation is a BlobFile of row groups. Each row group stores up to
+ * a few thousand records column by column: the values of every column form a
+ * column chunk, encoded on its own and kept in its own page chain, so reading
+ * a column does not touch the pages of the others. The zone map of every chunk
+ * is kept in the directory, so predicates can rule out whole row groups
+ * without reading them.
+ *
+ * Record <r> of row group <g> (both counted from 0) has the RecordId
+ * {g + 1, r + 1}, so a columnar relation can be indexed by BTreeIndex.
+ */
+class ColumnarRelation {
+ public:
+  /**
+   * Opens a columnar relation.
+   *
+   * @param name    Name of the relation file.
+   * @param bufMgr  Buffer manager instance.
+   * @throws  FileNotFoundException   If the relation doesn't exist.
+   */
+  ColumnarRelation(const std::string &name, BufMgr *bufMgr);
+
+  /**
+   * Flushes the pages of the relation and closes it.
+   */
+  ~ColumnarRelation();
+
+  /**
+   * Returns the columns of the relation.
+   */
+  const PaxSchema &schema() const { return schema_; }
+
+  /**
+   * Returns the index of the column at <recordOffset> in row format records,
+   * or -1 if there is none.
+   */
+  int findColumn(const int recordOffset) const;
+
+  /**
+   * Returns the length of a record in row format.
+   */
+  std::size_t recordLength() const { return recordLength_; }
+
+  /**
+   * Returns the number of row groups.
+   */
+  std::uint32_t numRowGroups() const { return rowGroupSizes_.size(); }
+
+  /**
+   * Returns the number of records of a row group.
+   */
+  std::uint32_t rowGroupSize(const std::uint32_t group) const {
+    return rowGroupSizes_[group];
+  }
+
+  /**
+   * Returns the chunk of a column in a row group.
+   */
+  const ColumnChunkInfo &chunk(const std::uint32_t group,
+                               const std::size_t column) const {
+    return chunks_[group * schema_.size() + column];
+  }
+
+  /**
+   * Reads and decodes the chunk of a column in a row group.
+   *
+   * @param group   Row group.
+   * @param column  Column.
+   * @param out     Receives rowGroupSize(group) values of the column, one
+   *                after the other.
+   */
+  void readColumn(const std::uint32_t group, const std::size_t column,
+                  std::vector<char> &out) const;
+
+  /**
+   * Returns a copy of a record in row format. Only the value of the record is
+   * read from PLAIN and FOR chunks. RLE and dictionary chunks have to be
+   * decoded whole, the last one decoded of every column is kept for the next
+   * records of the same row group. Scanning a row group should still go
+   * through a ColumnarScan.
+   *
+   * @param rid   ID of the record.
+   * @return  The record.
+   * @throws  InvalidRecordException  If the record doesn't exist.
+   */
+  std::string getRecord(const RecordId &rid) const;
+
+ private:
+  /**
+   * Copies the value of a column of one record into <out>.
+   */
+  void readValue(const std::uint32_t group, const std::size_t column,
+                 const std::uint32_t row, char *out) const;
+
+  BlobFile *file_;
+  BufMgr *bufMgr_;
+  PaxSchema schema_;
+  std::size_t recordLength_;
+  std::vector<std::uint32_t> rowGroupSizes_;
+  std::vector<ColumnChunkInfo> chunks_;
+
+  /**
+   * Row group of the chunk decoded last for every column by getRecord,
+   * numRowGroups() if there is none.
+   */
+  mutable std::vector<std::uint32_t> cachedGroups_;
+
+  /**
+   * Values of the chunk decoded last for every column by getRecord.
+   */
+  mutable std::vector<std::vector<char> > cachedValues_;
+
+  friend class ColumnarWriter;
+};
+
+/**
+ * @brief Appends records to a columnar relation.
+ *
+ * Records are buffered until a row group is full. The row group is then
+ * written column by column, each chunk in the smallest of the encodings that
+ * apply to it, with its zone map. The directory is rewritten on close.
+ */
+class ColumnarWriter {
+ public:
+  /**
+   * Opens a columnar relation for appending, creating it if it doesn't exist.
+   *
+   * @param name          Name of the relation file.
+   * @param bufMgr        Buffer manager instance.
+   * @param schema        Columns of the records. Ignored if the relation
+   *                      exists, which keeps its own.
+   * @param rowGroupSize  Number of records per row group, at most 65535.
+   */
+  ColumnarWriter(const std::string &name, BufMgr *bufMgr,
+                 const PaxSchema &schema,
+                 const std::uint32_t rowGroupSize = COLUMNAR_ROW_GROUP_SIZE);
+
+  /**
+   * Closes the writer if it hasn't been closed already.
+   */
+  ~ColumnarWriter();
+
+  /**
+   * Appends a record.
+   *
+   * @param record  Record in row format.
+   */
+  void append(const char *record);
+
+  /**
+   * Writes the records still buffered as a last, smaller row group, writes
+   * the directory and closes the relation.
+   */
+  void close();
+
+ private:
+  /**
+   * Writes the buffered records as a row group.
+   */
+  void flushRowGroup();
+
+  BlobFile *file_;
+  BufMgr *bufMgr_;
+  PaxSchema schema_;
+  std::uint32_t rowGroupSize_;
+  std::vector<std::uint32_t> rowGroupSizes_;
+  std::vector<ColumnChunkInfo> chunks_;
+
+  /**
+   * Values of the buffered records, one vector per column.
+   */
+  std::vector<std::vector<char> > columns_;
+  std::uint32_t numBuffered_;
+};
+
+/**
+ * @brief Sequential scan over a columnar relation.
+ *
+ * Only the columns asked for are read. A range predicate on one of them skips
+ * the row groups whose zone map rules it out and the records which don't
+ * satisfy it.
+ */
+class ColumnarScan {
+ public:
+  /**
+   * Opens a scan over the given relation.
+   *
+   * @param name      Name of the relation file.
+   * @param bufMgr    Buffer manager instance.
+   * @param columns   Indexes of the columns to read. All of them if empty.
+   */
+  ColumnarScan(const std::string &name, BufMgr *bufMgr,
+               const std::vector<int> &columns = std::vector<int>());
+
+  /**
+   * Restricts the scan to the records whose value of <column> is in the
+   * given range, and restarts it. The column is added to the columns read if
+   * needed. STRING values are compared on their first STRINGSIZE characters.
+   *
+   * @param column    Index of the column.
+   * @param lowVal    Low value of the range, of the column's type.
+   * @param lowOp     GT or GTE.
+   * @param highVal   High value of the range, of the column's type.
+   * @param highOp    LT or LTE.
+   * @throws  BadOpcodesException   If the operators are not as above.
+   */
+  void setRange(const int column, const void *lowVal, const Operator lowOp,
+                const void *highVal, const Operator highOp);
+
+  /**
+   * Moves to the next record of the scan.
+   *
+   * @param outRid  Receives the ID of the record.
+   * @throws  EndOfFileException  If there are no more records.
+   */
+  void scanNext(RecordId &outRid);
+
+  /**
+   * Returns the value of a column of the current record. The column must be
+   * one of the columns read.
+   *
+   * @param column  Index of the column.
+   */
+  const char *getValue(const int column) const {
+    return valueAt(column, curRow_);
+  }
+
+  /**
+   * Returns a copy of the current record in row format. Columns which are
+   * not read are left zeroed.
+   */
+  std::string getRecord() const;
+
+  /**
+   * Returns the number of row groups skipped on their zone map so far.
+   */
+  std::uint32_t rowGroupsSkipped() const { return rowGroupsSkipped_; }
+
+ private:
+  /**
+   * Returns the value of a column of a record of the current row group.
+   */
+  const char *valueAt(const int column, const std::uint32_t row) const {
+    return &values_[column][row * relation_.schema()[column].size];
+  }
+
+  ColumnarRelation relation_;
+  std::vector<bool> wanted_;
+  std::vector<std::vector<char> > values_;
+  std::uint32_t curGroup_;
+  std::uint32_t curRow_;
+  std::uint32_t nextRow_;
+  bool groupLoaded_;
+  int rangeColumn_;
+  AttributeRange range_;
+  std::uint32_t rowGroupsSkipped_;
+};
+
+}  // namespace badgerdb
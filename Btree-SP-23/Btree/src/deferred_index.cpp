@@ -0,0 +1,160 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "deferred_index.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+/**
+ * Returns true if a key satisfies the bounds of a scan.
+ */
+static bool inRange(const IndexKey &key, const IndexKey &lowValKey,
+                    const Operator lowOp, const IndexKey &highValKey,
+                    const Operator highOp) {
+  const int low = key.compare(lowValKey);
+  const int high = key.compare(highValKey);
+  return (lowOp == GT ? low > 0 : low >= 0) &&
+         (highOp == LT ? high < 0 : high <= 0);
+}
+
+/**
+ * Appends the entries of <entries> within the bounds of a scan to
+ * <outEntries>.
+ */
+static void appendInRange(const std::vector<RIDKeyPair<IndexKey> > &entries,
+                          const IndexKey &lowValKey, const Operator lowOp,
+                          const IndexKey &highValKey, const Operator highOp,
+                          std::vector<RIDKeyPair<IndexKey> > &outEntries) {
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    if (inRange(entries[i].key, lowValKey, lowOp, highValKey, highOp)) {
+      outEntries.push_back(entries[i]);
+    }
+  }
+}
+
+DeferredIndex::DeferredIndex(BTreeIndex *index, const std::size_t batchSize)
+    : index_(index),
+      batchSize_(batchSize),
+      flushing_(0),
+      stopping_(false),
+      thread_(&DeferredIndex::run, this) {}
+
+DeferredIndex::~DeferredIndex() {
+  {
+    std::lock_guard<std::mutex> lock(queueLatch_);
+    stopping_ = true;
+  }
+  workReady_.notify_one();
+  thread_.join();
+}
+
+void DeferredIndex::insertEntry(const void *key, const RecordId rid) {
+  RIDKeyPair<IndexKey> entry;
+  entry.set(rid, IndexKey::fromValue(index_->getAttributeType(), key));
+  std::lock_guard<std::mutex> lock(queueLatch_);
+  pending_.push_back(entry);
+  if (pending_.size() >= batchSize_) {
+    workReady_.notify_one();
+  }
+}
+
+void DeferredIndex::collectRids(const void *lowVal, const Operator lowOp,
+                                const void *highVal, const Operator highOp,
+                                std::vector<RecordId> &outRids) {
+  std::lock_guard<std::mutex> indexLock(indexLatch_);
+  const bool found = index_->tryStartScan(lowVal, lowOp, highVal, highOp);
+
+  // The thread is not applying a batch while the index is latched: the
+  // queued entries are those not in the index
+  std::vector<RIDKeyPair<IndexKey> > queuedEntries;
+  {
+    const Datatype type = index_->getAttributeType();
+    const IndexKey lowValKey = IndexKey::fromValue(type, lowVal);
+    const IndexKey highValKey = IndexKey::fromValue(type, highVal);
+    std::lock_guard<std::mutex> queueLock(queueLatch_);
+    appendInRange(applying_, lowValKey, lowOp, highValKey, highOp,
+                  queuedEntries);
+    appendInRange(pending_, lowValKey, lowOp, highValKey, highOp,
+                  queuedEntries);
+  }
+  std::stable_sort(queuedEntries.begin(), queuedEntries.end());
+
+  // Merge them with the entries of the index
+  std::size_t next = 0;
+  if (found) {
+    RecordId rid;
+    IndexKey key;
+    while (index_->tryScanNext(rid, key)) {
+      while (next < queuedEntries.size() &&
+             queuedEntries[next].key.compare(key) < 0) {
+        outRids.push_back(queuedEntries[next++].rid);
+      }
+      outRids.push_back(rid);
+    }
+  }
+  index_->endScan();
+  for (; next < queuedEntries.size(); next++) {
+    outRids.push_back(queuedEntries[next].rid);
+  }
+}
+
+void DeferredIndex::flush() {
+  std::unique_lock<std::mutex> lock(queueLatch_);
+  flushing_++;
+  workReady_.notify_one();
+  while (!pending_.empty() || !applying_.empty()) {
+    batchApplied_.wait(lock);
+  }
+  flushing_--;
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
+
+std::size_t DeferredIndex::queued() {
+  std::lock_guard<std::mutex> lock(queueLatch_);
+  return pending_.size() + applying_.size();
+}
+
+void DeferredIndex::run() {
+  std::unique_lock<std::mutex> queueLock(queueLatch_);
+  while (true) {
+    while (!stopping_ && pending_.size() < batchSize_ &&
+           (flushing_ == 0 || pending_.empty())) {
+      workReady_.wait(queueLock);
+    }
+    if (pending_.empty()) {
+      // Stopping, with nothing left to apply
+      return;
+    }
+    applying_.swap(pending_);
+    // Sorted entries go to the same leaves one after the other
+    std::sort(applying_.begin(), applying_.end());
+    queueLock.unlock();
+    {
+      std::lock_guard<std::mutex> indexLock(indexLatch_);
+      try {
+        for (std::size_t i = 0; i < applying_.size(); i++) {
+          index_->insertEntry(applying_[i].key, applying_[i].rid);
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> errorLock(queueLatch_);
+        error_ = std::current_exception();
+      }
+      queueLock.lock();
+      applying_.clear();
+    }
+    batchApplied_.notify_all();
+  }
+}
+
+}  // namespace badgerdb
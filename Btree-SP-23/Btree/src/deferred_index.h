@@ -0,0 +1,147 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Secondary BTreeIndex maintained in the background.
+ *
+ * Inserts are queued in memory and return at once, so inserting into a
+ * relation with several indexes does not wait for each of them. A thread of
+ * the index applies the queue in batches, sorted by key so consecutive
+ * entries land in the same leaves. Scans read the index and the entries
+ * still queued, so they see every insert made before them.
+ *
+ * The thread uses the buffer manager of the index, which is not thread safe:
+ * the index has to have a buffer manager of its own, and once wrapped it is
+ * only used through the DeferredIndex. Queued entries are lost if the
+ * process dies before they are applied.
+ */
+class DeferredIndex {
+ public:
+  /**
+   * Starts the thread maintaining an index.
+   *
+   * @param index       Index to maintain. Outlives the DeferredIndex.
+   * @param batchSize   Number of queued entries the thread waits for before
+   *                    applying them.
+   */
+  DeferredIndex(BTreeIndex *index, const std::size_t batchSize = 256);
+
+  /**
+   * Applies the queued entries and stops the thread.
+   */
+  ~DeferredIndex();
+
+  /**
+   * Queues an entry to insert into the index.
+   *
+   * @param key   Pointer to integer / double / char string, as for
+   *              BTreeIndex::insertEntry.
+   * @param rid   Record ID of the record.
+   */
+  void insertEntry(const void *key, const RecordId rid);
+
+  /**
+   * Runs a scan over the index and the queued entries and appends the
+   * RecordIds it returns to <outRids>, in key order. Entries with the same
+   * key come in no particular order, as in the index.
+   *
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   */
+  void collectRids(const void *lowVal, const Operator lowOp,
+                   const void *highVal, const Operator highOp,
+                   std::vector<RecordId> &outRids);
+
+  /**
+   * Waits until the queued entries are applied.
+   *
+   * @throws  Any exception an insert into the index threw in the thread.
+   *          The rest of its batch is dropped.
+   */
+  void flush();
+
+  /**
+   * Returns the number of entries not applied yet.
+   */
+  std::size_t queued();
+
+ private:
+  // Not copyable, the thread refers to the object
+  DeferredIndex(const DeferredIndex &);
+  DeferredIndex &operator=(const DeferredIndex &);
+
+  /**
+   * Body of the thread: applies batches until stopped.
+   */
+  void run();
+
+  BTreeIndex *index_;
+  std::size_t batchSize_;
+
+  /**
+   * Held while the index is read or modified. Taken before queueLatch_.
+   */
+  std::mutex indexLatch_;
+
+  /**
+   * Protects the members below.
+   */
+  std::mutex queueLatch_;
+
+  /**
+   * Signals the thread that there is work or that it has to stop.
+   */
+  std::condition_variable workReady_;
+
+  /**
+   * Signals flush() that a batch was applied.
+   */
+  std::condition_variable batchApplied_;
+
+  /**
+   * Entries queued since the thread took the last batch.
+   */
+  std::vector<RIDKeyPair<IndexKey> > pending_;
+
+  /**
+   * Batch the thread is applying. Its entries are all applied when the
+   * thread releases indexLatch_, and the batch cleared.
+   */
+  std::vector<RIDKeyPair<IndexKey> > applying_;
+
+  /**
+   * Number of callers waiting in flush(), for which the thread applies
+   * batches smaller than batchSize_.
+   */
+  int flushing_;
+
+  bool stopping_;
+
+  /**
+   * Exception thrown by the last failed insert, until flush() rethrows it.
+   */
+  std::exception_ptr error_;
+
+  std::thread thread_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "shared_segment_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+SharedSegmentException::SharedSegmentException(const std::string& segmentName,
+                                               const std::string& reason)
+    : BadgerDbException(""), segmentName_(segmentName) {
+  std::stringstream ss;
+  ss << "Shared buffer pool segment " << segmentName_ << ": " << reason;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a shared buffer pool segment cannot
+ * be created, attached or used.
+ */
+class SharedSegmentException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a shared segment exception for the given segment.
+   *
+   * @param segmentName  Name of the shared memory segment.
+   * @param reason       What went wrong.
+   */
+  explicit SharedSegmentException(const std::string& segmentName,
+                                  const std::string& reason);
+
+  /**
+   * Returns the name of the segment that caused this exception.
+   */
+  virtual const std::string& segmentName() const { return segmentName_; }
+
+ protected:
+  /**
+   * Name of the segment that caused this exception.
+   */
+  const std::string segmentName_;
+};
+
+}
@@ -7,6 +7,9 @@
 
 #include "file.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -17,6 +20,7 @@
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
+#include "exceptions/file_sync_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "file_iterator.h"
 #include "page.h"
@@ -25,6 +29,8 @@ namespace badgerdb {
 
 File::StreamMap File::open_streams_;
 File::CountMap File::open_counts_;
+File::FlagMap File::version_read_;
+File::DescriptorMap File::open_fds_;
 
 void File::remove(const std::string& filename) {
   if (!exists(filename)) {
@@ -36,6 +42,61 @@ void File::remove(const std::string& filename) {
   std::remove(filename.c_str());
 }
 
+Page File::readPageDirect(const PageId page_number) const {
+  if (fd_ < 0) {
+    throw FileNotFoundException(filename_);
+  }
+  Page page;
+  const ssize_t bytes = ::pread(fd_, reinterpret_cast<char*>(&page),
+                                Page::SIZE, pagePosition(page_number));
+  if (bytes != (ssize_t)Page::SIZE) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  return page;
+}
+
+void File::sync() const {
+  stream_->flush();
+  if (fd_ < 0 || ::fdatasync(fd_) != 0) {
+    throw FileSyncException(filename_);
+  }
+}
+
+void File::adviseWillNeed(const PageId page_number) const {
+  if (fd_ >= 0) {
+    ::posix_fadvise(fd_, pagePosition(page_number), Page::SIZE,
+                    POSIX_FADV_WILLNEED);
+  }
+}
+
+std::uint32_t File::version() const {
+  version_read_[filename_] = true;
+  return readHeader().version;
+}
+
+void File::changeVersion() {
+  if (!version_read_[filename_]) {
+    return;
+  }
+  FileHeader header = readHeader();
+  ++header.version;
+  writeHeader(header);
+  version_read_[filename_] = false;
+}
+
+void File::rename(const std::string& filename, const std::string& newName) {
+  if (!exists(filename)) {
+    throw FileNotFoundException(filename);
+  }
+  if (exists(newName)) {
+    throw FileExistsException(newName);
+  }
+  if (isOpen(filename)) {
+    throw FileOpenException(filename);
+  }
+  std::rename(filename.c_str(), newName.c_str());
+}
+
 bool File::isOpen(const std::string& filename) {
   if (!exists(filename)) {
     return false;
@@ -64,13 +125,15 @@ PageId File::getFirstPageNo() {
   return header.first_used_page;
 }
 
-File::File(const std::string& name, const bool create_new) : filename_(name) {
+File::File(const std::string& name, const bool create_new)
+    : filename_(name), fd_(-1) {
   openIfNeeded(create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
+                         0 /* num_free_pages */, 0 /* first_free_page */,
+                         0 /* version */};
     writeHeader(header);
   }
 }
@@ -79,6 +142,7 @@ void File::openIfNeeded(const bool create_new) {
   if (open_counts_.find(filename_) != open_counts_.end()) {	//exists an entry already
     ++open_counts_[filename_];
     stream_ = open_streams_[filename_];
+    fd_ = open_fds_[filename_];
   } else {
     std::ios_base::openmode mode =
         std::fstream::in | std::fstream::out | std::fstream::binary;
@@ -97,8 +161,12 @@ void File::openIfNeeded(const bool create_new) {
       }
     }
     stream_.reset(new std::fstream(filename_, mode));
+    fd_ = ::open(filename_.c_str(), O_RDONLY);
     open_streams_[filename_] = stream_;
     open_counts_[filename_] = 1;
+    open_fds_[filename_] = fd_;
+    // Whoever read the version before the file was opened is not known
+    version_read_[filename_] = true;
   }
 }
 
@@ -107,11 +175,20 @@ void File::close() {
   	--open_counts_[filename_];
 
   stream_.reset();
+  fd_ = -1;
 	assert(open_counts_[filename_] >= 0);
 
   if (open_counts_[filename_] == 0) {
+    const DescriptorMap::iterator fd = open_fds_.find(filename_);
+    if (fd != open_fds_.end()) {
+      if (fd->second >= 0) {
+        ::close(fd->second);
+      }
+      open_fds_.erase(fd);
+    }
     open_streams_.erase(filename_);
     open_counts_.erase(filename_);
+    version_read_.erase(filename_);
   }
 }
 
@@ -163,6 +240,7 @@ PageFile& PageFile::operator=(const PageFile& rhs) {
 }
 
 Page PageFile::allocatePage(PageId &new_page_number) {
+  changeVersion();
   FileHeader header = readHeader();
   Page new_page;
   Page existing_page;
@@ -258,6 +336,7 @@ Page PageFile::readPage(const PageId page_number, const bool allow_free) const {
 }
 
 void PageFile::writePage(const PageId new_page_number, const Page& new_page) {
+  changeVersion();
 	PageHeader header = readPageHeader(new_page_number);
 	if (header.current_page_number == Page::INVALID_NUMBER)
 	{
@@ -274,6 +353,7 @@ void PageFile::writePage(const PageId new_page_number, const Page& new_page) {
 }
 
 void PageFile::deletePage(const PageId page_number) {
+  changeVersion();
   FileHeader header = readHeader();
 
   Page existing_page = readPage(page_number);
@@ -304,6 +384,57 @@ void PageFile::deletePage(const PageId page_number) {
   writeHeader(header);
 }
 
+PageId PageFile::appendPages(Page* pages, const std::size_t count,
+                             const PageId tail_hint) {
+  if (count == 0) {
+    return tail_hint;
+  }
+  changeVersion();
+  FileHeader header = readHeader();
+  const PageId first_page_number = header.num_pages;
+  for (std::size_t i = 0; i < count; ++i) {
+    pages[i].set_page_number(first_page_number + i);
+    pages[i].set_next_page_number(i + 1 < count ? first_page_number + i + 1
+                                                : Page::INVALID_NUMBER);
+  }
+
+  // Find the last used page, which the new pages are linked after.
+  PageId tail = Page::INVALID_NUMBER;
+  PageHeader tail_header;
+  if (header.first_used_page == Page::INVALID_NUMBER) {
+    header.first_used_page = first_page_number;
+  } else {
+    tail = tail_hint;
+    if (tail != Page::INVALID_NUMBER) {
+      tail_header = readPageHeader(tail);
+    }
+    if (tail == Page::INVALID_NUMBER ||
+        tail_header.current_page_number != tail ||
+        tail_header.next_page_number != Page::INVALID_NUMBER) {
+      tail = header.first_used_page;
+      tail_header = readPageHeader(tail);
+      while (tail_header.next_page_number != Page::INVALID_NUMBER) {
+        tail = tail_header.next_page_number;
+        tail_header = readPageHeader(tail);
+      }
+    }
+  }
+
+  // Pages are laid out back to back on disk, the same way they are in memory.
+  stream_->seekp(pagePosition(first_page_number), std::ios::beg);
+  stream_->write(reinterpret_cast<const char*>(pages), count * Page::SIZE);
+  if (tail != Page::INVALID_NUMBER) {
+    tail_header.next_page_number = first_page_number;
+    stream_->seekp(pagePosition(tail), std::ios::beg);
+    stream_->write(reinterpret_cast<const char*>(&tail_header),
+                   sizeof(PageHeader));
+  }
+  header.num_pages += count;
+  writeHeader(header);
+
+  return first_page_number + count - 1;
+}
+
 FileIterator PageFile::begin() {
   const FileHeader& header = readHeader();
   return FileIterator(this, header.first_used_page);
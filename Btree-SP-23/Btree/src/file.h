@@ -42,6 +42,11 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Version of the pages of the file, see File::version().
+   */
+  std::uint32_t version;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,7 +57,8 @@ struct FileHeader {
     return num_pages == rhs.num_pages &&
         num_free_pages == rhs.num_free_pages &&
         first_used_page == rhs.first_used_page &&
-        first_free_page == rhs.first_free_page;
+        first_free_page == rhs.first_free_page &&
+        version == rhs.version;
   }
 };
 
@@ -96,6 +102,17 @@ class File {
    */
   static void remove(const std::string& filename);
 
+  /**
+   * Renames an existing file.
+   *
+   * @param filename  Name of the file.
+   * @param newName   New name of the file.
+   * @throws  FileNotFoundException   If the file doesn't exist.
+   * @throws  FileExistsException     If a file named newName already exists.
+   * @throws  FileOpenException       If the file is currently open.
+   */
+  static void rename(const std::string& filename, const std::string& newName);
+
   /**
    * Returns true if the file exists and is open.
    *
@@ -134,6 +151,45 @@ class File {
    */
   virtual Page readPage(const PageId page_number) const = 0;
 
+  /**
+   * Reads a page as stored in the file, through the file descriptor of the
+   * file instead of the stream shared by the File objects. Can be called by
+   * several threads at once, and while another one uses the stream, seeing
+   * the pages written through it.
+   *
+   * @param page_number   Number of page to read.
+   * @return  The page.
+   * @throws  FileNotFoundException If the file has no descriptor open.
+   * @throws  InvalidPageException  If the page is past the end of the file.
+   */
+  Page readPageDirect(const PageId page_number) const;
+
+  /**
+   * Forces the pages written to the file out to the disk. Returns once they
+   * would survive a crash.
+   *
+   * @throws  FileSyncException If the file cannot be synced.
+   */
+  void sync() const;
+
+  /**
+   * Tells the operating system a page will be read soon, so that it starts
+   * reading it in the background. Returns without waiting for the read.
+   *
+   * @param page_number   Number of page to read ahead.
+   */
+  void adviseWillNeed(const PageId page_number) const;
+
+  /**
+   * Returns the version of the pages of the file. Once a page of a PageFile
+   * is allocated, written or deleted, the file has a version it never had
+   * before, so what was built from the file can tell it changed since.
+   * Pages held dirty by a buffer manager only count once they are written.
+   *
+   * @return  Version of the pages.
+   */
+  std::uint32_t version() const;
+
   /**
    * Writes a page into the file at the given page number.
    * No bounds checking is performed.
@@ -210,8 +266,17 @@ class File {
    */
   void writeHeader(const FileHeader& header);
 
+  /**
+   * Moves the file to a new version ahead of a change to its pages. Only the
+   * first change after the version was read or the file opened writes the
+   * header.
+   */
+  void changeVersion();
+
   typedef std::map<std::string, std::shared_ptr<std::fstream> > StreamMap;
   typedef std::map<std::string, int> CountMap;
+  typedef std::map<std::string, bool> FlagMap;
+  typedef std::map<std::string, int> DescriptorMap;
 
   /**
    * Streams for opened files.
@@ -223,6 +288,18 @@ class File {
    */
   static CountMap open_counts_;
 
+  /**
+   * Whether the version of opened files may have been read since they last
+   * changed.
+   */
+  static FlagMap version_read_;
+
+  /**
+   * Read-only file descriptors of opened files, -1 if one could not be
+   * opened.
+   */
+  static DescriptorMap open_fds_;
+
   /**
    * Name of the file this object represents.
    */
@@ -233,6 +310,12 @@ class File {
    */
   std::shared_ptr<std::fstream> stream_;
 
+  /**
+   * Read-only file descriptor of the underlying filesystem object, shared
+   * like the stream.
+   */
+  int fd_;
+
   friend class FileIterator;
 };
 
@@ -326,6 +409,22 @@ class PageFile : public File {
    */
   void deletePage(const PageId page_number);
 
+  /**
+   * Appends pages at the end of the file with a single write and links them
+   * after the last used page.  The pages are numbered and linked in the order
+   * they are given; free pages of the file are not reused.
+   *
+   * @param pages       Pages to append.  Their page numbers and next page
+   *                    numbers are set.
+   * @param count       Number of pages to append.
+   * @param tail_hint   Last used page of the file if known by the caller
+   *                    (e.g. returned by the previous call), otherwise
+   *                    Page::INVALID_NUMBER and the used list is walked.
+   * @return  Number of the last appended page.
+   */
+  PageId appendPages(Page* pages, const std::size_t count,
+                     const PageId tail_hint = Page::INVALID_NUMBER);
+
   /**
    * Returns an iterator at the first page in the file.
    *
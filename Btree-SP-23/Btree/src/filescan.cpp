@@ -17,6 +17,8 @@ FileScan::FileScan(const std::string &name, BufMgr *bufferMgr)
 	curDirtyFlag = false;
   curPage = NULL;
 	filePageIter = file->begin();
+  zoneMap = NULL;
+  skippedPages = 0;
 }
 
 FileScan::~FileScan()
@@ -24,7 +26,7 @@ FileScan::~FileScan()
   // generally must unpin last page of the scan
   if (curPage != NULL)
   {
-    bufMgr->unPinPage(file, (*filePageIter).page_number(), curDirtyFlag);
+    bufMgr->unPinPage(file, filePageIter.page_number(), curDirtyFlag);
     curPage = NULL;
 		curDirtyFlag = false;
     filePageIter = file->begin();
@@ -35,73 +37,61 @@ FileScan::~FileScan()
 
 void FileScan::scanNext(RecordId& outRid)
 {
-  std::string rec;
-
-  if (filePageIter == file->end())
-	{
-		throw EndOfFileException();
-	}
-
-  // special case of the first record of the first page of the file
-  if (curPage == NULL)
+  if (!tryScanNext(outRid))
   {
-    // need to get the first page of the file
-		filePageIter = file->begin();
-    if(filePageIter == file->end())
-		{
-			throw EndOfFileException();
-		}
-	 
-		// read the first page of the file
-    bufMgr->readPage(file, (*filePageIter).page_number(), curPage); 
-		curDirtyFlag = false;
-
-		// get the first record off the page
-    pageRecordIter = curPage->begin(); 
-
-		if(pageRecordIter != curPage->end()) 
-		{
-		  // get pointer to record
-		  rec = *pageRecordIter;
-
-			outRid = pageRecordIter.getCurrentRecord();
-			return;
-		}
+    throw EndOfFileException();
   }
+}
 
-	// Loop, looking for a record that satisfied the predicate.
-	// First try and get the next record off the current page
-	pageRecordIter++;
-
-  while (pageRecordIter == curPage->end())
+bool FileScan::tryScanNext(RecordId& outRid)
+{
+  while (true)
   {
-    // unpin the current page
-    bufMgr->unPinPage(file, (*filePageIter).page_number(), curDirtyFlag);
-    curPage = NULL;
-    curDirtyFlag = false;
+    if (curPage == NULL)
+    {
+      // move to the next page that may hold a record of the scan, pages
+      // excluded by the zone map are not read
+      while (filePageIter != file->end() && zoneMap != NULL &&
+             !zoneMap->mayContain(filePageIter.page_number(), range))
+      {
+        filePageIter++;
+        skippedPages++;
+      }
+      if (filePageIter == file->end())
+      {
+        return false;
+      }
+
+      // read the page and get its first record
+      bufMgr->readPage(file, filePageIter.page_number(), curPage);
+      curDirtyFlag = false;
+      pageRecordIter = curPage->begin();
+    }
+    else
+    {
+      // try and get the next record off the current page
+      pageRecordIter++;
+    }
 
-    filePageIter++;
-    if (filePageIter == file->end())
+    if (pageRecordIter == curPage->end())
     {
+      // unpin the current page and move on to the next one
+      bufMgr->unPinPage(file, filePageIter.page_number(), curDirtyFlag);
       curPage = NULL;
-			throw EndOfFileException();
+      curDirtyFlag = false;
+      filePageIter++;
+      continue;
     }
 
-    // read the next page of the file
-    bufMgr->readPage(file, (*filePageIter).page_number(), curPage);
-
-    // get the first record off the page
-    pageRecordIter = curPage->begin(); 
+    // return rid of the record if it satisfies the range
+    outRid = pageRecordIter.getCurrentRecord();
+    if (zoneMap == NULL ||
+        range.contains(pageRecordIter.recordView().data +
+                       zoneMap->attrByteOffset()))
+    {
+      return true;
+    }
   }
-
-  // curRec points at a valid record
-  // see if the record satisfies the scan's predicate 
-  // get a pointer to the record
-  rec = *pageRecordIter;
-
-	// return rid of the record
-	outRid = pageRecordIter.getCurrentRecord();
-	return;
 }
 
 // returns pointer to the current record.  page is left pinned
@@ -111,10 +101,35 @@ std::string FileScan::getRecord()
   return *pageRecordIter;
 }
 
+// returns a view of the current record, pointing into the pinned page
+RecordView FileScan::getRecordView()
+{
+  return pageRecordIter.recordView();
+}
+
 // mark current page of scan dirty
 void FileScan::markDirty()
 {
   curDirtyFlag = true;
 }
 
+// restrict the scan to a range of the attribute summarized by the zone map
+void FileScan::setRange(const HeapZoneMap *zoneMap, const void *lowVal,
+                        const Operator lowOp, const void *highVal,
+                        const Operator highOp)
+{
+  range = AttributeRange(zoneMap->attrType(), lowVal, lowOp, highVal, highOp);
+  this->zoneMap = zoneMap;
+  skippedPages = 0;
+
+  // restart the scan
+  if (curPage != NULL)
+  {
+    bufMgr->unPinPage(file, filePageIter.page_number(), curDirtyFlag);
+    curPage = NULL;
+    curDirtyFlag = false;
+  }
+  filePageIter = file->begin();
+}
+
 }
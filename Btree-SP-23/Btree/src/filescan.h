@@ -14,6 +14,7 @@
 #include "buffer.h"
 #include "file_iterator.h"
 #include "page_iterator.h"
+#include "zone_map.h"
 
 namespace badgerdb {
 
@@ -28,15 +29,35 @@ class FileScan
 
   ~FileScan();
 
-  //return RecordId of next record that satisfies the scan 
+  //return RecordId of next record that satisfies the scan. Throws
+  //EndOfFileException when there are no more records
   void scanNext(RecordId& outRid);
 
-  //read current record, returning pointer and length
+  //same as scanNext, but returns false instead of throwing at the end of the
+  //scan. Loops over whole relations should use this one
+  bool tryScanNext(RecordId& outRid);
+
+  //read current record, returning a copy of it
   std::string getRecord();
 
+  //view of current record, pointing into the current page of the scan. Valid
+  //until the next call to scanNext
+  RecordView getRecordView();
+
   //marks current page of scan dirty
   void markDirty();
 
+  //restricts the scan to the records whose attribute summarized by zoneMap is
+  //in the given range, and restarts it. Pages whose zone map excludes the
+  //range are not read. Throws BadOpcodesException unless lowOp is GT or GTE
+  //and highOp is LT or LTE
+  void setRange(const HeapZoneMap *zoneMap, const void *lowVal,
+                const Operator lowOp, const void *highVal,
+                const Operator highOp);
+
+  //number of pages skipped on their zone map so far
+  int pagesSkipped() const { return skippedPages; }
+
  private:
   /**
    * File which is being scanned.
@@ -60,6 +81,22 @@ class FileScan
    * True if page has been updated
    */
   bool  	      curDirtyFlag;
+
+  /**
+   * Zone map of the attribute the scan is restricted on, NULL if the scan
+   * returns every record.
+   */
+  const HeapZoneMap *zoneMap;
+
+  /**
+   * Range of the attribute the scan is restricted on.
+   */
+  AttributeRange range;
+
+  /**
+   * Number of pages skipped on their zone map.
+   */
+  int           skippedPages;
 };
 
 }
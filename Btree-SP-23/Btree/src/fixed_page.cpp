@@ -0,0 +1,168 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "fixed_page.h"
+
+#include <string.h>
+
+#include "exceptions/end_of_file_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_exception.h"
+
+namespace badgerdb {
+
+static std::size_t bitmapWordsFor(const std::size_t capacity) {
+  return (capacity + 31) / 32;
+}
+
+// -----------------------------------------------------------------------------
+// FixedRecordPage
+// -----------------------------------------------------------------------------
+
+std::uint16_t FixedRecordPage::capacityFor(const std::size_t recordLength) {
+  const std::size_t space = Page::DATA_SIZE - sizeof(FixedPageHeader);
+  const std::size_t length = recordLength > 0 ? recordLength : 1;
+  // Every record takes <length> bytes and one bit of the bitmap
+  std::size_t capacity = space * 8 / (length * 8 + 1);
+  while (capacity > 0 &&
+         bitmapWordsFor(capacity) * sizeof(std::uint32_t) +
+                 capacity * length > space) {
+    capacity--;
+  }
+  return capacity > 0xFFFF ? 0xFFFF : capacity;
+}
+
+void FixedRecordPage::initialize(const std::size_t recordLength) {
+  FixedPageHeader *fixedHeader = header();
+  fixedHeader->recordLength = recordLength;
+  fixedHeader->capacity = capacityFor(recordLength);
+  fixedHeader->numRecords = 0;
+  fixedHeader->bitmapWords = bitmapWordsFor(fixedHeader->capacity);
+  memset(bitmap(), 0, fixedHeader->bitmapWords * sizeof(std::uint32_t));
+}
+
+RecordId FixedRecordPage::insertRecord(const char *data) {
+  FixedPageHeader *fixedHeader = header();
+  if (fixedHeader->numRecords == fixedHeader->capacity) {
+    throw InsufficientSpaceException(page_->page_number(),
+                                     fixedHeader->recordLength, 0);
+  }
+  std::uint32_t *words = bitmap();
+  std::size_t w = 0;
+  while (words[w] == 0xFFFFFFFFu) {
+    w++;
+  }
+  const std::size_t index = w * 32 + __builtin_ctz(~words[w]);
+  words[w] |= 1u << (index % 32);
+  fixedHeader->numRecords++;
+
+  const SlotId slot = index + 1;
+  memcpy(records() + index * fixedHeader->recordLength, data,
+         fixedHeader->recordLength);
+  return {page_->page_number(), slot};
+}
+
+RecordView FixedRecordPage::recordView(const RecordId &recordId) const {
+  validateRecordId(recordId);
+  const RecordView view = {recordData(recordId.slot_number),
+                           header()->recordLength};
+  return view;
+}
+
+void FixedRecordPage::updateRecord(const RecordId &recordId,
+                                   const char *data) {
+  validateRecordId(recordId);
+  memcpy(records() + (std::size_t)(recordId.slot_number - 1) *
+                         header()->recordLength,
+         data, header()->recordLength);
+}
+
+void FixedRecordPage::deleteRecord(const RecordId &recordId) {
+  validateRecordId(recordId);
+  const std::size_t index = recordId.slot_number - 1;
+  bitmap()[index / 32] &= ~(1u << (index % 32));
+  header()->numRecords--;
+}
+
+SlotId FixedRecordPage::nextUsedSlot(const SlotId start) const {
+  // Slot <start> is at index <start> - 1, so the search starts at index <start>
+  const std::size_t capacity = header()->capacity;
+  std::size_t index = start;
+  if (index >= capacity) {
+    return Page::INVALID_SLOT;
+  }
+  const std::uint32_t *words = bitmap();
+  std::size_t w = index / 32;
+  std::uint32_t word = words[w] & (0xFFFFFFFFu << (index % 32));
+  while (word == 0) {
+    if (++w == header()->bitmapWords) {
+      return Page::INVALID_SLOT;
+    }
+    word = words[w];
+  }
+  return w * 32 + __builtin_ctz(word) + 1;
+}
+
+void FixedRecordPage::validateRecordId(const RecordId &recordId) const {
+  if (recordId.page_number != page_->page_number() ||
+      recordId.slot_number == Page::INVALID_SLOT ||
+      recordId.slot_number > header()->capacity) {
+    throw InvalidRecordException(recordId, page_->page_number());
+  }
+  const std::size_t index = recordId.slot_number - 1;
+  if ((bitmap()[index / 32] & (1u << (index % 32))) == 0) {
+    throw InvalidRecordException(recordId, page_->page_number());
+  }
+}
+
+// -----------------------------------------------------------------------------
+// FixedFileScan
+// -----------------------------------------------------------------------------
+
+FixedFileScan::FixedFileScan(const std::string &name, BufMgr *bufMgr)
+    : file_(new PageFile(name, false)),
+      bufMgr_(bufMgr),
+      curPage_(NULL),
+      curSlot_(Page::INVALID_SLOT) {
+  filePageIter_ = file_->begin();
+}
+
+FixedFileScan::~FixedFileScan() {
+  if (curPage_ != NULL) {
+    bufMgr_->unPinPage(file_, filePageIter_.page_number(), false);
+    curPage_ = NULL;
+  }
+  bufMgr_->flushFile(file_);
+  delete file_;
+}
+
+void FixedFileScan::scanNext(RecordId &outRid) {
+  while (filePageIter_ != file_->end()) {
+    if (curPage_ == NULL) {
+      bufMgr_->readPage(file_, filePageIter_.page_number(), curPage_);
+      curSlot_ = Page::INVALID_SLOT;
+    }
+    curSlot_ = FixedRecordPage(curPage_).nextUsedSlot(curSlot_);
+    if (curSlot_ != Page::INVALID_SLOT) {
+      outRid = {filePageIter_.page_number(), curSlot_};
+      return;
+    }
+    bufMgr_->unPinPage(file_, filePageIter_.page_number(), false);
+    curPage_ = NULL;
+    filePageIter_++;
+  }
+  throw EndOfFileException();
+}
+
+RecordView FixedFileScan::getRecordView() const {
+  const FixedRecordPage page(curPage_);
+  const RecordView view = {page.recordData(curSlot_), page.recordLength()};
+  return view;
+}
+
+}  // namespace badgerdb
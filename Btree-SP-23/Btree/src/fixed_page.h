@@ -0,0 +1,271 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+#include "file_iterator.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Header stored at the start of the data area of a fixed-width record
+ * page.
+ */
+struct FixedPageHeader {
+  /**
+   * Number of bytes of every record of the page.
+   */
+  std::uint16_t recordLength;
+
+  /**
+   * Number of records the page can hold.
+   */
+  std::uint16_t capacity;
+
+  /**
+   * Number of records currently in the page.
+   */
+  std::uint16_t numRecords;
+
+  /**
+   * Number of 32 bit words of the presence bitmap.
+   */
+  std::uint16_t bitmapWords;
+};
+
+/**
+ * @brief Page format for relations whose records all have the same length.
+ *
+ * The data area of the page holds a FixedPageHeader, a presence bitmap with
+ * one bit per record and a dense array of records. Records need no PageSlot:
+ * the slot number of a record is its position in the array plus one, so
+ * finding a record is a multiplication and a page holds more records than a
+ * slotted page does.
+ *
+ * A FixedRecordPage is a view over a Page of a PageFile, typically one pinned
+ * in the buffer pool. The PageHeader of the page is left as Page initializes
+ * it (no slots), so slotted page readers see an empty page.
+ *
+ * @warning This class is not threadsafe.
+ */
+class FixedRecordPage {
+ public:
+  /**
+   * Returns the number of records of <recordLength> bytes a page can hold.
+   *
+   * @param recordLength  Length of the records.
+   * @return  Number of records.
+   */
+  static std::uint16_t capacityFor(const std::size_t recordLength);
+
+  /**
+   * Constructs a view over a page already formatted for fixed-width records.
+   *
+   * @param page  Page to access.
+   */
+  explicit FixedRecordPage(Page *page) : page_(page) {}
+
+  /**
+   * Formats the page for records of <recordLength> bytes, dropping anything
+   * it held.
+   *
+   * @param recordLength  Length of the records.
+   */
+  void initialize(const std::size_t recordLength);
+
+  /**
+   * Inserts a record into the first free position of the page.
+   *
+   * @param data  recordLength() bytes of the record.
+   * @return  ID of the newly inserted record.
+   * @throws  InsufficientSpaceException  If the page is full.
+   */
+  RecordId insertRecord(const char *data);
+
+  /**
+   * Returns a view of the record with the given ID.
+   *
+   * @param recordId  ID of the record.
+   * @return  View of the record.
+   * @throws  InvalidRecordException  If the record doesn't exist.
+   */
+  RecordView recordView(const RecordId &recordId) const;
+
+  /**
+   * Returns a copy of the record with the given ID.
+   *
+   * @param recordId  ID of the record.
+   * @return  The record.
+   * @throws  InvalidRecordException  If the record doesn't exist.
+   */
+  std::string getRecord(const RecordId &recordId) const {
+    return recordView(recordId).toString();
+  }
+
+  /**
+   * Overwrites the record with the given ID.
+   *
+   * @param recordId  ID of the record.
+   * @param data      recordLength() bytes of the new record.
+   * @throws  InvalidRecordException  If the record doesn't exist.
+   */
+  void updateRecord(const RecordId &recordId, const char *data);
+
+  /**
+   * Deletes the record with the given ID. Its position is reused by the next
+   * insert.
+   *
+   * @param recordId  ID of the record.
+   * @throws  InvalidRecordException  If the record doesn't exist.
+   */
+  void deleteRecord(const RecordId &recordId);
+
+  /**
+   * Returns the first slot after <start> holding a record, or
+   * Page::INVALID_SLOT if there is none.
+   *
+   * @param start   Slot to start search at, Page::INVALID_SLOT for the first.
+   * @return  Next used slot.
+   */
+  SlotId nextUsedSlot(const SlotId start) const;
+
+  /**
+   * Returns the bytes of the record in the given slot without checking that
+   * the slot is used.
+   *
+   * @param slot  Slot number, between 1 and capacity().
+   */
+  const char *recordData(const SlotId slot) const {
+    return records() + (std::size_t)(slot - 1) * header()->recordLength;
+  }
+
+  /**
+   * Returns the length of the records of the page.
+   */
+  std::uint16_t recordLength() const { return header()->recordLength; }
+
+  /**
+   * Returns the number of records the page can hold.
+   */
+  std::uint16_t capacity() const { return header()->capacity; }
+
+  /**
+   * Returns the number of records in the page.
+   */
+  std::uint16_t numRecords() const { return header()->numRecords; }
+
+ private:
+  const FixedPageHeader *header() const {
+    return reinterpret_cast<const FixedPageHeader *>(page_->data_);
+  }
+  FixedPageHeader *header() {
+    return reinterpret_cast<FixedPageHeader *>(page_->data_);
+  }
+  const std::uint32_t *bitmap() const {
+    return reinterpret_cast<const std::uint32_t *>(page_->data_ +
+                                                   sizeof(FixedPageHeader));
+  }
+  std::uint32_t *bitmap() {
+    return reinterpret_cast<std::uint32_t *>(page_->data_ +
+                                             sizeof(FixedPageHeader));
+  }
+  const char *records() const {
+    return page_->data_ + sizeof(FixedPageHeader) +
+           header()->bitmapWords * sizeof(std::uint32_t);
+  }
+  char *records() {
+    return page_->data_ + sizeof(FixedPageHeader) +
+           header()->bitmapWords * sizeof(std::uint32_t);
+  }
+
+  /**
+   * Throws InvalidRecordException unless the record ID refers to a used slot
+   * of this page.
+   */
+  void validateRecordId(const RecordId &recordId) const;
+
+  /**
+   * Page being accessed.
+   */
+  Page *page_;
+};
+
+/**
+ * @brief Sequential scan over a relation of fixed-width record pages.
+ */
+class FixedFileScan {
+ public:
+  /**
+   * Opens a scan over the given relation.
+   *
+   * @param name    Name of the relation file.
+   * @param bufMgr  Buffer manager instance.
+   */
+  FixedFileScan(const std::string &name, BufMgr *bufMgr);
+
+  /**
+   * Unpins the current page, flushes the pages of the scan out of the buffer
+   * pool and closes the relation.
+   */
+  ~FixedFileScan();
+
+  /**
+   * Moves to the next record of the relation.
+   *
+   * @param outRid  Receives the ID of the record.
+   * @throws  EndOfFileException  If there are no more records.
+   */
+  void scanNext(RecordId &outRid);
+
+  /**
+   * Returns a view of the current record, valid until the next call to
+   * scanNext.
+   */
+  RecordView getRecordView() const;
+
+  /**
+   * Returns a copy of the current record.
+   */
+  std::string getRecord() const { return getRecordView().toString(); }
+
+ private:
+  /**
+   * File which is being scanned.
+   */
+  PageFile *file_;
+
+  /**
+   * Buffer Manager instance used to read pages into the buffer pool.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Current page being scanned, NULL before the first page.
+   */
+  Page *curPage_;
+
+  /**
+   * Iterator on the page being scanned.
+   */
+  FileIterator filePageIter_;
+
+  /**
+   * Slot of the current record in the current page.
+   */
+  SlotId curSlot_;
+};
+
+}  // namespace badgerdb
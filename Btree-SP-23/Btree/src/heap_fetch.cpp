@@ -0,0 +1,128 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "heap_fetch.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+/**
+ * Orders positions of a RecordId batch by page, then slot.
+ */
+struct RidPositionLess {
+  const std::vector<RecordId> *rids;
+
+  bool operator()(const std::uint32_t a, const std::uint32_t b) const {
+    const RecordId &ra = (*rids)[a];
+    const RecordId &rb = (*rids)[b];
+    if (ra.page_number != rb.page_number) {
+      return ra.page_number < rb.page_number;
+    }
+    return ra.slot_number < rb.slot_number;
+  }
+};
+
+HeapFetcher::HeapFetcher(File *file, BufMgr *bufMgr,
+                         const std::uint32_t prefetchDepth)
+    : file_(file),
+      bufMgr_(bufMgr),
+      prefetchDepth_(prefetchDepth),
+      pagesPinned_(0) {}
+
+void HeapFetcher::sortPositions(const std::vector<RecordId> &rids,
+                                std::vector<std::uint32_t> &positions) {
+  positions.resize(rids.size());
+  for (std::uint32_t i = 0; i < rids.size(); i++) {
+    positions[i] = i;
+  }
+  RidPositionLess less = {&rids};
+  std::stable_sort(positions.begin(), positions.end(), less);
+}
+
+void HeapFetcher::visitPages(
+    const std::vector<RecordId> &rids,
+    const std::vector<std::uint32_t> &positions,
+    const std::function<void(std::uint32_t, const RecordView &)> &consume) {
+  // Distinct pages of the batch, in order
+  std::vector<PageId> pages;
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    const PageId pageNo = rids[positions[i]].page_number;
+    if (pages.empty() || pages.back() != pageNo) {
+      pages.push_back(pageNo);
+    }
+  }
+
+  pagesPinned_ = 0;
+  std::size_t next = 0;
+  std::size_t prefetched = 0;
+  for (std::size_t p = 0; p < pages.size(); p++) {
+    // Keep the read-ahead window <prefetchDepth_> pages past the current one
+    if (prefetched <= p) {
+      prefetched = p + 1;
+    }
+    while (prefetched < pages.size() && prefetched <= p + prefetchDepth_) {
+      bufMgr_->prefetchPage(file_, pages[prefetched]);
+      prefetched++;
+    }
+
+    Page *page;
+    bufMgr_->readPage(file_, pages[p], page);
+    pagesPinned_++;
+    try {
+      while (next < positions.size() &&
+             rids[positions[next]].page_number == pages[p]) {
+        consume(positions[next], page->recordView(rids[positions[next]]));
+        next++;
+      }
+    } catch (...) {
+      bufMgr_->unPinPage(file_, pages[p], false);
+      throw;
+    }
+    bufMgr_->unPinPage(file_, pages[p], false);
+  }
+}
+
+void HeapFetcher::fetch(std::vector<RecordId> &rids,
+                        std::vector<std::string> &outRecords,
+                        const ResultOrder order) {
+  std::vector<std::uint32_t> positions;
+  sortPositions(rids, positions);
+  outRecords.resize(rids.size());
+
+  if (order == ORIGINAL_ORDER) {
+    visitPages(rids, positions,
+               [&outRecords](std::uint32_t pos, const RecordView &record) {
+                 outRecords[pos] = record.toString();
+               });
+    return;
+  }
+
+  std::size_t k = 0;
+  visitPages(rids, positions,
+             [&outRecords, &k](std::uint32_t pos, const RecordView &record) {
+               outRecords[k++] = record.toString();
+             });
+  std::vector<RecordId> sorted(rids.size());
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    sorted[i] = rids[positions[i]];
+  }
+  rids.swap(sorted);
+}
+
+void HeapFetcher::fetch(const std::vector<RecordId> &rids,
+                        const Visitor &visitor) {
+  std::vector<std::uint32_t> positions;
+  sortPositions(rids, positions);
+  visitPages(rids, positions,
+             [&rids, &visitor](std::uint32_t pos, const RecordView &record) {
+               visitor(rids[pos], record);
+             });
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,111 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Fetches the records of a batch of RecordIds from a heap file.
+ *
+ * RecordIds coming out of an index scan are in key order, which for an
+ * unclustered index is a random page order. The fetcher sorts the batch by
+ * page, pins every page once for all the records it holds and has the
+ * following pages of the batch read ahead in the background.
+ */
+class HeapFetcher {
+ public:
+  /**
+   * Order in which fetched records are returned.
+   */
+  enum ResultOrder {
+    /**
+     * Same order as the RecordIds passed in.
+     */
+    ORIGINAL_ORDER,
+    /**
+     * Sorted by (page_number, slot_number).
+     */
+    PAGE_ORDER
+  };
+
+  /**
+   * Visitor called for every fetched record while its page is pinned. The
+   * record view is only valid during the call.
+   */
+  typedef std::function<void(const RecordId &rid, const RecordView &record)>
+      Visitor;
+
+  /**
+   * Constructor of HeapFetcher.
+   *
+   * @param file            Heap file holding the records.
+   * @param bufMgr          Buffer manager instance.
+   * @param prefetchDepth   Number of pages of the batch read ahead of the page
+   *                        being processed. 0 disables read-ahead.
+   */
+  HeapFetcher(File *file, BufMgr *bufMgr, const std::uint32_t prefetchDepth = 4);
+
+  /**
+   * Fetches the records of a batch.
+   *
+   * @param rids        RecordIds to fetch. May contain duplicates.
+   * @param outRecords  Receives one record per RecordId.
+   * @param order       Order of the records in <outRecords>. In PAGE_ORDER,
+   *                    <rids> is sorted the same way so the two stay aligned.
+   */
+  void fetch(std::vector<RecordId> &rids, std::vector<std::string> &outRecords,
+             const ResultOrder order = ORIGINAL_ORDER);
+
+  /**
+   * Visits the records of a batch in page order.
+   *
+   * @param rids      RecordIds to fetch.
+   * @param visitor   Called for every RecordId with its record.
+   */
+  void fetch(const std::vector<RecordId> &rids, const Visitor &visitor);
+
+  /**
+   * Returns the number of pages pinned by the last fetch.
+   */
+  std::uint32_t pagesPinned() const { return pagesPinned_; }
+
+ private:
+  /**
+   * Returns the positions of <rids> sorted by page and slot.
+   */
+  static void sortPositions(const std::vector<RecordId> &rids,
+                            std::vector<std::uint32_t> &positions);
+
+  /**
+   * Reads the pages of the batch in page order, calling <consume> with the
+   * position of every RecordId while its page is pinned.
+   */
+  void visitPages(const std::vector<RecordId> &rids,
+                  const std::vector<std::uint32_t> &positions,
+                  const std::function<void(std::uint32_t, const RecordView &)>
+                      &consume);
+
+  File *file_;
+  BufMgr *bufMgr_;
+  std::uint32_t prefetchDepth_;
+  std::uint32_t pagesPinned_;
+};
+
+}  // namespace badgerdb
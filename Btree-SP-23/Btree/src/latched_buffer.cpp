@@ -0,0 +1,129 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "latched_buffer.h"
+
+#include <algorithm>
+
+#include "exceptions/buffer_exceeded_exception.h"
+
+namespace badgerdb {
+
+/**
+ * Number of pages read by a task of prefetchInBackground, few enough for a
+ * foreground task not to wait long for its thread.
+ */
+static const std::size_t PREFETCH_PAGES_PER_TASK = 8;
+
+LatchedBufMgr::LatchedBufMgr(BufMgr *bufMgr) : BufMgr(), bufMgr_(bufMgr) {}
+
+bool LatchedBufMgr::tryReadPage(File *file, const PageId pageNo,
+                                Page *&page) {
+  std::lock_guard<std::mutex> lock(latch_);
+  return bufMgr_->tryReadPage(file, pageNo, page);
+}
+
+void LatchedBufMgr::prefetchPage(File *file, const PageId pageNo) {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->prefetchPage(file, pageNo);
+}
+
+bool LatchedBufMgr::tryReadCachedPage(File *file, const PageId pageNo,
+                                      Page *&page) {
+  std::lock_guard<std::mutex> lock(latch_);
+  return bufMgr_->tryReadCachedPage(file, pageNo, page);
+}
+
+bool LatchedBufMgr::installPage(File *file, const PageId pageNo,
+                                const Page &page, Page *&cached) {
+  std::lock_guard<std::mutex> lock(latch_);
+  return bufMgr_->installPage(file, pageNo, page, cached);
+}
+
+void LatchedBufMgr::unPinPage(File *file, const PageId pageNo,
+                              const bool dirty) {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->unPinPage(file, pageNo, dirty);
+}
+
+void LatchedBufMgr::allocPage(File *file, PageId &pageNo, Page *&page) {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->allocPage(file, pageNo, page);
+}
+
+void LatchedBufMgr::flushFile(const File *file) {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->flushFile(file);
+}
+
+void LatchedBufMgr::writeBackFile(const File *file) {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->writeBackFile(file);
+}
+
+void LatchedBufMgr::disposePage(File *file, const PageId pageNo) {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->disposePage(file, pageNo);
+}
+
+void LatchedBufMgr::printSelf() {
+  std::lock_guard<std::mutex> lock(latch_);
+  bufMgr_->printSelf();
+}
+
+void LatchedBufMgr::prefetchInBackground(File *file,
+                                         const std::vector<PageId> &pageNos,
+                                         TaskGroup &group) {
+  for (std::size_t first = 0; first < pageNos.size();
+       first += PREFETCH_PAGES_PER_TASK) {
+    const std::size_t last =
+        std::min(first + PREFETCH_PAGES_PER_TASK, pageNos.size());
+    const std::vector<PageId> batch(pageNos.begin() + first,
+                                    pageNos.begin() + last);
+    group.submit(
+        [this, file, batch]() {
+          // The latch is taken per page, foreground readers get in between
+          for (std::size_t i = 0; i < batch.size(); i++) {
+            Page *page;
+            if (this->tryReadPage(file, batch[i], page)) {
+              this->unPinPage(file, batch[i], false);
+            }
+          }
+        },
+        BACKGROUND_IO_TASK);
+  }
+}
+
+void LatchedBufMgr::writeBackInBackground(const File *file,
+                                          TaskGroup &group) {
+  group.submit([this, file]() { this->writeBackFile(file); },
+               BACKGROUND_IO_TASK);
+}
+
+void LatchedBufMgr::readInBackground(
+    File *file, const PageId pageNo, TaskGroup &group,
+    const std::function<void(Page *page, std::exception_ptr error)> &done,
+    const TaskPriority priority) {
+  group.submit(
+      [this, file, pageNo, done]() {
+        Page *cached = NULL;
+        std::exception_ptr error;
+        try {
+          const Page page = file->readPageDirect(pageNo);
+          if (!this->installPage(file, pageNo, page, cached)) {
+            throw BufferExceededException();
+          }
+        } catch (...) {
+          error = std::current_exception();
+        }
+        done(cached, error);
+      },
+      priority);
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,116 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+#include "work_pool.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Buffer manager letting several threads share another one.
+ *
+ * Every operation is forwarded to the wrapped buffer manager while holding a
+ * latch, so threads can pin and unpin pages of the same pool. The contents of
+ * pinned pages are not latched: the threads may read the same page at once,
+ * but one modifying a page has to keep the others off it. Statistics are
+ * kept by the wrapped buffer manager.
+ *
+ * Being shareable, it is the buffer manager the tasks of a WorkStealingPool
+ * go through: reads ahead and write backs can be handed to background tasks
+ * while other threads use the pool.
+ */
+class LatchedBufMgr : public BufMgr {
+ public:
+  /**
+   * @param bufMgr  Buffer manager to share. Outlives the LatchedBufMgr, and
+   *                is only used through it meanwhile.
+   */
+  explicit LatchedBufMgr(BufMgr *bufMgr);
+
+  bool tryReadPage(File *file, const PageId pageNo, Page *&page);
+
+  void prefetchPage(File *file, const PageId pageNo);
+
+  bool tryReadCachedPage(File *file, const PageId pageNo, Page *&page);
+
+  bool installPage(File *file, const PageId pageNo, const Page &page,
+                   Page *&cached);
+
+  void unPinPage(File *file, const PageId pageNo, const bool dirty);
+
+  void allocPage(File *file, PageId &pageNo, Page *&page);
+
+  void flushFile(const File *file);
+
+  void writeBackFile(const File *file);
+
+  void disposePage(File *file, const PageId pageNo);
+
+  void printSelf();
+
+  /**
+   * Reads pages into the pool from BACKGROUND_IO_TASK tasks of a group, a
+   * few pages each. They are left unpinned, pages for which no frame is free
+   * are skipped.
+   *
+   * @param file      File of the pages. Outlives the tasks of the group.
+   * @param pageNos   Pages to read.
+   * @param group     Group the tasks are submitted to. The LatchedBufMgr
+   *                  outlives its tasks.
+   */
+  void prefetchInBackground(File *file, const std::vector<PageId> &pageNos,
+                            TaskGroup &group);
+
+  /**
+   * Writes out the dirty pages of a file not pinned from a
+   * BACKGROUND_IO_TASK task of a group, as writeBackFile does.
+   *
+   * @param file      File of the pages. Outlives the task.
+   * @param group     Group the task is submitted to. The LatchedBufMgr
+   *                  outlives its tasks.
+   */
+  void writeBackInBackground(const File *file, TaskGroup &group);
+
+  /**
+   * Reads a page from a task of a group and installs it into the pool, as
+   * installPage does, then calls <done> from the task with the page pinned,
+   * so it is still in the pool when the receiver gets to it. The file is
+   * read outside of the latch, so the other threads keep using the pool
+   * meanwhile.
+   *
+   * @param file      File of the page, whose pages not in the pool are up
+   *                  to date on disk. Outlives the task.
+   * @param pageNo    Page to read.
+   * @param group     Group the task is submitted to. The LatchedBufMgr
+   *                  outlives its tasks.
+   * @param done      Receives the page in the pool, to be unpinned by the
+   *                  receiver, or NULL and the exception reading it threw,
+   *                  BufferExceededException if every frame is pinned.
+   * @param priority  Class of the task.
+   */
+  void readInBackground(
+      File *file, const PageId pageNo, TaskGroup &group,
+      const std::function<void(Page *page, std::exception_ptr error)> &done,
+      const TaskPriority priority = BACKGROUND_IO_TASK);
+
+ private:
+  BufMgr *bufMgr_;
+  std::mutex latch_;
+};
+
+}  // namespace badgerdb
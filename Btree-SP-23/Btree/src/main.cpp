@@ -6,21 +6,54 @@
  * of Wisconsin-Madison.
  */
 
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include "arena.h"
+#include "art.h"
+#include "async_index.h"
+#include "bitmap_index.h"
+#include "blob_stream.h"
 #include "btree.h"
+#include "bufHashTbl.h"
+#include "cluster.h"
+#include "columnar.h"
+#include "deferred_index.h"
+#include "exceptions/bad_index_info_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/end_of_file_exception.h"
 #include "exceptions/file_not_found_exception.h"
+#include "exceptions/hash_not_found_exception.h"
 #include "exceptions/index_scan_completed_exception.h"
 #include "exceptions/insufficient_space_exception.h"
 #include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/page_pinned_exception.h"
 #include "exceptions/scan_not_initialized_exception.h"
+#include "exceptions/shared_segment_exception.h"
 #include "file_iterator.h"
 #include "filescan.h"
+#include "fixed_page.h"
+#include "heap_fetch.h"
+#include "latched_buffer.h"
 #include "page.h"
+#include "page_builder.h"
 #include "page_iterator.h"
+#include "partitioned_index.h"
+#include "pax_page.h"
+#include "rid_list.h"
+#include "shared_buffer.h"
+#include "work_pool.h"
+#include "zone_map.h"
 
 #define checkPassFail(a, b)                                         \
   {                                                                 \
@@ -77,6 +110,7 @@ void createSparseRelation(int relSize);
 void createRelationTest4(int start, int end);
 void createEmptyRelation();
 void createLargeRelationForward();
+void createCyclicRelation(int relSize);
 void intTests();
 void intTestsTest8();
 void intTestsTest9();
@@ -137,6 +171,63 @@ void test10();
 void test11();
 void test12();
 void test13();
+void test14();
+void test15();
+void test16();
+void test17();
+void test18();
+void test19();
+void test20();
+void test21();
+void test22();
+void test23();
+void test24();
+void test25();
+void test26();
+void test27();
+void test28();
+void test29();
+void test30();
+void test31();
+void test32();
+void test33();
+void test34();
+void test35();
+void test36();
+void test37();
+void artTests();
+void bitmapTests();
+void ridListTests();
+void heapFetchTests();
+void clusterTests();
+void pageTests();
+void fixedPageTests();
+void paxTests();
+void columnarTests();
+void zoneMapTests();
+void insertTests();
+void indexKeyTests();
+void normalizedKeyTests();
+void tryScanTests();
+void sharedBufferTests();
+void snapshotTests();
+int snapshotCount(BTreeSnapshot *snapshot, int lowVal, int highVal,
+                  bool &onlyOriginal);
+void appendOnlyTests();
+int rangeCount(BTreeIndex &index, int lowVal, int highVal);
+void deferredIndexTests();
+void partitionedIndexTests();
+int partitionedCount(PartitionedIndex &index, int lowVal, int highVal,
+                     bool &ordered);
+void parallelScanTests();
+void schedulerTests();
+void asyncIndexTests();
+void bulkLoaderTests();
+void headArrayTests();
+int typedScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal,
+              Operator highOp);
+int zoneMapRangeScan(const HeapZoneMap &zoneMap, int low, int high,
+                     int &pagesSkipped);
 void errorTests();
 void deleteRelation();
 
@@ -202,8 +293,8 @@ int main(int argc, char **argv) {
         fscan.scanNext(scanRid);
         // Assuming RECORD.i is our key, lets extract the key, which we know is
         // INTEGER and whose byte offset is also know inside the record.
-        std::string recordStr = fscan.getRecord();
-        const char *record = recordStr.c_str();
+        RecordView recordView = fscan.getRecordView();
+        const char *record = recordView.data;
         int key = *((int *)(record + offsetof(RECORD, i)));
         std::cout << "Extracted : " << key << std::endl;
       }
@@ -220,7 +311,7 @@ int main(int argc, char **argv) {
   test3();
   test4();
   test5();
-  // test6();
+  test6();
   test7();
   test8();
   test9();
@@ -228,6 +319,30 @@ int main(int argc, char **argv) {
   test11();
   test12();
   test13();
+  test14();
+  test15();
+  test16();
+  test17();
+  test18();
+  test19();
+  test20();
+  test21();
+  test22();
+  test23();
+  test24();
+  test25();
+  test26();
+  test27();
+  test28();
+  test29();
+  test30();
+  test31();
+  test32();
+  test33();
+  test34();
+  test35();
+  test36();
+  test37();
   errorTests();
   return 1;
 }
@@ -381,6 +496,192 @@ void test13() {
   deleteRelation();
 }
 
+// Build an adaptive radix tree index over the string attribute
+void test14() {
+  // Create a relation with tuples valued 0 to relationSize in forward order and
+  // perform point lookups and prefix scans on the string attribute
+  std::cout << "--------------------" << std::endl;
+  std::cout << "createRelationForward (ART)" << std::endl;
+  createRelationForward();
+  artTests();
+  deleteRelation();
+}
+
+// Combine bitmap index predicates over low-cardinality attributes
+void test15() {
+  // Create a relation where i cycles through 10 values and d through 4, and
+  // combine equality predicates on both attributes
+  std::cout << "--------------------" << std::endl;
+  std::cout << "createCyclicRelation (bitmap)" << std::endl;
+  createCyclicRelation(relationSize);
+  bitmapTests();
+  deleteRelation();
+}
+
+// Combine scans of several indexes through sorted RecordId lists
+void test16() {
+  // Create a relation with tuples valued 0 to relationSize in random order and
+  // intersect and unite scans of the int and double indexes
+  std::cout << "--------------------" << std::endl;
+  std::cout << "createRelationRandom (rid lists)" << std::endl;
+  createRelationRandom();
+  ridListTests();
+  deleteRelation();
+}
+
+// Fetch the records of an unclustered index scan in page order
+void test17() {
+  // Create a relation with tuples valued 0 to relationSize in random order and
+  // fetch the records of a full int index scan as one batch
+  std::cout << "--------------------" << std::endl;
+  std::cout << "createRelationRandom (heap fetch)" << std::endl;
+  createRelationRandom();
+  heapFetchTests();
+  deleteRelation();
+}
+
+// Cluster a relation on its int attribute and rebuild its index
+void test18() {
+  // Create a relation with tuples valued 0 to relationSize in random order,
+  // rewrite it sorted on i and check the rebuilt index returns page order
+  std::cout << "--------------------" << std::endl;
+  std::cout << "createRelationRandom (cluster)" << std::endl;
+  createRelationRandom();
+  clusterTests();
+  deleteRelation();
+}
+
+// Delete, update and insert records on a single page
+void test19() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "page compaction" << std::endl;
+  pageTests();
+}
+
+// Store a relation in fixed-width record pages
+void test20() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "fixed-width record pages" << std::endl;
+  fixedPageTests();
+}
+
+// Store a relation in PAX pages and index it from its key column
+void test21() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "PAX pages" << std::endl;
+  paxTests();
+}
+
+// Store a relation in columnar row groups, scan it with zone maps and index it
+void test22() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "columnar relation" << std::endl;
+  columnarTests();
+}
+
+// Skip the heap pages of a range scan from their zone map
+void test23() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "heap zone maps" << std::endl;
+  zoneMapTests();
+}
+
+// Fill an empty index entry by entry, splitting leaves along the way
+void test24() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "insertEntry with leaf splits" << std::endl;
+  insertTests();
+}
+
+void test25() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Normalized index keys" << std::endl;
+  indexKeyTests();
+}
+
+void test26() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Index with normalized keys" << std::endl;
+  normalizedKeyTests();
+}
+
+// Lookups and scans reporting misses and ends through their return value
+void test27() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Non-throwing lookups and scans" << std::endl;
+  tryScanTests();
+}
+
+// Buffer pool shared by a forked process
+void test28() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Shared buffer pool" << std::endl;
+  sharedBufferTests();
+}
+
+// Snapshot scans interleaved with inserts
+void test29() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Index snapshots" << std::endl;
+  snapshotTests();
+}
+
+// Append-only index, reopened at its last commit
+void test30() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Append-only index" << std::endl;
+  appendOnlyTests();
+}
+
+// Index maintained by a background thread
+void test31() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Deferred index maintenance" << std::endl;
+  deferredIndexTests();
+}
+
+// Index split into key ranges, scanned in parallel
+void test32() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Partitioned index" << std::endl;
+  partitionedIndexTests();
+}
+
+// One range scan split over the threads of a pool
+void test33() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Parallel range scan" << std::endl;
+  parallelScanTests();
+}
+
+// Task classes of the work-stealing pool and its buffer manager hooks
+void test34() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Work-stealing scheduler" << std::endl;
+  schedulerTests();
+}
+
+// Lookups and cursors suspended on buffer misses
+void test35() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Asynchronous index" << std::endl;
+  asyncIndexTests();
+}
+
+// Records packed into pages and appended to the file an extent at a time
+void test36() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Bulk loading" << std::endl;
+  bulkLoaderTests();
+}
+
+// DOUBLE and STRING indexes with inner nodes searched through their heads
+void test37() {
+  std::cout << "--------------------" << std::endl;
+  std::cout << "Head arrays of inner nodes" << std::endl;
+  headArrayTests();
+}
+
 // -----------------------------------------------------------------------------
 // createRelationForward
 // -----------------------------------------------------------------------------
@@ -421,6 +722,46 @@ void createRelationForward() {
   file1->writePage(new_page_number, new_page);
 }
 
+// -----------------------------------------------------------------------------
+// createCyclicRelation
+// -----------------------------------------------------------------------------
+
+// Creates a relation of relSize tuples where i is the tuple number modulo 10
+// and d the tuple number modulo 4
+void createCyclicRelation(int relSize) {
+  // destroy any old copies of relation file
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+
+  file1 = new PageFile(relationName, true);
+
+  // initialize all of record1.s to keep purify happy
+  memset(record1.s, ' ', sizeof(record1.s));
+  PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  for (int i = 0; i < relSize; i++) {
+    sprintf(record1.s, "%05d string record", i);
+    record1.i = i % 10;
+    record1.d = (double)(i % 4);
+    std::string new_data(reinterpret_cast<char *>(&record1), sizeof(record1));
+
+    while (1) {
+      try {
+        new_page.insertRecord(new_data);
+        break;
+      } catch (const InsufficientSpaceException &e) {
+        file1->writePage(new_page_number, new_page);
+        new_page = file1->allocatePage(new_page_number);
+      }
+    }
+  }
+
+  file1->writePage(new_page_number, new_page);
+}
+
 // Creates forward relation from [start, end]
 void createCustomRelationForward(int start, int end) {
   std::vector<RecordId> ridVec;
@@ -1103,7 +1444,7 @@ int intScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal,
       index->scanNext(scanRid);
       bufMgr->readPage(file1, scanRid.page_number, curPage);
       RECORD myRec = *(
-          reinterpret_cast<const RECORD *>(curPage->getRecord(scanRid).data()));
+          reinterpret_cast<const RECORD *>(curPage->recordView(scanRid).data));
       bufMgr->unPinPage(file1, scanRid.page_number, false);
 
       if (numResults < 5) {
@@ -1286,7 +1627,7 @@ int doubleScan(BTreeIndex *index, double lowVal, Operator lowOp, double highVal,
       index->scanNext(scanRid);
       bufMgr->readPage(file1, scanRid.page_number, curPage);
       RECORD myRec = *(
-          reinterpret_cast<const RECORD *>(curPage->getRecord(scanRid).data()));
+          reinterpret_cast<const RECORD *>(curPage->recordView(scanRid).data));
       bufMgr->unPinPage(file1, scanRid.page_number, false);
 
       if (numResults < 5) {
@@ -1473,7 +1814,7 @@ int stringScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal,
       index->scanNext(scanRid);
       bufMgr->readPage(file1, scanRid.page_number, curPage);
       RECORD myRec = *(
-          reinterpret_cast<const RECORD *>(curPage->getRecord(scanRid).data()));
+          reinterpret_cast<const RECORD *>(curPage->recordView(scanRid).data));
       bufMgr->unPinPage(file1, scanRid.page_number, false);
 
       if (numResults < 5) {
@@ -1593,6 +1934,2280 @@ void errorTests() {
   deleteRelation();
 }
 
+// -----------------------------------------------------------------------------
+// artTests
+// -----------------------------------------------------------------------------
+
+void artTests() {
+  std::string artIndexName;
+  {
+    ARTIndex index(relationName, artIndexName, bufMgr, offsetof(tuple, s),
+                   sizeof(record1.s));
+    std::vector<RecordId> rids;
+    checkPassFail(index.numKeys(), (std::uint32_t)relationSize)
+    checkPassFail(index.lookup("00042 string record", rids), true)
+    checkPassFail(rids.size(), (std::size_t)1)
+    checkPassFail(index.lookup("00042 string", rids), false)
+    rids.clear();
+    index.prefixScan("0004", rids);
+    checkPassFail(rids.size(), (std::size_t)10)
+    rids.clear();
+    index.prefixScan("00", rids);
+    checkPassFail(rids.size(), (std::size_t)1000)
+    rids.clear();
+    index.prefixScan("", rids);
+    checkPassFail(rids.size(), (std::size_t)relationSize)
+    rids.clear();
+    index.prefixScan("5", rids);
+    checkPassFail(rids.size(), (std::size_t)0)
+
+    // Entries are visited in key order
+    std::string previous;
+    bool ordered = true;
+    index.scanAll([&](const std::string &key, const RecordId &rid) {
+      ordered = ordered && previous < key;
+      previous = key;
+    });
+    checkPassFail(ordered, true)
+  }
+
+  // Reopen the index from its file
+  {
+    ARTIndex index(relationName, artIndexName, bufMgr, offsetof(tuple, s),
+                   sizeof(record1.s));
+    std::vector<RecordId> rids;
+    checkPassFail(index.numKeys(), (std::uint32_t)relationSize)
+    index.prefixScan("0123", rids);
+    checkPassFail(rids.size(), (std::size_t)10)
+  }
+
+  try {
+    File::remove(artIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+
+  // Rewriting a blob chain with a shorter stream keeps the rest of the chain
+  // for a longer rewrite after it
+  const std::string blobName = "blob.rewrite";
+  {
+    BlobFile blobFile(blobName, true);
+    const std::vector<char> bytes(3 * BLOBPAGEDATASIZE, 'b');
+    std::vector<char> readBack(bytes.size());
+    PageId firstPageNo;
+    {
+      BlobWriter writer(&blobFile, bufMgr);
+      writer.write(bytes.data(), bytes.size());
+      firstPageNo = writer.firstPageNo();
+    }
+    {
+      BlobWriter writer(&blobFile, bufMgr, firstPageNo);
+      writer.write(bytes.data(), BLOBPAGEDATASIZE);
+    }
+    {
+      BlobReader reader(&blobFile, bufMgr, firstPageNo);
+      checkPassFail(reader.read(readBack.data(), BLOBPAGEDATASIZE), true)
+      checkPassFail(reader.read(readBack.data(), 1), false)
+    }
+    {
+      BlobWriter writer(&blobFile, bufMgr, firstPageNo);
+      writer.write(bytes.data(), bytes.size() - 1);
+    }
+    {
+      BlobReader reader(&blobFile, bufMgr, firstPageNo);
+      checkPassFail(reader.read(readBack.data(), bytes.size() - 1), true)
+      checkPassFail(reader.read(readBack.data(), 1), false)
+    }
+    // No page was added by the rewrites
+    PageId nextPageNo;
+    Page *nextPage;
+    bufMgr->allocPage(&blobFile, nextPageNo, nextPage);
+    bufMgr->unPinPage(&blobFile, nextPageNo, false);
+    checkPassFail(nextPageNo, firstPageNo + 3)
+    bufMgr->flushFile(&blobFile);
+  }
+  File::remove(blobName);
+}
+
+// -----------------------------------------------------------------------------
+// bitmapTests
+// -----------------------------------------------------------------------------
+
+void bitmapTests() {
+  std::string intBitmapName, doubleBitmapName;
+  {
+    BitmapIndex intIndex(relationName, intBitmapName, bufMgr,
+                         offsetof(tuple, i), INTEGER);
+    BitmapIndex doubleIndex(relationName, doubleBitmapName, bufMgr,
+                            offsetof(tuple, d), DOUBLE);
+    checkPassFail(intIndex.numKeys(), (std::uint32_t)10)
+    checkPassFail(doubleIndex.numKeys(), (std::uint32_t)4)
+
+    int three = 3;
+    double one = 1;
+    RowBitmap iIs3 = intIndex.lookup(&three);
+    RowBitmap dIs1 = doubleIndex.lookup(&one);
+    checkPassFail(iIs3.cardinality(), (std::uint64_t)(relationSize / 10))
+    // i == 3 and d == 1 holds for tuples congruent to 13 modulo 20
+    checkPassFail((iIs3 & dIs1).cardinality(), (std::uint64_t)(relationSize / 20))
+    checkPassFail((iIs3 | dIs1).cardinality(),
+                  (std::uint64_t)(relationSize / 10 + relationSize / 4 -
+                                  relationSize / 20))
+    checkPassFail(iIs3.flip(intIndex.numRows()).cardinality(),
+                  (std::uint64_t)(relationSize - relationSize / 10))
+    checkPassFail(iIs3.andNot(dIs1).cardinality(),
+                  (std::uint64_t)(relationSize / 10 - relationSize / 20))
+
+    int missing = 42;
+    checkPassFail(intIndex.lookup(&missing).empty(), true)
+    int four = 4;
+    std::vector<const void *> keys;
+    keys.push_back(&three);
+    keys.push_back(&four);
+    checkPassFail(intIndex.lookupAny(keys).cardinality(),
+                  (std::uint64_t)(relationSize / 5))
+
+    std::vector<RecordId> rids;
+    intIndex.toRecordIds(iIs3 & dIs1, rids);
+    checkPassFail(rids.size(), (std::size_t)(relationSize / 20))
+  }
+
+  // Reopen the index from its file
+  {
+    BitmapIndex intIndex(relationName, intBitmapName, bufMgr,
+                         offsetof(tuple, i), INTEGER);
+    checkPassFail(intIndex.numRows(), (std::uint32_t)relationSize)
+    int seven = 7;
+    checkPassFail(intIndex.lookup(&seven).cardinality(),
+                  (std::uint64_t)(relationSize / 10))
+  }
+
+  // Once the relation is written the index is stale and refuses to open
+  {
+    const PageId firstPageNo = file1->getFirstPageNo();
+    file1->writePage(firstPageNo, file1->readPage(firstPageNo));
+    bool refused = false;
+    try {
+      BitmapIndex intIndex(relationName, intBitmapName, bufMgr,
+                           offsetof(tuple, i), INTEGER);
+    } catch (const BadIndexInfoException &e) {
+      refused = true;
+    }
+    checkPassFail(refused, true)
+  }
+
+  try {
+    File::remove(intBitmapName);
+    File::remove(doubleBitmapName);
+  } catch (const FileNotFoundException &e) {
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ridListTests
+// -----------------------------------------------------------------------------
+
+void ridListTests() {
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER);
+    BTreeIndex doubleIndex(relationName, doubleIndexName, bufMgr,
+                           offsetof(tuple, d), DOUBLE);
+    int intLow = 100, intHigh = 1000;
+    double doubleLow = 500, doubleHigh = 2000;
+    std::vector<IndexPredicate> predicates(2);
+    IndexPredicate intPredicate = {&intIndex, &intLow, GTE, &intHigh, LT};
+    IndexPredicate doublePredicate = {&doubleIndex, &doubleLow, GTE,
+                                      &doubleHigh, LTE};
+    predicates[0] = intPredicate;
+    predicates[1] = doublePredicate;
+
+    std::vector<RecordId> rids;
+    intersectScans(predicates, rids);
+    checkPassFail(rids.size(), (std::size_t)500)
+
+    // Output is in page order
+    bool ordered = true;
+    for (std::size_t k = 1; k < rids.size(); k++) {
+      ordered = ordered &&
+                (rids[k - 1].page_number < rids[k].page_number ||
+                 (rids[k - 1].page_number == rids[k].page_number &&
+                  rids[k - 1].slot_number < rids[k].slot_number));
+    }
+    checkPassFail(ordered, true)
+
+    unionScans(predicates, rids);
+    checkPassFail(rids.size(), (std::size_t)1901)
+
+    // A short list against a long one is intersected by galloping
+    int fewLow = 10, fewHigh = 12;
+    double allLow = 0, allHigh = relationSize;
+    IndexPredicate fewPredicate = {&intIndex, &fewLow, GTE, &fewHigh, LTE};
+    IndexPredicate allPredicate = {&doubleIndex, &allLow, GTE, &allHigh, LTE};
+    predicates[0] = fewPredicate;
+    predicates[1] = allPredicate;
+    intersectScans(predicates, rids);
+    checkPassFail(rids.size(), (std::size_t)3)
+
+    // Scan matching no key
+    int noneLow = relationSize + 10, noneHigh = relationSize + 20;
+    IndexPredicate nonePredicate = {&intIndex, &noneLow, GTE, &noneHigh, LTE};
+    predicates[0] = nonePredicate;
+    intersectScans(predicates, rids);
+    checkPassFail(rids.size(), (std::size_t)0)
+  }
+
+  try {
+    File::remove(intIndexName);
+    File::remove(doubleIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+}
+
+// -----------------------------------------------------------------------------
+// heapFetchTests
+// -----------------------------------------------------------------------------
+
+void heapFetchTests() {
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER);
+    int low = 0, high = relationSize;
+    IndexPredicate all = {&intIndex, &low, GTE, &high, LT};
+    std::vector<RecordId> rids;
+    collectRids(all, rids);
+    checkPassFail(rids.size(), (std::size_t)relationSize)
+
+    std::vector<RecordId> sortedRids(rids);
+    sortRids(sortedRids);
+    std::uint32_t numPages = 0;
+    for (std::size_t k = 0; k < sortedRids.size(); k++) {
+      if (k == 0 ||
+          sortedRids[k].page_number != sortedRids[k - 1].page_number) {
+        numPages++;
+      }
+    }
+
+    // Records come back in key order, each page pinned once
+    HeapFetcher fetcher(file1, bufMgr);
+    std::vector<std::string> records;
+    fetcher.fetch(rids, records);
+    bool inKeyOrder = true;
+    for (std::size_t k = 0; k < records.size(); k++) {
+      const RECORD *rec = reinterpret_cast<const RECORD *>(records[k].data());
+      inKeyOrder = inKeyOrder && rec->i == (int)k;
+    }
+    checkPassFail(inKeyOrder, true)
+    checkPassFail(fetcher.pagesPinned(), numPages)
+
+    // In page order the RecordIds are sorted along with the records
+    fetcher.fetch(rids, records, HeapFetcher::PAGE_ORDER);
+    bool sameOrder = rids == sortedRids;
+    checkPassFail(sameOrder, true)
+
+    // Record views handed to the visitor match the copied records
+    int visited = 0;
+    int sameRecords = 0;
+    fetcher.fetch(rids, [&](const RecordId &rid, const RecordView &record) {
+      visited++;
+      if (record.toString() == records[visited - 1]) {
+        sameRecords++;
+      }
+    });
+    checkPassFail(visited, relationSize)
+    checkPassFail(sameRecords, relationSize)
+  }
+
+  try {
+    File::remove(intIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+}
+
+// -----------------------------------------------------------------------------
+// clusterTests
+// -----------------------------------------------------------------------------
+
+void clusterTests() {
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER);
+  }
+
+  // The relation has to be closed while it is rewritten
+  bufMgr->flushFile(file1);
+  delete file1;
+  file1 = NULL;
+  std::vector<IndexAttribute> indexes(1);
+  indexes[0].attrByteOffset = offsetof(tuple, i);
+  indexes[0].attrType = INTEGER;
+  // Sort memory well below the relation size forces several runs
+  std::size_t runs = clusterRelation(relationName, bufMgr, offsetof(tuple, i),
+                                     INTEGER, indexes, 100000);
+  bool severalRuns = runs > 1;
+  checkPassFail(severalRuns, true)
+  file1 = new PageFile(relationName, false);
+
+  // Relation is now in key order
+  {
+    FileScan fscan(relationName, bufMgr);
+    int expected = 0;
+    bool ordered = true;
+    try {
+      RecordId scanRid;
+      while (1) {
+        fscan.scanNext(scanRid);
+        std::string recordStr = fscan.getRecord();
+        const RECORD *rec = reinterpret_cast<const RECORD *>(recordStr.data());
+        ordered = ordered && rec->i == expected++;
+      }
+    } catch (const EndOfFileException &e) {
+    }
+    checkPassFail(ordered, true)
+    checkPassFail(expected, relationSize)
+  }
+
+  // Rebuilt index returns RecordIds in page order
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER);
+    checkPassFail(intScan(&intIndex, 25, GT, 40, LT), 14)
+    int low = 0, high = relationSize;
+    IndexPredicate all = {&intIndex, &low, GTE, &high, LT};
+    std::vector<RecordId> rids;
+    collectRids(all, rids);
+    std::vector<RecordId> sortedRids(rids);
+    sortRids(sortedRids);
+    bool pageOrder = rids == sortedRids;
+    checkPassFail(pageOrder, true)
+    checkPassFail(rids.size(), (std::size_t)relationSize)
+  }
+
+  // Bulk loads leave room in the nodes unless asked to fill them
+  {
+    std::vector<RIDKeyPair<IndexKey> > entries;
+    BTreeIndex::scanRelation(relationName, bufMgr, offsetof(tuple, i),
+                             INTEGER, SLOTTED_RELATION, entries);
+    std::vector<RIDKeyPair<IndexKey> > sameEntries(entries);
+    const std::string fullName = relationName + ".full";
+    const std::string defaultName = relationName + ".default";
+    {
+      BTreeIndex full(relationName, fullName, bufMgr, offsetof(tuple, i),
+                      INTEGER, entries, NATIVE_KEYS, IN_PLACE_STORAGE, 1.0);
+      BTreeIndex loose(relationName, defaultName, bufMgr, offsetof(tuple, i),
+                       INTEGER, sameEntries);
+      checkPassFail(intScan(&full, 25, GT, 40, LT), 14)
+      checkPassFail(intScan(&loose, 25, GT, 40, LT), 14)
+    }
+    std::ifstream fullFile(fullName, std::ios::binary | std::ios::ate);
+    std::ifstream defaultFile(defaultName, std::ios::binary | std::ios::ate);
+    bool moreNodes = defaultFile.tellg() > fullFile.tellg();
+    checkPassFail(moreNodes, true)
+    fullFile.close();
+    defaultFile.close();
+    File::remove(fullName);
+    File::remove(defaultName);
+  }
+
+  try {
+    File::remove(intIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+}
+
+// -----------------------------------------------------------------------------
+// pageTests
+// -----------------------------------------------------------------------------
+
+void pageTests() {
+  Page page;
+  std::vector<RecordId> rids;
+  std::vector<std::string> records;
+  try {
+    for (int i = 0;; i++) {
+      std::string record(100, 'a' + i % 26);
+      rids.push_back(page.insertRecord(record));
+      records.push_back(record);
+    }
+  } catch (const InsufficientSpaceException &e) {
+  }
+  std::uint16_t fullFreeSpace = page.getFreeSpace();
+
+  // Deletes only add to the free space, records stay where they are. The last
+  // record is kept so the slot array does not shrink.
+  std::vector<RecordId> kept;
+  std::vector<std::string> keptRecords;
+  std::size_t numDeleted = 0;
+  for (std::size_t i = 0; i < rids.size(); i++) {
+    if (i % 2 == 0 && i + 1 < rids.size()) {
+      page.deleteRecord(rids[i]);
+      numDeleted++;
+    } else {
+      kept.push_back(rids[i]);
+      keptRecords.push_back(records[i]);
+    }
+  }
+  checkPassFail(page.getFreeSpace(), fullFreeSpace + numDeleted * 100)
+
+  // Larger records only fit once the page is compacted, which keeps the
+  // RecordIds of the remaining records
+  std::string large(250, 'z');
+  RecordId largeRid = page.insertRecord(large);
+  bool reusedSlot = largeRid.slot_number < rids.back().slot_number;
+  checkPassFail(reusedSlot, true)
+  checkPassFail(page.getRecord(largeRid), large)
+  std::size_t sameRecords = 0;
+  for (std::size_t i = 0; i < kept.size(); i++) {
+    if (page.getRecord(kept[i]) == keptRecords[i]) {
+      sameRecords++;
+    }
+  }
+  checkPassFail(sameRecords, kept.size())
+
+  // Updates shrink in place and grow into the free space
+  page.updateRecord(kept[0], "short");
+  checkPassFail(page.getRecord(kept[0]), "short")
+  std::string grown(300, 'y');
+  page.updateRecord(kept[1], grown);
+  checkPassFail(page.getRecord(kept[1]), grown)
+  checkPassFail(page.getRecord(kept[2]), keptRecords[2])
+
+  // Iteration skips the unused slots
+  std::size_t numRecords = 0;
+  for (PageIterator iter = page.begin(); iter != page.end(); ++iter) {
+    numRecords++;
+  }
+  checkPassFail(numRecords, kept.size() + 1)
+
+  // Emptying the page gives back all of its space
+  page.deleteRecord(largeRid);
+  for (std::size_t i = 0; i < kept.size(); i++) {
+    page.deleteRecord(kept[i]);
+  }
+  checkPassFail(page.getFreeSpace(), Page::DATA_SIZE)
+}
+
+// -----------------------------------------------------------------------------
+// fixedPageTests
+// -----------------------------------------------------------------------------
+
+void fixedPageTests() {
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+  file1 = new PageFile(relationName, true);
+
+  // Without slots, a page holds more records than a slotted page
+  std::size_t slottedCapacity =
+      Page::DATA_SIZE / (sizeof(RECORD) + sizeof(PageSlot));
+  bool moreRecords = FixedRecordPage::capacityFor(sizeof(RECORD)) >
+                     slottedCapacity;
+  checkPassFail(moreRecords, true)
+
+  std::vector<RecordId> rids;
+  PageId pageNo;
+  Page *page;
+  bufMgr->allocPage(file1, pageNo, page);
+  FixedRecordPage(page).initialize(sizeof(RECORD));
+  memset(record1.s, ' ', sizeof(record1.s));
+  for (int i = 0; i < relationSize; i++) {
+    sprintf(record1.s, "%05d string record", i);
+    record1.i = i;
+    record1.d = (double)i;
+    try {
+      rids.push_back(FixedRecordPage(page).insertRecord((char *)&record1));
+    } catch (const InsufficientSpaceException &e) {
+      bufMgr->unPinPage(file1, pageNo, true);
+      bufMgr->allocPage(file1, pageNo, page);
+      FixedRecordPage(page).initialize(sizeof(RECORD));
+      rids.push_back(FixedRecordPage(page).insertRecord((char *)&record1));
+    }
+  }
+  bufMgr->unPinPage(file1, pageNo, true);
+
+  // Record lookup by RecordId
+  bufMgr->readPage(file1, rids[1234].page_number, page);
+  RecordView view = FixedRecordPage(page).recordView(rids[1234]);
+  checkPassFail(((const RECORD *)view.data)->i, 1234)
+  bufMgr->unPinPage(file1, rids[1234].page_number, false);
+
+  // Deleted positions are reused by the next insert on the page
+  bufMgr->readPage(file1, rids[10].page_number, page);
+  FixedRecordPage(page).deleteRecord(rids[11]);
+  FixedRecordPage(page).deleteRecord(rids[10]);
+  record1.i = -1;
+  RecordId reused = FixedRecordPage(page).insertRecord((char *)&record1);
+  bool sameSlot = reused == rids[10];
+  checkPassFail(sameSlot, true)
+  bufMgr->unPinPage(file1, rids[10].page_number, true);
+  bufMgr->flushFile(file1);
+
+  // Scan returns every record, in slot order
+  {
+    FixedFileScan fscan(relationName, bufMgr);
+    int numRecords = 0;
+    int expected = 0;
+    bool ordered = true;
+    try {
+      RecordId scanRid;
+      while (1) {
+        fscan.scanNext(scanRid);
+        const RECORD *rec = (const RECORD *)fscan.getRecordView().data;
+        if (expected == 11) {
+          expected++;
+        }
+        ordered = ordered && (rec->i == expected || rec->i == -1);
+        expected++;
+        numRecords++;
+      }
+    } catch (const EndOfFileException &e) {
+    }
+    checkPassFail(numRecords, relationSize - 1)
+    checkPassFail(ordered, true)
+  }
+
+  // Index built with the fixed-width scan
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER, FIXED_RELATION);
+    int low = 5, high = 20;
+    IndexPredicate range = {&intIndex, &low, GTE, &high, LT};
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    // 10 and 11 were deleted
+    checkPassFail(rids.size(), (std::size_t)13)
+  }
+  try {
+    File::remove(intIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// paxTests
+// -----------------------------------------------------------------------------
+
+void paxTests() {
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+  file1 = new PageFile(relationName, true);
+
+  PaxSchema schema(3);
+  schema[0].offset = offsetof(tuple, i);
+  schema[0].type = INTEGER;
+  schema[0].size = sizeof(int);
+  schema[1].offset = offsetof(tuple, d);
+  schema[1].type = DOUBLE;
+  schema[1].size = sizeof(double);
+  schema[2].offset = offsetof(tuple, s);
+  schema[2].type = STRING;
+  schema[2].size = sizeof(record1.s);
+
+  // Insert the tuples in random order
+  std::vector<int> values(relationSize);
+  for (int i = 0; i < relationSize; i++) {
+    values[i] = i;
+  }
+  srand(1);
+  std::random_shuffle(values.begin(), values.end());
+  PageId pageNo;
+  Page *page;
+  bufMgr->allocPage(file1, pageNo, page);
+  PaxPage(page).initialize(schema);
+  memset(&record1, 0, sizeof(record1));
+  for (int i = 0; i < relationSize; i++) {
+    sprintf(record1.s, "%05d string record", values[i]);
+    record1.i = values[i];
+    record1.d = (double)values[i];
+    try {
+      PaxPage(page).insertRecord((char *)&record1);
+    } catch (const InsufficientSpaceException &e) {
+      bufMgr->unPinPage(file1, pageNo, true);
+      bufMgr->allocPage(file1, pageNo, page);
+      PaxPage(page).initialize(schema);
+      PaxPage(page).insertRecord((char *)&record1);
+    }
+  }
+  bufMgr->unPinPage(file1, pageNo, true);
+  bufMgr->flushFile(file1);
+
+  // Records are put back together in row format
+  {
+    PaxFileScan pscan(relationName, bufMgr);
+    int numRecords = 0;
+    bool sameRecords = true;
+    try {
+      RecordId scanRid;
+      while (1) {
+        pscan.scanNext(scanRid);
+        std::string recordStr = pscan.getRecord();
+        const RECORD *rec = reinterpret_cast<const RECORD *>(recordStr.data());
+        int expected = values[numRecords++];
+        sameRecords = sameRecords && rec->i == expected &&
+                      rec->d == (double)expected &&
+                      atoi(rec->s) == expected &&
+                      *(const int *)pscan.getValue(0) == expected;
+      }
+    } catch (const EndOfFileException &e) {
+    }
+    checkPassFail(numRecords, relationSize)
+    checkPassFail(sameRecords, true)
+  }
+
+  // Index built from the key column only. The records of a range scan are
+  // looked up in the i column of their page.
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER, PAX_RELATION);
+    int low = 25, high = 40;
+    IndexPredicate range = {&intIndex, &low, GT, &high, LT};
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)14)
+    bool inRange = true;
+    for (std::size_t r = 0; r < rids.size(); r++) {
+      bufMgr->readPage(file1, rids[r].page_number, page);
+      int key = *(const int *)PaxPage(page).value(0, rids[r].slot_number);
+      inRange = inRange && key > low && key < high;
+      bufMgr->unPinPage(file1, rids[r].page_number, false);
+    }
+    checkPassFail(inRange, true)
+  }
+  try {
+    File::remove(intIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  {
+    BTreeIndex stringIndex(relationName, stringIndexName, bufMgr,
+                           offsetof(tuple, s), STRING, PAX_RELATION);
+    // Keys are the first STRINGSIZE characters, "00025 stri" is above "00025"
+    char low[STRINGSIZE + 1] = "00025";
+    char high[STRINGSIZE + 1] = "00040";
+    IndexPredicate range = {&stringIndex, low, GT, high, LT};
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)15)
+  }
+  try {
+    File::remove(stringIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// columnarTests
+// -----------------------------------------------------------------------------
+
+void columnarTests() {
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+
+  PaxSchema schema(3);
+  schema[0].offset = offsetof(tuple, i);
+  schema[0].type = INTEGER;
+  schema[0].size = sizeof(int);
+  schema[1].offset = offsetof(tuple, d);
+  schema[1].type = DOUBLE;
+  schema[1].size = sizeof(double);
+  schema[2].offset = offsetof(tuple, s);
+  schema[2].type = STRING;
+  schema[2].size = sizeof(record1.s);
+
+  // Tuples in forward order, 500 per row group
+  const std::uint32_t rowGroupSize = 500;
+  const std::uint32_t numRowGroups =
+      (relationSize + rowGroupSize - 1) / rowGroupSize;
+  {
+    ColumnarWriter writer(relationName, bufMgr, schema, rowGroupSize);
+    memset(&record1, 0, sizeof(record1));
+    for (int i = 0; i < relationSize; i++) {
+      sprintf(record1.s, "%05d string record", i);
+      record1.i = i;
+      record1.d = (double)i;
+      writer.append((char *)&record1);
+    }
+    writer.close();
+  }
+  {
+    ColumnarRelation relation(relationName, bufMgr);
+    checkPassFail(relation.numRowGroups(), numRowGroups)
+    // Consecutive integers are stored as small deltas from the chunk minimum
+    bool forEncoded = relation.chunk(0, 0).encoding == FOR_ENCODING;
+    checkPassFail(forEncoded, true)
+    bool zoneMap = relation.chunk(1, 0).zoneMap.minNumber == rowGroupSize &&
+                   relation.chunk(1, 0).zoneMap.maxNumber == 2 * rowGroupSize - 1;
+    checkPassFail(zoneMap, true)
+  }
+
+  // Records are put back together in row format
+  {
+    ColumnarScan cscan(relationName, bufMgr);
+    int numRecords = 0;
+    bool sameRecords = true;
+    try {
+      RecordId scanRid;
+      while (1) {
+        cscan.scanNext(scanRid);
+        std::string recordStr = cscan.getRecord();
+        const RECORD *rec = reinterpret_cast<const RECORD *>(recordStr.data());
+        int expected = numRecords++;
+        sameRecords = sameRecords && rec->i == expected &&
+                      rec->d == (double)expected &&
+                      atoi(rec->s) == expected;
+      }
+    } catch (const EndOfFileException &e) {
+    }
+    checkPassFail(numRecords, relationSize)
+    checkPassFail(sameRecords, true)
+  }
+
+  // Range scan reading only the d column, row groups outside the range are
+  // skipped from their zone map
+  {
+    ColumnarScan cscan(relationName, bufMgr, std::vector<int>(1, 1));
+    double low = 1200, high = 1450;
+    cscan.setRange(1, &low, GTE, &high, LT);
+    int numRecords = 0;
+    bool inRange = true;
+    try {
+      RecordId scanRid;
+      while (1) {
+        cscan.scanNext(scanRid);
+        double value = *(const double *)cscan.getValue(1);
+        inRange = inRange && value >= low && value < high;
+        numRecords++;
+      }
+    } catch (const EndOfFileException &e) {
+    }
+    checkPassFail(numRecords, 250)
+    checkPassFail(inRange, true)
+    checkPassFail(cscan.rowGroupsSkipped(), numRowGroups - 1)
+  }
+
+  // Index built from the key column only, RecordIds give back the records
+  {
+    BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple, i),
+                        INTEGER, COLUMNAR_RELATION);
+    int low = 25, high = 40;
+    IndexPredicate range = {&intIndex, &low, GT, &high, LT};
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)14)
+    ColumnarRelation relation(relationName, bufMgr);
+    bool inRange = true;
+    for (std::size_t r = 0; r < rids.size(); r++) {
+      std::string recordStr = relation.getRecord(rids[r]);
+      const RECORD *rec = reinterpret_cast<const RECORD *>(recordStr.data());
+      inRange = inRange && rec->i > low && rec->i < high &&
+                atoi(rec->s) == rec->i;
+    }
+    checkPassFail(inRange, true)
+  }
+  try {
+    File::remove(intIndexName);
+  } catch (const FileNotFoundException &e) {
+  }
+
+  // Repeated values, fetched one record at a time out of RLE and dictionary
+  // chunks as well
+  File::remove(relationName);
+  {
+    ColumnarWriter writer(relationName, bufMgr, schema, rowGroupSize);
+    memset(&record1, 0, sizeof(record1));
+    for (int i = 0; i < relationSize; i++) {
+      sprintf(record1.s, "%05d string record", i);
+      record1.i = i / 100;
+      record1.d = (double)(i % 3);
+      writer.append((char *)&record1);
+    }
+    writer.close();
+  }
+  {
+    ColumnarRelation relation(relationName, bufMgr);
+    bool encodings = relation.chunk(0, 0).encoding == RLE_ENCODING &&
+                     relation.chunk(0, 1).encoding == DICTIONARY_ENCODING &&
+                     relation.chunk(0, 2).encoding == PLAIN_ENCODING;
+    checkPassFail(encodings, true)
+    // Every 7th record, going back and forth between the row groups
+    bool sameRecords = true;
+    for (int n = 0; n < relationSize; n++) {
+      const int i = (n * 7) % relationSize;
+      RecordId rid = {(PageId)(i / rowGroupSize + 1),
+                      (SlotId)(i % rowGroupSize + 1)};
+      std::string recordStr = relation.getRecord(rid);
+      const RECORD *rec = reinterpret_cast<const RECORD *>(recordStr.data());
+      sameRecords = sameRecords && rec->i == i / 100 &&
+                    rec->d == (double)(i % 3) && atoi(rec->s) == i;
+    }
+    checkPassFail(sameRecords, true)
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// zoneMapTests
+// -----------------------------------------------------------------------------
+
+// Returns the number of records of a range scan of the relation on the i
+// attribute, checking they are all in the range
+int zoneMapRangeScan(const HeapZoneMap &zoneMap, int low, int high,
+                     int &pagesSkipped) {
+  FileScan fscan(relationName, bufMgr);
+  fscan.setRange(&zoneMap, &low, GTE, &high, LT);
+  int numRecords = 0;
+  try {
+    RecordId scanRid;
+    while (1) {
+      fscan.scanNext(scanRid);
+      const RECORD *rec =
+          reinterpret_cast<const RECORD *>(fscan.getRecordView().data);
+      if (rec->i < low || rec->i >= high) {
+        return -1;
+      }
+      numRecords++;
+    }
+  } catch (const EndOfFileException &e) {
+  }
+  pagesSkipped = fscan.pagesSkipped();
+  return numRecords;
+}
+
+void zoneMapTests() {
+  // Built from the relation when it is first opened
+  createRelationForward();
+  bufMgr->flushFile(file1);
+  std::string zoneMapName;
+  int pagesSkipped = 0;
+  {
+    HeapZoneMap zoneMap(relationName, bufMgr, offsetof(tuple, i), INTEGER);
+    zoneMapName = zoneMap.zoneMapName();
+    checkPassFail(zoneMapRangeScan(zoneMap, 1000, 1100, pagesSkipped), 100)
+    bool skipped = pagesSkipped > 0;
+    checkPassFail(skipped, true)
+
+    // Records updated and inserted through the zone map widen it
+    PageId firstPageNo = file1->begin().page_number();
+    Page *page;
+    bufMgr->readPage(file1, firstPageNo, page);
+    RecordId rid = page->begin().getCurrentRecord();
+    RECORD updated =
+        *reinterpret_cast<const RECORD *>(page->recordView(rid).data);
+    updated.i = -5;
+    std::string updatedStr(reinterpret_cast<char *>(&updated), sizeof(RECORD));
+    zoneMap.updateRecord(page, rid, updatedStr);
+    bufMgr->unPinPage(file1, firstPageNo, true);
+
+    PageId newPageNo;
+    bufMgr->allocPage(file1, newPageNo, page);
+    updated.i = relationSize * 2;
+    std::string insertedStr(reinterpret_cast<char *>(&updated), sizeof(RECORD));
+    zoneMap.insertRecord(page, insertedStr);
+    bufMgr->unPinPage(file1, newPageNo, true);
+    bufMgr->flushFile(file1);
+
+    checkPassFail(zoneMapRangeScan(zoneMap, -10, 0, pagesSkipped), 1)
+    checkPassFail(zoneMapRangeScan(zoneMap, relationSize * 2,
+                                   relationSize * 2 + 1, pagesSkipped), 1)
+  }
+
+  // Reopened from its file
+  {
+    HeapZoneMap zoneMap(relationName, bufMgr, offsetof(tuple, i), INTEGER);
+    bool summarized =
+        zoneMap.pageSummary(file1->begin().page_number()) != NULL;
+    checkPassFail(summarized, true)
+    checkPassFail(zoneMapRangeScan(zoneMap, -10, 0, pagesSkipped), 1)
+    checkPassFail(zoneMapRangeScan(zoneMap, 1000, 1100, pagesSkipped), 100)
+  }
+
+  // A record written behind the zone map's back makes it stale, it is
+  // rebuilt on open instead of skipping the page
+  {
+    PageId firstPageNo = file1->begin().page_number();
+    Page *page;
+    bufMgr->readPage(file1, firstPageNo, page);
+    RecordId rid = page->begin().getCurrentRecord();
+    RECORD updated =
+        *reinterpret_cast<const RECORD *>(page->recordView(rid).data);
+    updated.i = -100;
+    page->updateRecord(
+        rid, std::string(reinterpret_cast<char *>(&updated), sizeof(RECORD)));
+    bufMgr->unPinPage(file1, firstPageNo, true);
+    bufMgr->flushFile(file1);
+    HeapZoneMap zoneMap(relationName, bufMgr, offsetof(tuple, i), INTEGER);
+    checkPassFail(zoneMapRangeScan(zoneMap, -200, -50, pagesSkipped), 1)
+  }
+  try {
+    File::remove(zoneMapName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// insertTests
+// -----------------------------------------------------------------------------
+
+void insertTests() {
+  // Split temporaries come from an arena which stops growing once it is
+  // rewound and reused
+  {
+    Arena arena(1024);
+    bool aligned = true;
+    for (int round = 0; round < 2; round++) {
+      ArenaScope scope(arena);
+      for (int i = 0; i < 100; i++) {
+        arena.allocate(3, 1);
+        double *values = arena.allocateArray<double>(5);
+        aligned = aligned && (uintptr_t)values % alignof(double) == 0;
+      }
+      arena.allocate(4096);
+    }
+    checkPassFail(aligned, true)
+    std::size_t reserved = arena.bytesReserved();
+    {
+      ArenaScope scope(arena);
+      for (int i = 0; i < 100; i++) {
+        arena.allocateArray<double>(5);
+      }
+    }
+    checkPassFail(arena.bytesReserved(), reserved)
+  }
+
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+  file1 = new PageFile(relationName, true);
+
+  const Datatype types[] = {INTEGER, DOUBLE, STRING};
+  const int offsets[] = {offsetof(tuple, i), offsetof(tuple, d),
+                         offsetof(tuple, s)};
+  const Datatype type = types[testNum - 1];
+  std::string indexName;
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsets[testNum - 1],
+                     type);
+    std::vector<int> values(relationSize);
+    for (int i = 0; i < relationSize; i++) {
+      values[i] = i;
+    }
+    srand(1);
+    std::random_shuffle(values.begin(), values.end());
+    for (int i = 0; i < relationSize; i++) {
+      const int value = values[i];
+      RecordId rid = {(PageId)(value / 100 + 1), (SlotId)(value % 100 + 1)};
+      if (type == INTEGER) {
+        index.insertEntry(&value, rid);
+      } else if (type == DOUBLE) {
+        double key = value;
+        index.insertEntry(&key, rid);
+      } else {
+        char buffer[STRINGSIZE + 16];
+        sprintf(buffer, "%05d string record", value);
+        index.insertEntry(buffer, rid);
+      }
+    }
+
+    // Every entry is found again, in key order
+    std::vector<RecordId> rids;
+    int intLow = 25, intHigh = 40;
+    double doubleLow = 25, doubleHigh = 40;
+    char stringLow[STRINGSIZE + 1] = "00025 zzzz";
+    char stringHigh[STRINGSIZE + 1] = "00040";
+    IndexPredicate range = {&index, &intLow, GT, &intHigh, LT};
+    if (type == DOUBLE) {
+      range.lowVal = &doubleLow;
+      range.highVal = &doubleHigh;
+    } else if (type == STRING) {
+      range.lowVal = stringLow;
+      range.highVal = stringHigh;
+    }
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)14)
+    bool sameRids = true;
+    for (std::size_t r = 0; r < rids.size(); r++) {
+      const int value = 26 + r;
+      sameRids = sameRids && rids[r].page_number == (PageId)(value / 100 + 1) &&
+                 rids[r].slot_number == (SlotId)(value % 100 + 1);
+    }
+    checkPassFail(sameRids, true)
+
+    int intMax = relationSize;
+    double doubleMax = relationSize;
+    char stringMax[STRINGSIZE + 1] = "99999";
+    int intMin = -1;
+    double doubleMin = -1;
+    char stringMin[STRINGSIZE + 1] = "";
+    IndexPredicate all = {&index, &intMin, GT, &intMax, LT};
+    if (type == DOUBLE) {
+      all.lowVal = &doubleMin;
+      all.highVal = &doubleMax;
+    } else if (type == STRING) {
+      all.lowVal = stringMin;
+      all.highVal = stringMax;
+    }
+    rids.clear();
+    collectRids(all, rids);
+    checkPassFail(rids.size(), (std::size_t)relationSize)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// indexKeyTests
+// -----------------------------------------------------------------------------
+
+void indexKeyTests() {
+  // Keys of every type compare with memcmp in the order of their values
+  {
+    const int ints[] = {INT_MIN, -70000, -1, 0, 1, 255, 256, INT_MAX};
+    bool ordered = true;
+    bool decoded = true;
+    for (int i = 0; i < 8; i++) {
+      const IndexKey key = IndexKey::fromInt(ints[i]);
+      decoded = decoded && key.toInt() == ints[i];
+      if (i > 0) {
+        ordered = ordered && IndexKey::fromInt(ints[i - 1]) < key;
+      }
+    }
+    checkPassFail(ordered, true)
+    checkPassFail(decoded, true)
+
+    const double doubles[] = {-1e300, -2.5, -1e-300, 0, 1e-300, 0.75, 2.5,
+                              1e300};
+    ordered = true;
+    decoded = true;
+    for (int i = 0; i < 8; i++) {
+      const IndexKey key = IndexKey::fromDouble(doubles[i]);
+      decoded = decoded && key.toDouble() == doubles[i];
+      if (i > 0) {
+        ordered = ordered && IndexKey::fromDouble(doubles[i - 1]) < key;
+      }
+    }
+    checkPassFail(ordered, true)
+    checkPassFail(decoded, true)
+    bool zeroes =
+        IndexKey::fromDouble(-0.0).compare(IndexKey::fromDouble(0)) == 0;
+    checkPassFail(zeroes, true)
+
+    const char *strings[] = {"", "00025", "00025 zzzz", "0003", "a"};
+    ordered = true;
+    for (int i = 1; i < 5; i++) {
+      ordered = ordered && IndexKey::fromString(strings[i - 1]) <
+                               IndexKey::fromString(strings[i]);
+    }
+    checkPassFail(ordered, true)
+    // Only the first STRINGSIZE characters are part of the key
+    bool truncated = IndexKey::fromString("00025 string record")
+                         .compare(IndexKey::fromString("00025 stri")) == 0;
+    checkPassFail(truncated, true)
+    checkPassFail(IndexKey::fromString("00025 string record").length(),
+                  STRINGSIZE)
+  }
+
+  if (testNum == 3) {
+    return;
+  }
+
+  // Negative keys inserted one by one are found in order
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+  file1 = new PageFile(relationName, true);
+  const Datatype type = testNum == 1 ? INTEGER : DOUBLE;
+  const int offset = testNum == 1 ? offsetof(tuple, i) : offsetof(tuple, d);
+  std::string indexName;
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+    for (int i = 0; i < relationSize; i++) {
+      // Alternate signs so both halves of the tree grow
+      const int value = i % 2 ? -(i / 2) - 1 : i / 2;
+      RecordId rid = {(PageId)(i / 100 + 1), (SlotId)(i % 100 + 1)};
+      if (type == INTEGER) {
+        index.insertEntry(&value, rid);
+      } else {
+        index.insertEntry(IndexKey::fromDouble(value - 0.5), rid);
+      }
+    }
+    int intLow = -10, intHigh = 10;
+    double doubleLow = -10, doubleHigh = 10;
+    IndexPredicate range = {&index, &intLow, GTE, &intHigh, LT};
+    if (type == DOUBLE) {
+      range.lowVal = &doubleLow;
+      range.highVal = &doubleHigh;
+    }
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)20)
+    // Smallest key first: -10 inserted at i = 19, or -9.5 at i = 17
+    const PageId firstPage = 1;
+    const SlotId firstSlot = type == INTEGER ? 20 : 18;
+    bool first = !rids.empty() && rids[0].page_number == firstPage &&
+                 rids[0].slot_number == firstSlot;
+    checkPassFail(first, true)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// normalizedKeyTests
+// -----------------------------------------------------------------------------
+
+int typedScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal,
+              Operator highOp) {
+  if (testNum == 1) {
+    return intScan(index, lowVal, lowOp, highVal, highOp);
+  } else if (testNum == 2) {
+    return doubleScan(index, lowVal, lowOp, highVal, highOp);
+  }
+  return stringScan(index, lowVal, lowOp, highVal, highOp);
+}
+
+void normalizedKeyTests() {
+  createRelationRandom();
+  const Datatype types[] = {INTEGER, DOUBLE, STRING};
+  const int offsets[] = {offsetof(tuple, i), offsetof(tuple, d),
+                         offsetof(tuple, s)};
+  const Datatype type = types[testNum - 1];
+  std::string indexName;
+  {
+    // Bulk loaded
+    BTreeIndex index(relationName, indexName, bufMgr, offsets[testNum - 1],
+                     type, SLOTTED_RELATION, NORMALIZED_KEYS);
+    checkPassFail(typedScan(&index, 25, GT, 40, LT), 14)
+    checkPassFail(typedScan(&index, 20, GTE, 35, LTE), 16)
+    checkPassFail(typedScan(&index, -3, GT, 3, LT), 3)
+    checkPassFail(typedScan(&index, 996, GT, 1001, LT), 4)
+    checkPassFail(typedScan(&index, 3000, GTE, 4000, LT), 1000)
+
+    // Inserted one by one, splitting the nodes
+    for (int value = relationSize; value < 2 * relationSize; value++) {
+      RecordId rid = {(PageId)(value / 100 + 1), (SlotId)(value % 100 + 1)};
+      if (type == INTEGER) {
+        index.insertEntry(&value, rid);
+      } else if (type == DOUBLE) {
+        double key = value;
+        index.insertEntry(&key, rid);
+      } else {
+        char buffer[STRINGSIZE + 16];
+        sprintf(buffer, "%05d string record", value);
+        index.insertEntry(buffer, rid);
+      }
+    }
+  }
+  {
+    // The index keeps its key encoding when opened again
+    BTreeIndex index(relationName, indexName, bufMgr, offsets[testNum - 1],
+                     type);
+    int intLow = relationSize - 10, intHigh = relationSize + 10;
+    double doubleLow = intLow, doubleHigh = intHigh;
+    char stringLow[STRINGSIZE + 16];
+    char stringHigh[STRINGSIZE + 16];
+    sprintf(stringLow, "%05d", intLow);
+    sprintf(stringHigh, "%05d", intHigh);
+    IndexPredicate range = {&index, &intLow, GTE, &intHigh, LT};
+    if (type == DOUBLE) {
+      range.lowVal = &doubleLow;
+      range.highVal = &doubleHigh;
+    } else if (type == STRING) {
+      range.lowVal = stringLow;
+      range.highVal = stringHigh;
+    }
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)20)
+    bool inserted = rids.size() == 20 &&
+                    rids[10].page_number == (PageId)(relationSize / 100 + 1) &&
+                    rids[10].slot_number == (SlotId)(relationSize % 100 + 1);
+    checkPassFail(inserted, true)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// tryScanTests
+// -----------------------------------------------------------------------------
+
+void tryScanTests() {
+  createRelationForward();
+
+  // Hash table misses
+  {
+    BufHashTbl hashTable(7);
+    FrameId frameNo = 0;
+    hashTable.insert(file1, 3, 5);
+    bool found = hashTable.tryLookup(file1, 3, frameNo) && frameNo == 5;
+    checkPassFail(found, true)
+    bool missed = !hashTable.tryLookup(file1, 4, frameNo) && frameNo == 5;
+    checkPassFail(missed, true)
+    bool thrown = false;
+    try {
+      hashTable.lookup(file1, 4, frameNo);
+    } catch (const HashNotFoundException &e) {
+      thrown = true;
+    }
+    checkPassFail(thrown, true)
+  }
+
+  // Reads into a buffer pool whose frames are all pinned
+  {
+    BufMgr smallBufMgr(2);
+    FileIterator iter = file1->begin();
+    const PageId first = iter.page_number();
+    const PageId second = (++iter).page_number();
+    const PageId third = (++iter).page_number();
+    Page *page;
+    smallBufMgr.readPage(file1, first, page);
+    bool read = smallBufMgr.tryReadPage(file1, second, page) &&
+                page->page_number() == second;
+    checkPassFail(read, true)
+    bool full = !smallBufMgr.tryReadPage(file1, third, page);
+    checkPassFail(full, true)
+    bool thrown = false;
+    try {
+      smallBufMgr.readPage(file1, third, page);
+    } catch (const BufferExceededException &e) {
+      thrown = true;
+    }
+    checkPassFail(thrown, true)
+    smallBufMgr.unPinPage(file1, first, false);
+    bool freed = smallBufMgr.tryReadPage(file1, third, page) &&
+                 page->page_number() == third;
+    checkPassFail(freed, true)
+    smallBufMgr.unPinPage(file1, second, false);
+    smallBufMgr.unPinPage(file1, third, false);
+  }
+
+  // Relation scan, which keeps reporting its end
+  {
+    FileScan fscan(relationName, bufMgr);
+    RecordId rid;
+    int count = 0;
+    while (fscan.tryScanNext(rid)) {
+      count++;
+    }
+    checkPassFail(count, relationSize)
+    bool ended = !fscan.tryScanNext(rid);
+    checkPassFail(ended, true)
+  }
+
+  // Index scans, empty ranges included
+  std::string indexName;
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                     INTEGER);
+    RecordId rid;
+    int low = 25, high = 40;
+    bool started = index.tryStartScan(&low, GT, &high, LT);
+    int count = 0;
+    while (index.tryScanNext(rid)) {
+      count++;
+    }
+    index.endScan();
+    checkPassFail(started, true)
+    checkPassFail(count, 14)
+
+    // Between two keys, and above every key
+    low = 100;
+    high = 101;
+    bool between = !index.tryStartScan(&low, GT, &high, LT) &&
+                   !index.tryScanNext(rid);
+    index.endScan();
+    checkPassFail(between, true)
+    low = relationSize;
+    high = relationSize + 10;
+    bool above = !index.tryStartScan(&low, GTE, &high, LTE) &&
+                 !index.tryScanNext(rid);
+    checkPassFail(above, true)
+    bool thrown = false;
+    try {
+      index.startScan(&low, GTE, &high, LTE);
+    } catch (const NoSuchKeyFoundException &e) {
+      thrown = true;
+    }
+    index.endScan();
+    checkPassFail(thrown, true)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// sharedBufferTests
+// -----------------------------------------------------------------------------
+
+void sharedBufferTests() {
+  createRelationForward();
+  const std::string segmentName = "/badgerdb_test_pool";
+  SharedBufMgr::removeSegment(segmentName);
+  const PageId pageNo = file1->begin().page_number();
+  const int marker = -7;
+  Page *page;
+  {
+    SharedBufMgr parentMgr(segmentName, 16);
+    parentMgr.readPage(file1, pageNo, page);
+    const RecordId firstRid = page->begin().getCurrentRecord();
+    parentMgr.unPinPage(file1, pageNo, false);
+
+    // Another process finds the page cached and updates a record of it
+    const pid_t child = fork();
+    if (child == 0) {
+      int status = 1;
+      try {
+        SharedBufMgr childMgr(segmentName, 16);
+        childMgr.readPage(file1, pageNo, page);
+        std::string record = page->getRecord(firstRid);
+        memcpy(&record[offsetof(tuple, i)], &marker, sizeof(int));
+        page->updateRecord(firstRid, record);
+        childMgr.unPinPage(file1, pageNo, true);
+        status = childMgr.getBufStats().diskreads == 0 ? 0 : 2;
+      } catch (...) {
+      }
+      _exit(status);
+    }
+    int status = -1;
+    waitpid(child, &status, 0);
+    bool childHit = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    checkPassFail(childHit, true)
+
+    // The update is seen without going to disk
+    int value;
+    parentMgr.clearBufStats();
+    parentMgr.readPage(file1, pageNo, page);
+    memcpy(&value, page->getRecord(firstRid).data() + offsetof(tuple, i),
+           sizeof(int));
+    parentMgr.unPinPage(file1, pageNo, false);
+    bool seen = value == marker && parentMgr.getBufStats().diskreads == 0;
+    checkPassFail(seen, true)
+
+    // and written back by flushFile
+    parentMgr.flushFile(file1);
+    memcpy(&value,
+           file1->readPage(pageNo).getRecord(firstRid).data() +
+               offsetof(tuple, i),
+           sizeof(int));
+    checkPassFail(value, marker)
+
+    // A process dying with a page pinned does not keep it pinned
+    const pid_t crashed = fork();
+    if (crashed == 0) {
+      try {
+        SharedBufMgr childMgr(segmentName, 16);
+        childMgr.readPage(file1, pageNo, page);
+      } catch (...) {
+      }
+      _exit(0);
+    }
+    waitpid(crashed, &status, 0);
+    bool unpinned = true;
+    try {
+      parentMgr.flushFile(file1);
+    } catch (const PagePinnedException &e) {
+      unpinned = false;
+    }
+    checkPassFail(unpinned, true)
+
+    bool refused = false;
+    try {
+      SharedBufMgr otherSize(segmentName, 8);
+    } catch (const SharedSegmentException &e) {
+      refused = true;
+    }
+    checkPassFail(refused, true)
+  }
+  // The segment went away with its last process, so a new size is accepted
+  bool recreated = true;
+  try {
+    SharedBufMgr otherSize(segmentName, 8);
+  } catch (const SharedSegmentException &e) {
+    recreated = false;
+  }
+  checkPassFail(recreated, true)
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// snapshotTests
+// -----------------------------------------------------------------------------
+
+// Entries inserted by the test point past the relation
+const PageId SNAPSHOT_TEST_PAGE = 10000;
+
+int snapshotCount(BTreeSnapshot *snapshot, int lowVal, int highVal,
+                  bool &onlyOriginal) {
+  int count = 0;
+  RecordId rid;
+  onlyOriginal = true;
+  snapshot->tryStartScan(&lowVal, GTE, &highVal, LT);
+  while (snapshot->tryScanNext(rid)) {
+    onlyOriginal = onlyOriginal && rid.page_number < SNAPSHOT_TEST_PAGE;
+    count++;
+  }
+  snapshot->endScan();
+  return count;
+}
+
+void snapshotTests() {
+  createRelationForward();
+  std::string indexName;
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                     INTEGER);
+    int inserted = 0;
+    BTreeSnapshot *before = index.openSnapshot();
+
+    // Keys of the range are inserted while the snapshot scans it, splitting
+    // its leaves, and the root
+    int low = 1900, high = 2100;
+    int count = 0;
+    bool onlyOriginal = true;
+    bool ordered = true;
+    RecordId rid;
+    RecordId previous = {0, 0};
+    before->tryStartScan(&low, GTE, &high, LT);
+    while (before->tryScanNext(rid)) {
+      onlyOriginal = onlyOriginal && rid.page_number < SNAPSHOT_TEST_PAGE;
+      // The relation was written in key order
+      ordered = ordered && (rid.page_number > previous.page_number ||
+                            (rid.page_number == previous.page_number &&
+                             rid.slot_number > previous.slot_number));
+      previous = rid;
+      count++;
+      for (int i = 0; i < 60; i++, inserted++) {
+        const int key = low + inserted % (high - low);
+        RecordId newRid = {(PageId)(SNAPSHOT_TEST_PAGE + inserted / 100),
+                           (SlotId)(inserted % 100 + 1)};
+        index.insertEntry(&key, newRid);
+      }
+    }
+    before->endScan();
+    checkPassFail(count, high - low)
+    checkPassFail(onlyOriginal, true)
+    checkPassFail(ordered, true)
+
+    // A second snapshot sees the inserts, the first one still doesn't
+    BTreeSnapshot *after = index.openSnapshot();
+    for (int i = 0; i < 500; i++, inserted++) {
+      const int key = i;
+      RecordId newRid = {(PageId)(SNAPSHOT_TEST_PAGE + inserted / 100),
+                         (SlotId)(inserted % 100 + 1)};
+      index.insertEntry(&key, newRid);
+    }
+    checkPassFail(snapshotCount(before, low, high, onlyOriginal), high - low)
+    checkPassFail(snapshotCount(after, 0, relationSize, onlyOriginal),
+                  relationSize + inserted - 500)
+    delete before;
+    checkPassFail(snapshotCount(after, 0, relationSize, onlyOriginal),
+                  relationSize + inserted - 500)
+    delete after;
+
+    // Without snapshots the index is updated in place again
+    int key = 0;
+    RecordId newRid = {SNAPSHOT_TEST_PAGE, 1};
+    index.insertEntry(&key, newRid);
+    int zero = 0, one = 1;
+    IndexPredicate range = {&index, &zero, GTE, &one, LT};
+    std::vector<RecordId> rids;
+    collectRids(range, rids);
+    checkPassFail(rids.size(), (std::size_t)3)
+  }
+
+  // Copies of closed snapshots are reused once the index is opened again,
+  // rather than growing its file
+  std::ifstream::pos_type sizes[2];
+  for (int round = 0; round < 2; round++) {
+    {
+      BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                       INTEGER);
+      BTreeSnapshot *snapshot = index.openSnapshot();
+      for (int i = 0; i < 10; i++) {
+        const int key = 2510 + i * 250;
+        RecordId newRid = {(PageId)(SNAPSHOT_TEST_PAGE + 1 + round),
+                           (SlotId)(i + 1)};
+        index.insertEntry(&key, newRid);
+      }
+      delete snapshot;
+    }
+    std::ifstream indexFile(indexName, std::ios::binary | std::ios::ate);
+    sizes[round] = indexFile.tellg();
+  }
+  bool reused = sizes[1] == sizes[0];
+  checkPassFail(reused, true)
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// appendOnlyTests
+// -----------------------------------------------------------------------------
+
+int rangeCount(BTreeIndex &index, int lowVal, int highVal) {
+  IndexPredicate range = {&index, &lowVal, GTE, &highVal, LT};
+  std::vector<RecordId> rids;
+  collectRids(range, rids);
+  return rids.size();
+}
+
+void appendOnlyTests() {
+  createRelationForward();
+  std::string indexName;
+  int inserted = 0;
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                     INTEGER, SLOTTED_RELATION, NATIVE_KEYS,
+                     APPEND_ONLY_STORAGE);
+    // Inserts copy the leaves the snapshot reads, and split them
+    BTreeSnapshot *snapshot = index.openSnapshot();
+    for (; inserted < 2000; inserted++) {
+      const int key = inserted;
+      RecordId newRid = {(PageId)(SNAPSHOT_TEST_PAGE + inserted / 100),
+                         (SlotId)(inserted % 100 + 1)};
+      index.insertEntry(&key, newRid);
+    }
+    bool onlyOriginal = true;
+    checkPassFail(snapshotCount(snapshot, 0, relationSize, onlyOriginal),
+                  relationSize)
+    checkPassFail(onlyOriginal, true)
+    delete snapshot;
+    checkPassFail(rangeCount(index, 0, relationSize), relationSize + 2000)
+
+    // A scan open across the commit goes on from the entry it was on
+    int lowVal = 0;
+    int highVal = relationSize;
+    index.startScan(&lowVal, GTE, &highVal, LT);
+    RecordId scanRid;
+    int scanned = 0;
+    for (; scanned < 10; scanned++) {
+      index.scanNext(scanRid);
+    }
+    index.commit();
+    try {
+      while (true) {
+        index.scanNext(scanRid);
+        scanned++;
+      }
+    } catch (const IndexScanCompletedException &e) {
+    }
+    index.endScan();
+    checkPassFail(scanned, relationSize + 2000)
+
+    // Left uncommitted until the index is closed
+    for (; inserted < 3000; inserted++) {
+      const int key = inserted;
+      RecordId newRid = {(PageId)(SNAPSHOT_TEST_PAGE + inserted / 100),
+                         (SlotId)(inserted % 100 + 1)};
+      index.insertEntry(&key, newRid);
+    }
+    checkPassFail(rangeCount(index, 0, relationSize), relationSize + 3000)
+  }
+
+  // Tear the write of the last meta page, the commit before it is opened
+  {
+    BlobFile indexFile(indexName, false);
+    const Page first = indexFile.readPage(1);
+    const Page second = indexFile.readPage(2);
+    const bool secondIsLast = ((const IndexMetaInfo *)&second)->txnId >
+                              ((const IndexMetaInfo *)&first)->txnId;
+    indexFile.writePage(secondIsLast ? 2 : 1, Page());
+  }
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                     INTEGER);
+    checkPassFail(rangeCount(index, 0, relationSize), relationSize + 2000)
+    checkPassFail(rangeCount(index, 2000, 3000), 1000)
+  }
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                     INTEGER);
+    checkPassFail(rangeCount(index, 0, relationSize), relationSize + 2000)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// deferredIndexTests
+// -----------------------------------------------------------------------------
+
+void deferredIndexTests() {
+  createRelationForward();
+  std::string indexName;
+  {
+    // The thread of the index has a buffer manager to itself
+    BufMgr indexBufMgr(100);
+    BTreeIndex index(relationName, indexName, &indexBufMgr, offsetof(tuple, i),
+                     INTEGER);
+    {
+      DeferredIndex deferred(&index, 64);
+      for (int inserted = 0; inserted < 2000; inserted++) {
+        const int key = inserted;
+        RecordId newRid = {(PageId)(SNAPSHOT_TEST_PAGE + inserted / 100),
+                           (SlotId)(inserted % 100 + 1)};
+        deferred.insertEntry(&key, newRid);
+      }
+      // Inserts are seen whether they were applied or not
+      int low = 0, high = relationSize;
+      std::vector<RecordId> rids;
+      deferred.collectRids(&low, GTE, &high, LT, rids);
+      checkPassFail(rids.size(), (std::size_t)(relationSize + 2000))
+      low = 100;
+      high = 100;
+      rids.clear();
+      deferred.collectRids(&low, GTE, &high, LTE, rids);
+      // In either order, as in the index
+      bool bothFound =
+          rids.size() == 2 &&
+          (rids[0].page_number < SNAPSHOT_TEST_PAGE) !=
+              (rids[1].page_number < SNAPSHOT_TEST_PAGE);
+      checkPassFail(bothFound, true)
+
+      deferred.flush();
+      checkPassFail(deferred.queued(), (std::size_t)0)
+    }
+    checkPassFail(rangeCount(index, 0, relationSize), relationSize + 2000)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// partitionedIndexTests
+// -----------------------------------------------------------------------------
+
+int partitionedCount(PartitionedIndex &index, int lowVal, int highVal,
+                     bool &ordered) {
+  std::vector<RecordId> rids;
+  index.collectRids(&lowVal, GTE, &highVal, LT, rids);
+  // The relation was written in key order
+  ordered = true;
+  for (std::size_t i = 1; i < rids.size(); i++) {
+    ordered = ordered && (rids[i].page_number > rids[i - 1].page_number ||
+                          (rids[i].page_number == rids[i - 1].page_number &&
+                           rids[i].slot_number > rids[i - 1].slot_number));
+  }
+  return rids.size();
+}
+
+void partitionedIndexTests() {
+  createRelationForward();
+  std::vector<IndexKey> boundaries;
+  boundaries.push_back(IndexKey::fromInt(1000));
+  boundaries.push_back(IndexKey::fromInt(2500));
+  boundaries.push_back(IndexKey::fromInt(4000));
+  bool ordered = false;
+  {
+    PartitionedIndex index(relationName, bufMgr, offsetof(tuple, i), INTEGER,
+                           boundaries);
+    checkPassFail(index.numPartitions(), (std::size_t)4)
+    checkPassFail(partitionedCount(index, 0, relationSize, ordered),
+                  relationSize)
+    checkPassFail(ordered, true)
+    checkPassFail(partitionedCount(index, 900, 1100, ordered), 200)
+
+    const int key = 3000;
+    RecordId rid = {SNAPSHOT_TEST_PAGE, 1};
+    index.insertEntry(&key, rid);
+    checkPassFail(rangeCount(*index.partition(2), 3000, 3001), 2)
+
+    index.dropPartition(0);
+    checkPassFail(partitionedCount(index, 0, relationSize, ordered),
+                  relationSize - 1000 + 1)
+
+    // Rebuilt in a file of its own which then takes the partition's place
+    std::vector<RIDKeyPair<IndexKey> > entries;
+    for (int i = 1000; i < 1500; i++) {
+      RIDKeyPair<IndexKey> entry;
+      entry.set({(PageId)(i / 100 + 1), (SlotId)(i % 100 + 1)},
+                IndexKey::fromInt(i));
+      entries.push_back(entry);
+    }
+    index.rebuildPartition(1, entries);
+    checkPassFail(partitionedCount(index, 0, 2500, ordered), 500)
+    checkPassFail(ordered, true)
+    std::ostringstream partitionName;
+    partitionName << relationName << "." << offsetof(tuple, i) << ".p1";
+    bool swapped = File::exists(partitionName.str()) &&
+                   !File::exists(partitionName.str() + ".new") &&
+                   !File::exists(partitionName.str() + ".old");
+    checkPassFail(swapped, true)
+  }
+  {
+    // Opened from the partition files
+    PartitionedIndex index(relationName, bufMgr, offsetof(tuple, i), INTEGER,
+                           boundaries);
+    checkPassFail(partitionedCount(index, 0, relationSize, ordered),
+                  relationSize - 2500 + 1 + 500)
+  }
+  for (std::size_t k = 0; k <= boundaries.size(); k++) {
+    std::ostringstream indexName;
+    indexName << relationName << "." << offsetof(tuple, i) << ".p" << k;
+    try {
+      File::remove(indexName.str());
+    } catch (const FileNotFoundException &e) {
+    }
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// parallelScanTests
+// -----------------------------------------------------------------------------
+
+void parallelScanTests() {
+  createRelationForward();
+  std::string indexName;
+  {
+    BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                     INTEGER);
+    WorkStealingPool pool(4);
+    int low = 100, high = 4900;
+    std::vector<IndexKey> cuts;
+    index.splitRange(&low, &high, 4, cuts);
+    bool increasing = !cuts.empty() && cuts.size() < 4 &&
+                      cuts[0].toInt() > low &&
+                      cuts.back().toInt() <= high;
+    for (std::size_t i = 1; i < cuts.size(); i++) {
+      increasing = increasing && cuts[i - 1] < cuts[i];
+    }
+    checkPassFail(increasing, true)
+
+    // In key order across the sub-ranges
+    std::vector<int> keys;
+    index.parallelScan(
+        &low, GTE, &high, LT, 4, pool, ORDERED_DELIVERY,
+        [&keys](const std::size_t subrange,
+                const std::vector<RIDKeyPair<IndexKey> > &entries) {
+          for (std::size_t i = 0; i < entries.size(); i++) {
+            keys.push_back(entries[i].key.toInt());
+          }
+        });
+    bool sequential = keys.size() == (std::size_t)(high - low);
+    for (std::size_t i = 0; sequential && i < keys.size(); i++) {
+      sequential = keys[i] == low + (int)i;
+    }
+    checkPassFail(sequential, true)
+
+    // Each sub-range aggregated on its own, concurrently
+    std::vector<long> sums(cuts.size() + 1, 0);
+    index.parallelScan(
+        &low, GT, &high, LTE, 4, pool, UNORDERED_DELIVERY,
+        [&sums](const std::size_t subrange,
+                const std::vector<RIDKeyPair<IndexKey> > &entries) {
+          for (std::size_t i = 0; i < entries.size(); i++) {
+            sums[subrange] += entries[i].key.toInt();
+          }
+        });
+    long total = 0;
+    for (std::size_t i = 0; i < sums.size(); i++) {
+      total += sums[i];
+    }
+    checkPassFail(total, (long)(low + 1 + high) * (high - low) / 2)
+
+    // The index is back on its own buffer manager
+    checkPassFail(rangeCount(index, 0, relationSize), relationSize)
+  }
+  try {
+    File::remove(indexName);
+  } catch (const FileNotFoundException &e) {
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// schedulerTests
+// -----------------------------------------------------------------------------
+
+void schedulerTests() {
+  {
+    // A single thread, busy while the tasks are queued, runs the foreground
+    // ones first
+    WorkStealingPool pool(1, 1);
+    TaskGroup group(pool);
+    std::mutex gate;
+    std::mutex latch;
+    std::vector<TaskPriority> order;
+    gate.lock();
+    group.submit([&gate]() { std::lock_guard<std::mutex> lock(gate); });
+    const TaskPriority submitted[] = {MAINTENANCE_TASK, BACKGROUND_IO_TASK,
+                                      FOREGROUND_TASK};
+    for (int i = 0; i < 3; i++) {
+      const TaskPriority priority = submitted[i];
+      group.submit([&latch, &order, priority]() {
+        std::lock_guard<std::mutex> lock(latch);
+        order.push_back(priority);
+      }, priority);
+    }
+    gate.unlock();
+    // Left to the pool's thread, the waiting thread would run them itself
+    for (int i = 0; i < 1000; i++) {
+      std::lock_guard<std::mutex> lock(latch);
+      if (order.size() == 3) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    group.wait();
+    bool byPriority = order.size() == 3 && order[0] == FOREGROUND_TASK &&
+                      order[1] == BACKGROUND_IO_TASK &&
+                      order[2] == MAINTENANCE_TASK;
+    checkPassFail(byPriority, true)
+  }
+  {
+    // One of the two threads is kept for the foreground
+    WorkStealingPool pool(2, 1);
+    TaskGroup group(pool);
+    std::mutex latch;
+    int running = 0, mostRunning = 0, finished = 0;
+    for (int i = 0; i < 4; i++) {
+      group.submit([&]() {
+        {
+          std::lock_guard<std::mutex> lock(latch);
+          mostRunning = std::max(mostRunning, ++running);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lock(latch);
+        running--;
+        finished++;
+      }, MAINTENANCE_TASK);
+    }
+    // Left to the pool's threads, the waiting thread would run some itself
+    for (int i = 0; i < 1000; i++) {
+      std::lock_guard<std::mutex> lock(latch);
+      if (finished == 4) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    group.wait();
+    checkPassFail(mostRunning, 1)
+
+    bool thrown = false;
+    group.submit([]() { throw BadScanrangeException(); });
+    try {
+      group.wait();
+    } catch (const BadScanrangeException &e) {
+      thrown = true;
+    }
+    checkPassFail(thrown, true)
+
+    std::vector<RIDKeyPair<IndexKey> > entries(100000);
+    for (std::size_t i = 0; i < entries.size(); i++) {
+      RecordId rid = {(PageId)(i / 100 + 1), (SlotId)(i % 100 + 1)};
+      entries[i].set(rid, IndexKey::fromInt((int)(i * 7919 % 100003)));
+    }
+    BTreeIndex::sortEntries(entries, pool);
+    bool sorted = std::is_sorted(entries.begin(), entries.end());
+    checkPassFail(sorted, true)
+  }
+  {
+    // A single thread is kept for the foreground, its background tasks are
+    // run by the thread waiting for them
+    WorkStealingPool pool(1);
+    TaskGroup group(pool);
+    std::thread::id ranOn;
+    group.submit([&ranOn]() { ranOn = std::this_thread::get_id(); },
+                 MAINTENANCE_TASK);
+    group.wait();
+    bool waiterRan = ranOn == std::this_thread::get_id();
+    checkPassFail(waiterRan, true)
+
+    // A task of the pool waits for tasks it submits, on the pool's only
+    // thread
+    int done = 0;
+    group.submit([&pool, &done]() {
+      TaskGroup inner(pool);
+      for (int i = 0; i < 4; i++) {
+        inner.submit([&done]() { done++; });
+      }
+      inner.wait();
+    });
+    group.wait();
+    checkPassFail(done, 4)
+  }
+
+  // A page dirtied through a LatchedBufMgr is written back by a background
+  // task and stays cached
+  createRelationForward();
+  const PageId pageNo = file1->begin().page_number();
+  const int marker = -9;
+  {
+    BufMgr poolBufMgr(16);
+    LatchedBufMgr latchedBufMgr(&poolBufMgr);
+    WorkStealingPool pool(2);
+    TaskGroup group(pool);
+    Page *page;
+    latchedBufMgr.readPage(file1, pageNo, page);
+    const RecordId firstRid = page->begin().getCurrentRecord();
+    std::string record = page->getRecord(firstRid);
+    memcpy(&record[offsetof(tuple, i)], &marker, sizeof(int));
+    page->updateRecord(firstRid, record);
+    latchedBufMgr.unPinPage(file1, pageNo, true);
+    latchedBufMgr.writeBackInBackground(file1, group);
+    group.wait();
+
+    int value;
+    memcpy(&value,
+           file1->readPage(pageNo).getRecord(firstRid).data() +
+               offsetof(tuple, i),
+           sizeof(int));
+    poolBufMgr.clearBufStats();
+    latchedBufMgr.readPage(file1, pageNo, page);
+    latchedBufMgr.unPinPage(file1, pageNo, false);
+    bool written = value == marker && poolBufMgr.getBufStats().diskreads == 0;
+    checkPassFail(written, true)
+    latchedBufMgr.flushFile(file1);
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// asyncIndexTests
+// -----------------------------------------------------------------------------
+
+void asyncIndexTests() {
+  createRelationForward();
+  const IndexStorage storages[] = {IN_PLACE_STORAGE, APPEND_ONLY_STORAGE};
+  for (int s = 0; s < 2; s++) {
+    std::string indexName;
+    {
+      BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple, i),
+                       INTEGER, SLOTTED_RELATION, NATIVE_KEYS, storages[s]);
+      // Written out and dropped from the pool, every page is a miss once
+      index.commit();
+      WorkStealingPool pool(2);
+      {
+        AsyncIndex async(&index, pool);
+        // Many lookups in flight on a single thread, one of them absent
+        std::vector<int> found(relationSize + 1, -1);
+        for (int key = 0; key <= relationSize; key += 7) {
+          async.lookup(&key,
+                       [&found, key](const std::vector<RecordId> &rids) {
+                         found[key] = (int)rids.size();
+                       });
+        }
+        async.run();
+        bool matched = true;
+        for (int key = 0; key <= relationSize; key += 7) {
+          matched = matched && found[key] == (key < relationSize ? 1 : 0);
+        }
+        checkPassFail(matched, true)
+        bool suspended = async.misses() > 0;
+        checkPassFail(suspended, true)
+
+        // A cursor fetching the next entry from its callback
+        int low = 100, high = 4900;
+        AsyncCursor cursor(async, &low, GTE, &high, LT);
+        std::vector<int> keys;
+        AsyncCursor::NextCallback onNext = [&](const bool more,
+                                               const RecordId &rid,
+                                               const IndexKey &key) {
+          if (more) {
+            keys.push_back(key.toInt());
+            cursor.next(onNext);
+          }
+        };
+        cursor.next(onNext);
+        async.run();
+        bool sequential = keys.size() == (std::size_t)(high - low);
+        for (std::size_t i = 0; sequential && i < keys.size(); i++) {
+          sequential = keys[i] == low + (int)i;
+        }
+        checkPassFail(sequential, true)
+      }
+      // The index kept reading through its own buffer manager
+      checkPassFail(rangeCount(index, 0, relationSize), relationSize)
+    }
+    {
+      // A pool of a few frames: the page a lookup waited for is handed to it
+      // pinned, so the other lookups cannot evict it before it resumes
+      BufMgr smallMgr(4);
+      BTreeIndex index(relationName, indexName, &smallMgr,
+                       offsetof(tuple, i), INTEGER);
+      WorkStealingPool pool(2);
+      AsyncIndex async(&index, pool);
+      int completed = 0;
+      bool matched = true;
+      std::function<void(int)> lookupFrom = [&](const int key) {
+        async.lookup(&key, [&, key](const std::vector<RecordId> &rids) {
+          completed++;
+          matched = matched && rids.size() == 1;
+          if (key + 500 < relationSize) {
+            lookupFrom(key + 500);
+          }
+        });
+      };
+      lookupFrom(0);
+      lookupFrom(250);
+      async.run();
+      checkPassFail(completed, relationSize / 250)
+      checkPassFail(matched, true)
+    }
+    try {
+      File::remove(indexName);
+    } catch (const FileNotFoundException& e) {
+    }
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// bulkLoaderTests
+// -----------------------------------------------------------------------------
+
+void bulkLoaderTests() {
+  // A page packed by a PageBuilder reads like one filled with insertRecord
+  {
+    Page page;
+    PageBuilder builder;
+    builder.start(&page);
+    std::vector<std::string> records;
+    for (int i = 0;; i++) {
+      std::string record(100, 'a' + i % 26);
+      if (!builder.add(record.data(), record.length())) {
+        break;
+      }
+      records.push_back(record);
+    }
+    bool filled = records.size() > 1;
+    checkPassFail(filled, true)
+    checkPassFail(builder.numRecords(), records.size())
+    std::size_t sameRecords = 0;
+    for (PageIterator iter = page.begin(); iter != page.end(); ++iter) {
+      if (sameRecords < records.size() && *iter == records[sameRecords]) {
+        sameRecords++;
+      }
+    }
+    checkPassFail(sameRecords, records.size())
+    bool full = page.getFreeSpace() < 100 + sizeof(PageSlot);
+    checkPassFail(full, true)
+  }
+
+  // Pages are appended after the ones already in the file
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+  file1 = new PageFile(relationName, true);
+  memset(record1.s, ' ', sizeof(record1.s));
+  {
+    PageId pageNo;
+    Page page = file1->allocatePage(pageNo);
+    record1.i = -1;
+    page.insertRecord(std::string(reinterpret_cast<char *>(&record1),
+                                  sizeof(record1)));
+    file1->writePage(pageNo, page);
+  }
+  BulkLoader loader(file1, 4);
+  for (int i = 0; i < relationSize; i++) {
+    sprintf(record1.s, "%05d string record", i);
+    record1.i = i;
+    record1.d = (double)i;
+    loader.append(reinterpret_cast<char *>(&record1), sizeof(record1));
+  }
+  loader.flush();
+  bool severalExtents = loader.pagesWritten() > 4;
+  checkPassFail(severalExtents, true)
+  std::size_t numPages = 0;
+  for (FileIterator iter = file1->begin(); iter != file1->end(); ++iter) {
+    numPages++;
+  }
+  checkPassFail(numPages, loader.pagesWritten() + 1)
+
+  // Records come back in the order they were appended
+  {
+    FileScan fscan(relationName, bufMgr);
+    int expected = -1;
+    bool ordered = true;
+    try {
+      RecordId scanRid;
+      while (1) {
+        fscan.scanNext(scanRid);
+        std::string recordStr = fscan.getRecord();
+        const RECORD *rec = reinterpret_cast<const RECORD *>(recordStr.data());
+        ordered = ordered && rec->i == expected++;
+      }
+    } catch (const EndOfFileException &e) {
+    }
+    checkPassFail(ordered, true)
+    checkPassFail(expected, relationSize)
+  }
+
+  // A record larger than a page is refused
+  {
+    BulkLoader tooLarge(file1);
+    bool thrown = false;
+    try {
+      tooLarge.append(std::string(Page::DATA_SIZE + 1, 'x'));
+    } catch (const InsufficientSpaceException &e) {
+      thrown = true;
+    }
+    checkPassFail(thrown, true)
+  }
+  deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// headArrayTests
+// -----------------------------------------------------------------------------
+
+void headArrayTests() {
+  try {
+    File::remove(relationName);
+  } catch (const FileNotFoundException &e) {
+  }
+  file1 = new PageFile(relationName, true);
+
+  // Enough keys for several leaves. Many of them share their first 4 bytes,
+  // so inner nodes also have to compare whole keys within a head.
+  const int numKeys = 20000;
+  std::vector<double> doubleKeys(numKeys);
+  std::vector<std::string> stringKeys(numKeys);
+  for (int k = 0; k < numKeys; k++) {
+    doubleKeys[k] = (k % 40 - 20) * 1000.0 + k * 1e-6;
+    char buffer[STRINGSIZE + 16];
+    if (k % 1000 == 0) {
+      // A prefix of the keys sharing its head
+      sprintf(buffer, "%04d", k / 1000);
+    } else {
+      sprintf(buffer, "%04d%06d", k % 40, k);
+    }
+    stringKeys[k] = buffer;
+  }
+
+  const Datatype types[] = {DOUBLE, STRING};
+  for (int t = 0; t < 2; t++) {
+    const Datatype type = types[t];
+    std::vector<int> order(numKeys);
+    for (int k = 0; k < numKeys; k++) {
+      order[k] = k;
+    }
+    srand(1);
+    std::random_shuffle(order.begin(), order.end());
+
+    std::string indexName;
+    {
+      BTreeIndex index(relationName, indexName, bufMgr,
+                       type == DOUBLE ? offsetof(tuple, d) : offsetof(tuple, s),
+                       type);
+      for (int i = 0; i < numKeys; i++) {
+        const int k = order[i];
+        RecordId rid = {(PageId)(k / 100 + 1), (SlotId)(k % 100 + 1)};
+        if (type == DOUBLE) {
+          index.insertEntry(&doubleKeys[k], rid);
+        } else {
+          index.insertEntry(stringKeys[k].c_str(), rid);
+        }
+      }
+
+      // The keys in order, as a naive sort gives them
+      if (type == DOUBLE) {
+        std::sort(order.begin(), order.end(), [&](const int a, const int b) {
+          return doubleKeys[a] < doubleKeys[b];
+        });
+      } else {
+        std::sort(order.begin(), order.end(), [&](const int a, const int b) {
+          return stringKeys[a] < stringKeys[b];
+        });
+      }
+      std::function<const void *(int)> keyAt = [&](const int k) {
+        return type == DOUBLE ? (const void *)&doubleKeys[k]
+                              : (const void *)stringKeys[k].c_str();
+      };
+      std::function<bool(const std::vector<RecordId> &, int, int)>
+          sameRids = [&](const std::vector<RecordId> &rids, const int first,
+                         const int last) {
+            bool same = rids.size() == (std::size_t)(last - first);
+            for (int i = first; same && i < last; i++) {
+              const int k = order[i];
+              const RecordId &rid = rids[i - first];
+              same = rid.page_number == (PageId)(k / 100 + 1) &&
+                     rid.slot_number == (SlotId)(k % 100 + 1);
+            }
+            return same;
+          };
+
+      // Every key is found on its own
+      bool found = true;
+      for (int k = 0; k < numKeys; k++) {
+        IndexPredicate point = {&index, keyAt(k), GTE, keyAt(k), LTE};
+        std::vector<RecordId> rids;
+        collectRids(point, rids);
+        found = found && rids.size() == 1 &&
+                rids[0].page_number == (PageId)(k / 100 + 1) &&
+                rids[0].slot_number == (SlotId)(k % 100 + 1);
+      }
+      checkPassFail(found, true)
+
+      // Ranges between keys, bounds included or not
+      bool ranges = true;
+      for (int r = 0; r < 50; r++) {
+        int first = rand() % numKeys;
+        int last = rand() % numKeys;
+        if (first == last) {
+          continue;
+        } else if (first > last) {
+          std::swap(first, last);
+        }
+        std::vector<RecordId> rids;
+        IndexPredicate range = {&index, keyAt(order[first]), GTE,
+                                keyAt(order[last]), LT};
+        collectRids(range, rids);
+        ranges = ranges && sameRids(rids, first, last);
+        rids.clear();
+        IndexPredicate open = {&index, keyAt(order[first]), GT,
+                               keyAt(order[last]), LTE};
+        collectRids(open, rids);
+        ranges = ranges && sameRids(rids, first + 1, last + 1);
+      }
+      checkPassFail(ranges, true)
+    }
+
+    // Deep enough for inner nodes
+    {
+      BlobFile indexFile(indexName, false);
+      const Page meta = indexFile.readPage(1);
+      checkPassFail(((const IndexMetaInfo *)&meta)->isRootLeaf, false)
+    }
+    try {
+      File::remove(indexName);
+    } catch (const FileNotFoundException &e) {
+    }
+  }
+  deleteRelation();
+}
+
 void deleteRelation() {
   if (file1) {
     bufMgr->flushFile(file1);
@@ -5,7 +5,9 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include <iostream>
 #include "exceptions/insufficient_space_exception.h"
@@ -27,6 +29,8 @@ void Page::initialize() {
   header_.free_space_upper_bound = DATA_SIZE;
   header_.num_slots = 0;
   header_.num_free_slots = 0;
+  header_.first_free_slot = INVALID_SLOT;
+  header_.fragmented_bytes = 0;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
   //data_.assign(DATA_SIZE, char());
@@ -38,83 +42,81 @@ RecordId Page::insertRecord(const std::string& record_data) {
     throw InsufficientSpaceException(
         page_number(), record_data.length(), getFreeSpace());
   }
+  std::size_t record_size = record_data.length();
+  if (header_.num_free_slots == 0) {
+    record_size += sizeof(PageSlot);
+  }
+  reserveContiguousSpace(record_size);
   const SlotId slot_number = getAvailableSlot();
   insertRecordInSlot(slot_number, record_data);
   return {page_number(), slot_number};
 }
 
 std::string Page::getRecord(const RecordId& record_id) const {
+  return recordView(record_id).toString();
+}
+
+RecordView Page::recordView(const RecordId& record_id) const {
   validateRecordId(record_id);
   const PageSlot& slot = getSlot(record_id.slot_number);
-	std::string retStr = std::string(data_, DATA_SIZE).substr(slot.item_offset, slot.item_length);
-
-	return retStr;
+  const RecordView view = {&data_[slot.item_offset], slot.item_length};
+  return view;
 }
 
 void Page::updateRecord(const RecordId& record_id,
                         const std::string& record_data) {
   validateRecordId(record_id);
-  const PageSlot* slot = getSlot(record_id.slot_number);
+  PageSlot* slot = getSlot(record_id.slot_number);
+  const std::uint16_t record_length = record_data.length();
+  if (record_length <= slot->item_length) {
+    // Overwrite in place, the tail of the old record becomes fragmented.
+    memcpy(&data_[slot->item_offset], record_data.data(), record_length);
+    releaseData(slot->item_offset + record_length,
+                slot->item_length - record_length);
+    slot->item_length = record_length;
+    return;
+  }
   const std::size_t free_space_after_delete =
       getFreeSpace() + slot->item_length;
   if (record_data.length() > free_space_after_delete) {
     throw InsufficientSpaceException(
         page_number(), record_data.length(), free_space_after_delete);
   }
-  // We have to disallow slot compaction here because we're going to place the
-  // record data in the same slot, and compaction might delete the slot if we
-  // permit it.
-  deleteRecord(record_id, false /* allow_slot_compaction */);
-  insertRecordInSlot(record_id.slot_number, record_data);
+  // The slot keeps its number but gives up its data before the page is
+  // compacted, so compaction can reuse those bytes.
+  releaseData(slot->item_offset, slot->item_length);
+  slot->item_length = 0;
+  reserveContiguousSpace(record_length);
+  slot->item_length = record_length;
+  slot->item_offset = header_.free_space_upper_bound - record_length;
+  header_.free_space_upper_bound = slot->item_offset;
+  memcpy(&data_[slot->item_offset], record_data.data(), record_length);
 }
 
 void Page::deleteRecord(const RecordId& record_id) {
-  deleteRecord(record_id, true /* allow_slot_compaction */);
-}
-
-void Page::deleteRecord(const RecordId& record_id,
-                        const bool allow_slot_compaction) {
   validateRecordId(record_id);
   PageSlot* slot = getSlot(record_id.slot_number);
+  releaseData(slot->item_offset, slot->item_length);
 
-	for(int i = 0; i < slot->item_length; i++)
-		data_[i + slot->item_offset] = '\0';
-
-  //data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
-
-  // Compact the data by removing the hole left by this record (if necessary).
-  std::uint16_t move_offset = slot->item_offset; 
-  std::size_t move_bytes = 0;
-  for (SlotId i = 1; i <= header_.num_slots; ++i) {
-    PageSlot* other_slot = getSlot(i);
-    if (other_slot->used && other_slot->item_offset < slot->item_offset) {
-      if (other_slot->item_offset < move_offset) {
-        move_offset = other_slot->item_offset;
-      }
-      move_bytes += other_slot->item_length;
-      // Update the slot for the other data to reflect the soon-to-be-new
-      // location.
-      other_slot->item_offset += slot->item_length;
-    }
-  }
-  // If we have data to move, shift it to the right.
-  if (move_bytes > 0) {
-    const std::string& data_to_move = std::string(data_, DATA_SIZE).substr(move_offset, move_bytes);
-
-		for(std::uint16_t i = 0; i < move_bytes; i++)
-			data_[i + move_offset + slot->item_length] = data_to_move[i];
-
-    //data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
-  }
-  header_.free_space_upper_bound += slot->item_length;
-
-  // Mark slot as unused.
+  // Mark slot as unused and put it at the head of the free slot list.
   slot->used = false;
-  slot->item_offset = 0;
+  slot->item_offset = header_.first_free_slot;
   slot->item_length = 0;
+  header_.first_free_slot = record_id.slot_number;
   ++header_.num_free_slots;
 
-  if (allow_slot_compaction && record_id.slot_number == header_.num_slots) {
+  if (header_.num_free_slots == header_.num_slots) {
+    // No record left, start over with an empty page.
+    header_.free_space_lower_bound = 0;
+    header_.free_space_upper_bound = DATA_SIZE;
+    header_.num_slots = 0;
+    header_.num_free_slots = 0;
+    header_.first_free_slot = INVALID_SLOT;
+    header_.fragmented_bytes = 0;
+    return;
+  }
+
+  if (record_id.slot_number == header_.num_slots) {
     // Last slot in the list, so we need to free any unused slots that are at
     // the end of the slot list.
     int num_slots_to_delete = 1;
@@ -132,9 +134,75 @@ void Page::deleteRecord(const RecordId& record_id,
     header_.num_slots -= num_slots_to_delete;
     header_.num_free_slots -= num_slots_to_delete;
     header_.free_space_lower_bound -= sizeof(PageSlot) * num_slots_to_delete;
+
+    // Drop the deleted slots from the free slot list.
+    SlotId* link = &header_.first_free_slot;
+    while (*link != INVALID_SLOT) {
+      PageSlot* free_slot = getSlot(*link);
+      if (*link > header_.num_slots) {
+        *link = free_slot->item_offset;
+      } else {
+        link = &free_slot->item_offset;
+      }
+    }
+  }
+}
+
+void Page::compact() {
+  if (header_.fragmented_bytes == 0) {
+    return;
+  }
+  // Move records closest to the end of the page first, so data is only ever
+  // moved towards the end over bytes that were already moved or freed.
+  std::vector<SlotId> used_slots;
+  used_slots.reserve(header_.num_slots - header_.num_free_slots);
+  for (SlotId i = 1; i <= header_.num_slots; ++i) {
+    if (getSlot(i)->used) {
+      used_slots.push_back(i);
+    }
+  }
+  std::sort(used_slots.begin(), used_slots.end(),
+            [this](const SlotId a, const SlotId b) {
+              return getSlot(a)->item_offset > getSlot(b)->item_offset;
+            });
+  std::uint16_t upper_bound = DATA_SIZE;
+  for (std::size_t i = 0; i < used_slots.size(); ++i) {
+    PageSlot* slot = getSlot(used_slots[i]);
+    upper_bound -= slot->item_length;
+    if (upper_bound != slot->item_offset) {
+      memmove(&data_[upper_bound], &data_[slot->item_offset],
+              slot->item_length);
+      slot->item_offset = upper_bound;
+    }
+  }
+  header_.free_space_upper_bound = upper_bound;
+  header_.fragmented_bytes = 0;
+}
+
+void Page::reserveContiguousSpace(const std::size_t bytes) {
+  if (getContiguousFreeSpace() < bytes) {
+    compact();
   }
 }
 
+void Page::releaseData(const std::uint16_t offset,
+                       const std::uint16_t length) {
+  if (offset == header_.free_space_upper_bound) {
+    header_.free_space_upper_bound += length;
+  } else {
+    header_.fragmented_bytes += length;
+  }
+}
+
+void Page::unlinkFreeSlot(const SlotId slot_number) {
+  SlotId* link = &header_.first_free_slot;
+  while (*link != slot_number) {
+    assert(*link != INVALID_SLOT);
+    link = &getSlot(*link)->item_offset;
+  }
+  *link = getSlot(slot_number)->item_offset;
+}
+
 bool Page::hasSpaceForRecord(const std::string& record_data) const {
   std::size_t record_size = record_data.length();
   if (header_.num_free_slots == 0) {
@@ -152,27 +220,22 @@ const PageSlot& Page::getSlot(const SlotId slot_number) const {
 }
 
 SlotId Page::getAvailableSlot() {
-  SlotId slot_number = INVALID_SLOT;
-  if (header_.num_free_slots > 0) {
-    // Have an allocated but unused slot that we can reuse.
-    for (SlotId i = 1; i <= header_.num_slots; ++i) {
-      const PageSlot* slot = getSlot(i);
-      if (!slot->used) {
-        // We don't decrement the number of free slots until someone actually
-        // puts data in the slot.
-        slot_number = i;
-        break;
-      }
-    }
-  } else {
+  if (header_.num_free_slots == 0) {
     // Have to allocate a new slot.
-    slot_number = header_.num_slots + 1;
+    const SlotId slot_number = header_.num_slots + 1;
     ++header_.num_slots;
     ++header_.num_free_slots;
     header_.free_space_lower_bound = sizeof(PageSlot) * header_.num_slots;
+    PageSlot* slot = getSlot(slot_number);
+    slot->used = false;
+    slot->item_offset = header_.first_free_slot;
+    slot->item_length = 0;
+    header_.first_free_slot = slot_number;
   }
-  assert(slot_number != INVALID_SLOT);
-  return static_cast<SlotId>(slot_number);
+  // Have an allocated but unused slot that we can reuse.  We don't take it
+  // off the list until someone actually puts data in the slot.
+  assert(header_.first_free_slot != INVALID_SLOT);
+  return header_.first_free_slot;
 }
 
 void Page::insertRecordInSlot(const SlotId slot_number,
@@ -185,6 +248,7 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   if (slot->used) {
     throw SlotInUseException(page_number(), slot_number);
   }
+  unlinkFreeSlot(slot_number);
   const int record_length = record_data.length();
   slot->used = true;
   slot->item_length = record_length;
@@ -192,10 +256,7 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   header_.free_space_upper_bound = slot->item_offset;
   --header_.num_free_slots;
 
-	for(int i = 0; i < slot->item_length; i++)
-		data_[i + slot->item_offset] = record_data[i];
-
-  //data_.replace(slot->item_offset, slot->item_length, record_data);
+  memcpy(&data_[slot->item_offset], record_data.data(), slot->item_length);
 }
 
 void Page::validateRecordId(const RecordId& record_id) const {
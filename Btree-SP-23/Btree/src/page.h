@@ -48,6 +48,20 @@ struct PageHeader {
    */
   SlotId num_free_slots;
 
+  /**
+   * First slot of the list of slots allocated but not in use, or
+   * Page::INVALID_SLOT if there is none.  Unused slots are chained through
+   * their item_offset field.
+   */
+  SlotId first_free_slot;
+
+  /**
+   * Number of bytes of the data area freed by deletes and updates which are
+   * not part of the contiguous free space yet.  They are reclaimed when the
+   * page is compacted.
+   */
+  std::uint16_t fragmented_bytes;
+
   /**
    * Number of the page within the file.
    */
@@ -93,6 +107,31 @@ struct PageSlot {
   std::uint16_t item_length;
 };
 
+/**
+ * @brief Non-owning view of the bytes of a record stored in a page.
+ *
+ * The view points directly into the page, so reading a record through it
+ * does not copy or allocate. It is only valid as long as the page stays where
+ * it is (for a page of the buffer pool, while it is pinned) and the record is
+ * not updated or deleted.
+ */
+struct RecordView {
+  /**
+   * First byte of the record.
+   */
+  const char* data;
+
+  /**
+   * Number of bytes of the record.
+   */
+  std::size_t length;
+
+  /**
+   * Returns a copy of the record.
+   */
+  std::string toString() const { return std::string(data, length); }
+};
+
 class PageIterator;
 
 /**
@@ -151,6 +190,18 @@ class Page {
    */
   std::string getRecord(const RecordId& record_id) const;
 
+  /**
+   * Returns a view of the record with the given ID, pointing into this page.
+   * Unlike getRecord, nothing is copied; the view is valid as long as this
+   * page is and the record is not changed.
+   *
+   * @see RecordView
+   * @param record_id  ID of the record to return.
+   * @return  View of the record.
+   * @throws  InvalidRecordException   If the record doesn't exist.
+   */
+  RecordView recordView(const RecordId& record_id) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
@@ -162,14 +213,22 @@ class Page {
   void updateRecord(const RecordId& record_id, const std::string& record_data);
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array.
+   * Deletes the record with the given ID.  The space of the record is not
+   * reclaimed right away; it is counted as free and reused once an insert or
+   * update needs contiguous space and compacts the page.  Slot array is
+   * compacted if the slot deleted is at the end of the slot array.
    *
    * @param record_id   ID of the record to delete.
    */
   void deleteRecord(const RecordId& record_id);
 
+  /**
+   * Moves the data of all records to the end of the page so that all free
+   * space, including the space left by deleted and shrunk records, is
+   * contiguous.  Record IDs do not change.
+   */
+  void compact();
+
   /**
    * Returns true if the page has enough free space to hold the given data.
    *
@@ -179,12 +238,14 @@ class Page {
   bool hasSpaceForRecord(const std::string& record_data) const;
 
   /**
-   * Returns this page's free space in bytes.
+   * Returns this page's free space in bytes, including the space left by
+   * deleted records that the page has not been compacted over yet.
    *
    * @return  Free space in bytes.
    */
-  std::uint16_t getFreeSpace() const { return header_.free_space_upper_bound -
-                                              header_.free_space_lower_bound; }
+  std::uint16_t getFreeSpace() const {
+    return getContiguousFreeSpace() + header_.fragmented_bytes;
+  }
 
   /**
    * Returns this page's number in its file.
@@ -240,17 +301,38 @@ class Page {
   }
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array and
-   * <allow_slot_compaction> is set.
+   * Returns the number of free bytes between the slot array and the first
+   * data record.
+   *
+   * @return  Contiguous free space in bytes.
+   */
+  std::uint16_t getContiguousFreeSpace() const {
+    return header_.free_space_upper_bound - header_.free_space_lower_bound;
+  }
+
+  /**
+   * Compacts the page if its contiguous free space is smaller than <bytes>.
+   *
+   * @param bytes   Number of contiguous bytes needed.
+   */
+  void reserveContiguousSpace(const std::size_t bytes);
+
+  /**
+   * Releases the data bytes of a record.  If the record lies at the start of
+   * the data area the free space grows right away, otherwise the bytes are
+   * counted as fragmented until the next compaction.
+   *
+   * @param offset  Offset of the record data.
+   * @param length  Length of the record data.
+   */
+  void releaseData(const std::uint16_t offset, const std::uint16_t length);
+
+  /**
+   * Removes the given slot from the list of unused slots.
    *
-   * @param record_id             ID of the record to delete.
-   * @param allow_slot_compaction If true, the slot array will be compacted if
-   *                              possible.
+   * @param slot_number   Number of an unused slot.
    */
-  void deleteRecord(const RecordId& record_id,
-                    const bool allow_slot_compaction);
+  void unlinkFreeSlot(const SlotId slot_number);
 
   /**
    * Returns the slot with the given number.  This method will return
@@ -273,13 +355,14 @@ class Page {
   const PageSlot& getSlot(const SlotId slot_number) const;
 
   /**
-   * Returns the slot number of an available slot.  If no slots are available
-   * to be reused, allocates a new slot.  Updates available slot count in the
-   * header metadata, but does not mark returned slot as used.  If a new slot is
-   * allocated, updates the free space lower bound.
+   * Returns the slot number of an available slot, taken from the head of the
+   * list of unused slots.  If no slots are available to be reused, allocates a
+   * new slot.  Updates available slot count in the header metadata, but does
+   * not mark returned slot as used.  If a new slot is allocated, updates the
+   * free space lower bound.
    *
-   * Callers are responsible for making sure there is enough space to allocate a
-   * new slot before calling this method.
+   * Callers are responsible for making sure there is enough contiguous space
+   * to allocate a new slot before calling this method.
    *
    * Since the returned slot is not marked as used, callers must take care to
    * fill the slot or mark it used before someone else calls this method.
@@ -292,8 +375,8 @@ class Page {
    * Inserts record data into the given slot.  The slot should not be currently
    * in use.  <slot_number> must be less than <header_.num_slots>.
    *
-   * Callers are responsible for making sure there is enough space to hold the
-   * record before calling this method.
+   * Callers are responsible for making sure there is enough contiguous space
+   * to hold the record before calling this method.
    *
    * @param slot_number   Number of slot to insert record into.
    * @param record_data   Bytes that compose the record.
@@ -337,11 +420,16 @@ class Page {
   friend class PageFile;
   friend class BlobFile;
   friend class PageIterator;
+  friend class PageBuilder;
+  friend class FixedRecordPage;
+  friend class PaxPage;
 };
 
 static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0,
               "Page must have some space to hold data.");
+static_assert(sizeof(Page) == Page::SIZE,
+              "Page must be laid out in memory the same way it is on disk.");
 
 }
@@ -0,0 +1,78 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "page_builder.h"
+
+#include <string.h>
+
+#include "exceptions/insufficient_space_exception.h"
+
+namespace badgerdb {
+
+// -----------------------------------------------------------------------------
+// PageBuilder
+// -----------------------------------------------------------------------------
+
+void PageBuilder::start(Page* page) {
+  page_ = page;
+  page_->initialize();
+}
+
+bool PageBuilder::add(const char* data, const std::size_t length) {
+  PageHeader& header = page_->header_;
+  if (length + sizeof(PageSlot) > page_->getContiguousFreeSpace()) {
+    return false;
+  }
+  ++header.num_slots;
+  header.free_space_lower_bound += sizeof(PageSlot);
+  header.free_space_upper_bound -= length;
+
+  PageSlot* slot = page_->getSlot(header.num_slots);
+  slot->used = true;
+  slot->item_offset = header.free_space_upper_bound;
+  slot->item_length = length;
+  memcpy(&page_->data_[slot->item_offset], data, length);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// BulkLoader
+// -----------------------------------------------------------------------------
+
+BulkLoader::BulkLoader(PageFile* file, const std::size_t extentPages)
+    : file_(file),
+      extent_(extentPages > 0 ? extentPages : 1),
+      numPages_(0),
+      tail_(Page::INVALID_NUMBER),
+      pagesWritten_(0) {}
+
+void BulkLoader::append(const char* data, const std::size_t length) {
+  if (length + sizeof(PageSlot) > Page::DATA_SIZE) {
+    throw InsufficientSpaceException(Page::INVALID_NUMBER, length,
+                                     Page::DATA_SIZE - sizeof(PageSlot));
+  }
+  if (numPages_ > 0 && builder_.add(data, length)) {
+    return;
+  }
+  if (numPages_ == extent_.size()) {
+    flush();
+  }
+  builder_.start(&extent_[numPages_++]);
+  builder_.add(data, length);
+}
+
+void BulkLoader::flush() {
+  if (numPages_ == 0) {
+    return;
+  }
+  tail_ = file_->appendPages(&extent_[0], numPages_, tail_);
+  pagesWritten_ += numPages_;
+  numPages_ = 0;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,156 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Default number of pages a BulkLoader fills before writing them to
+ * the file in one go.
+ */
+const std::size_t BULK_LOAD_EXTENT_PAGES = 64;
+
+/**
+ * @brief Packs records into an empty page.
+ *
+ * Records are appended one after the other: each one takes the next slot and
+ * the bytes right below the previous record. Unlike Page::insertRecord there
+ * is no free slot to look for, no std::string to build and no space left by
+ * deleted records to take into account.
+ */
+class PageBuilder {
+ public:
+  /**
+   * Constructs a builder without a page.
+   */
+  PageBuilder() : page_(NULL) {}
+
+  /**
+   * Empties the given page and starts packing records into it.
+   *
+   * @param page  Page to fill.
+   */
+  void start(Page* page);
+
+  /**
+   * Appends a record to the page.
+   *
+   * @param data    First byte of the record.
+   * @param length  Number of bytes of the record.
+   * @return  False if the page has no room left for the record.
+   */
+  bool add(const char* data, const std::size_t length);
+
+  /**
+   * Returns the number of records in the page.
+   */
+  SlotId numRecords() const { return page_->header_.num_slots; }
+
+ private:
+  /**
+   * Page being filled.
+   */
+  Page* page_;
+};
+
+/**
+ * @brief Loads records into a PageFile page after page.
+ *
+ * Records are packed with a PageBuilder into a buffer of <extentPages> pages.
+ * Once the buffer is full it is appended to the end of the file with a single
+ * write, so loading a relation costs one sequential write per extent instead
+ * of an allocatePage and a writePage per page.
+ *
+ * Pages are always appended after the last page of the file, free pages of the
+ * file are not reused. Nothing else may allocate pages in the file while it is
+ * being loaded.
+ */
+class BulkLoader {
+ public:
+  /**
+   * Constructor of BulkLoader.
+   *
+   * @param file          File to load records into.
+   * @param extentPages   Number of pages written to the file at once.
+   */
+  BulkLoader(PageFile* file,
+             const std::size_t extentPages = BULK_LOAD_EXTENT_PAGES);
+
+  /**
+   * Appends a record to the relation.
+   *
+   * @param data    First byte of the record.
+   * @param length  Number of bytes of the record.
+   * @throws  InsufficientSpaceException  If the record is larger than a page.
+   */
+  void append(const char* data, const std::size_t length);
+
+  /**
+   * Appends a record to the relation.
+   *
+   * @param record  Bytes that compose the record.
+   * @throws  InsufficientSpaceException  If the record is larger than a page.
+   */
+  void append(const std::string& record) {
+    append(record.data(), record.length());
+  }
+
+  /**
+   * Writes the pages still buffered to the file. Has to be called once all
+   * records are appended, records not flushed are lost.
+   */
+  void flush();
+
+  /**
+   * Returns the number of pages written to the file so far.
+   */
+  std::size_t pagesWritten() const { return pagesWritten_; }
+
+ private:
+  /**
+   * File the records are loaded into.
+   */
+  PageFile* file_;
+
+  /**
+   * Pages filled before they are written to the file.
+   */
+  std::vector<Page> extent_;
+
+  /**
+   * Number of pages of <extent_> in use, the last one being filled.
+   */
+  std::size_t numPages_;
+
+  /**
+   * Builder over the last page of <extent_>.
+   */
+  PageBuilder builder_;
+
+  /**
+   * Last page appended to the file, so the next extent can be linked to it
+   * without walking the file.
+   */
+  PageId tail_;
+
+  /**
+   * Number of pages written to the file.
+   */
+  std::size_t pagesWritten_;
+};
+
+}  // namespace badgerdb
@@ -101,6 +101,15 @@ class PageIterator {
 		return page_->getRecord(current_record_); 
 	}
 
+  /**
+   * Returns a view of the current record, pointing into the page.
+   *
+   * @return  View of the record in page.
+   */
+	inline RecordView recordView() const {
+		return page_->recordView(current_record_);
+	}
+
   /**
    * Returns the next used slot in the page after the given slot or
    * Page::INVALID_SLOT if no slots are used after the given slot.
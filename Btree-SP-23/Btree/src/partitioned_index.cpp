@@ -0,0 +1,158 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "partitioned_index.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scanrange_exception.h"
+#include "file.h"
+#include "rid_list.h"
+#include "work_pool.h"
+
+namespace badgerdb {
+
+PartitionedIndex::PartitionedIndex(const std::string &relationName,
+                                   BufMgr *bufMgr, const int attrByteOffset,
+                                   const Datatype attrType,
+                                   const std::vector<IndexKey> &boundaries,
+                                   const std::uint32_t bufsPerPartition,
+                                   const RelationFormat format)
+    : relationName_(relationName),
+      attrByteOffset_(attrByteOffset),
+      attrType_(attrType),
+      boundaries_(boundaries) {
+  const std::size_t numPartitions = boundaries_.size() + 1;
+  bool missing = false;
+  for (std::size_t k = 0; k < numPartitions; k++) {
+    missing = missing || !File::exists(this->fileName(k));
+  }
+  // The relation is scanned once for all the missing partitions
+  std::vector<std::vector<RIDKeyPair<IndexKey> > > entries(numPartitions);
+  if (missing) {
+    std::vector<RIDKeyPair<IndexKey> > all;
+    BTreeIndex::scanRelation(relationName, bufMgr, attrByteOffset, attrType,
+                             format, all);
+    for (std::size_t i = 0; i < all.size(); i++) {
+      entries[this->partitionOf(all[i].key)].push_back(all[i]);
+    }
+  }
+  for (std::size_t k = 0; k < numPartitions; k++) {
+    bufMgrs_.push_back(new BufMgr(bufsPerPartition));
+    partitions_.push_back(new BTreeIndex(relationName, this->fileName(k),
+                                         bufMgrs_[k], attrByteOffset,
+                                         attrType, entries[k]));
+  }
+}
+
+PartitionedIndex::~PartitionedIndex() {
+  for (std::size_t k = 0; k < partitions_.size(); k++) {
+    delete partitions_[k];
+    delete bufMgrs_[k];
+  }
+}
+
+std::string PartitionedIndex::fileName(const std::size_t partition) const {
+  std::ostringstream name;
+  name << relationName_ << "." << attrByteOffset_ << ".p" << partition;
+  return name.str();
+}
+
+std::size_t PartitionedIndex::partitionOf(const IndexKey &key) const {
+  return std::upper_bound(boundaries_.begin(), boundaries_.end(), key) -
+         boundaries_.begin();
+}
+
+void PartitionedIndex::insertEntry(const void *key, const RecordId rid) {
+  const IndexKey indexKey = IndexKey::fromValue(attrType_, key);
+  partitions_[this->partitionOf(indexKey)]->insertEntry(indexKey, rid);
+}
+
+void PartitionedIndex::collectRids(const void *lowVal, const Operator lowOp,
+                                   const void *highVal, const Operator highOp,
+                                   std::vector<RecordId> &outRids) {
+  if (lowOp == LT || lowOp == LTE || highOp == GT || highOp == GTE) {
+    throw BadOpcodesException();
+  }
+  const IndexKey lowValKey = IndexKey::fromValue(attrType_, lowVal);
+  const IndexKey highValKey = IndexKey::fromValue(attrType_, highVal);
+  if (highValKey < lowValKey) {
+    throw BadScanrangeException();
+  }
+  const std::size_t first = this->partitionOf(lowValKey);
+  const std::size_t last = this->partitionOf(highValKey);
+  if (first == last) {
+    IndexPredicate predicate = {partitions_[first], lowVal, lowOp, highVal,
+                                highOp};
+    badgerdb::collectRids(predicate, outRids);
+    return;
+  }
+
+  // One task per partition on the engine pool, each scanning with the
+  // buffer manager of its partition
+  const std::size_t count = last - first + 1;
+  std::vector<std::vector<RecordId> > rids(count);
+  TaskGroup group(WorkStealingPool::shared());
+  for (std::size_t i = 0; i < count; i++) {
+    group.submit([&, i]() {
+      IndexPredicate predicate = {partitions_[first + i], lowVal, lowOp,
+                                  highVal, highOp};
+      badgerdb::collectRids(predicate, rids[i]);
+    });
+  }
+  group.wait();
+  // The partitions hold consecutive key ranges
+  for (std::size_t i = 0; i < count; i++) {
+    outRids.insert(outRids.end(), rids[i].begin(), rids[i].end());
+  }
+}
+
+void PartitionedIndex::rebuildPartition(
+    const std::size_t partition, std::vector<RIDKeyPair<IndexKey> > &entries) {
+  const std::string name = this->fileName(partition);
+  const std::string newName = name + ".new";
+  const std::string oldName = name + ".old";
+  // Left behind by a rebuild which did not complete
+  if (File::exists(newName)) {
+    File::remove(newName);
+  }
+  if (File::exists(oldName)) {
+    File::remove(oldName);
+  }
+
+  // The new tree is built beside the old one, which stays in use if the
+  // build fails
+  try {
+    BTreeIndex rebuilt(relationName_, newName, bufMgrs_[partition],
+                       attrByteOffset_, attrType_, entries);
+  } catch (...) {
+    if (File::exists(newName)) {
+      File::remove(newName);
+    }
+    throw;
+  }
+
+  // Swapped once both trees are closed, one of the files is always there
+  delete partitions_[partition];
+  partitions_[partition] = NULL;
+  File::rename(name, oldName);
+  File::rename(newName, name);
+  File::remove(oldName);
+  partitions_[partition] =
+      new BTreeIndex(relationName_, name, bufMgrs_[partition], attrByteOffset_,
+                     attrType_, entries);
+}
+
+void PartitionedIndex::dropPartition(const std::size_t partition) {
+  std::vector<RIDKeyPair<IndexKey> > none;
+  this->rebuildPartition(partition, none);
+}
+
+}  // namespace badgerdb
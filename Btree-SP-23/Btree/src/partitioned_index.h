@@ -0,0 +1,140 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "buffer.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Index over an attribute of a relation split into key ranges, each
+ * with a BTreeIndex and an index file of its own.
+ *
+ * Partition k holds the keys from boundary k - 1 included to boundary k
+ * excluded, the first and last partitions being unbounded below and above.
+ * Each partition has a buffer manager of its own, so the scans of a range
+ * run one task per partition it overlaps on the engine WorkStealingPool,
+ * their results being concatenated in partition order. A partition can be
+ * rebuilt or emptied without touching the others, as when old time ranges
+ * are dropped.
+ *
+ * The boundaries are not stored: an existing index has to be opened with the
+ * ones it was created with.
+ */
+class PartitionedIndex {
+ public:
+  /**
+   * Opens the partitions of an index, creating the missing ones from a
+   * single scan of the relation. The file of partition k is named
+   * "<relationName>.<attrByteOffset>.p<k>".
+   *
+   * @param relationName      Name of the relation.
+   * @param bufMgr            Buffer manager the relation is scanned with.
+   * @param attrByteOffset    Offset of the attribute in the records.
+   * @param attrType          Datatype of the attribute.
+   * @param boundaries        Lowest key of every partition but the first, in
+   *                          increasing order.
+   * @param bufsPerPartition  Number of frames of the buffer manager of each
+   *                          partition.
+   * @param format            Page format of the relation.
+   * @throws  BadIndexInfoException   If an index file exists for another
+   *                                  relation or attribute.
+   */
+  PartitionedIndex(const std::string &relationName, BufMgr *bufMgr,
+                   const int attrByteOffset, const Datatype attrType,
+                   const std::vector<IndexKey> &boundaries,
+                   const std::uint32_t bufsPerPartition = 100,
+                   const RelationFormat format = SLOTTED_RELATION);
+
+  /**
+   * Closes the partitions, writing them to their files.
+   */
+  ~PartitionedIndex();
+
+  /**
+   * Inserts an entry into the partition of its key.
+   *
+   * @param key   Pointer to integer / double / char string, as for
+   *              BTreeIndex::insertEntry.
+   * @param rid   Record ID of the record.
+   */
+  void insertEntry(const void *key, const RecordId rid);
+
+  /**
+   * Scans a range and appends the RecordIds it returns to <outRids>, in key
+   * order. The partitions the range overlaps are scanned in parallel. Not to
+   * be called from a task of the engine pool.
+   *
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of
+   *their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   */
+  void collectRids(const void *lowVal, const Operator lowOp,
+                   const void *highVal, const Operator highOp,
+                   std::vector<RecordId> &outRids);
+
+  /**
+   * Replaces the contents of a partition with a list of entries, bulk
+   * loaded into a new tree. The tree is built in a file of its own, which
+   * replaces the one of the partition once it is complete.
+   *
+   * @param partition   Number of the partition.
+   * @param entries     <key, rid> pairs, whose keys have to be in the range
+   *                    of the partition. Sorted in place.
+   */
+  void rebuildPartition(const std::size_t partition,
+                        std::vector<RIDKeyPair<IndexKey> > &entries);
+
+  /**
+   * Empties a partition.
+   *
+   * @param partition   Number of the partition.
+   */
+  void dropPartition(const std::size_t partition);
+
+  /**
+   * Returns the partition holding a key.
+   */
+  std::size_t partitionOf(const IndexKey &key) const;
+
+  std::size_t numPartitions() const { return partitions_.size(); }
+
+  /**
+   * Returns the tree of a partition.
+   */
+  BTreeIndex *partition(const std::size_t partition) {
+    return partitions_[partition];
+  }
+
+ private:
+  // Not copyable, the partitions are closed once
+  PartitionedIndex(const PartitionedIndex &);
+  PartitionedIndex &operator=(const PartitionedIndex &);
+
+  /**
+   * Returns the name of the index file of a partition.
+   */
+  std::string fileName(const std::size_t partition) const;
+
+  std::string relationName_;
+  int attrByteOffset_;
+  Datatype attrType_;
+  std::vector<IndexKey> boundaries_;
+  std::vector<BufMgr *> bufMgrs_;
+  std::vector<BTreeIndex *> partitions_;
+};
+
+}  // namespace badgerdb
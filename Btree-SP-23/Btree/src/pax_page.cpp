@@ -0,0 +1,167 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "pax_page.h"
+
+#include <string.h>
+
+#include "exceptions/end_of_file_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+
+namespace badgerdb {
+
+/**
+ * Minipages start on 8 byte boundaries of the data area.
+ */
+static std::size_t alignMinipage(const std::size_t offset) {
+  return (offset + 7) & ~(std::size_t)7;
+}
+
+/**
+ * Returns the number of bytes of the data area used by the minipages of
+ * <capacity> records, starting after the header and minipage descriptions.
+ */
+static std::size_t paxPageBytes(const PaxSchema &schema,
+                                const std::size_t capacity) {
+  std::size_t bytes =
+      sizeof(PaxPageHeader) + schema.size() * sizeof(PaxMinipage);
+  for (std::size_t a = 0; a < schema.size(); a++) {
+    bytes = alignMinipage(bytes) + capacity * schema[a].size;
+  }
+  return bytes;
+}
+
+// -----------------------------------------------------------------------------
+// PaxPage
+// -----------------------------------------------------------------------------
+
+std::uint16_t PaxPage::capacityFor(const PaxSchema &schema) {
+  std::size_t rowBytes = 0;
+  for (std::size_t a = 0; a < schema.size(); a++) {
+    rowBytes += schema[a].size;
+  }
+  if (rowBytes == 0) {
+    return 0;
+  }
+  std::size_t capacity = Page::DATA_SIZE / rowBytes;
+  while (capacity > 0 && paxPageBytes(schema, capacity) > Page::DATA_SIZE) {
+    capacity--;
+  }
+  return capacity > 0xFFFF ? 0xFFFF : capacity;
+}
+
+void PaxPage::initialize(const PaxSchema &schema) {
+  PaxPageHeader *paxHeader = header();
+  paxHeader->numAttributes = schema.size();
+  paxHeader->capacity = capacityFor(schema);
+  paxHeader->numRecords = 0;
+  paxHeader->recordLength = 0;
+
+  PaxMinipage *minipage =
+      reinterpret_cast<PaxMinipage *>(page_->data_ + sizeof(PaxPageHeader));
+  std::size_t offset =
+      sizeof(PaxPageHeader) + schema.size() * sizeof(PaxMinipage);
+  for (std::size_t a = 0; a < schema.size(); a++) {
+    offset = alignMinipage(offset);
+    minipage[a].recordOffset = schema[a].offset;
+    minipage[a].size = schema[a].size;
+    minipage[a].offset = offset;
+    minipage[a].type = schema[a].type;
+    offset += paxHeader->capacity * schema[a].size;
+    if (schema[a].offset + schema[a].size > paxHeader->recordLength) {
+      paxHeader->recordLength = schema[a].offset + schema[a].size;
+    }
+  }
+}
+
+RecordId PaxPage::insertRecord(const char *record) {
+  PaxPageHeader *paxHeader = header();
+  if (paxHeader->numRecords == paxHeader->capacity) {
+    throw InsufficientSpaceException(page_->page_number(),
+                                     paxHeader->recordLength, 0);
+  }
+  const std::size_t index = paxHeader->numRecords++;
+  const PaxMinipage *minipage = minipages();
+  for (std::size_t a = 0; a < paxHeader->numAttributes; a++) {
+    memcpy(page_->data_ + minipage[a].offset + index * minipage[a].size,
+           record + minipage[a].recordOffset, minipage[a].size);
+  }
+  return {page_->page_number(), (SlotId)(index + 1)};
+}
+
+void PaxPage::readRecord(const SlotId slot, char *record) const {
+  const PaxMinipage *minipage = minipages();
+  for (std::size_t a = 0; a < header()->numAttributes; a++) {
+    memcpy(record + minipage[a].recordOffset, value(a, slot),
+           minipage[a].size);
+  }
+}
+
+int PaxPage::findAttribute(const int recordOffset) const {
+  const PaxMinipage *minipage = minipages();
+  for (std::size_t a = 0; a < header()->numAttributes; a++) {
+    if (minipage[a].recordOffset == recordOffset) {
+      return a;
+    }
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+// PaxFileScan
+// -----------------------------------------------------------------------------
+
+PaxFileScan::PaxFileScan(const std::string &name, BufMgr *bufMgr)
+    : file_(new PageFile(name, false)),
+      bufMgr_(bufMgr),
+      curPage_(NULL),
+      curSlot_(Page::INVALID_SLOT) {
+  filePageIter_ = file_->begin();
+}
+
+PaxFileScan::~PaxFileScan() {
+  if (curPage_ != NULL) {
+    bufMgr_->unPinPage(file_, filePageIter_.page_number(), false);
+    curPage_ = NULL;
+  }
+  bufMgr_->flushFile(file_);
+  delete file_;
+}
+
+bool PaxFileScan::nextPage() {
+  if (curPage_ != NULL) {
+    bufMgr_->unPinPage(file_, filePageIter_.page_number(), false);
+    curPage_ = NULL;
+    filePageIter_++;
+  }
+  if (filePageIter_ == file_->end()) {
+    return false;
+  }
+  bufMgr_->readPage(file_, filePageIter_.page_number(), curPage_);
+  curSlot_ = Page::INVALID_SLOT;
+  return true;
+}
+
+void PaxFileScan::scanNext(RecordId &outRid) {
+  while (curPage_ == NULL || curSlot_ == PaxPage(curPage_).numRecords()) {
+    if (!nextPage()) {
+      throw EndOfFileException();
+    }
+  }
+  curSlot_++;
+  outRid = {filePageIter_.page_number(), curSlot_};
+}
+
+std::string PaxFileScan::getRecord() const {
+  const PaxPage page(curPage_);
+  std::string record(page.recordLength(), '\0');
+  page.readRecord(curSlot_, &record[0]);
+  return record;
+}
+
+}  // namespace badgerdb
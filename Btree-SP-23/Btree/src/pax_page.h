@@ -0,0 +1,327 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "buffer.h"
+#include "file.h"
+#include "file_iterator.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Fixed-width attribute of a record, as laid out in the record.
+ */
+struct PaxAttribute {
+  /**
+   * Offset of the attribute inside the record.
+   */
+  int offset;
+
+  /**
+   * Datatype of the attribute.
+   */
+  Datatype type;
+
+  /**
+   * Number of bytes of the attribute.
+   */
+  std::size_t size;
+};
+
+/**
+ * @brief Attributes of the records of a PAX relation.
+ */
+typedef std::vector<PaxAttribute> PaxSchema;
+
+/**
+ * @brief Header stored at the start of the data area of a PAX page.
+ */
+struct PaxPageHeader {
+  /**
+   * Number of attributes, each stored in its own minipage.
+   */
+  std::uint16_t numAttributes;
+
+  /**
+   * Number of records the page can hold.
+   */
+  std::uint16_t capacity;
+
+  /**
+   * Number of records in the page. Records are never deleted, so they are the
+   * first <numRecords> entries of every minipage.
+   */
+  std::uint16_t numRecords;
+
+  /**
+   * Length of a record when it is put back together in row format.
+   */
+  std::uint16_t recordLength;
+};
+
+/**
+ * @brief Description of one minipage, stored after the PaxPageHeader. Pages
+ * describe their own layout so they can be read without the schema.
+ */
+struct PaxMinipage {
+  /**
+   * Offset of the attribute inside a row format record.
+   */
+  std::uint16_t recordOffset;
+
+  /**
+   * Number of bytes of the attribute.
+   */
+  std::uint16_t size;
+
+  /**
+   * Offset of the minipage in the data area of the page.
+   */
+  std::uint16_t offset;
+
+  /**
+   * Datatype of the attribute.
+   */
+  std::uint16_t type;
+};
+
+/**
+ * @brief PAX (Partition Attributes Across) page format.
+ *
+ * The records of the page are split by attribute: the values of every
+ * attribute are stored next to each other in a minipage of their own. A scan
+ * which needs a few attributes only touches their minipages, and reads each
+ * of them sequentially, instead of striding over whole records.
+ *
+ * PAX pages are meant for relations that are loaded once and scanned: records
+ * can be appended and read back, but not updated or deleted. The slot number
+ * of a record is its position in the minipages plus one.
+ *
+ * A PaxPage is a view over a Page of a PageFile, typically one pinned in the
+ * buffer pool. The PageHeader of the page is left with no slots, so slotted
+ * page readers see an empty page.
+ *
+ * @warning This class is not threadsafe.
+ */
+class PaxPage {
+ public:
+  /**
+   * Returns the number of records with the given attributes a page can hold.
+   *
+   * @param schema  Attributes of the records.
+   * @return  Number of records.
+   */
+  static std::uint16_t capacityFor(const PaxSchema &schema);
+
+  /**
+   * Constructs a view over a page already formatted as a PAX page.
+   *
+   * @param page  Page to access.
+   */
+  explicit PaxPage(Page *page) : page_(page) {}
+
+  /**
+   * Formats the page for records with the given attributes, dropping anything
+   * it held.
+   *
+   * @param schema  Attributes of the records.
+   */
+  void initialize(const PaxSchema &schema);
+
+  /**
+   * Appends a record, splitting its attributes into their minipages.
+   *
+   * @param record  Record in row format.
+   * @return  ID of the newly inserted record.
+   * @throws  InsufficientSpaceException  If the page is full.
+   */
+  RecordId insertRecord(const char *record);
+
+  /**
+   * Puts a record back together in row format. Bytes of the record that are
+   * not part of any attribute are left untouched.
+   *
+   * @param slot    Slot of the record, between 1 and numRecords().
+   * @param record  Receives recordLength() bytes.
+   */
+  void readRecord(const SlotId slot, char *record) const;
+
+  /**
+   * Returns the index of the attribute stored at <recordOffset> in row format
+   * records, or -1 if there is none.
+   *
+   * @param recordOffset  Offset of the attribute inside the record.
+   */
+  int findAttribute(const int recordOffset) const;
+
+  /**
+   * Returns the values of an attribute for all the records of the page, one
+   * after the other, attributeSize(attribute) bytes each.
+   *
+   * @param attribute   Index of the attribute.
+   */
+  const char *column(const std::size_t attribute) const {
+    return page_->data_ + minipages()[attribute].offset;
+  }
+
+  /**
+   * Returns the value of an attribute of a record.
+   *
+   * @param attribute   Index of the attribute.
+   * @param slot        Slot of the record, between 1 and numRecords().
+   */
+  const char *value(const std::size_t attribute, const SlotId slot) const {
+    return column(attribute) +
+           (std::size_t)(slot - 1) * minipages()[attribute].size;
+  }
+
+  /**
+   * Returns the number of bytes of an attribute.
+   *
+   * @param attribute   Index of the attribute.
+   */
+  std::size_t attributeSize(const std::size_t attribute) const {
+    return minipages()[attribute].size;
+  }
+
+  /**
+   * Returns the number of attributes of the records.
+   */
+  std::uint16_t numAttributes() const { return header()->numAttributes; }
+
+  /**
+   * Returns the number of records in the page.
+   */
+  std::uint16_t numRecords() const { return header()->numRecords; }
+
+  /**
+   * Returns the number of records the page can hold.
+   */
+  std::uint16_t capacity() const { return header()->capacity; }
+
+  /**
+   * Returns the length of the records in row format.
+   */
+  std::uint16_t recordLength() const { return header()->recordLength; }
+
+ private:
+  const PaxPageHeader *header() const {
+    return reinterpret_cast<const PaxPageHeader *>(page_->data_);
+  }
+  PaxPageHeader *header() {
+    return reinterpret_cast<PaxPageHeader *>(page_->data_);
+  }
+  const PaxMinipage *minipages() const {
+    return reinterpret_cast<const PaxMinipage *>(page_->data_ +
+                                                 sizeof(PaxPageHeader));
+  }
+
+  /**
+   * Page being accessed.
+   */
+  Page *page_;
+};
+
+/**
+ * @brief Sequential scan over a relation of PAX pages.
+ *
+ * The scan can be driven a page at a time, reading whole columns of the
+ * current page, or a record at a time.
+ */
+class PaxFileScan {
+ public:
+  /**
+   * Opens a scan over the given relation.
+   *
+   * @param name    Name of the relation file.
+   * @param bufMgr  Buffer manager instance.
+   */
+  PaxFileScan(const std::string &name, BufMgr *bufMgr);
+
+  /**
+   * Unpins the current page, flushes the pages of the scan out of the buffer
+   * pool and closes the relation.
+   */
+  ~PaxFileScan();
+
+  /**
+   * Moves to the next page of the relation, pinning it.
+   *
+   * @return  False if there are no more pages.
+   */
+  bool nextPage();
+
+  /**
+   * Moves to the next record of the relation.
+   *
+   * @param outRid  Receives the ID of the record.
+   * @throws  EndOfFileException  If there are no more records.
+   */
+  void scanNext(RecordId &outRid);
+
+  /**
+   * Returns the page the scan is on.
+   */
+  PaxPage currentPage() const { return PaxPage(curPage_); }
+
+  /**
+   * Returns the number of the page the scan is on.
+   */
+  PageId currentPageNo() const { return filePageIter_.page_number(); }
+
+  /**
+   * Returns the value of an attribute of the current record.
+   *
+   * @param attribute   Index of the attribute.
+   */
+  const char *getValue(const std::size_t attribute) const {
+    return currentPage().value(attribute, curSlot_);
+  }
+
+  /**
+   * Returns a copy of the current record in row format.
+   */
+  std::string getRecord() const;
+
+ private:
+  /**
+   * File which is being scanned.
+   */
+  PageFile *file_;
+
+  /**
+   * Buffer Manager instance used to read pages into the buffer pool.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Current page being scanned, NULL before the first page and at the end.
+   */
+  Page *curPage_;
+
+  /**
+   * Iterator on the page being scanned.
+   */
+  FileIterator filePageIter_;
+
+  /**
+   * Slot of the current record in the current page.
+   */
+  SlotId curSlot_;
+};
+
+}  // namespace badgerdb
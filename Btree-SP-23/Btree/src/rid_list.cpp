@@ -0,0 +1,249 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "rid_list.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace badgerdb {
+
+/**
+ * Number of significant bits of a packed RecordId: 32 for the page number and
+ * 16 for the slot number.
+ */
+static const int PACKED_RID_BITS = 48;
+
+/**
+ * Above this ratio between the lengths of two lists, intersection gallops
+ * through the longer one instead of merging.
+ */
+static const std::size_t GALLOP_RATIO = 32;
+
+/**
+ * Packs a RecordId into an integer whose order is the (page, slot) order.
+ */
+static inline std::uint64_t packRid(const RecordId &rid) {
+  return (std::uint64_t(rid.page_number) << 16) | rid.slot_number;
+}
+
+static inline RecordId unpackRid(const std::uint64_t key) {
+  RecordId rid;
+  rid.page_number = PageId(key >> 16);
+  rid.slot_number = SlotId(key & 0xFFFF);
+  return rid;
+}
+
+static void packRids(const std::vector<RecordId> &rids,
+                     std::vector<std::uint64_t> &keys) {
+  keys.resize(rids.size());
+  for (std::size_t i = 0; i < rids.size(); i++) {
+    keys[i] = packRid(rids[i]);
+  }
+}
+
+static void unpackRids(const std::vector<std::uint64_t> &keys,
+                       std::vector<RecordId> &rids) {
+  rids.resize(keys.size());
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    rids[i] = unpackRid(keys[i]);
+  }
+}
+
+/**
+ * LSD radix sort of packed RecordIds, one byte per pass. Passes where every
+ * key has the same byte (typically the high bytes of the page number) are
+ * skipped. Duplicates are removed afterwards.
+ */
+static void radixSortKeys(std::vector<std::uint64_t> &keys) {
+  if (keys.size() < 2) {
+    return;
+  }
+  std::vector<std::uint64_t> buffer(keys.size());
+  for (int shift = 0; shift < PACKED_RID_BITS; shift += 8) {
+    std::size_t counts[256] = {0};
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      counts[(keys[i] >> shift) & 0xFF]++;
+    }
+    if (counts[(keys[0] >> shift) & 0xFF] == keys.size()) {
+      continue;
+    }
+    std::size_t offset = 0;
+    for (int b = 0; b < 256; b++) {
+      std::size_t count = counts[b];
+      counts[b] = offset;
+      offset += count;
+    }
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      buffer[counts[(keys[i] >> shift) & 0xFF]++] = keys[i];
+    }
+    keys.swap(buffer);
+  }
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+/**
+ * Intersects two sorted key lists, galloping through the longer one if the
+ * lists are very unbalanced.
+ */
+static void intersectKeys(const std::vector<std::uint64_t> &a,
+                          const std::vector<std::uint64_t> &b,
+                          std::vector<std::uint64_t> &out) {
+  const std::vector<std::uint64_t> &shorter = a.size() <= b.size() ? a : b;
+  const std::vector<std::uint64_t> &longer = a.size() <= b.size() ? b : a;
+  out.clear();
+
+  if (longer.size() / GALLOP_RATIO > shorter.size()) {
+    const std::size_t n = longer.size();
+    std::size_t lo = 0;
+    for (std::size_t i = 0; i < shorter.size() && lo < n; i++) {
+      const std::uint64_t key = shorter[i];
+      // Double the step until an entry not less than the key is passed
+      std::size_t hi = lo;
+      std::size_t step = 1;
+      while (hi < n && longer[hi] < key) {
+        lo = hi + 1;
+        hi += step;
+        step <<= 1;
+      }
+      std::size_t end = hi < n ? hi + 1 : n;
+      lo = std::lower_bound(longer.begin() + lo, longer.begin() + end, key) -
+           longer.begin();
+      if (lo < n && longer[lo] == key) {
+        out.push_back(key);
+        lo++;
+      }
+    }
+    return;
+  }
+
+  std::size_t i = 0, j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (b[j] < a[i]) {
+      j++;
+    } else {
+      out.push_back(a[i]);
+      i++;
+      j++;
+    }
+  }
+}
+
+static void unionKeys(const std::vector<std::uint64_t> &a,
+                      const std::vector<std::uint64_t> &b,
+                      std::vector<std::uint64_t> &out) {
+  out.clear();
+  out.reserve(a.size() + b.size());
+  std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                 std::back_inserter(out));
+}
+
+/**
+ * Runs every scan and returns the sorted key list of each, shortest first.
+ */
+static void collectSortedKeys(const std::vector<IndexPredicate> &predicates,
+                              std::vector<std::vector<std::uint64_t> > &lists) {
+  lists.resize(predicates.size());
+  std::vector<RecordId> rids;
+  for (std::size_t i = 0; i < predicates.size(); i++) {
+    rids.clear();
+    collectRids(predicates[i], rids);
+    packRids(rids, lists[i]);
+    radixSortKeys(lists[i]);
+  }
+  for (std::size_t i = 1; i < lists.size(); i++) {
+    for (std::size_t j = i; j > 0 && lists[j].size() < lists[j - 1].size();
+         j--) {
+      lists[j].swap(lists[j - 1]);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// collectRids
+// -----------------------------------------------------------------------------
+
+void collectRids(const IndexPredicate &predicate,
+                 std::vector<RecordId> &outRids) {
+  predicate.index->tryStartScan(predicate.lowVal, predicate.lowOp,
+                                predicate.highVal, predicate.highOp);
+  RecordId rid;
+  while (predicate.index->tryScanNext(rid)) {
+    outRids.push_back(rid);
+  }
+  predicate.index->endScan();
+}
+
+// -----------------------------------------------------------------------------
+// sortRids / intersectRids / unionRids
+// -----------------------------------------------------------------------------
+
+void sortRids(std::vector<RecordId> &rids) {
+  std::vector<std::uint64_t> keys;
+  packRids(rids, keys);
+  radixSortKeys(keys);
+  unpackRids(keys, rids);
+}
+
+void intersectRids(const std::vector<RecordId> &a,
+                   const std::vector<RecordId> &b,
+                   std::vector<RecordId> &outRids) {
+  std::vector<std::uint64_t> keysA, keysB, result;
+  packRids(a, keysA);
+  packRids(b, keysB);
+  intersectKeys(keysA, keysB, result);
+  unpackRids(result, outRids);
+}
+
+void unionRids(const std::vector<RecordId> &a, const std::vector<RecordId> &b,
+               std::vector<RecordId> &outRids) {
+  std::vector<std::uint64_t> keysA, keysB, result;
+  packRids(a, keysA);
+  packRids(b, keysB);
+  unionKeys(keysA, keysB, result);
+  unpackRids(result, outRids);
+}
+
+// -----------------------------------------------------------------------------
+// intersectScans / unionScans
+// -----------------------------------------------------------------------------
+
+void intersectScans(const std::vector<IndexPredicate> &predicates,
+                    std::vector<RecordId> &outRids) {
+  outRids.clear();
+  if (predicates.empty()) {
+    return;
+  }
+  std::vector<std::vector<std::uint64_t> > lists;
+  collectSortedKeys(predicates, lists);
+  std::vector<std::uint64_t> result(lists[0]);
+  std::vector<std::uint64_t> next;
+  for (std::size_t i = 1; i < lists.size() && !result.empty(); i++) {
+    intersectKeys(result, lists[i], next);
+    result.swap(next);
+  }
+  unpackRids(result, outRids);
+}
+
+void unionScans(const std::vector<IndexPredicate> &predicates,
+                std::vector<RecordId> &outRids) {
+  outRids.clear();
+  std::vector<std::vector<std::uint64_t> > lists;
+  collectSortedKeys(predicates, lists);
+  std::vector<std::uint64_t> result;
+  std::vector<std::uint64_t> next;
+  for (std::size_t i = 0; i < lists.size(); i++) {
+    unionKeys(result, lists[i], next);
+    result.swap(next);
+  }
+  unpackRids(result, outRids);
+}
+
+}  // namespace badgerdb
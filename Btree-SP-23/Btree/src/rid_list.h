@@ -0,0 +1,94 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "btree.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief A range predicate answered by one BTreeIndex, with the same
+ * arguments as BTreeIndex::startScan().
+ */
+struct IndexPredicate {
+  BTreeIndex *index;
+  const void *lowVal;
+  Operator lowOp;
+  const void *highVal;
+  Operator highOp;
+};
+
+/**
+ * Runs the scan of a predicate to completion and appends the RecordIds it
+ * returns to <outRids>, in index order. A scan matching no key adds nothing.
+ *
+ * @param predicate   Predicate to scan.
+ * @param outRids     RecordIds are appended to this vector.
+ * @throws  BadOpcodesException, BadScanrangeException as
+ * BTreeIndex::startScan().
+ */
+void collectRids(const IndexPredicate &predicate,
+                 std::vector<RecordId> &outRids);
+
+/**
+ * Sorts RecordIds by (page_number, slot_number) with a radix sort and removes
+ * duplicates, so the records can then be fetched in page order.
+ *
+ * @param rids    RecordIds to sort in place.
+ */
+void sortRids(std::vector<RecordId> &rids);
+
+/**
+ * Intersects two RecordId lists sorted by sortRids(). When one list is much
+ * shorter, its entries are searched in the other by galloping instead of a
+ * full merge.
+ *
+ * @param a, b      Sorted lists.
+ * @param outRids   Receives the sorted RecordIds present in both lists.
+ */
+void intersectRids(const std::vector<RecordId> &a,
+                   const std::vector<RecordId> &b,
+                   std::vector<RecordId> &outRids);
+
+/**
+ * Unites two RecordId lists sorted by sortRids().
+ *
+ * @param a, b      Sorted lists.
+ * @param outRids   Receives the sorted RecordIds present in either list.
+ */
+void unionRids(const std::vector<RecordId> &a, const std::vector<RecordId> &b,
+               std::vector<RecordId> &outRids);
+
+/**
+ * Answers a conjunction of predicates: runs every scan, sorts each RecordId
+ * list and intersects them starting from the shortest one.
+ *
+ * @param predicates  Predicates to combine, possibly on different indexes of
+ * the same relation.
+ * @param outRids     Receives the RecordIds matching all the predicates, in
+ * page order.
+ */
+void intersectScans(const std::vector<IndexPredicate> &predicates,
+                    std::vector<RecordId> &outRids);
+
+/**
+ * Answers a disjunction of predicates: runs every scan, sorts each RecordId
+ * list and unites them.
+ *
+ * @param predicates  Predicates to combine.
+ * @param outRids     Receives the RecordIds matching any of the predicates, in
+ * page order.
+ */
+void unionScans(const std::vector<IndexPredicate> &predicates,
+                std::vector<RecordId> &outRids);
+
+}  // namespace badgerdb
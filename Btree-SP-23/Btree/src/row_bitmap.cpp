@@ -0,0 +1,395 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "row_bitmap.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace badgerdb {
+
+/**
+ * Combines two bitmap containers word by word, 128 bits at a time with SSE2.
+ */
+static void combineWords(const std::uint64_t *a, const std::uint64_t *b,
+                         std::uint64_t *out, const int op) {
+  const std::uint32_t numWords = RowBitmap::BITMAP_WORDS;
+#ifdef __SSE2__
+  const __m128i *va = (const __m128i *)a;
+  const __m128i *vb = (const __m128i *)b;
+  __m128i *vout = (__m128i *)out;
+  const std::uint32_t numVectors = numWords / 2;
+  switch (op) {
+    case 0:
+      for (std::uint32_t i = 0; i < numVectors; i++) {
+        _mm_storeu_si128(vout + i, _mm_and_si128(_mm_loadu_si128(va + i),
+                                                 _mm_loadu_si128(vb + i)));
+      }
+      break;
+    case 1:
+      for (std::uint32_t i = 0; i < numVectors; i++) {
+        _mm_storeu_si128(vout + i, _mm_or_si128(_mm_loadu_si128(va + i),
+                                                _mm_loadu_si128(vb + i)));
+      }
+      break;
+    default:
+      // _mm_andnot_si128(x, y) computes ~x & y
+      for (std::uint32_t i = 0; i < numVectors; i++) {
+        _mm_storeu_si128(vout + i, _mm_andnot_si128(_mm_loadu_si128(vb + i),
+                                                    _mm_loadu_si128(va + i)));
+      }
+      break;
+  }
+#else
+  for (std::uint32_t i = 0; i < numWords; i++) {
+    switch (op) {
+      case 0:
+        out[i] = a[i] & b[i];
+        break;
+      case 1:
+        out[i] = a[i] | b[i];
+        break;
+      default:
+        out[i] = a[i] & ~b[i];
+        break;
+    }
+  }
+#endif
+}
+
+static inline bool testBit(const std::vector<std::uint64_t> &words,
+                           const std::uint16_t low) {
+  return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+// -----------------------------------------------------------------------------
+// RowBitmap::add / contains / cardinality
+// -----------------------------------------------------------------------------
+
+void RowBitmap::add(const std::uint32_t row) {
+  const std::uint16_t key = row >> 16;
+  const std::uint16_t low = row & 0xFFFF;
+
+  std::vector<Container>::iterator it = containers_.begin();
+  while (it != containers_.end() && it->key < key) {
+    ++it;
+  }
+  if (it == containers_.end() || it->key != key) {
+    Container c;
+    c.key = key;
+    c.cardinality = 0;
+    it = containers_.insert(it, c);
+  }
+
+  if (it->isBitmap()) {
+    if (!testBit(it->words, low)) {
+      it->words[low >> 6] |= std::uint64_t(1) << (low & 63);
+      it->cardinality++;
+    }
+    return;
+  }
+
+  std::vector<std::uint16_t>::iterator pos =
+      std::lower_bound(it->array.begin(), it->array.end(), low);
+  if (pos != it->array.end() && *pos == low) {
+    return;
+  }
+  it->array.insert(pos, low);
+  it->cardinality++;
+  if (it->cardinality > ARRAY_MAX_SIZE) {
+    // Container became dense, switch it to a bitmap
+    std::vector<std::uint64_t> words(BITMAP_WORDS, 0);
+    toWords(*it, &words[0]);
+    it->words.swap(words);
+    std::vector<std::uint16_t>().swap(it->array);
+  }
+}
+
+bool RowBitmap::contains(const std::uint32_t row) const {
+  const std::uint16_t key = row >> 16;
+  const std::uint16_t low = row & 0xFFFF;
+  for (std::size_t i = 0; i < containers_.size(); i++) {
+    const Container &c = containers_[i];
+    if (c.key < key) {
+      continue;
+    }
+    if (c.key > key) {
+      return false;
+    }
+    if (c.isBitmap()) {
+      return testBit(c.words, low);
+    }
+    return std::binary_search(c.array.begin(), c.array.end(), low);
+  }
+  return false;
+}
+
+std::uint64_t RowBitmap::cardinality() const {
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < containers_.size(); i++) {
+    total += containers_[i].cardinality;
+  }
+  return total;
+}
+
+// -----------------------------------------------------------------------------
+// RowBitmap::toWords / fromWords
+// -----------------------------------------------------------------------------
+
+void RowBitmap::toWords(const Container &c, std::uint64_t *out) {
+  if (c.isBitmap()) {
+    memcpy(out, &c.words[0], BITMAP_WORDS * sizeof(std::uint64_t));
+    return;
+  }
+  memset(out, 0, BITMAP_WORDS * sizeof(std::uint64_t));
+  for (std::size_t i = 0; i < c.array.size(); i++) {
+    out[c.array[i] >> 6] |= std::uint64_t(1) << (c.array[i] & 63);
+  }
+}
+
+void RowBitmap::fromWords(const std::uint64_t *words, Container &out) {
+  std::uint32_t count = 0;
+  for (std::uint32_t i = 0; i < BITMAP_WORDS; i++) {
+    count += __builtin_popcountll(words[i]);
+  }
+  out.cardinality = count;
+  out.array.clear();
+  out.words.clear();
+  if (count > ARRAY_MAX_SIZE) {
+    out.words.assign(words, words + BITMAP_WORDS);
+    return;
+  }
+  out.array.reserve(count);
+  for (std::uint32_t i = 0; i < BITMAP_WORDS; i++) {
+    std::uint64_t w = words[i];
+    while (w) {
+      out.array.push_back(i * 64 + __builtin_ctzll(w));
+      w &= w - 1;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// RowBitmap::combine
+// -----------------------------------------------------------------------------
+
+bool RowBitmap::combine(const Container &a, const Container &b,
+                        const Operation op, Container &out) {
+  out.key = a.key;
+  out.array.clear();
+  out.words.clear();
+
+  if (!a.isBitmap() && !b.isBitmap()) {
+    // Both sparse, merge the sorted arrays
+    switch (op) {
+      case OP_AND:
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(),
+                              b.array.end(), std::back_inserter(out.array));
+        break;
+      case OP_OR:
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(),
+                       b.array.end(), std::back_inserter(out.array));
+        break;
+      case OP_ANDNOT:
+        std::set_difference(a.array.begin(), a.array.end(), b.array.begin(),
+                            b.array.end(), std::back_inserter(out.array));
+        break;
+    }
+    out.cardinality = out.array.size();
+    if (out.cardinality > ARRAY_MAX_SIZE) {
+      std::vector<std::uint64_t> words(BITMAP_WORDS, 0);
+      toWords(out, &words[0]);
+      out.words.swap(words);
+      std::vector<std::uint16_t>().swap(out.array);
+    }
+    return out.cardinality > 0;
+  }
+
+  if (op != OP_OR && !a.isBitmap()) {
+    // Sparse left side, probe the bitmap of the right side
+    for (std::size_t i = 0; i < a.array.size(); i++) {
+      if (testBit(b.words, a.array[i]) == (op == OP_AND)) {
+        out.array.push_back(a.array[i]);
+      }
+    }
+    out.cardinality = out.array.size();
+    return out.cardinality > 0;
+  }
+  if (op == OP_AND && !b.isBitmap()) {
+    for (std::size_t i = 0; i < b.array.size(); i++) {
+      if (testBit(a.words, b.array[i])) {
+        out.array.push_back(b.array[i]);
+      }
+    }
+    out.cardinality = out.array.size();
+    return out.cardinality > 0;
+  }
+
+  // Combine the bitmaps of the two containers
+  std::uint64_t wordsA[BITMAP_WORDS];
+  std::uint64_t wordsB[BITMAP_WORDS];
+  std::uint64_t result[BITMAP_WORDS];
+  toWords(a, wordsA);
+  toWords(b, wordsB);
+  combineWords(wordsA, wordsB, result, op);
+  fromWords(result, out);
+  return out.cardinality > 0;
+}
+
+// -----------------------------------------------------------------------------
+// RowBitmap boolean operations
+// -----------------------------------------------------------------------------
+
+RowBitmap RowBitmap::apply(const RowBitmap &other, const Operation op) const {
+  RowBitmap result;
+  std::size_t i = 0, j = 0;
+  while (i < containers_.size() || j < other.containers_.size()) {
+    if (j == other.containers_.size() ||
+        (i < containers_.size() &&
+         containers_[i].key < other.containers_[j].key)) {
+      // Key only present in this set
+      if (op != OP_AND) {
+        result.containers_.push_back(containers_[i]);
+      }
+      i++;
+    } else if (i == containers_.size() ||
+               other.containers_[j].key < containers_[i].key) {
+      // Key only present in the other set
+      if (op == OP_OR) {
+        result.containers_.push_back(other.containers_[j]);
+      }
+      j++;
+    } else {
+      Container c;
+      if (combine(containers_[i], other.containers_[j], op, c)) {
+        result.containers_.push_back(c);
+      }
+      i++;
+      j++;
+    }
+  }
+  return result;
+}
+
+RowBitmap RowBitmap::operator&(const RowBitmap &other) const {
+  return apply(other, OP_AND);
+}
+
+RowBitmap RowBitmap::operator|(const RowBitmap &other) const {
+  return apply(other, OP_OR);
+}
+
+RowBitmap RowBitmap::andNot(const RowBitmap &other) const {
+  return apply(other, OP_ANDNOT);
+}
+
+RowBitmap RowBitmap::flip(const std::uint32_t numRows) const {
+  return range(numRows).andNot(*this);
+}
+
+RowBitmap RowBitmap::range(const std::uint32_t numRows) {
+  RowBitmap result;
+  for (std::uint64_t base = 0; base < numRows; base += 65536) {
+    std::uint32_t count = 65536;
+    if (numRows - base < count) {
+      count = numRows - base;
+    }
+    Container c;
+    c.key = base >> 16;
+    c.cardinality = count;
+    if (count > ARRAY_MAX_SIZE) {
+      c.words.assign(BITMAP_WORDS, 0);
+      for (std::uint32_t w = 0; w < count / 64; w++) {
+        c.words[w] = ~std::uint64_t(0);
+      }
+      if (count % 64) {
+        c.words[count / 64] = (std::uint64_t(1) << (count % 64)) - 1;
+      }
+    } else {
+      for (std::uint32_t low = 0; low < count; low++) {
+        c.array.push_back(low);
+      }
+    }
+    result.containers_.push_back(c);
+  }
+  return result;
+}
+
+void RowBitmap::toRows(std::vector<std::uint32_t> &out) const {
+  for (std::size_t i = 0; i < containers_.size(); i++) {
+    const Container &c = containers_[i];
+    const std::uint32_t base = std::uint32_t(c.key) << 16;
+    if (!c.isBitmap()) {
+      for (std::size_t k = 0; k < c.array.size(); k++) {
+        out.push_back(base | c.array[k]);
+      }
+      continue;
+    }
+    for (std::uint32_t w = 0; w < BITMAP_WORDS; w++) {
+      std::uint64_t word = c.words[w];
+      while (word) {
+        out.push_back(base | (w * 64 + __builtin_ctzll(word)));
+        word &= word - 1;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// RowBitmap::write / read
+// -----------------------------------------------------------------------------
+
+void RowBitmap::write(BlobWriter &writer) const {
+  writer.writeValue(std::uint32_t(containers_.size()));
+  for (std::size_t i = 0; i < containers_.size(); i++) {
+    const Container &c = containers_[i];
+    writer.writeValue(c.key);
+    writer.writeValue(c.cardinality);
+    if (c.isBitmap()) {
+      writer.write(&c.words[0], BITMAP_WORDS * sizeof(std::uint64_t));
+    } else {
+      writer.write(&c.array[0], c.array.size() * sizeof(std::uint16_t));
+    }
+  }
+}
+
+bool RowBitmap::read(BlobReader &reader) {
+  containers_.clear();
+  std::uint32_t numContainers;
+  if (!reader.readValue(numContainers)) {
+    return false;
+  }
+  containers_.resize(numContainers);
+  for (std::uint32_t i = 0; i < numContainers; i++) {
+    Container &c = containers_[i];
+    if (!reader.readValue(c.key) || !reader.readValue(c.cardinality)) {
+      return false;
+    }
+    // The representation follows from the cardinality
+    bool ok;
+    if (c.cardinality > ARRAY_MAX_SIZE) {
+      c.words.resize(BITMAP_WORDS);
+      ok = reader.read(&c.words[0], BITMAP_WORDS * sizeof(std::uint64_t));
+    } else {
+      c.array.resize(c.cardinality);
+      ok = reader.read(&c.array[0], c.cardinality * sizeof(std::uint16_t));
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,171 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "blob_stream.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Compressed set of row numbers, organized like a Roaring bitmap. Rows
+ * are split by their high 16 bits into containers; a container holding few
+ * rows is a sorted array of the low 16 bits, a dense one is a plain 2^16 bit
+ * bitmap. Boolean combination of bitmap containers is done with SSE2 when
+ * available.
+ */
+class RowBitmap {
+ public:
+  /**
+   * Maximum number of rows a container keeps as a sorted array. Above it a
+   * bitmap container takes less space.
+   */
+  static const std::uint32_t ARRAY_MAX_SIZE = 4096;
+
+  /**
+   * Number of 64-bit words of a bitmap container.
+   */
+  static const std::uint32_t BITMAP_WORDS = 1024;
+
+  /**
+   * Adds a row to the set.
+   *
+   * @param row   Row number to add.
+   */
+  void add(const std::uint32_t row);
+
+  /**
+   * @param row   Row number to test.
+   * @return  True if the row is in the set.
+   */
+  bool contains(const std::uint32_t row) const;
+
+  /**
+   * Returns the number of rows in the set.
+   */
+  std::uint64_t cardinality() const;
+
+  /**
+   * Returns true if the set holds no row.
+   */
+  bool empty() const { return containers_.empty(); }
+
+  /**
+   * Returns the rows which are in both sets.
+   */
+  RowBitmap operator&(const RowBitmap &other) const;
+
+  /**
+   * Returns the rows which are in either set.
+   */
+  RowBitmap operator|(const RowBitmap &other) const;
+
+  /**
+   * Returns the rows of this set which are not in <other>.
+   */
+  RowBitmap andNot(const RowBitmap &other) const;
+
+  /**
+   * Returns the complement of the set within rows [0, numRows).
+   *
+   * @param numRows   Number of rows of the universe.
+   */
+  RowBitmap flip(const std::uint32_t numRows) const;
+
+  /**
+   * Returns the set of all rows [0, numRows).
+   *
+   * @param numRows   Number of rows.
+   */
+  static RowBitmap range(const std::uint32_t numRows);
+
+  /**
+   * Appends the rows of the set, in increasing order, to <out>.
+   */
+  void toRows(std::vector<std::uint32_t> &out) const;
+
+  /**
+   * Writes the set to a blob stream.
+   */
+  void write(BlobWriter &writer) const;
+
+  /**
+   * Reads a set written by write() from a blob stream.
+   *
+   * @return  False if the stream ended before the whole set could be read.
+   */
+  bool read(BlobReader &reader);
+
+ private:
+  /**
+   * Boolean operations supported between two sets.
+   */
+  enum Operation { OP_AND, OP_OR, OP_ANDNOT };
+
+  /**
+   * Rows sharing the same high 16 bits.
+   */
+  struct Container {
+    /**
+     * High 16 bits of the rows in the container.
+     */
+    std::uint16_t key;
+
+    /**
+     * Sorted low 16 bits of the rows, used while the container is sparse.
+     */
+    std::vector<std::uint16_t> array;
+
+    /**
+     * Bitmap of the low 16 bits of the rows, used once the container holds
+     * more than ARRAY_MAX_SIZE rows. Empty for array containers.
+     */
+    std::vector<std::uint64_t> words;
+
+    /**
+     * Number of rows in the container.
+     */
+    std::uint32_t cardinality;
+
+    bool isBitmap() const { return !words.empty(); }
+  };
+
+  /**
+   * Combines two containers having the same key. Returns false if the result
+   * is empty.
+   */
+  static bool combine(const Container &a, const Container &b,
+                      const Operation op, Container &out);
+
+  /**
+   * Fills <out> with the bitmap form of a container.
+   */
+  static void toWords(const Container &c, std::uint64_t *out);
+
+  /**
+   * Sets a container from a bitmap, choosing its representation from the
+   * number of bits set.
+   */
+  static void fromWords(const std::uint64_t *words, Container &out);
+
+  /**
+   * Combines two sets container by container.
+   */
+  RowBitmap apply(const RowBitmap &other, const Operation op) const;
+
+  /**
+   * Containers sorted by key.
+   */
+  std::vector<Container> containers_;
+};
+
+}  // namespace badgerdb
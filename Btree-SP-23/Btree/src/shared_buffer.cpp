@@ -0,0 +1,976 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "shared_buffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <iostream>
+
+#include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+#include "exceptions/page_not_pinned_exception.h"
+#include "exceptions/page_pinned_exception.h"
+#include "exceptions/shared_segment_exception.h"
+
+namespace badgerdb {
+
+/**
+ * Tells a segment is initialized, and built by this code.
+ */
+static const std::uint32_t SHARED_SEGMENT_MAGIC = 0x42446254;
+
+/**
+ * Number of times to wait for a segment being created or removed by another
+ * process, 1ms each.
+ */
+static const int SHARED_ATTACH_RETRIES = 5000;
+
+/**
+ * Time a process waits for the I/O of another on a frame before checking
+ * that the other is still alive.
+ */
+static const long SHARED_IO_WAIT_NS = 10 * 1000 * 1000;
+
+/**
+ * I/O a frame is reserved for. The latch is not held during the I/O.
+ */
+static const std::uint8_t SHARED_IO_NONE = 0;
+static const std::uint8_t SHARED_IO_READING = 1; /* Contents not valid yet */
+static const std::uint8_t SHARED_IO_WRITING = 2; /* Not to be evicted */
+
+/**
+ * @brief A file with pages in the pool. Unused if the name is empty.
+ */
+struct SharedFileEntry {
+  char name[SHARED_FILENAME_LENGTH];
+  std::uint32_t blob;
+
+  /**
+   * Number of the registration of the file, so the processes tell apart a
+   * file registered again, possibly another file of the same name.
+   */
+  std::uint32_t generation;
+};
+
+/**
+ * @brief Descriptor of a frame. The frames of a page table bucket are chained
+ * through next. A descriptor is marked valid last when assigned and invalid
+ * first when released, so one left half updated by a dead process is dropped.
+ */
+struct SharedFrameDesc {
+  std::uint32_t fileId;
+  PageId pageNo;
+  std::int32_t pinCnt;
+  std::int32_t next;
+  std::uint32_t ioOwner;
+  std::uint8_t dirty;
+  std::uint8_t valid;
+  std::uint8_t refbit;
+  std::uint8_t io;
+};
+
+/**
+ * @brief Start of the shared memory segment. The frame descriptors, the page
+ * table buckets, the pins and the frames follow it, at the offsets it
+ * records.
+ */
+struct SharedSegment {
+  std::uint32_t magic;
+  volatile std::uint32_t ready;
+  std::uint32_t closed;
+  std::uint32_t broken;
+  std::uint32_t numBufs;
+  std::uint32_t htSize;
+  std::uint32_t clockHand;
+  std::uint32_t attached;
+  std::uint32_t lastGeneration;
+  std::size_t descOffset;
+  std::size_t bucketOffset;
+  std::size_t pinOffset;
+  std::size_t frameOffset;
+  pthread_mutex_t latch;
+
+  /**
+   * Signaled whenever the I/O on a frame is over.
+   */
+  pthread_cond_t ioDone;
+
+  /**
+   * Processes attached, 0 for a free entry.
+   */
+  pid_t processes[SHARED_MAX_PROCESSES];
+
+  SharedFileEntry files[SHARED_MAX_FILES];
+};
+
+static SharedFrameDesc *descsOf(SharedSegment *segment) {
+  return (SharedFrameDesc *)((char *)segment + segment->descOffset);
+}
+
+static std::int32_t *bucketsOf(SharedSegment *segment) {
+  return (std::int32_t *)((char *)segment + segment->bucketOffset);
+}
+
+/**
+ * Returns the pins of every process on a frame, SHARED_MAX_PROCESSES
+ * counters.
+ */
+static std::int32_t *pinsOf(SharedSegment *segment, const FrameId frame) {
+  return (std::int32_t *)((char *)segment + segment->pinOffset) +
+         frame * SHARED_MAX_PROCESSES;
+}
+
+static std::size_t roundUp(const std::size_t size, const std::size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+static std::uint32_t bucketOf(const SharedSegment *segment,
+                              const std::uint32_t fileId,
+                              const PageId pageNo) {
+  return (fileId * 31 + pageNo) % segment->htSize;
+}
+
+static void clearDesc(SharedSegment *segment, const FrameId frame) {
+  SharedFrameDesc &desc = descsOf(segment)[frame];
+  desc.valid = 0;
+  __sync_synchronize();
+  desc.fileId = SHARED_MAX_FILES;
+  desc.pageNo = Page::INVALID_NUMBER;
+  desc.pinCnt = 0;
+  desc.next = -1;
+  desc.ioOwner = 0;
+  desc.dirty = 0;
+  desc.refbit = 0;
+  desc.io = SHARED_IO_NONE;
+  memset(pinsOf(segment, frame), 0,
+         SHARED_MAX_PROCESSES * sizeof(std::int32_t));
+}
+
+static bool processAlive(const pid_t pid) {
+  return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/**
+ * Drops the processes of a segment which died without detaching: their pins
+ * are released, the pages they were reading dropped and the pages they were
+ * writing marked dirty again. Then, or if forced because a process died
+ * holding the latch, the page table and the pin counts are rebuilt from the
+ * frame descriptors, dropping the descriptors which are not consistent, and
+ * the entries of the files without pages are freed. Called with the latch
+ * held.
+ */
+static void recoverSegment(SharedSegment *segment, const bool force) {
+  SharedFrameDesc *descs = descsOf(segment);
+  const std::uint32_t numBufs = segment->numBufs;
+  bool died = false;
+  for (std::uint32_t slot = 0; slot < SHARED_MAX_PROCESSES; slot++) {
+    if (segment->processes[slot] == 0 ||
+        processAlive(segment->processes[slot])) {
+      continue;
+    }
+    died = true;
+    segment->processes[slot] = 0;
+    if (segment->attached > 0) {
+      segment->attached--;
+    }
+    for (std::uint32_t i = 0; i < numBufs; i++) {
+      pinsOf(segment, i)[slot] = 0;
+      if (descs[i].io != SHARED_IO_NONE && descs[i].ioOwner == slot) {
+        if (descs[i].io == SHARED_IO_READING) {
+          descs[i].valid = 0;
+        } else {
+          // The write may be torn on disk
+          descs[i].dirty = 1;
+        }
+        descs[i].io = SHARED_IO_NONE;
+      }
+    }
+  }
+  if (!died && !force) {
+    return;
+  }
+
+  std::int32_t *buckets = bucketsOf(segment);
+  for (std::uint32_t i = 0; i < segment->htSize; i++) {
+    buckets[i] = -1;
+  }
+  bool used[SHARED_MAX_FILES] = {false};
+  for (std::uint32_t i = 0; i < numBufs; i++) {
+    SharedFrameDesc &desc = descs[i];
+    bool keep = desc.valid && desc.fileId < SHARED_MAX_FILES &&
+                segment->files[desc.fileId].name[0] != '\0' &&
+                desc.pageNo != Page::INVALID_NUMBER;
+    std::int32_t *link = NULL;
+    if (keep) {
+      link = &buckets[bucketOf(segment, desc.fileId, desc.pageNo)];
+      for (std::int32_t other = *link; other >= 0;
+           other = descs[other].next) {
+        if (descs[other].fileId == desc.fileId &&
+            descs[other].pageNo == desc.pageNo) {
+          keep = false;
+        }
+      }
+    }
+    if (!keep) {
+      clearDesc(segment, i);
+      continue;
+    }
+    const std::int32_t *pins = pinsOf(segment, i);
+    desc.pinCnt = 0;
+    for (std::uint32_t slot = 0; slot < SHARED_MAX_PROCESSES; slot++) {
+      desc.pinCnt += pins[slot];
+    }
+    desc.next = *link;
+    *link = i;
+    used[desc.fileId] = true;
+  }
+  for (std::uint32_t id = 0; id < SHARED_MAX_FILES; id++) {
+    if (!used[id]) {
+      segment->files[id].name[0] = '\0';
+    }
+  }
+  segment->clockHand %= numBufs;
+  pthread_cond_broadcast(&segment->ioDone);
+}
+
+/**
+ * @brief Holds the latch of a segment for its lifetime, unless released for
+ * an I/O. A latch left locked by a process which died is taken over and the
+ * segment recovered.
+ */
+class SegmentLatch {
+ public:
+  SegmentLatch(SharedSegment *segment, const std::string &segmentName)
+      : segment_(segment), segmentName_(segmentName), locked_(false) {
+    this->lock();
+  }
+
+  ~SegmentLatch() {
+    if (locked_) {
+      this->unlock();
+    }
+  }
+
+  /**
+   * @throws  SharedSegmentException  If the segment is unusable.
+   */
+  void lock() {
+    this->acquired(pthread_mutex_lock(&segment_->latch));
+  }
+
+  void unlock() {
+    locked_ = false;
+    pthread_mutex_unlock(&segment_->latch);
+  }
+
+  /**
+   * Waits until the I/O on some frame is over, or a while. Processes which
+   * died during their I/O are dropped meanwhile.
+   *
+   * @throws  SharedSegmentException  If the segment is unusable.
+   */
+  void waitForIo() {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += SHARED_IO_WAIT_NS;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000 * 1000 * 1000;
+    }
+    locked_ = false;
+    const int result = pthread_cond_timedwait(&segment_->ioDone,
+                                              &segment_->latch, &deadline);
+    this->acquired(result == ETIMEDOUT ? 0 : result);
+    if (result == ETIMEDOUT) {
+      recoverSegment(segment_, false);
+    }
+  }
+
+ private:
+  void acquired(const int result) {
+    if (result == EOWNERDEAD) {
+      locked_ = true;
+      // The owner died in the middle of an operation
+      recoverSegment(segment_, true);
+      if (pthread_mutex_consistent(&segment_->latch) != 0) {
+        segment_->broken = 1;
+        this->unlock();
+        throw SharedSegmentException(segmentName_, "latch not recoverable");
+      }
+      return;
+    }
+    if (result != 0) {
+      throw SharedSegmentException(segmentName_, "latch not recoverable");
+    }
+    locked_ = true;
+    if (segment_->broken) {
+      this->unlock();
+      throw SharedSegmentException(segmentName_, "segment unusable");
+    }
+  }
+
+  SharedSegment *segment_;
+  const std::string &segmentName_;
+  bool locked_;
+};
+
+// -----------------------------------------------------------------------------
+// SharedBufMgr::SharedBufMgr
+// -----------------------------------------------------------------------------
+
+SharedBufMgr::SharedBufMgr(const std::string &segmentName, std::uint32_t bufs)
+    : BufMgr(), segmentName_(segmentName), segment_(NULL), slot_(0) {
+  const std::uint32_t htSize = ((((int)(bufs * 1.2)) * 2) / 2) + 1;
+  const std::size_t descOffset = roundUp(sizeof(SharedSegment), 8);
+  const std::size_t bucketOffset = descOffset + bufs * sizeof(SharedFrameDesc);
+  const std::size_t pinOffset =
+      roundUp(bucketOffset + htSize * sizeof(std::int32_t), 8);
+  const std::size_t frameOffset = roundUp(
+      pinOffset + bufs * SHARED_MAX_PROCESSES * sizeof(std::int32_t),
+      Page::SIZE);
+  segmentSize_ = frameOffset + bufs * Page::SIZE;
+
+  for (int attempt = 0; segment_ == NULL; attempt++) {
+    if (attempt == SHARED_ATTACH_RETRIES) {
+      throw SharedSegmentException(segmentName_, "timed out attaching");
+    }
+    bool created = true;
+    int fd = shm_open(segmentName_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+      created = false;
+      fd = shm_open(segmentName_.c_str(), O_RDWR, 0600);
+      if (fd < 0 && errno == ENOENT) {
+        // Removed in between, try again
+        continue;
+      }
+    }
+    if (fd < 0) {
+      throw SharedSegmentException(segmentName_, strerror(errno));
+    }
+    if (created && ftruncate(fd, segmentSize_) != 0) {
+      const int error = errno;
+      close(fd);
+      shm_unlink(segmentName_.c_str());
+      throw SharedSegmentException(segmentName_, strerror(error));
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+      // Still being sized by the process creating it
+      close(fd);
+      usleep(1000);
+      continue;
+    }
+    if ((std::size_t)status.st_size != segmentSize_) {
+      close(fd);
+      throw SharedSegmentException(segmentName_,
+                                   "pool has another number of frames");
+    }
+    void *address = mmap(NULL, segmentSize_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+      throw SharedSegmentException(segmentName_, strerror(errno));
+    }
+    SharedSegment *segment = (SharedSegment *)address;
+
+    if (created) {
+      segment->magic = SHARED_SEGMENT_MAGIC;
+      segment->closed = 0;
+      segment->broken = 0;
+      segment->numBufs = bufs;
+      segment->htSize = htSize;
+      segment->clockHand = bufs - 1;
+      segment->attached = 0;
+      segment->lastGeneration = 0;
+      segment->descOffset = descOffset;
+      segment->bucketOffset = bucketOffset;
+      segment->pinOffset = pinOffset;
+      segment->frameOffset = frameOffset;
+      pthread_mutexattr_t attributes;
+      pthread_mutexattr_init(&attributes);
+      pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+      pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+      pthread_mutex_init(&segment->latch, &attributes);
+      pthread_mutexattr_destroy(&attributes);
+      pthread_condattr_t condAttributes;
+      pthread_condattr_init(&condAttributes);
+      pthread_condattr_setpshared(&condAttributes, PTHREAD_PROCESS_SHARED);
+      pthread_cond_init(&segment->ioDone, &condAttributes);
+      pthread_condattr_destroy(&condAttributes);
+      memset(segment->processes, 0, sizeof(segment->processes));
+      memset(segment->files, 0, sizeof(segment->files));
+      for (std::uint32_t i = 0; i < bufs; i++) {
+        clearDesc(segment, i);
+      }
+      std::int32_t *buckets = bucketsOf(segment);
+      for (std::uint32_t i = 0; i < htSize; i++) {
+        buckets[i] = -1;
+      }
+      __sync_synchronize();
+      segment->ready = 1;
+    } else {
+      for (int wait = 0; !segment->ready && wait < SHARED_ATTACH_RETRIES;
+           wait++) {
+        usleep(1000);
+      }
+      __sync_synchronize();
+      if (!segment->ready || segment->magic != SHARED_SEGMENT_MAGIC) {
+        munmap(address, segmentSize_);
+        throw SharedSegmentException(segmentName_, "segment not initialized");
+      }
+    }
+
+    try {
+      SegmentLatch latch(segment, segmentName_);
+      if (!segment->closed) {
+        // Frees the entries of the processes which died attached
+        recoverSegment(segment, false);
+        std::uint32_t slot = 0;
+        while (slot < SHARED_MAX_PROCESSES && segment->processes[slot] != 0) {
+          slot++;
+        }
+        if (slot == SHARED_MAX_PROCESSES) {
+          throw SharedSegmentException(segmentName_,
+                                       "too many processes attached");
+        }
+        segment->processes[slot] = getpid();
+        segment->attached++;
+        slot_ = slot;
+        segment_ = segment;
+      }
+    } catch (...) {
+      munmap(address, segmentSize_);
+      throw;
+    }
+    if (segment_ == NULL) {
+      // The last process detached after we opened it, wait for the removal
+      munmap(address, segmentSize_);
+      usleep(1000);
+    }
+  }
+
+  bufPool = (Page *)((char *)segment_ + segment_->frameOffset);
+}
+
+// -----------------------------------------------------------------------------
+// SharedBufMgr::~SharedBufMgr
+// -----------------------------------------------------------------------------
+
+SharedBufMgr::~SharedBufMgr() {
+  bool last = false;
+  try {
+    SegmentLatch latch(segment_, segmentName_);
+    SharedFrameDesc *descs = descsOf(segment_);
+    const std::uint32_t numBufs = segment_->numBufs;
+    for (std::uint32_t i = 0; i < numBufs; i++) {
+      std::int32_t &pins = pinsOf(segment_, i)[slot_];
+      descs[i].pinCnt -= pins;
+      pins = 0;
+    }
+    segment_->processes[slot_] = 0;
+    last = --segment_->attached == 0;
+    if (last) {
+      segment_->closed = 1;
+      for (std::uint32_t i = 0; i < numBufs; i++) {
+        if (descs[i].valid && descs[i].dirty &&
+            descs[i].io == SHARED_IO_NONE) {
+          writeBack(latch, i);
+        }
+      }
+    }
+  } catch (...) {
+    // The segment is unusable or a page could not be written back
+  }
+  for (std::map<std::string, std::pair<std::uint32_t, File *> >::iterator it =
+           openFiles_.begin();
+       it != openFiles_.end(); ++it) {
+    delete it->second.second;
+  }
+  munmap(segment_, segmentSize_);
+  if (last) {
+    shm_unlink(segmentName_.c_str());
+  }
+  // The frames are not owned by BufMgr
+  bufPool = NULL;
+}
+
+void SharedBufMgr::removeSegment(const std::string &segmentName) {
+  shm_unlink(segmentName.c_str());
+}
+
+// -----------------------------------------------------------------------------
+// Page table
+// -----------------------------------------------------------------------------
+
+std::uint32_t SharedBufMgr::fileId(const File *file, const bool registerFile) {
+  const std::string &name = file->filename();
+  if (name.size() >= SHARED_FILENAME_LENGTH) {
+    throw SharedSegmentException(segmentName_, "file name too long: " + name);
+  }
+  std::uint32_t freeId = SHARED_MAX_FILES;
+  for (std::uint32_t id = 0; id < SHARED_MAX_FILES; id++) {
+    const char *entryName = segment_->files[id].name;
+    if (entryName[0] == '\0') {
+      if (freeId == SHARED_MAX_FILES) {
+        freeId = id;
+      }
+    } else if (name == entryName) {
+      return id;
+    }
+  }
+  if (!registerFile) {
+    return SHARED_MAX_FILES;
+  }
+  if (freeId == SHARED_MAX_FILES) {
+    throw SharedSegmentException(segmentName_, "too many files in the pool");
+  }
+  SharedFileEntry &entry = segment_->files[freeId];
+  strcpy(entry.name, name.c_str());
+  entry.blob = dynamic_cast<const BlobFile *>(file) != NULL;
+  entry.generation = ++segment_->lastGeneration;
+  return freeId;
+}
+
+std::int32_t SharedBufMgr::findFrame(const std::uint32_t fileId,
+                                     const PageId pageNo) {
+  SharedFrameDesc *descs = descsOf(segment_);
+  std::int32_t frame = bucketsOf(segment_)[bucketOf(segment_, fileId, pageNo)];
+  while (frame >= 0) {
+    if (descs[frame].fileId == fileId && descs[frame].pageNo == pageNo) {
+      return frame;
+    }
+    frame = descs[frame].next;
+  }
+  return -1;
+}
+
+void SharedBufMgr::assignFrame(const FrameId frame, const std::uint32_t fileId,
+                               const PageId pageNo, const std::uint8_t io) {
+  SharedFrameDesc &desc = descsOf(segment_)[frame];
+  std::int32_t &bucket =
+      bucketsOf(segment_)[bucketOf(segment_, fileId, pageNo)];
+  desc.fileId = fileId;
+  desc.pageNo = pageNo;
+  desc.pinCnt = 0;
+  desc.ioOwner = slot_;
+  desc.dirty = 0;
+  desc.refbit = 1;
+  desc.io = io;
+  desc.next = bucket;
+  __sync_synchronize();
+  desc.valid = 1;
+  bucket = frame;
+}
+
+void SharedBufMgr::releaseFrame(const FrameId frame) {
+  SharedFrameDesc *descs = descsOf(segment_);
+  SharedFrameDesc &desc = descs[frame];
+  std::int32_t *link =
+      &bucketsOf(segment_)[bucketOf(segment_, desc.fileId, desc.pageNo)];
+  while (*link != (std::int32_t)frame) {
+    link = &descs[*link].next;
+  }
+  *link = desc.next;
+  clearDesc(segment_, frame);
+}
+
+void SharedBufMgr::pinFrame(const FrameId frame) {
+  pinsOf(segment_, frame)[slot_]++;
+  descsOf(segment_)[frame].pinCnt++;
+}
+
+bool SharedBufMgr::unpinFrame(const FrameId frame) {
+  std::int32_t &pins = pinsOf(segment_, frame)[slot_];
+  if (pins == 0) {
+    return false;
+  }
+  pins--;
+  descsOf(segment_)[frame].pinCnt--;
+  return true;
+}
+
+std::int32_t SharedBufMgr::readFrame(SegmentLatch &latch, File *file,
+                                     const PageId pageNo) {
+  SharedFrameDesc *descs = descsOf(segment_);
+  while (true) {
+    std::uint32_t id = fileId(file, true);
+    const std::int32_t found = findFrame(id, pageNo);
+    if (found >= 0) {
+      if (descs[found].io == SHARED_IO_READING) {
+        latch.waitForIo();
+        continue;
+      }
+      descs[found].refbit = 1;
+      pinFrame(found);
+      return found;
+    }
+    FrameId frame;
+    if (!tryAllocFrame(latch, frame)) {
+      return -1;
+    }
+    // The latch may have been released to write the victim back
+    id = fileId(file, true);
+    if (findFrame(id, pageNo) >= 0) {
+      continue;
+    }
+    assignFrame(frame, id, pageNo, SHARED_IO_READING);
+    pinFrame(frame);
+    latch.unlock();
+    try {
+      bufPool[frame] = file->readPage(pageNo);
+    } catch (...) {
+      latch.lock();
+      releaseFrame(frame);
+      pthread_cond_broadcast(&segment_->ioDone);
+      throw;
+    }
+    latch.lock();
+    descs[frame].io = SHARED_IO_NONE;
+    pthread_cond_broadcast(&segment_->ioDone);
+    bufStats.diskreads++;
+    return frame;
+  }
+}
+
+bool SharedBufMgr::tryAllocFrame(SegmentLatch &latch, FrameId &frame) {
+  SharedFrameDesc *descs = descsOf(segment_);
+  const std::uint32_t numBufs = segment_->numBufs;
+  for (int round = 0; round < 2; round++) {
+    if (round > 0) {
+      // Every frame is pinned, maybe by processes which died
+      recoverSegment(segment_, false);
+    }
+    for (std::uint32_t numScanned = 0; numScanned < 2 * numBufs;
+         numScanned++) {
+      segment_->clockHand = (segment_->clockHand + 1) % numBufs;
+      const FrameId hand = segment_->clockHand;
+      SharedFrameDesc &desc = descs[hand];
+      if (!desc.valid) {
+        frame = hand;
+        return true;
+      }
+      if (desc.io != SHARED_IO_NONE) {
+        continue;
+      }
+      if (desc.refbit) {
+        // has been referenced, clear the bit
+        bufStats.accesses++;
+        desc.refbit = 0;
+        continue;
+      }
+      if (desc.pinCnt > 0) {
+        continue;
+      }
+      if (desc.dirty) {
+        const std::uint32_t id = desc.fileId;
+        const PageId pageNo = desc.pageNo;
+        writeBack(latch, hand);
+        if (!desc.valid || desc.fileId != id || desc.pageNo != pageNo ||
+            desc.pinCnt > 0 || desc.dirty || desc.io != SHARED_IO_NONE) {
+          // Used again while the latch was released
+          continue;
+        }
+      }
+      releaseFrame(hand);
+      frame = hand;
+      return true;
+    }
+  }
+  return false;
+}
+
+void SharedBufMgr::writeBack(SegmentLatch &latch, const FrameId frame) {
+  SharedFrameDesc &desc = descsOf(segment_)[frame];
+  File *file = openFile(desc.fileId);
+  const PageId pageNo = desc.pageNo;
+  // Copied, as the page may be pinned and modified during the write
+  const Page page = bufPool[frame];
+  desc.dirty = 0;
+  desc.io = SHARED_IO_WRITING;
+  desc.ioOwner = slot_;
+  latch.unlock();
+  try {
+    file->writePage(pageNo, page);
+  } catch (...) {
+    latch.lock();
+    desc.dirty = 1;
+    desc.io = SHARED_IO_NONE;
+    pthread_cond_broadcast(&segment_->ioDone);
+    throw;
+  }
+  latch.lock();
+  desc.io = SHARED_IO_NONE;
+  pthread_cond_broadcast(&segment_->ioDone);
+  bufStats.diskwrites++;
+}
+
+File *SharedBufMgr::openFile(const std::uint32_t fileId) {
+  const SharedFileEntry &entry = segment_->files[fileId];
+  std::map<std::string, std::pair<std::uint32_t, File *> >::iterator it =
+      openFiles_.find(entry.name);
+  if (it != openFiles_.end()) {
+    if (it->second.first == entry.generation) {
+      return it->second.second;
+    }
+    // Registered again since, maybe for another file of the same name
+    delete it->second.second;
+    openFiles_.erase(it);
+  }
+  File *file;
+  if (entry.blob) {
+    file = new BlobFile(entry.name, false);
+  } else {
+    file = new PageFile(entry.name, false);
+  }
+  openFiles_[entry.name] = std::make_pair(entry.generation, file);
+  return file;
+}
+
+void SharedBufMgr::closeFile(const std::string &name) {
+  std::map<std::string, std::pair<std::uint32_t, File *> >::iterator it =
+      openFiles_.find(name);
+  if (it != openFiles_.end()) {
+    delete it->second.second;
+    openFiles_.erase(it);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// BufMgr interface
+// -----------------------------------------------------------------------------
+
+bool SharedBufMgr::tryReadPage(File *file, const PageId pageNo, Page *&page) {
+  SegmentLatch latch(segment_, segmentName_);
+  const std::int32_t frame = readFrame(latch, file, pageNo);
+  if (frame < 0) {
+    return false;
+  }
+  page = &bufPool[frame];
+  return true;
+}
+
+void SharedBufMgr::prefetchPage(File *file, const PageId pageNo) {
+  {
+    SegmentLatch latch(segment_, segmentName_);
+    const std::uint32_t id = fileId(file, false);
+    if (id != SHARED_MAX_FILES && findFrame(id, pageNo) >= 0) {
+      return;
+    }
+  }
+  file->adviseWillNeed(pageNo);
+}
+
+bool SharedBufMgr::tryReadCachedPage(File *file, const PageId pageNo,
+                                     Page *&page) {
+  SegmentLatch latch(segment_, segmentName_);
+  while (true) {
+    const std::uint32_t id = fileId(file, false);
+    const std::int32_t found =
+        id == SHARED_MAX_FILES ? -1 : findFrame(id, pageNo);
+    if (found < 0) {
+      return false;
+    }
+    SharedFrameDesc &desc = descsOf(segment_)[found];
+    if (desc.io == SHARED_IO_READING) {
+      latch.waitForIo();
+      continue;
+    }
+    desc.refbit = 1;
+    pinFrame(found);
+    page = &bufPool[found];
+    return true;
+  }
+}
+
+bool SharedBufMgr::installPage(File *file, const PageId pageNo,
+                               const Page &page, Page *&cached) {
+  SegmentLatch latch(segment_, segmentName_);
+  SharedFrameDesc *descs = descsOf(segment_);
+  while (true) {
+    std::uint32_t id = fileId(file, true);
+    std::int32_t found = findFrame(id, pageNo);
+    FrameId frame;
+    if (found < 0) {
+      if (!tryAllocFrame(latch, frame)) {
+        return false;
+      }
+      // The latch may have been released to write the victim back
+      id = fileId(file, true);
+      found = findFrame(id, pageNo);
+    }
+    if (found >= 0) {
+      // The copy in the pool may be newer than the one read
+      if (descs[found].io == SHARED_IO_READING) {
+        latch.waitForIo();
+        continue;
+      }
+      descs[found].refbit = 1;
+      pinFrame(found);
+      cached = &bufPool[found];
+      return true;
+    }
+    bufStats.diskreads++;
+    bufPool[frame] = page;
+    assignFrame(frame, id, pageNo, SHARED_IO_NONE);
+    pinFrame(frame);
+    cached = &bufPool[frame];
+    return true;
+  }
+}
+
+void SharedBufMgr::unPinPage(File *file, const PageId pageNo,
+                             const bool dirty) {
+  SegmentLatch latch(segment_, segmentName_);
+  const std::uint32_t id = fileId(file, false);
+  const std::int32_t frame =
+      id == SHARED_MAX_FILES ? -1 : findFrame(id, pageNo);
+  if (frame < 0) {
+    throw HashNotFoundException(file->filename(), pageNo);
+  }
+  if (dirty) {
+    descsOf(segment_)[frame].dirty = 1;
+  }
+  if (!unpinFrame(frame)) {
+    throw PageNotPinnedException(file->filename(), pageNo, frame);
+  }
+}
+
+void SharedBufMgr::allocPage(File *file, PageId &pageNo, Page *&page) {
+  SegmentLatch latch(segment_, segmentName_);
+  FrameId frame;
+  if (!tryAllocFrame(latch, frame)) {
+    throw BufferExceededException();
+  }
+  // Under the latch, which serializes the updates of the file header
+  bufPool[frame] = file->allocatePage(pageNo);
+  assignFrame(frame, fileId(file, true), pageNo, SHARED_IO_NONE);
+  pinFrame(frame);
+  page = &bufPool[frame];
+}
+
+void SharedBufMgr::flushFile(const File *file) {
+  {
+    SegmentLatch latch(segment_, segmentName_);
+    SharedFrameDesc *descs = descsOf(segment_);
+    const std::uint32_t numBufs = segment_->numBufs;
+    bool recovered = false;
+    while (true) {
+      const std::uint32_t id = fileId(file, false);
+      if (id == SHARED_MAX_FILES) {
+        break;
+      }
+      std::int32_t pinned = -1;
+      std::int32_t dirty = -1;
+      bool busy = false;
+      for (std::uint32_t i = 0; i < numBufs; i++) {
+        if (!descs[i].valid || descs[i].fileId != id) {
+          continue;
+        }
+        if (descs[i].pinCnt > 0) {
+          pinned = i;
+        } else if (descs[i].io != SHARED_IO_NONE) {
+          busy = true;
+        } else if (descs[i].dirty) {
+          dirty = i;
+        }
+      }
+      if (pinned >= 0) {
+        if (!recovered) {
+          // The pins may be held by processes which died
+          recoverSegment(segment_, false);
+          recovered = true;
+          continue;
+        }
+        throw PagePinnedException(file->filename(), descs[pinned].pageNo,
+                                  pinned);
+      }
+      if (busy) {
+        latch.waitForIo();
+      } else if (dirty >= 0) {
+        writeBack(latch, dirty);
+      } else {
+        for (std::uint32_t i = 0; i < numBufs; i++) {
+          if (descs[i].valid && descs[i].fileId == id) {
+            releaseFrame(i);
+          }
+        }
+        // No page of the file is left, its entry can be reused
+        segment_->files[id].name[0] = '\0';
+        break;
+      }
+    }
+  }
+  closeFile(file->filename());
+}
+
+void SharedBufMgr::writeBackFile(const File *file) {
+  SegmentLatch latch(segment_, segmentName_);
+  SharedFrameDesc *descs = descsOf(segment_);
+  std::uint32_t id = fileId(file, false);
+  for (std::uint32_t i = 0; i < segment_->numBufs && id != SHARED_MAX_FILES;
+       i++) {
+    if (descs[i].valid && descs[i].fileId == id && descs[i].dirty &&
+        descs[i].pinCnt == 0 && descs[i].io == SHARED_IO_NONE) {
+      writeBack(latch, i);
+      id = fileId(file, false);
+    }
+  }
+}
+
+void SharedBufMgr::disposePage(File *file, const PageId pageNo) {
+  {
+    SegmentLatch latch(segment_, segmentName_);
+    while (true) {
+      const std::uint32_t id = fileId(file, false);
+      const std::int32_t frame =
+          id == SHARED_MAX_FILES ? -1 : findFrame(id, pageNo);
+      if (frame < 0) {
+        break;
+      }
+      if (descsOf(segment_)[frame].io != SHARED_IO_NONE) {
+        latch.waitForIo();
+        continue;
+      }
+      releaseFrame(frame);
+      break;
+    }
+  }
+  file->deletePage(pageNo);
+}
+
+void SharedBufMgr::printSelf() {
+  SegmentLatch latch(segment_, segmentName_);
+  const SharedFrameDesc *descs = descsOf(segment_);
+  int validFrames = 0;
+  for (std::uint32_t i = 0; i < segment_->numBufs; i++) {
+    std::cout << "FrameNo:" << i << " ";
+    if (descs[i].valid) {
+      std::cout << "file:" << segment_->files[descs[i].fileId].name << " ";
+      std::cout << "pageNo:" << descs[i].pageNo << " ";
+      validFrames++;
+    } else {
+      std::cout << "file:NULL ";
+    }
+    std::cout << "valid:" << (int)descs[i].valid << " ";
+    std::cout << "pinCnt:" << descs[i].pinCnt << " ";
+    std::cout << "dirty:" << (int)descs[i].dirty << " ";
+    std::cout << "refbit:" << (int)descs[i].refbit << "\n";
+  }
+  std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,233 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Number of files which can have pages in a shared buffer pool at the
+ * same time.
+ */
+const std::uint32_t SHARED_MAX_FILES = 64;
+
+/**
+ * @brief Longest file name, terminator included, a shared buffer pool can
+ * hold pages of.
+ */
+const std::uint32_t SHARED_FILENAME_LENGTH = 128;
+
+/**
+ * @brief Number of processes which can be attached to a shared buffer pool at
+ * the same time.
+ */
+const std::uint32_t SHARED_MAX_PROCESSES = 32;
+
+struct SharedSegment;
+class SegmentLatch;
+
+/**
+ * @brief Buffer manager whose pool is shared by several processes.
+ *
+ * The frames, their descriptors and the page table live in a POSIX shared
+ * memory segment. Every process attaching to the segment with the same name
+ * sees the same cache: a page read by one process is a hit for the others,
+ * and a page dirtied by one is seen by the others before it is written back.
+ * Every operation holds a latch kept in the segment, a process shared robust
+ * mutex. Pages are read and written without it: the frame is reserved and
+ * marked as under I/O, so the other processes wait for that frame only.
+ * Latching the contents of pinned pages is left to the callers, as it is for
+ * BufMgr.
+ *
+ * Pins are counted per process. A process dying, while holding the latch or
+ * not, has its pins dropped and its reads in progress abandoned by the next
+ * process finding it gone, and the page table is rebuilt from the frame
+ * descriptors if it died holding the latch. The segment is marked unusable,
+ * and every operation throws, only if the latch cannot be recovered.
+ *
+ * Files are identified by name, so the processes have to open them through
+ * the same path. A page of a file the evicting process has not opened is
+ * written back through a file object it opens for the purpose, kept until
+ * the file is flushed.
+ *
+ * The segment is created by the first process attaching to it and removed
+ * when the last one detaches, after its dirty pages are written back.
+ * Statistics are kept per process.
+ */
+class SharedBufMgr : public BufMgr {
+ public:
+  /**
+   * Attaches to the shared buffer pool with the given name, creating it if it
+   * doesn't exist.
+   *
+   * @param segmentName   Name of the shared memory segment, "/name".
+   * @param bufs          Number of frames of the pool. Must match the pool
+   *                      if it exists already.
+   * @throws  SharedSegmentException  If the segment cannot be created or
+   *                                  attached, has another size or
+   *                                  SHARED_MAX_PROCESSES processes.
+   */
+  SharedBufMgr(const std::string &segmentName, std::uint32_t bufs);
+
+  /**
+   * Detaches from the shared buffer pool, dropping the pins of the process.
+   * The last process to detach writes the dirty pages back and removes the
+   * segment.
+   */
+  ~SharedBufMgr();
+
+  bool tryReadPage(File *file, const PageId pageNo, Page *&page);
+
+  void prefetchPage(File *file, const PageId pageNo);
+
+  bool tryReadCachedPage(File *file, const PageId pageNo, Page *&page);
+
+  bool installPage(File *file, const PageId pageNo, const Page &page,
+                   Page *&cached);
+
+  /**
+   * @throws  HashNotFoundException   If the page is not in the buffer pool.
+   * @throws  PageNotPinnedException  If the page is not already pinned by
+   *                                  this process.
+   */
+  void unPinPage(File *file, const PageId pageNo, const bool dirty);
+
+  void allocPage(File *file, PageId &pageNo, Page *&page);
+
+  /**
+   * Writes out all dirty pages of the file, cached by any process, and
+   * drops them from the pool.
+   *
+   * @throws  PagePinnedException If any page of the file is pinned by any
+   *                              process.
+   */
+  void flushFile(const File *file);
+
+  /**
+   * Writes out the dirty pages of the file no process has pinned, keeping
+   * them in the pool.
+   */
+  void writeBackFile(const File *file);
+
+  /**
+   * Deletes a page from the file and from the buffer pool if it is there.
+   */
+  void disposePage(File *file, const PageId pageNo);
+
+  void printSelf();
+
+  /**
+   * Removes a segment left behind by processes which did not detach, for
+   * instance because they crashed. Does nothing if there is none.
+   *
+   * @param segmentName   Name of the shared memory segment.
+   */
+  static void removeSegment(const std::string &segmentName);
+
+ private:
+  /**
+   * Returns the id of a file in the segment, registering it if asked to.
+   * Returns SHARED_MAX_FILES if the file is not registered.
+   *
+   * @throws  SharedSegmentException  If a file has to be registered and
+   *                                  there is no room left.
+   */
+  std::uint32_t fileId(const File *file, const bool registerFile);
+
+  /**
+   * Returns the frame holding a page, -1 if it is not in the pool.
+   */
+  std::int32_t findFrame(const std::uint32_t fileId, const PageId pageNo);
+
+  /**
+   * Assigns a free frame to a page, unpinned, and adds it to the page table.
+   *
+   * @param io  I/O the frame is reserved for, SHARED_IO_NONE if the page is
+   *            already in it.
+   */
+  void assignFrame(const FrameId frame, const std::uint32_t fileId,
+                   const PageId pageNo, const std::uint8_t io);
+
+  /**
+   * Drops the page of a frame from the page table and clears the frame.
+   */
+  void releaseFrame(const FrameId frame);
+
+  /**
+   * Pins a frame for this process.
+   */
+  void pinFrame(const FrameId frame);
+
+  /**
+   * Drops a pin of this process on a frame.
+   *
+   * @return  false if the process has not pinned it.
+   */
+  bool unpinFrame(const FrameId frame);
+
+  /**
+   * Finds a page in the pool or reads it into a free frame, the latch being
+   * released during the read, and pins it.
+   *
+   * @return  The frame, -1 if every frame is pinned.
+   */
+  std::int32_t readFrame(SegmentLatch &latch, File *file, const PageId pageNo);
+
+  /**
+   * Frees a frame with the clock algorithm, writing its page back if dirty,
+   * during which the latch is released.
+   *
+   * @return  false if every frame is pinned.
+   */
+  bool tryAllocFrame(SegmentLatch &latch, FrameId &frame);
+
+  /**
+   * Writes the page of a dirty frame back to its file. The latch is released
+   * during the write, the frame marked so it is not evicted or dropped
+   * meanwhile.
+   */
+  void writeBack(SegmentLatch &latch, const FrameId frame);
+
+  /**
+   * Returns the file object of this process for a file of the segment,
+   * opening it if needed.
+   */
+  File *openFile(const std::uint32_t fileId);
+
+  /**
+   * Closes the file object of this process for a file, if any.
+   */
+  void closeFile(const std::string &name);
+
+  std::string segmentName_;
+  std::size_t segmentSize_;
+  SharedSegment *segment_;
+
+  /**
+   * Entry of the process in the segment, which its pins are counted under.
+   */
+  std::uint32_t slot_;
+
+  /**
+   * File objects opened to write pages back, by name, with the generation
+   * of the file entry they were opened for.
+   */
+  std::map<std::string, std::pair<std::uint32_t, File *> > openFiles_;
+};
+
+}  // namespace badgerdb
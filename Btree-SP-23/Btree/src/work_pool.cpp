@@ -0,0 +1,246 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "work_pool.h"
+
+namespace badgerdb {
+
+/**
+ * Pool the current thread belongs to, NULL outside of the pools, and its
+ * number in the pool.
+ */
+static thread_local const WorkStealingPool *currentPool = NULL;
+static thread_local std::size_t currentWorker = 0;
+
+WorkStealingPool::WorkStealingPool(const std::size_t numThreads,
+                                   const std::size_t maxBackgroundThreads)
+    : backgroundThreads_(0), nextWorker_(0), stopping_(false) {
+  const std::size_t count = numThreads == 0 ? 1 : numThreads;
+  maxBackgroundThreads_ =
+      maxBackgroundThreads != 0 ? maxBackgroundThreads : count - 1;
+  for (int p = 0; p < NUM_TASK_PRIORITIES; p++) {
+    queued_[p] = 0;
+  }
+  for (std::size_t i = 0; i < count; i++) {
+    workers_.push_back(new Worker());
+  }
+  for (std::size_t i = 0; i < count; i++) {
+    threads_.push_back(std::thread(&WorkStealingPool::run, this, i));
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(idleLatch_);
+    stopping_ = true;
+  }
+  workReady_.notify_all();
+  for (std::size_t i = 0; i < threads_.size(); i++) {
+    threads_[i].join();
+  }
+  for (std::size_t i = 0; i < workers_.size(); i++) {
+    delete workers_[i];
+  }
+}
+
+WorkStealingPool &WorkStealingPool::shared() {
+  static WorkStealingPool pool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+bool WorkStealingPool::isWorkerThread() const { return currentPool == this; }
+
+void WorkStealingPool::submit(const Task &task, const TaskPriority priority) {
+  std::size_t target = currentWorker;
+  if (currentPool != this) {
+    std::lock_guard<std::mutex> lock(idleLatch_);
+    target = nextWorker_;
+    nextWorker_ = (nextWorker_ + 1) % workers_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(workers_[target]->latch);
+    workers_[target]->tasks[priority].push_back(task);
+  }
+  {
+    std::lock_guard<std::mutex> lock(idleLatch_);
+    queued_[priority]++;
+  }
+  workReady_.notify_one();
+}
+
+bool WorkStealingPool::tryTake(const std::size_t self,
+                               const TaskPriority priority, Task &task) {
+  {
+    Worker *own = workers_[self];
+    std::lock_guard<std::mutex> lock(own->latch);
+    if (!own->tasks[priority].empty()) {
+      task.swap(own->tasks[priority].back());
+      own->tasks[priority].pop_back();
+      return true;
+    }
+  }
+  for (std::size_t i = 1; i < workers_.size(); i++) {
+    Worker *victim = workers_[(self + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim->latch);
+    if (!victim->tasks[priority].empty()) {
+      task.swap(victim->tasks[priority].front());
+      victim->tasks[priority].pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingPool::hasRunnableTask() const {
+  if (queued_[FOREGROUND_TASK] > 0) {
+    return true;
+  }
+  return this->hasBackgroundRoom() &&
+         queued_[BACKGROUND_IO_TASK] + queued_[MAINTENANCE_TASK] > 0;
+}
+
+void WorkStealingPool::run(const std::size_t self) {
+  currentPool = this;
+  currentWorker = self;
+  Task task;
+  // queued_ is decremented once a task is taken, so it may still count a
+  // task gone from the deques: they are tried again until it is 0
+  std::unique_lock<std::mutex> lock(idleLatch_);
+  while (true) {
+    if (queued_[FOREGROUND_TASK] > 0) {
+      lock.unlock();
+      const bool taken = this->tryTake(self, FOREGROUND_TASK, task);
+      lock.lock();
+      if (taken) {
+        queued_[FOREGROUND_TASK]--;
+        lock.unlock();
+        task();
+        task = Task();
+        lock.lock();
+        continue;
+      }
+    }
+    if (this->hasBackgroundRoom() &&
+        queued_[BACKGROUND_IO_TASK] + queued_[MAINTENANCE_TASK] > 0) {
+      // No foreground task is left, and the background ones have room
+      backgroundThreads_++;
+      lock.unlock();
+      int taken = NUM_TASK_PRIORITIES;
+      for (int p = BACKGROUND_IO_TASK; p < NUM_TASK_PRIORITIES; p++) {
+        if (this->tryTake(self, (TaskPriority)p, task)) {
+          taken = p;
+          break;
+        }
+      }
+      if (taken != NUM_TASK_PRIORITIES) {
+        lock.lock();
+        queued_[taken]--;
+        lock.unlock();
+        task();
+        task = Task();
+      }
+      lock.lock();
+      backgroundThreads_--;
+      if (queued_[BACKGROUND_IO_TASK] + queued_[MAINTENANCE_TASK] > 0) {
+        // A thread waiting for the background tasks to make room may go
+        workReady_.notify_one();
+      }
+      continue;
+    }
+    const bool idle = queued_[FOREGROUND_TASK] + queued_[BACKGROUND_IO_TASK] +
+                          queued_[MAINTENANCE_TASK] ==
+                      0;
+    if (stopping_ && idle) {
+      return;
+    }
+    if (idle || !this->hasRunnableTask()) {
+      workReady_.wait(lock);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// TaskGroup
+// -----------------------------------------------------------------------------
+
+TaskGroup::TaskGroup(WorkStealingPool &pool)
+    : pool_(pool), state_(new State()) {
+  state_->running = 0;
+}
+
+TaskGroup::~TaskGroup() { this->finish(); }
+
+void TaskGroup::submit(const WorkStealingPool::Task &task,
+                       const TaskPriority priority) {
+  {
+    std::lock_guard<std::mutex> lock(state_->latch);
+    state_->pending[priority].push_back(task);
+    state_->running++;
+  }
+  state_->changed.notify_all();
+  // Runs a task of the class, unless the waiting thread took them all
+  std::shared_ptr<State> state = state_;
+  pool_.submit([state, priority]() { runPending(*state, priority); },
+               priority);
+}
+
+bool TaskGroup::runPending(State &state, const int priority) {
+  WorkStealingPool::Task task;
+  {
+    std::lock_guard<std::mutex> lock(state.latch);
+    if (state.pending[priority].empty()) {
+      return false;
+    }
+    task.swap(state.pending[priority].front());
+    state.pending[priority].pop_front();
+  }
+  try {
+    task();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(state.latch);
+    if (!state.error) {
+      state.error = std::current_exception();
+    }
+  }
+  std::lock_guard<std::mutex> lock(state.latch);
+  if (--state.running == 0) {
+    state.changed.notify_all();
+  }
+  return true;
+}
+
+void TaskGroup::finish() {
+  std::unique_lock<std::mutex> lock(state_->latch);
+  while (state_->running > 0) {
+    int priority = 0;
+    while (priority < NUM_TASK_PRIORITIES &&
+           state_->pending[priority].empty()) {
+      priority++;
+    }
+    if (priority == NUM_TASK_PRIORITIES) {
+      // Every task left is running on a thread of the pool
+      state_->changed.wait(lock);
+      continue;
+    }
+    lock.unlock();
+    runPending(*state_, priority);
+    lock.lock();
+  }
+}
+
+void TaskGroup::wait() {
+  this->finish();
+  std::lock_guard<std::mutex> lock(state_->latch);
+  if (state_->error) {
+    std::exception_ptr error = state_->error;
+    state_->error = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,248 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Class of a task of a WorkStealingPool, in the order the pool runs
+ * them.
+ */
+enum TaskPriority {
+  FOREGROUND_TASK,    /* Part of a query waiting for it, such as a scan */
+  BACKGROUND_IO_TASK, /* Reads ahead or writes back pages */
+  MAINTENANCE_TASK    /* Reorganizes data nobody waits for */
+};
+
+/**
+ * @brief Number of classes of tasks.
+ */
+const int NUM_TASK_PRIORITIES = 3;
+
+/**
+ * @brief Pool of threads running tasks, each thread taking them from deques
+ * of its own and stealing from the others once they are empty.
+ *
+ * Tasks submitted from outside the pool are dealt to the deques in turn,
+ * tasks submitted by a task go to the deques of its thread. A thread runs the
+ * newest task of its deques, whose pages are likely still cached, and steals
+ * the oldest task of another, so uneven tasks end up spread over the threads.
+ *
+ * Each thread has a deque per TaskPriority. A thread takes a task of a class
+ * only if no task of a higher class is queued in any deque. The background
+ * classes run on a limited number of threads at once, so the others are left
+ * free for the foreground tasks submitted meanwhile. Tasks are not
+ * preempted: background tasks are kept short, a few pages each. A pool
+ * stopping runs its background tasks on all of its threads.
+ */
+class WorkStealingPool {
+ public:
+  typedef std::function<void()> Task;
+
+  /**
+   * Starts the threads of the pool.
+   *
+   * @param numThreads            Number of threads, at least 1.
+   * @param maxBackgroundThreads  Number of threads which may run background
+   *                              tasks at once, 0 for all of them but one.
+   *                              A single thread is then kept for the
+   *                              foreground: background tasks of a TaskGroup
+   *                              are run by the thread waiting for them.
+   */
+  explicit WorkStealingPool(const std::size_t numThreads,
+                            const std::size_t maxBackgroundThreads = 0);
+
+  /**
+   * Runs the tasks still queued and stops the threads.
+   */
+  ~WorkStealingPool();
+
+  /**
+   * Returns the pool of the storage engine, with a thread per core, started
+   * on first use and stopped when the program exits.
+   */
+  static WorkStealingPool &shared();
+
+  /**
+   * Queues a task. A task throwing an exception terminates the program, as
+   * for std::thread: tasks report their errors themselves, or through a
+   * TaskGroup.
+   */
+  void submit(const Task &task, const TaskPriority priority = FOREGROUND_TASK);
+
+  std::size_t numThreads() const { return threads_.size(); }
+
+  /**
+   * Returns true if called from a task of the pool.
+   */
+  bool isWorkerThread() const;
+
+ private:
+  // Not copyable, the threads refer to the object
+  WorkStealingPool(const WorkStealingPool &);
+  WorkStealingPool &operator=(const WorkStealingPool &);
+
+  /**
+   * Deques of a thread, one per TaskPriority.
+   */
+  struct Worker {
+    std::mutex latch;
+    std::deque<Task> tasks[NUM_TASK_PRIORITIES];
+  };
+
+  /**
+   * Body of thread <self>: runs tasks until stopped.
+   */
+  void run(const std::size_t self);
+
+  /**
+   * Takes the newest task of a class from deque <self>, or else the oldest
+   * of another.
+   *
+   * @return  false if every deque of the class is empty.
+   */
+  bool tryTake(const std::size_t self, const TaskPriority priority,
+               Task &task);
+
+  /**
+   * Returns true if an idle thread may take a task. Called under idleLatch_.
+   */
+  bool hasRunnableTask() const;
+
+  /**
+   * Returns true if one more thread may run background tasks. Called under
+   * idleLatch_.
+   */
+  bool hasBackgroundRoom() const {
+    return stopping_ || backgroundThreads_ < maxBackgroundThreads_;
+  }
+
+  std::vector<Worker *> workers_;
+  std::vector<std::thread> threads_;
+  std::size_t maxBackgroundThreads_;
+
+  /**
+   * Protects the members below.
+   */
+  std::mutex idleLatch_;
+
+  /**
+   * Signals the idle threads that a task may be taken or that they have to
+   * stop.
+   */
+  std::condition_variable workReady_;
+
+  /**
+   * Number of tasks of each class queued and not taken yet.
+   */
+  std::size_t queued_[NUM_TASK_PRIORITIES];
+
+  /**
+   * Number of threads running a background task or looking for one.
+   */
+  std::size_t backgroundThreads_;
+
+  /**
+   * Deque the next task submitted from outside the pool goes to.
+   */
+  std::size_t nextWorker_;
+
+  bool stopping_;
+};
+
+/**
+ * @brief Tasks submitted to a WorkStealingPool together, waited for at once.
+ *
+ * The group keeps the tasks which have not started yet: the pool runs them
+ * as usual, and the thread waiting for the group runs the ones still queued
+ * itself rather than sleeping. Waiting from a task of the pool, or for
+ * background tasks no thread of the pool may run, does not deadlock.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(WorkStealingPool &pool);
+
+  /**
+   * Runs or waits for the tasks of the group.
+   */
+  ~TaskGroup();
+
+  /**
+   * Queues a task of the group. An exception thrown by the task is kept for
+   * wait().
+   */
+  void submit(const WorkStealingPool::Task &task,
+              const TaskPriority priority = FOREGROUND_TASK);
+
+  /**
+   * Runs the tasks of the group not started yet, then waits until the others
+   * are done. May be called from a task of the pool.
+   *
+   * @throws  The first exception thrown by a task since the last wait().
+   */
+  void wait();
+
+ private:
+  // Not copyable
+  TaskGroup(const TaskGroup &);
+  TaskGroup &operator=(const TaskGroup &);
+
+  /**
+   * Tasks of the group, shared with the pool which may still hold a task
+   * of the group once the group is gone.
+   */
+  struct State {
+    /**
+     * Protects the members below.
+     */
+    std::mutex latch;
+
+    /**
+     * Signaled when a task is queued and when the last one is done.
+     */
+    std::condition_variable changed;
+
+    /**
+     * Tasks not started yet, one deque per TaskPriority.
+     */
+    std::deque<WorkStealingPool::Task> pending[NUM_TASK_PRIORITIES];
+
+    /**
+     * Number of tasks submitted and not done.
+     */
+    std::size_t running;
+    std::exception_ptr error;
+  };
+
+  /**
+   * Runs the oldest task of a class not started yet.
+   *
+   * @return  false if there was none.
+   */
+  static bool runPending(State &state, const int priority);
+
+  /**
+   * Runs the tasks not started yet, then waits until the others are done.
+   */
+  void finish();
+
+  WorkStealingPool &pool_;
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace badgerdb
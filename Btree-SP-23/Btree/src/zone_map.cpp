@@ -0,0 +1,280 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "zone_map.h"
+
+#include <string.h>
+
+#include <sstream>
+
+#include "blob_stream.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+static double numberAt(const Datatype type, const char *value) {
+  if (type == INTEGER) {
+    int number;
+    memcpy(&number, value, sizeof(int));
+    return number;
+  }
+  double number;
+  memcpy(&number, value, sizeof(double));
+  return number;
+}
+
+// -----------------------------------------------------------------------------
+// ZoneMap
+// -----------------------------------------------------------------------------
+
+void ZoneMap::reset(const Datatype type, const char *value) {
+  memset(this, 0, sizeof(ZoneMap));
+  if (type == STRING) {
+    strncpy(minString, value, STRINGSIZE);
+    strncpy(maxString, value, STRINGSIZE);
+  } else {
+    minNumber = maxNumber = numberAt(type, value);
+  }
+}
+
+void ZoneMap::widen(const Datatype type, const char *value) {
+  if (type == STRING) {
+    if (strncmp(value, minString, STRINGSIZE) < 0) {
+      strncpy(minString, value, STRINGSIZE);
+    }
+    if (strncmp(value, maxString, STRINGSIZE) > 0) {
+      strncpy(maxString, value, STRINGSIZE);
+    }
+    return;
+  }
+  const double number = numberAt(type, value);
+  if (number < minNumber) {
+    minNumber = number;
+  }
+  if (number > maxNumber) {
+    maxNumber = number;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// AttributeRange
+// -----------------------------------------------------------------------------
+
+/**
+ * Copies a bound, STRING bounds on their first STRINGSIZE characters.
+ */
+static std::string copyBound(const Datatype type, const void *value) {
+  if (type == STRING) {
+    return std::string((const char *)value,
+                       strnlen((const char *)value, STRINGSIZE));
+  }
+  const std::size_t size = type == INTEGER ? sizeof(int) : sizeof(double);
+  return std::string((const char *)value, size);
+}
+
+/**
+ * Compares a value with a bound copied by copyBound.
+ */
+static int compareToBound(const Datatype type, const char *value,
+                          const std::string &bound) {
+  if (type == STRING) {
+    return strncmp(value, bound.c_str(), STRINGSIZE);
+  }
+  const double number = numberAt(type, value);
+  const double boundNumber = numberAt(type, bound.data());
+  return number < boundNumber ? -1 : (number > boundNumber ? 1 : 0);
+}
+
+AttributeRange::AttributeRange(const Datatype type, const void *lowVal,
+                               const Operator lowOp, const void *highVal,
+                               const Operator highOp)
+    : type_(type), lowOp_(lowOp), highOp_(highOp) {
+  if ((lowOp != GT && lowOp != GTE) || (highOp != LT && highOp != LTE)) {
+    throw BadOpcodesException();
+  }
+  lowVal_ = copyBound(type, lowVal);
+  highVal_ = copyBound(type, highVal);
+}
+
+bool AttributeRange::contains(const char *value) const {
+  const int low = compareToBound(type_, value, lowVal_);
+  const int high = compareToBound(type_, value, highVal_);
+  return (lowOp_ == GT ? low > 0 : low >= 0) &&
+         (highOp_ == LT ? high < 0 : high <= 0);
+}
+
+bool AttributeRange::mayMatch(const ZoneMap &zoneMap) const {
+  int maxToLow;
+  int minToHigh;
+  if (type_ == STRING) {
+    maxToLow = compareToBound(type_, zoneMap.maxString, lowVal_);
+    minToHigh = compareToBound(type_, zoneMap.minString, highVal_);
+  } else {
+    const double low = numberAt(type_, lowVal_.data());
+    const double high = numberAt(type_, highVal_.data());
+    maxToLow = zoneMap.maxNumber < low ? -1 : (zoneMap.maxNumber > low);
+    minToHigh = zoneMap.minNumber < high ? -1 : (zoneMap.minNumber > high);
+  }
+  return (lowOp_ == GT ? maxToLow > 0 : maxToLow >= 0) &&
+         (highOp_ == LT ? minToHigh < 0 : minToHigh <= 0);
+}
+
+// -----------------------------------------------------------------------------
+// HeapZoneMap
+// -----------------------------------------------------------------------------
+
+HeapZoneMap::HeapZoneMap(const std::string &relationName, BufMgr *bufMgr,
+                         const int attrByteOffset, const Datatype attrType)
+    : relationName_(relationName),
+      file_(NULL),
+      bufMgr_(bufMgr),
+      attrByteOffset_(attrByteOffset),
+      attrType_(attrType),
+      dirty_(false) {
+  std::ostringstream nameStr;
+  nameStr << relationName << ".zonemap." << attrByteOffset;
+  zoneMapName_ = nameStr.str();
+
+  try {
+    file_ = new BlobFile(zoneMapName_, false);
+    Page *metaPage;
+    bufMgr_->readPage(file_, 1, metaPage);
+    const HeapZoneMapMetaInfo metaInfo = *(HeapZoneMapMetaInfo *)metaPage;
+    bufMgr_->unPinPage(file_, 1, false);
+    if (metaInfo.attrByteOffset != attrByteOffset ||
+        metaInfo.attrType != attrType) {
+      throw BadIndexInfoException(
+          "Parameters passed while opening the zone map don't match");
+    }
+    if (PageFile(relationName, false).version() != metaInfo.relationVersion) {
+      // Stale, it could skip pages holding matches
+      rebuild();
+      return;
+    }
+    summaries_.resize(metaInfo.numPages);
+    if (!summaries_.empty()) {
+      BlobReader reader(file_, bufMgr_, metaInfo.summaryPageNo);
+      reader.read(&summaries_[0], summaries_.size() * sizeof(PageSummary));
+    }
+  } catch (const FileNotFoundException &e) {
+    file_ = new BlobFile(zoneMapName_, true);
+    PageId metaPageNo;
+    Page *metaPage;
+    bufMgr_->allocPage(file_, metaPageNo, metaPage);
+    HeapZoneMapMetaInfo *metaInfo = (HeapZoneMapMetaInfo *)metaPage;
+    metaInfo->attrByteOffset = attrByteOffset;
+    metaInfo->attrType = attrType;
+    metaInfo->numPages = 0;
+    metaInfo->summaryPageNo = Page::INVALID_NUMBER;
+    metaInfo->relationVersion = 0;
+    bufMgr_->unPinPage(file_, metaPageNo, true);
+    rebuild();
+  }
+}
+
+HeapZoneMap::~HeapZoneMap() {
+  try {
+    flush();
+    bufMgr_->flushFile(file_);
+  } catch (...) {
+  }
+  delete file_;
+}
+
+PageSummary &HeapZoneMap::summaryFor(const PageId pageNo) {
+  if (pageNo >= summaries_.size()) {
+    PageSummary unknown;
+    memset(&unknown, 0, sizeof(PageSummary));
+    summaries_.resize(pageNo + 1, unknown);
+  }
+  return summaries_[pageNo];
+}
+
+RecordId HeapZoneMap::insertRecord(Page *page, const std::string &record) {
+  const RecordId rid = page->insertRecord(record);
+  recordWritten(page->page_number(), record.data());
+  return rid;
+}
+
+void HeapZoneMap::updateRecord(Page *page, const RecordId &rid,
+                               const std::string &record) {
+  page->updateRecord(rid, record);
+  recordWritten(page->page_number(), record.data());
+}
+
+void HeapZoneMap::recordWritten(const PageId pageNo, const char *record) {
+  PageSummary &summary = summaryFor(pageNo);
+  const char *value = record + attrByteOffset_;
+  if (summary.numRecords == 0) {
+    summary.zoneMap.reset(attrType_, value);
+  } else {
+    summary.zoneMap.widen(attrType_, value);
+  }
+  summary.summarized = 1;
+  summary.numRecords++;
+  dirty_ = true;
+}
+
+void HeapZoneMap::rebuild() {
+  summaries_.clear();
+  dirty_ = true;
+  PageFile relation(relationName_, false);
+  for (FileIterator iter = relation.begin(); iter != relation.end(); ++iter) {
+    const PageId pageNo = iter.page_number();
+    summaryFor(pageNo).summarized = 1;
+    Page *page;
+    bufMgr_->readPage(&relation, pageNo, page);
+    for (PageIterator recordIter = page->begin(); recordIter != page->end();
+         ++recordIter) {
+      recordWritten(pageNo, recordIter.recordView().data);
+    }
+    bufMgr_->unPinPage(&relation, pageNo, false);
+  }
+  bufMgr_->flushFile(&relation);
+}
+
+bool HeapZoneMap::mayContain(const PageId pageNo,
+                             const AttributeRange &range) const {
+  const PageSummary *summary = pageSummary(pageNo);
+  if (summary == NULL) {
+    return true;
+  }
+  return summary->numRecords > 0 && range.mayMatch(summary->zoneMap);
+}
+
+const PageSummary *HeapZoneMap::pageSummary(const PageId pageNo) const {
+  if (pageNo >= summaries_.size() || !summaries_[pageNo].summarized) {
+    return NULL;
+  }
+  return &summaries_[pageNo];
+}
+
+void HeapZoneMap::flush() {
+  if (!dirty_) {
+    return;
+  }
+  Page *metaPage;
+  bufMgr_->readPage(file_, 1, metaPage);
+  HeapZoneMapMetaInfo *metaInfo = (HeapZoneMapMetaInfo *)metaPage;
+  BlobWriter writer(file_, bufMgr_, metaInfo->summaryPageNo);
+  if (!summaries_.empty()) {
+    writer.write(&summaries_[0], summaries_.size() * sizeof(PageSummary));
+  }
+  writer.close();
+  metaInfo->summaryPageNo = writer.firstPageNo();
+  metaInfo->numPages = summaries_.size();
+  metaInfo->relationVersion = PageFile(relationName_, false).version();
+  bufMgr_->unPinPage(file_, 1, true);
+  dirty_ = false;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,265 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "attribute.h"
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Smallest and largest value of an attribute over a set of records.
+ * Stored as is in files, it must remain a plain struct.
+ */
+struct ZoneMap {
+  /**
+   * Bounds of INTEGER and DOUBLE attributes.
+   */
+  double minNumber;
+  double maxNumber;
+
+  /**
+   * Bounds of STRING attributes, on their first STRINGSIZE characters.
+   */
+  char minString[STRINGSIZE];
+  char maxString[STRINGSIZE];
+
+  /**
+   * Sets both bounds to the given value.
+   *
+   * @param type   Datatype of the attribute.
+   * @param value  Value of the attribute inside a record.
+   */
+  void reset(const Datatype type, const char *value);
+
+  /**
+   * Widens the bounds so they include the given value.
+   *
+   * @param type   Datatype of the attribute.
+   * @param value  Value of the attribute inside a record.
+   */
+  void widen(const Datatype type, const char *value);
+};
+
+/**
+ * @brief Range of values of an attribute. Keeps a copy of its bounds.
+ */
+class AttributeRange {
+ public:
+  AttributeRange() : type_(INTEGER), lowOp_(GTE), highOp_(LTE) {}
+
+  /**
+   * @param type     Datatype of the attribute.
+   * @param lowVal   Low bound, an int, a double or a string compared on its
+   *                 first STRINGSIZE characters.
+   * @param lowOp    GT or GTE.
+   * @param highVal  High bound, of the same type as lowVal.
+   * @param highOp   LT or LTE.
+   * @throws  BadOpcodesException   If the operators are not as above.
+   */
+  AttributeRange(const Datatype type, const void *lowVal, const Operator lowOp,
+                 const void *highVal, const Operator highOp);
+
+  /**
+   * @param value  Value of the attribute inside a record.
+   * @return  True if the value is in the range.
+   */
+  bool contains(const char *value) const;
+
+  /**
+   * @return  False if no value within the bounds of the zone map can be in
+   *          the range.
+   */
+  bool mayMatch(const ZoneMap &zoneMap) const;
+
+ private:
+  Datatype type_;
+  std::string lowVal_;
+  std::string highVal_;
+  Operator lowOp_;
+  Operator highOp_;
+};
+
+/**
+ * @brief Zone map of one page of a heap relation.
+ */
+struct PageSummary {
+  /**
+   * Non zero once the page is known to the zone map. Pages that are not may
+   * hold any value.
+   */
+  std::uint32_t summarized;
+
+  /**
+   * Number of records summarized. Deleted records are not subtracted.
+   */
+  std::uint32_t numRecords;
+
+  ZoneMap zoneMap;
+};
+
+/**
+ * @brief The meta page of a HeapZoneMap file, which is always page 1.
+ */
+struct HeapZoneMapMetaInfo {
+  /**
+   * Offset of the summarized attribute inside the records.
+   */
+  int attrByteOffset;
+
+  /**
+   * Datatype of the summarized attribute.
+   */
+  Datatype attrType;
+
+  /**
+   * Number of PageSummary entries, indexed by page number.
+   */
+  std::uint32_t numPages;
+
+  /**
+   * First page of the blob stream holding the entries.
+   */
+  PageId summaryPageNo;
+
+  /**
+   * File::version() of the relation when the entries were written. A relation
+   * written since has its zone map rebuilt on open.
+   */
+  std::uint32_t relationVersion;
+};
+
+/**
+ * @brief Sidecar file with the min/max of one attribute of every page of a
+ * heap (PageFile) relation, so range scans skip the pages that cannot match.
+ *
+ * The zone map is named "<relation>.zonemap.<attrByteOffset>". It is kept up
+ * to date by inserting and updating records through insertRecord() and
+ * updateRecord(), or through recordWritten() for records written otherwise.
+ * Bounds are only ever widened, so deleting records keeps the zone map correct
+ * but loosens it; rebuild() recomputes it from the relation.
+ *
+ * FileScan::setRange() uses it to skip pages.
+ */
+class HeapZoneMap {
+ public:
+  /**
+   * Opens the zone map of an attribute of a relation. If it does not exist
+   * yet, or the relation was written since the zone map was, it is built
+   * from the records of the relation. The pages of the relation must have
+   * been flushed: writes still in the buffer pool are not seen. Pages written
+   * through the zone map but flushed after it also get it rebuilt.
+   *
+   * @param relationName    Name of the relation file.
+   * @param bufMgr          Buffer manager instance.
+   * @param attrByteOffset  Offset of the attribute inside the records.
+   * @param attrType        Datatype of the attribute.
+   * @throws  BadIndexInfoException   If the existing zone map is for another
+   *                                  datatype.
+   */
+  HeapZoneMap(const std::string &relationName, BufMgr *bufMgr,
+              const int attrByteOffset, const Datatype attrType);
+
+  /**
+   * Writes the zone map back and closes its file.
+   */
+  ~HeapZoneMap();
+
+  /**
+   * @return  Name of the zone map file.
+   */
+  const std::string &zoneMapName() const { return zoneMapName_; }
+
+  int attrByteOffset() const { return attrByteOffset_; }
+
+  Datatype attrType() const { return attrType_; }
+
+  /**
+   * Inserts a record into a page of the relation and adds it to the page's
+   * zone map.
+   *
+   * @param page    Page of the relation.
+   * @param record  Record to insert.
+   * @return  RecordId of the new record.
+   * @throws  InsufficientSpaceException   If the record does not fit.
+   */
+  RecordId insertRecord(Page *page, const std::string &record);
+
+  /**
+   * Updates a record of a page of the relation and adds its new value to the
+   * page's zone map.
+   *
+   * @param page    Page of the relation.
+   * @param rid     Record to update.
+   * @param record  New content of the record.
+   */
+  void updateRecord(Page *page, const RecordId &rid,
+                    const std::string &record);
+
+  /**
+   * Adds a record written to a page of the relation to the page's zone map.
+   *
+   * @param pageNo  Page holding the record.
+   * @param record  Content of the record.
+   */
+  void recordWritten(const PageId pageNo, const char *record);
+
+  /**
+   * Recomputes the zone map of every page from the relation, whose pages must
+   * have been flushed.
+   */
+  void rebuild();
+
+  /**
+   * @param pageNo  Page of the relation.
+   * @param range   Range of values of the attribute.
+   * @return  False if the page holds no record in the range.
+   */
+  bool mayContain(const PageId pageNo, const AttributeRange &range) const;
+
+  /**
+   * @return  Zone map of a page, NULL if the page is not summarized.
+   */
+  const PageSummary *pageSummary(const PageId pageNo) const;
+
+  /**
+   * Writes the zone map to its file.
+   */
+  void flush();
+
+ private:
+  PageSummary &summaryFor(const PageId pageNo);
+
+  std::string relationName_;
+  std::string zoneMapName_;
+  BlobFile *file_;
+  BufMgr *bufMgr_;
+  int attrByteOffset_;
+  Datatype attrType_;
+
+  /**
+   * Zone map of every page, indexed by page number.
+   */
+  std::vector<PageSummary> summaries_;
+
+  /**
+   * True if summaries_ changed since the zone map was last written.
+   */
+  bool dirty_;
+};
+
+}  // namespace badgerdb